@@ -16,6 +16,7 @@
 #include "symaths/numbers.hpp"
 
 #include <string>
+#include <string_view>
 #include <vector>
 
 namespace sym {
@@ -31,26 +32,66 @@ namespace sym {
 			abs,
 			LEN
 		};
+
+		// Id of the functions which do not exist, registered ones come after the builtins
+		constexpr uint32_t none = ~0u;
 	}
 
 	namespace detail {
 		void init_builtin_functions();
 
+		/*
+		 * Numeric kernels, called by the compiled evaluators. A kernel computes the function from its arguments, and a
+		 * batch kernel computes it on count points at once : args[k] holds the count values of the k-th argument.
+		 */
+		using kernel_t = double (*)(const double* args);
+		using batch_kernel_t = void (*)(const double* const* args, double* out, size_t count);
+
 		struct builtin_func_descriptor {
-			using eval_t = number (*)(const std::vector<const node*>& args);
+			using eval_t = number (*)(const std::vector<number>& args);
 			using reduce_t = const node* (*)(const std::vector<const node*>& args);
 			using derivative_t = const node* (*)(const std::vector<const node*>& args, const node* wrt);
 
-			const char* name;
-			eval_t eval;
-			reduce_t reduce;
-			derivative_t derivative;
+			std::string name;
+			uint32_t id = funcs::none;
+			size_t arity = 1;
+			// Exact evaluation, functions without it are evaluated on doubles by their kernel
+			eval_t eval = nullptr;
+			reduce_t reduce = nullptr;
+			derivative_t derivative = nullptr;
+			kernel_t kernel = nullptr;
+			batch_kernel_t batch_kernel = nullptr;
 		};
 
-		const builtin_func_descriptor& get_func(funcs::builtin_fn_id id);
+		/**
+		 * @throws std::invalid_argument If no function has this id
+		 */
+		const builtin_func_descriptor& get_func(uint32_t id);
 
-		funcs::builtin_fn_id get_func_id(const std::string& name);
+		/**
+		 * @brief Finds a builtin or registered function by name.
+		 * @return Its id, or funcs::none
+		 */
+		uint32_t get_func_id(std::string_view name);
+
+		// Amount of functions registered so far, which only grows
+		size_t registered_functions_count();
 	}
+
+	/**
+	 * @brief Registers a function of doubles, which parsed expressions can then call by name.
+	 *
+	 * Functions must be registered before expressions calling them are parsed or evaluated by other threads.
+	 *
+	 * @param kernel Computes the function from its arity arguments
+	 * @param batch_kernel Optional, see detail::batch_kernel_t. Without it, batches call kernel on each point.
+	 * @param derivative Optional, without it differentiating a call throws
+	 * @return Id of the function, for make_func
+	 * @throws std::invalid_argument If the name is not an identifier or is already taken, or the arity is not within
+	 * [1, 8]
+	 */
+	uint32_t register_function(const std::string& name, size_t arity, detail::kernel_t kernel,
+		detail::batch_kernel_t batch_kernel = nullptr, detail::builtin_func_descriptor::derivative_t derivative = nullptr);
 }
 
 #endif
@@ -0,0 +1,75 @@
+/*
+ *	                            _   _
+ *	  ___ _   _ _ __ ___   __ _| |_| |__  ___
+ *	 / __| | | | '_ ` _ \ / _` | __| '_ \/ __|   Symbolic maths for C++
+ *	 \__ \ |_| | | | | | | (_| | |_| | | \__ \   Version : 0.0.1
+ *	 |___/\__, |_| |_| |_|\__,_|\__|_| |_|___/   https://github.com/dgdzd/symaths
+ *		  |___/
+ *
+ * All source code is distributed under the GNU General Public License v2.0.
+ *
+ */
+
+#ifndef BOUNDS_HPP
+#define BOUNDS_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+/*
+ * Interval arithmetic on doubles. Every result is rounded outwards (by one ulp for exact IEEE operations), so that it
+ * contains every value of the operation on the operands. An empty interval (lower > upper, or NaN bounds) stands for
+ * the values of an operation outside of its domain, for example ln([-2;-1]).
+ */
+namespace sym::detail {
+	struct bounds {
+		double lower = -std::numeric_limits<double>::infinity();
+		double upper = std::numeric_limits<double>::infinity();
+
+		static bounds point(double value) { return {value, value}; }
+		static bounds entire() { return {}; }
+		static bounds empty() { return {std::numeric_limits<double>::infinity(), -std::numeric_limits<double>::infinity()}; }
+
+		[[nodiscard]] bool is_empty() const { return !(lower <= upper); }
+		[[nodiscard]] bool contains(double value) const { return lower <= value && value <= upper; }
+		[[nodiscard]] double width() const { return upper - lower; }
+		[[nodiscard]] double midpoint() const { return std::isfinite(lower) && std::isfinite(upper) ? lower + (upper - lower) / 2 : 0; }
+	};
+
+	inline double round_down(double x) { return std::nextafter(x, -std::numeric_limits<double>::infinity()); }
+	inline double round_up(double x) { return std::nextafter(x, std::numeric_limits<double>::infinity()); }
+
+	inline bounds intersection(const bounds& a, const bounds& b) {
+		return {std::max(a.lower, b.lower), std::min(a.upper, b.upper)};
+	}
+
+	inline bounds operator-(const bounds& a) {
+		return {-a.upper, -a.lower};
+	}
+
+	inline bounds operator+(const bounds& a, const bounds& b) {
+		if (a.is_empty() || b.is_empty()) return bounds::empty();
+		return {round_down(a.lower + b.lower), round_up(a.upper + b.upper)};
+	}
+
+	inline bounds operator-(const bounds& a, const bounds& b) {
+		return a + -b;
+	}
+
+	inline bounds operator*(const bounds& a, const bounds& b) {
+		if (a.is_empty() || b.is_empty()) return bounds::empty();
+		double p[] = {a.lower * b.lower, a.lower * b.upper, a.upper * b.lower, a.upper * b.upper};
+		// 0 * inf : the interval with a zero bound may be as small as wanted, so the product is not bounded
+		if (std::ranges::any_of(p, [](double x) { return std::isnan(x); })) return bounds::entire();
+		return {round_down(std::ranges::min(p)), round_up(std::ranges::max(p))};
+	}
+
+	inline bounds operator/(const bounds& a, const bounds& b) {
+		if (a.is_empty() || b.is_empty() || (b.lower == 0 && b.upper == 0)) return bounds::empty();
+		if (b.contains(0)) return bounds::entire();
+		return a * bounds{round_down(1 / b.upper), round_up(1 / b.lower)};
+	}
+}
+
+#endif
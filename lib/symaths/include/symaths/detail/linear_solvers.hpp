@@ -0,0 +1,92 @@
+/*
+ *	                            _   _
+ *	  ___ _   _ _ __ ___   __ _| |_| |__  ___
+ *	 / __| | | | '_ ` _ \ / _` | __| '_ \/ __|   Symbolic maths for C++
+ *	 \__ \ |_| | | | | | | (_| | |_| | | \__ \   Version : 0.0.1
+ *	 |___/\__, |_| |_| |_|\__,_|\__|_| |_|___/   https://github.com/dgdzd/symaths
+ *		  |___/
+ *
+ * All source code is distributed under the GNU General Public License v2.0.
+ *
+ */
+
+#ifndef LINEAR_SOLVERS_HPP
+#define LINEAR_SOLVERS_HPP
+
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+/*
+ * LU factorizations of square matrices, given by the values of their non-zero entries over a fixed pattern of
+ * (row, column) pairs. Factorizing again a matrix of the same size reuses the memory of the previous one.
+ */
+namespace sym::detail {
+	using sparsity_pattern = std::vector<std::pair<size_t, size_t>>;
+
+	/**
+	 * @brief LU factorization with partial pivoting, on a dense copy of the matrix.
+	 */
+	class dense_lu {
+		size_t m_n = 0;
+		std::vector<double> m_lu;
+		std::vector<size_t> m_pivots;
+
+		bool decompose();
+
+	public:
+		/**
+		 * @return false if the matrix is singular
+		 */
+		bool factorize(size_t n, const sparsity_pattern& pattern, const double* values);
+		/**
+		 * @brief Factorizes a matrix given by its n * n entries, row by row.
+		 */
+		bool factorize(size_t n, const double* matrix);
+		/**
+		 * @brief Solves A x = b in place.
+		 */
+		void solve(double* b) const;
+	};
+
+	/**
+	 * @brief Sparse LU factorization by gaussian elimination on rows stored as sorted lists of entries.
+	 *
+	 * Columns are eliminated by increasing amount of entries. The pivot of a column is the shortest of its rows
+	 * whose entry is at least a tenth of the largest one (threshold partial pivoting), which limits fill-in.
+	 */
+	class sparse_lu {
+		struct entry {
+			size_t column;
+			double value;
+		};
+		struct multiplier {
+			size_t row;
+			double value;
+		};
+
+		size_t m_n = 0;
+		// Rows of U, by their original index
+		std::vector<std::vector<entry>> m_rows;
+		// Rows which had an entry in a column at some point
+		std::vector<std::vector<size_t>> m_column_rows;
+		// Pivot row and column, and multipliers of the other rows, of each elimination step
+		std::vector<size_t> m_pivot_rows;
+		std::vector<size_t> m_pivot_columns;
+		std::vector<std::vector<multiplier>> m_multipliers;
+		std::vector<entry> m_merged;
+		mutable std::vector<double> m_solution;
+
+	public:
+		/**
+		 * @return false if the matrix is singular
+		 */
+		bool factorize(size_t n, const sparsity_pattern& pattern, const double* values);
+		/**
+		 * @brief Solves A x = b in place.
+		 */
+		void solve(double* b) const;
+	};
+}
+
+#endif
@@ -0,0 +1,51 @@
+/*
+ *	                            _   _
+ *	  ___ _   _ _ __ ___   __ _| |_| |__  ___
+ *	 / __| | | | '_ ` _ \ / _` | __| '_ \/ __|   Symbolic maths for C++
+ *	 \__ \ |_| | | | | | | (_| | |_| | | \__ \   Version : 0.0.1
+ *	 |___/\__, |_| |_| |_|\__,_|\__|_| |_|___/   https://github.com/dgdzd/symaths
+ *		  |___/
+ *
+ * All source code is distributed under the GNU General Public License v2.0.
+ *
+ */
+
+#ifndef MAPPED_FILE_HPP
+#define MAPPED_FILE_HPP
+
+#include <cstddef>
+#include <filesystem>
+#include <string>
+#include <string_view>
+
+namespace sym::detail {
+	/**
+	 * @brief Read-only contents of a file, mapped in memory with mmap where it is available. Elsewhere, or when the
+	 * file cannot be mapped, it is read into a string.
+	 */
+	class mapped_file {
+		const char* m_data = nullptr;
+		size_t m_size = 0;
+		bool m_mapped = false;
+		// Contents of the file when it cannot be mapped
+		std::string m_copy;
+
+		void unmap();
+
+	public:
+		/**
+		 * @throws std::runtime_error If the file cannot be opened or read
+		 */
+		explicit mapped_file(const std::filesystem::path& path);
+		~mapped_file();
+
+		mapped_file(const mapped_file&) = delete;
+		mapped_file& operator=(const mapped_file&) = delete;
+		mapped_file(mapped_file&& other) noexcept;
+		mapped_file& operator=(mapped_file&& other) noexcept;
+
+		[[nodiscard]] std::string_view view() const { return {m_data, m_size}; }
+	};
+}
+
+#endif
@@ -16,6 +16,7 @@
 #include "symaths/base_functions.hpp"
 #include "symaths/numbers.hpp"
 
+#include <cstdint>
 #include <deque>
 #include <unordered_map>
 #include <memory>
@@ -27,8 +28,24 @@ namespace sym {
 
 	namespace detail {
 		class node;
+		class node_table;
 	}
 
+	/**
+	 * @brief 128-bit structural hash of an expression.
+	 *
+	 * It only depends on the kinds and values of the nodes, and on the names of the functions, never on addresses or
+	 * registration order : it is the same across runs, processes and platforms.
+	 */
+	struct fingerprint {
+		uint64_t low = 0;
+		uint64_t high = 0;
+
+		bool operator==(const fingerprint&) const = default;
+		// 32 hexadecimal digits, high word first
+		[[nodiscard]] std::string string() const;
+	};
+
 	namespace detail {
 		using Context = std::unordered_map<std::string, number>;
 
@@ -107,6 +124,8 @@ namespace sym {
 
 			internal_data_t p_data;
 			size_t p_hash = 0;
+			// Computed once, from the fingerprints of the children, when the node is interned
+			fingerprint p_fingerprint;
 
 			node() = default;
 			virtual ~node() = default;
@@ -126,6 +145,8 @@ namespace sym {
 
 	struct node_key {
 		detail::node::internal_data_t data;
+		// Fingerprint of a node holding data, which the table is hashed by
+		fingerprint print;
 
 		bool operator==(const node_key& other) const {
 			return data == other.data;
@@ -140,6 +161,9 @@ namespace sym {
 		std::unordered_map<node_key, const detail::node*, node_hash> table;
 		std::vector<std::unique_ptr<detail::node>> arena;
 
+		// Interns serialized nodes as they were
+		friend detail::node_table;
+
 	public:
 		const detail::node* make_symbol(const std::string& name);
 		const detail::node* make_constant(const number& v);
@@ -152,6 +176,15 @@ namespace sym {
 		const detail::node* make_func(uint32_t f_id, const std::vector<const detail::node*>& args);
 		const detail::node* make_func(funcs::builtin_fn_id f_id, const std::vector<const detail::node*>& args);
 
+		/**
+		 * @brief Interns a copy of every node of another manager.
+		 * @return The node of this manager matching each node of the other one
+		 */
+		std::unordered_map<const detail::node*, const detail::node*> import(const node_manager_t& other);
+
+		// Every node, children before their parents
+		[[nodiscard]] std::vector<const detail::node*> nodes() const;
+
 	private:
 		const detail::node* intern(detail::node::internal_data_t data);
 	};
@@ -0,0 +1,87 @@
+/*
+ *	                            _   _
+ *	  ___ _   _ _ __ ___   __ _| |_| |__  ___
+ *	 / __| | | | '_ ` _ \ / _` | __| '_ \/ __|   Symbolic maths for C++
+ *	 \__ \ |_| | | | | | | (_| | |_| | | \__ \   Version : 0.0.1
+ *	 |___/\__, |_| |_| |_|\__,_|\__|_| |_|___/   https://github.com/dgdzd/symaths
+ *		  |___/
+ *
+ * All source code is distributed under the GNU General Public License v2.0.
+ *
+ */
+
+#ifndef POLYNOMIAL_KERNELS_HPP
+#define POLYNOMIAL_KERNELS_HPP
+
+#include "symaths/numbers.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <vector>
+
+/*
+ * Products of dense coefficient arrays, in increasing order of degree.
+ */
+namespace sym::detail {
+	// Below this amount of coefficients in the smallest operand, schoolbook multiplication is the fastest
+	constexpr size_t karatsuba_threshold = 64;
+	// From this amount of coefficients in the smallest operand, FFT (or NTT) multiplication is the fastest
+	constexpr size_t fft_threshold = 512;
+
+	std::vector<double> multiply_schoolbook(const std::vector<double>& a, const std::vector<double>& b);
+	std::vector<double> multiply_karatsuba(const std::vector<double>& a, const std::vector<double>& b);
+	/**
+	 * @brief Multiplies with a complex FFT. Both operands are packed in a single transform (a in the real part and b
+	 * in the imaginary part), so a product costs two transforms.
+	 */
+	std::vector<double> multiply_fft(const std::vector<double>& a, const std::vector<double>& b);
+	/**
+	 * @brief Picks the fastest of the kernels above according to the size of the operands.
+	 */
+	std::vector<double> multiply_dense(const std::vector<double>& a, const std::vector<double>& b);
+
+	/**
+	 * @brief Multiplies integers exactly with number theoretic transforms modulo three primes, recombined by the
+	 * chinese remainder theorem.
+	 *
+	 * @return The product, or nothing when a coefficient of the product could exceed 64 bits
+	 */
+	std::optional<std::vector<long long>> multiply_ntt(const std::vector<long long>& a, const std::vector<long long>& b);
+	/**
+	 * @brief Multiplies exactly. Rational coefficients are scaled to integers and multiplied by NTT, or schoolbook for
+	 * small operands. Other coefficients (or too large integers) are multiplied by schoolbook multiplication on numbers.
+	 */
+	std::vector<number> multiply_dense(const std::vector<number>& a, const std::vector<number>& b);
+
+	/**
+	 * @brief Greatest common divisor of non-zero integer polynomials, from their gcds modulo primes recombined by the
+	 * chinese remainder theorem, until a candidate divides both. Intermediate coefficients never grow, unlike
+	 * pseudo-remainder sequences.
+	 *
+	 * @return The gcd, with coprime coefficients and a positive leading coefficient, or nothing when its coefficients
+	 * do not fit in 64 bits
+	 */
+	std::optional<std::vector<long long>> gcd_modular(const std::vector<long long>& a, const std::vector<long long>& b);
+
+	/**
+	 * @brief Term of a multivariate integer polynomial, with one exponent per variable.
+	 */
+	struct integer_term {
+		std::vector<uint64_t> exponents;
+		long long coefficient;
+	};
+	/**
+	 * @brief Greatest common divisor of non-zero multivariate integer polynomials, by Brown's algorithm : modulo a
+	 * prime, the gcd is interpolated in the last variable from gcds at points of it, found recursively down to
+	 * univariate gcds. The gcds modulo primes are recombined by the chinese remainder theorem until accept takes a
+	 * candidate, which has coprime coefficients.
+	 *
+	 * @return The accepted gcd, or nothing when it takes more than max_work gcds modulo primes or at points, or when
+	 * its coefficients do not fit in 64 bits
+	 */
+	std::optional<std::vector<integer_term>> gcd_modular(const std::vector<integer_term>& a, const std::vector<integer_term>& b, const std::function<bool(const std::vector<integer_term>&)>& accept, size_t max_work);
+}
+
+#endif
@@ -0,0 +1,203 @@
+/*
+ *	                            _   _
+ *	  ___ _   _ _ __ ___   __ _| |_| |__  ___
+ *	 / __| | | | '_ ` _ \ / _` | __| '_ \/ __|   Symbolic maths for C++
+ *	 \__ \ |_| | | | | | | (_| | |_| | | \__ \   Version : 0.0.1
+ *	 |___/\__, |_| |_| |_|\__,_|\__|_| |_|___/   https://github.com/dgdzd/symaths
+ *		  |___/
+ *
+ * All source code is distributed under the GNU General Public License v2.0.
+ *
+ */
+
+#ifndef SPARSE_POLYNOMIAL_HPP
+#define SPARSE_POLYNOMIAL_HPP
+
+#include "symaths/numbers.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+namespace sym {
+	/**
+	 * @brief Orders of the terms of multivariate polynomials, the first variable being the largest.
+	 *
+	 * - lex : by the exponent of the first variable, then of the second...
+	 * - grlex : by total degree, then lex
+	 * - grevlex : by total degree, then the smallest exponent of the last variable, of the one before...
+	 */
+	enum class monomial_order { lex, grlex, grevlex };
+}
+
+namespace sym::detail {
+	class node;
+
+	/**
+	 * @brief Packing of the exponents of monomials over a fixed list of generators.
+	 *
+	 * Every exponent takes the same amount of bits, and several exponents share a 64 bits word, the first generator
+	 * in the most significant bits (the last one for grevlex). Graded orders keep the total degree in a first word.
+	 * Comparing the words compares monomials, and adding them multiplies monomials, as long as no exponent exceeds
+	 * the maximum degree the layout was made for.
+	 */
+	struct monomial_layout {
+		std::vector<const node*> generators;
+		monomial_order order = monomial_order::lex;
+		unsigned int bits = 1;
+		size_t per_word = 64;
+		size_t words = 0;
+
+		monomial_layout(std::vector<const node*> generators, uint64_t max_degree, monomial_order order = monomial_order::lex);
+
+		[[nodiscard]] uint64_t exponent(const uint64_t* monomial, size_t generator) const;
+		void set_exponent(uint64_t* monomial, size_t generator, uint64_t exponent) const;
+		[[nodiscard]] uint64_t max_exponent() const { return bits == 64 ? UINT64_MAX : (1ULL << bits) - 1; }
+
+		/**
+		 * @return A positive number if a is larger than b, negative if smaller, 0 if they are equal
+		 */
+		[[nodiscard]] int compare(const uint64_t* a, const uint64_t* b) const {
+			for (size_t i = 0; i < words; ++i) {
+				if (a[i] != b[i]) {
+					// Past the degree, grevlex prefers smaller exponents
+					bool larger = (a[i] > b[i]) != (order == monomial_order::grevlex && i > 0);
+					return larger ? 1 : -1;
+				}
+			}
+			return 0;
+		}
+	};
+
+	/**
+	 * @brief Polynomial with numeric coefficients over the generators of a layout, which only stores its non-zero terms.
+	 *
+	 * Terms are sorted in decreasing order of their monomials, without like terms. Exact coefficients whose numerator
+	 * or denominator would overflow 64 bits become reals, so the polynomial is no longer exact.
+	 */
+	class sparse_polynomial {
+		const monomial_layout* m_layout;
+		// m_layout->words exponent words per term
+		std::vector<uint64_t> m_monomials;
+		std::vector<number> m_coefficients;
+
+		void push_term(const uint64_t* monomial, const number& coefficient);
+
+	public:
+		explicit sparse_polynomial(const monomial_layout& layout);
+
+		static sparse_polynomial constant(const monomial_layout& layout, const number& value);
+		static sparse_polynomial generator(const monomial_layout& layout, size_t index, uint64_t exponent = 1);
+		/**
+		 * @brief Adds many polynomials at once, by sorting all their terms : O(n log n) for n terms, where adding them
+		 * one by one is quadratic.
+		 */
+		static sparse_polynomial sum(const monomial_layout& layout, const std::vector<const sparse_polynomial*>& operands);
+
+		[[nodiscard]] size_t size() const { return m_coefficients.size(); }
+		[[nodiscard]] bool is_zero() const { return m_coefficients.empty(); }
+		/**
+		 * @brief Whether all coefficients are naturals, integers or rationals.
+		 */
+		[[nodiscard]] bool is_exact() const;
+		[[nodiscard]] uint64_t degree(size_t generator) const;
+		[[nodiscard]] bool is_constant() const;
+		/**
+		 * @brief Coefficients as a polynomial in a generator, by decreasing degree, at most count of them. Generators
+		 * before this one must not appear in the polynomial, so that the terms of each coefficient are contiguous.
+		 */
+		[[nodiscard]] std::vector<sparse_polynomial> coefficients(size_t generator, size_t count = SIZE_MAX) const;
+		[[nodiscard]] const monomial_layout& layout() const { return *m_layout; }
+		[[nodiscard]] const uint64_t* monomial(size_t term) const { return m_monomials.data() + term * m_layout->words; }
+		[[nodiscard]] const number& coefficient(size_t term) const { return m_coefficients[term]; }
+
+		sparse_polynomial operator+(const sparse_polynomial& other) const;
+		sparse_polynomial operator-() const;
+		sparse_polynomial operator*(const sparse_polynomial& other) const;
+
+		/**
+		 * @brief Adds, giving up as soon as the sum has more than max_terms terms.
+		 */
+		[[nodiscard]] std::optional<sparse_polynomial> add(const sparse_polynomial& other, size_t max_terms) const;
+		/**
+		 * @brief Multiplies with a heap merging the rows of the product (Johnson's algorithm), so like terms are
+		 * summed as soon as they are produced, without ever storing the whole cartesian product. Gives up as soon
+		 * as the product has more than max_terms terms : memory stays bounded by max_terms, whatever the amount of
+		 * products of terms.
+		 */
+		[[nodiscard]] std::optional<sparse_polynomial> multiply(const sparse_polynomial& other, size_t max_terms) const;
+		[[nodiscard]] std::optional<sparse_polynomial> pow(unsigned long long n, size_t max_terms) const;
+		[[nodiscard]] sparse_polynomial scaled(const number& factor) const;
+		/**
+		 * @brief The same polynomial over another layout, which has all the generators this one depends on.
+		 */
+		[[nodiscard]] sparse_polynomial repacked(const monomial_layout& layout) const;
+		/**
+		 * @brief Divides exactly, by eliminating leading terms.
+		 *
+		 * @return The quotient, or nothing when divisor does not divide this polynomial
+		 */
+		[[nodiscard]] std::optional<sparse_polynomial> divide(const sparse_polynomial& divisor) const;
+		/**
+		 * @brief The number c for which this polynomial divided by c has coprime integer coefficients and a positive
+		 * leading coefficient. For inexact coefficients, the leading coefficient.
+		 */
+		[[nodiscard]] number content() const;
+
+		/**
+		 * @brief Builds the sum of the terms, in decreasing order of their monomials.
+		 */
+		[[nodiscard]] const node* to_node() const;
+	};
+
+	/**
+	 * @brief Expands a node through sparse polynomials.
+	 *
+	 * Subexpressions which are not polynomials (symbols, function calls, powers with a non natural exponent) are
+	 * the generators, and are kept as is. A subexpression whose polynomial would have more than max_terms terms is
+	 * a generator too, in which only the operands are expanded.
+	 */
+	const node* expand_polynomial(const node* node, size_t max_terms);
+
+	/**
+	 * @brief Bounds the degree of a node, which must be a polynomial of the generators, in one pass over its nodes.
+	 * Symbols which are not generators are appended to them if add_symbols is true.
+	 *
+	 * @throws std::invalid_argument When the node is not a polynomial of the generators. Ground subexpressions which
+	 * are not polynomials (functions, non natural powers) are numbers.
+	 */
+	uint64_t polynomial_degree_bound(const node* root, std::vector<const node*>& generators, bool add_symbols);
+	/**
+	 * @brief Develops a node which is a polynomial of the generators of a layout, in one pass over its nodes.
+	 * Ground subexpressions which are not polynomials are evaluated.
+	 */
+	sparse_polynomial develop_polynomial(const node* root, const monomial_layout& layout);
+
+	/**
+	 * @brief Greatest common divisor, with coprime integer coefficients and a positive leading coefficient. Inexact
+	 * polynomials have no gcd but 1.
+	 *
+	 * Polynomials are mapped to univariate ones by Kronecker substitution, whose gcd is found by a modular algorithm.
+	 * When this fails (too high degrees, or a gcd of the images which is not an image), Brown's modular algorithm is
+	 * used, with a bounded amount of work. Past it, the gcd of the contents in the first generator the polynomials
+	 * depend on (found recursively) is returned : it still divides both, but may not be their greatest divisor.
+	 */
+	sparse_polynomial polynomial_gcd(const sparse_polynomial& a, const sparse_polynomial& b);
+
+	/**
+	 * @brief Greatest common divisor of polynomial nodes, whose generators are found as in expand_polynomial.
+	 */
+	const node* polynomial_gcd(const node* a, const node* b);
+	/**
+	 * @brief Exact quotient of polynomial nodes, or nullptr when divisor does not divide dividend.
+	 */
+	const node* divide_polynomial(const node* dividend, const node* divisor);
+	/**
+	 * @brief Writes a node as a quotient of coprime polynomials, the denominator having coprime integer coefficients
+	 * and a positive leading coefficient.
+	 */
+	const node* cancel_rational(const node* node);
+}
+
+#endif
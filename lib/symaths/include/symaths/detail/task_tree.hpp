@@ -0,0 +1,112 @@
+/*
+ *	                            _   _
+ *	  ___ _   _ _ __ ___   __ _| |_| |__  ___
+ *	 / __| | | | '_ ` _ \ / _` | __| '_ \/ __|   Symbolic maths for C++
+ *	 \__ \ |_| | | | | | | (_| | |_| | | \__ \   Version : 0.0.1
+ *	 |___/\__, |_| |_| |_|\__,_|\__|_| |_|___/   https://github.com/dgdzd/symaths
+ *		  |___/
+ *
+ * All source code is distributed under the GNU General Public License v2.0.
+ *
+ */
+
+#ifndef TASK_TREE_HPP
+#define TASK_TREE_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace sym::detail {
+	/**
+	 * @brief Processes a tree of tasks on several threads, with work stealing.
+	 *
+	 * process(task, worker, push) handles one task, and calls push(child) for each task it spawns. Each worker keeps
+	 * its own deque : it takes its latest tasks first (depth first, so the deque stays short), while idle workers
+	 * steal the oldest tasks of the others, which are the roots of the largest subtrees. Returns once every task is
+	 * processed. The first exception thrown by process stops the workers and is rethrown.
+	 */
+	template <typename Task, typename Process>
+	void run_task_tree(std::vector<Task> roots, size_t threads, Process&& process) {
+		if (threads == 0) {
+			threads = std::max(1u, std::thread::hardware_concurrency());
+		}
+
+		struct queue {
+			std::mutex mutex;
+			std::deque<Task> tasks;
+		};
+		std::vector<queue> queues(threads);
+		for (size_t i = 0; i < roots.size(); ++i) {
+			queues[i % threads].tasks.push_back(std::move(roots[i]));
+		}
+		// Tasks pushed and not yet processed : children are counted before their parent is done
+		std::atomic<size_t> pending = roots.size();
+		std::atomic<bool> stop = false;
+		std::vector<std::exception_ptr> errors(threads);
+
+		auto take = [&](size_t worker, Task& task) {
+			{
+				std::lock_guard lock(queues[worker].mutex);
+				if (!queues[worker].tasks.empty()) {
+					task = std::move(queues[worker].tasks.back());
+					queues[worker].tasks.pop_back();
+					return true;
+				}
+			}
+			for (size_t k = 1; k < threads; ++k) {
+				queue& victim = queues[(worker + k) % threads];
+				std::lock_guard lock(victim.mutex);
+				if (!victim.tasks.empty()) {
+					task = std::move(victim.tasks.front());
+					victim.tasks.pop_front();
+					return true;
+				}
+			}
+			return false;
+		};
+
+		auto work = [&](size_t worker) {
+			try {
+				auto push = [&](Task child) {
+					++pending;
+					std::lock_guard lock(queues[worker].mutex);
+					queues[worker].tasks.push_back(std::move(child));
+				};
+				Task task;
+				while (!stop && pending > 0) {
+					if (!take(worker, task)) {
+						std::this_thread::yield();
+						continue;
+					}
+					process(task, worker, push);
+					--pending;
+				}
+			}
+			catch (...) {
+				errors[worker] = std::current_exception();
+				stop = true;
+			}
+		};
+
+		{
+			std::vector<std::jthread> workers;
+			for (size_t t = 1; t < threads; ++t) {
+				workers.emplace_back(work, t);
+			}
+			work(0);
+		}
+		for (auto& error : errors) {
+			if (error) {
+				std::rethrow_exception(error);
+			}
+		}
+	}
+}
+
+#endif
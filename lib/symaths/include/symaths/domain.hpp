@@ -0,0 +1,86 @@
+/*
+ *	                            _   _
+ *	  ___ _   _ _ __ ___   __ _| |_| |__  ___
+ *	 / __| | | | '_ ` _ \ / _` | __| '_ \/ __|   Symbolic maths for C++
+ *	 \__ \ |_| | | | | | | (_| | |_| | | \__ \   Version : 0.0.1
+ *	 |___/\__, |_| |_| |_|\__,_|\__|_| |_|___/   https://github.com/dgdzd/symaths
+ *		  |___/
+ *
+ * All source code is distributed under the GNU General Public License v2.0.
+ *
+ */
+
+#ifndef DOMAIN_HPP
+#define DOMAIN_HPP
+
+#include <limits>
+#include <unordered_map>
+#include <vector>
+
+namespace sym {
+	class expression;
+	class symbol;
+	namespace detail {
+		class node;
+	}
+
+	/**
+	 * @brief Numeric range of the values an expression can take.
+	 *
+	 * Unlike sym::interval, bounds are plain doubles : this is what static analysis works on.
+	 * Infinite bounds are always open.
+	 */
+	struct domain {
+		double lower = -std::numeric_limits<double>::infinity();
+		double upper = std::numeric_limits<double>::infinity();
+		bool lower_open = true;
+		bool upper_open = true;
+
+		static domain real();
+		static domain positive();
+		static domain non_negative();
+		static domain negative();
+		static domain non_positive();
+		static domain point(double value);
+		static domain between(double lower, double upper, bool lower_open = false, bool upper_open = false);
+
+		[[nodiscard]] bool contains(double value) const;
+		[[nodiscard]] bool is_positive() const;
+		[[nodiscard]] bool is_negative() const;
+		[[nodiscard]] bool is_non_negative() const;
+		[[nodiscard]] bool excludes_zero() const;
+
+		bool operator==(const domain&) const = default;
+	};
+
+	/**
+	 * @brief Box of several variables : the range of each one, in order.
+	 */
+	using box = std::vector<domain>;
+
+	/**
+	 * @brief Declares the values a symbol can take in the current context.
+	 *
+	 * For example, assume(x, domain::positive()) declares x > 0.
+	 */
+	void assume(const symbol& symbol, const domain& d);
+
+	/**
+	 * @brief Computes a range containing every value of the expression, using the declared symbol domains.
+	 *
+	 * The result is conservative : it may be wider than the true range, never narrower.
+	 * For example, with x > 0 :
+	 * - infer_domain(x + 1) = ]1;+∞[
+	 * - infer_domain(sqrt(x) * 2) = ]0;+∞[
+	 * - infer_domain(sin(x)) = [-1;1]
+	 */
+	domain infer_domain(const expression& expr);
+
+	namespace detail {
+		using domain_cache_t = std::unordered_map<const node*, domain>;
+
+		domain infer_domain(const node* node, domain_cache_t& cache);
+	}
+}
+
+#endif
@@ -14,8 +14,31 @@
 #define EQUATION_HPP
 
 #include "symaths/expression.hpp"
+#include "symaths/symbol.hpp"
+
+#include <cstddef>
+#include <vector>
 
 namespace sym {
+	/**
+	 * @brief Settings of the numeric solver, used when an equation is not a polynomial of degree at most 2.
+	 */
+	struct solve_options {
+		// Starting points are evenly spread over [lower, upper], and only roots in it are kept
+		double lower = -100;
+		double upper = 100;
+		size_t starts = 4096;
+		// 0 for one thread per core
+		size_t threads = 0;
+		size_t max_iterations = 100;
+		// A start converges when its step is below tolerance, relative to the root
+		double tolerance = 1e-12;
+		// Largest |left - right| at a root, which rules out poles the iterations may stall at
+		double residual = 1e-9;
+		// Roots closer than this, relative to their magnitude, are the same root
+		double merge_tolerance = 1e-8;
+	};
+
 	class equation {
 		expression m_left;
 		expression m_right;
@@ -28,10 +51,26 @@ namespace sym {
 		const expression& right() const { return m_right; }
 		expression& right() { return m_right; }
 
-		std::vector<const symbol&> unknowns();
-		bool is_solvable();
+		/**
+		 * @brief Symbols of both sides, in order of appearance.
+		 */
+		[[nodiscard]] std::vector<symbol> unknowns() const;
+		/**
+		 * @brief Whether solve can handle this equation, i.e. it has a single unknown.
+		 */
+		[[nodiscard]] bool is_solvable() const;
 
-		std::vector<expression> solve() const;
+		/**
+		 * @brief Finds the real solutions of an equation in one unknown, in increasing order.
+		 *
+		 * Polynomials of degree 1 or 2 are solved exactly, and polynomials of higher degree with find_roots. Other
+		 * equations are solved numerically : left - right and its first two derivatives are compiled, then Halley's
+		 * method runs from many starting points at once, in blocks shared by several threads. Roots found several
+		 * times are merged.
+		 *
+		 * @throws std::invalid_argument If the equation does not have exactly one unknown, or holds for every value
+		 */
+		[[nodiscard]] std::vector<expression> solve(const solve_options& options = {}) const;
 	};
 }
 
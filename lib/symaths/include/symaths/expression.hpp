@@ -54,6 +54,60 @@ namespace sym {
 	expression operator*(const expression& lhs, const expression& rhs);
 	expression operator/(const expression& lhs, const expression& rhs);
 	expression operator-(const expression& e);
+
+	/**
+	 * @brief Accumulates the terms of a sum and interns it once.
+	 *
+	 * Chaining operator+ flattens and interns a new sum for each term, so n terms cost O(n²) and leave n - 1
+	 * intermediate sums in the library.
+	 */
+	class sum_builder {
+		std::vector<const detail::node*> m_operands;
+
+	public:
+		explicit sum_builder(size_t capacity = 0) { m_operands.reserve(capacity); }
+
+		// Sums are added term by term
+		sum_builder& add(const expression& term);
+		sum_builder& subtract(const expression& term);
+		sum_builder& operator+=(const expression& term) { return add(term); }
+		sum_builder& operator-=(const expression& term) { return subtract(term); }
+
+		void reserve(size_t capacity) { m_operands.reserve(capacity); }
+		[[nodiscard]] size_t size() const { return m_operands.size(); }
+		void clear() { m_operands.clear(); }
+
+		/**
+		 * @return The sum of the terms, the term itself if there is one, 0 if there is none
+		 */
+		[[nodiscard]] expression build() const;
+	};
+
+	/**
+	 * @brief Accumulates the factors of a product and interns it once (see sum_builder).
+	 */
+	class product_builder {
+		std::vector<const detail::node*> m_operands;
+
+	public:
+		explicit product_builder(size_t capacity = 0) { m_operands.reserve(capacity); }
+
+		// Products are multiplied factor by factor
+		product_builder& multiply(const expression& factor);
+		// Multiplies by factor^(-1), as operator/ does
+		product_builder& divide(const expression& factor);
+		product_builder& operator*=(const expression& factor) { return multiply(factor); }
+		product_builder& operator/=(const expression& factor) { return divide(factor); }
+
+		void reserve(size_t capacity) { m_operands.reserve(capacity); }
+		[[nodiscard]] size_t size() const { return m_operands.size(); }
+		void clear() { m_operands.clear(); }
+
+		/**
+		 * @return The product of the factors, the factor itself if there is one, 1 if there is none
+		 */
+		[[nodiscard]] expression build() const;
+	};
 }
 
 #endif
@@ -15,8 +15,12 @@
 
 #include "symaths/numbers.hpp"
 
+#include <chrono>
+#include <cstddef>
+
 namespace sym {
 	class expression;
+	struct fingerprint;
 	namespace detail {
 		class node;
 	}
@@ -36,9 +40,89 @@ namespace sym {
 	 * @return The simplified expression
 	 */
 	expression reduce(const expression& expr);
+
+	/**
+	 * @brief Limits of the search done by simplify.
+	 */
+	struct simplify_budget {
+		// Maximum amount of distinct nodes in the e-graph
+		size_t max_nodes = 20000;
+		// Maximum amount of rewriting passes over the e-graph
+		size_t max_iterations = 30;
+		std::chrono::milliseconds timeout{100};
+	};
+
+	/**
+	 * @brief Searches for the cheapest expression equivalent to expr, by equality saturation.
+	 *
+	 * Every equivalent form found by the rewrite rules is kept in an e-graph, so no rule can hide a simpler
+	 * form from another one. Rules cover like terms and powers, exp/ln, sqrt/abs, parity and the Pythagorean
+	 * identity of trigonometric functions, and factoring. Rules which are only valid on a part of the real line
+	 * (exp(ln(x)) = x, sqrt(x)^2 = x, ...) are only applied when infer_domain proves it.
+	 * Once the budget is exhausted, the cheapest form according to the evaluation cost model is extracted.
+	 *
+	 * For example :
+	 * - simplify(sin(x)^2 + cos(x)^2) = 1
+	 * - simplify(x^3 / x + 2x^2) = 3x^2
+	 * - simplify(ln(exp(x + 1))) = x + 1
+	 *
+	 * @param expr The expression to simplify
+	 * @param budget Limits of the search
+	 * @return The simplest equivalent expression found
+	 */
+	expression simplify(const expression& expr, const simplify_budget& budget = {});
 	expression sort(const expression& expr);
 	expression expand(const expression& expr);
-	//size_t hash(const expression& expr);
+
+	/**
+	 * @brief Develops products and natural powers of sums, merging like terms as they are produced.
+	 *
+	 * Memory stays bounded by max_terms : a subexpression which would have more terms is left partially expanded,
+	 * only its operands being developed. For example, with max_terms = 5, (x+1)^9 (y+1) is expanded to
+	 * (x+1)^9 y + (x+1)^9. So is a subexpression whose exact coefficients would overflow 64 bits, as (x+1)^70.
+	 * expand(expr) uses refactoring_rules().max_expansion_terms.
+	 *
+	 * @param expr The expression to expand
+	 * @param max_terms Maximum amount of terms of a developed subexpression
+	 * @return The expanded expression
+	 */
+	expression expand(const expression& expr, size_t max_terms);
+
+	/**
+	 * @brief Greatest common divisor of polynomials in any amount of variables, with coprime integer coefficients and
+	 * a positive leading coefficient. Subexpressions which are not polynomials (functions, non natural powers) are
+	 * taken as variables. Polynomials with inexact (real) coefficients have no common divisor but 1.
+	 *
+	 * For example, polynomial_gcd(x^2 - 1, 2x^2 + 4x + 2) = x + 1.
+	 */
+	expression polynomial_gcd(const expression& a, const expression& b);
+
+	/**
+	 * @brief Divides polynomials exactly.
+	 *
+	 * @throws std::invalid_argument When divisor does not divide dividend
+	 */
+	expression divide_exact(const expression& dividend, const expression& divisor);
+
+	/**
+	 * @brief Reduces a rational function to lowest terms : it is put over a common denominator, and the common divisor
+	 * of the numerator and the denominator is cancelled. Arguments of functions are cancelled too.
+	 *
+	 * For example :
+	 * - cancel((x^2 - 1) / (x - 1)) = x + 1
+	 * - cancel(1 / x + 1 / (x^2 + x)) = (x + 2) / (x^2 + x)
+	 *
+	 * @param expr The expression to cancel
+	 * @return The quotient of expanded coprime polynomials
+	 */
+	expression cancel(const expression& expr);
+
+	/**
+	 * @brief Structural fingerprint of an expression, stable across runs, processes and platforms (see fingerprint).
+	 *
+	 * Each node computes its own once, when it is created, so this does not traverse the expression.
+	 */
+	fingerprint hash(const expression& expr);
 
 	namespace detail {
 		struct term {
@@ -0,0 +1,63 @@
+/*
+ *	                            _   _
+ *	  ___ _   _ _ __ ___   __ _| |_| |__  ___
+ *	 / __| | | | '_ ` _ \ / _` | __| '_ \/ __|   Symbolic maths for C++
+ *	 \__ \ |_| | | | | | | (_| | |_| | | \__ \   Version : 0.0.1
+ *	 |___/\__, |_| |_| |_|\__,_|\__|_| |_|___/   https://github.com/dgdzd/symaths
+ *		  |___/
+ *
+ * All source code is distributed under the GNU General Public License v2.0.
+ *
+ */
+
+#ifndef INTEGRATION_HPP
+#define INTEGRATION_HPP
+
+#include "symaths/domain.hpp"
+#include "symaths/expression.hpp"
+#include "symaths/symbol.hpp"
+
+#include <cstddef>
+#include <vector>
+
+namespace sym {
+	struct integration_options {
+		// Subdivision stops once the estimated error is below max(absolute_tolerance, tolerance * |value|)
+		double tolerance = 1e-10;
+		double absolute_tolerance = 0;
+		// Evaluations of the integrand after which subdivision stops, even if the error is too large
+		size_t max_evaluations = 10'000'000;
+		// 0 for one thread per core
+		size_t threads = 0;
+	};
+
+	struct integration_result {
+		double value = 0;
+		// Estimated absolute error
+		double error = 0;
+		size_t evaluations = 0;
+		// The error is within the tolerance
+		bool converged = false;
+	};
+
+	/**
+	 * @brief Integrates f over [a;b] (which may be infinite) with adaptive Gauss-Kronrod quadrature (7-15 points).
+	 *
+	 * The expression is compiled, and every subinterval split in a round is evaluated in one batch : intervals are
+	 * split in bulk, those with the largest errors first, and the batch is shared between threads.
+	 */
+	integration_result integrate(const expression& f, const symbol& variable, double a, double b, double tolerance = 1e-10);
+	integration_result integrate(const expression& f, const symbol& variable, double a, double b, const integration_options& options);
+	/**
+	 * @brief Integrates f over a box of several variables, whose bounds may be infinite.
+	 *
+	 * Boxes are integrated with the degree 7 rule of Genz and Malik, whose embedded degree 5 rule estimates the
+	 * error, and split in half along the variable in which f has the largest fourth difference. It needs
+	 * 2^n + 2n^2 + 2n + 1 points per box : beyond a few variables, Monte-Carlo methods are better suited.
+	 *
+	 * @throws std::invalid_argument If the region is not a box of the variables, or has more than 20 of them
+	 */
+	integration_result integrate(const expression& f, const std::vector<symbol>& variables, const box& region, const integration_options& options = {});
+}
+
+#endif
@@ -81,6 +81,8 @@ namespace sym {
 
 		void downcast();
 		std::string string() const;
+		// Appends the text of string() to out
+		void append_to(std::string& out) const;
 
 		bool operator==(const number& rhs) const;
 		operator std::string() const;
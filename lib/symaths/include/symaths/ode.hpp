@@ -0,0 +1,111 @@
+/*
+ *	                            _   _
+ *	  ___ _   _ _ __ ___   __ _| |_| |__  ___
+ *	 / __| | | | '_ ` _ \ / _` | __| '_ \/ __|   Symbolic maths for C++
+ *	 \__ \ |_| | | | | | | (_| | |_| | | \__ \   Version : 0.0.1
+ *	 |___/\__, |_| |_| |_|\__,_|\__|_| |_|___/   https://github.com/dgdzd/symaths
+ *		  |___/
+ *
+ * All source code is distributed under the GNU General Public License v2.0.
+ *
+ */
+
+#ifndef ODE_HPP
+#define ODE_HPP
+
+#include "symaths/expression.hpp"
+#include "symaths/symbol.hpp"
+#include "symaths/detail/linear_solvers.hpp"
+#include "symaths/parsing/compiler.hpp"
+
+#include <cstddef>
+#include <vector>
+
+namespace sym {
+	enum class ode_method {
+		// Explicit Runge-Kutta 5(4) method of Dormand and Prince
+		dormand_prince,
+		// Linearly implicit Rosenbrock 2(3) method of Shampine (ode23s), for stiff systems. It is L-stable, and solves
+		// one linear system with the Jacobian per stage instead of a nonlinear one.
+		rosenbrock,
+	};
+
+	enum class ode_status {
+		success,
+		too_many_steps,
+		// The step size underflowed, which happens near singularities of the solution
+		step_too_small,
+	};
+
+	struct ode_options {
+		ode_method method = ode_method::dormand_prince;
+		// Each step keeps its local error on every component below absolute_tolerance + relative_tolerance * |y|
+		double relative_tolerance = 1e-8;
+		double absolute_tolerance = 1e-10;
+		// 0 to estimate it from the derivatives at the initial time
+		double initial_step = 0;
+		// Accepted steps per trajectory
+		size_t max_steps = 100'000;
+		// 0 for one thread per core
+		size_t threads = 0;
+	};
+
+	struct ode_result {
+		size_t trajectories = 0;
+		size_t dimension = 0;
+		// Component i of trajectory j at the k-th output time is states[(k * trajectories + j) * dimension + i]. It is
+		// NaN after a trajectory failed.
+		std::vector<double> states;
+		std::vector<ode_status> status;
+		// Accepted and rejected steps of each trajectory
+		std::vector<size_t> steps;
+		std::vector<size_t> rejected;
+
+		[[nodiscard]] double state(size_t time, size_t trajectory, size_t component) const {
+			return states[(time * trajectories + trajectory) * dimension + component];
+		}
+	};
+
+	/**
+	 * @brief System of ordinary differential equations y' = f(t, y, p), whose right-hand sides are expressions of the
+	 * time, of the states and of parameters.
+	 *
+	 * The right-hand sides are compiled once, along with their Jacobian and their derivatives in time (for implicit
+	 * methods). Trajectories are integrated in blocks whose lanes are stepped in lockstep : each stage evaluates the
+	 * whole block with one batch call, while every lane keeps its own step size. Blocks are shared between threads.
+	 */
+	class ode_system {
+		std::vector<expression> m_rhs;
+		std::vector<symbol> m_states;
+		symbol m_time;
+		std::vector<symbol> m_parameters;
+		detail::sparsity_pattern m_jacobian_pattern;
+		compiled_vector_expression m_rhs_program;
+		// Right-hand sides, the non-zero entries of the Jacobian, then the derivatives in time
+		compiled_vector_expression m_rosenbrock_program;
+
+	public:
+		/**
+		 * @throws std::invalid_argument If there is not one right-hand side per state, or they depend on other symbols
+		 */
+		ode_system(std::vector<expression> rhs, std::vector<symbol> states, symbol time, std::vector<symbol> parameters = {});
+
+		[[nodiscard]] size_t dimension() const { return m_states.size(); }
+		[[nodiscard]] const std::vector<symbol>& states() const { return m_states; }
+		[[nodiscard]] const std::vector<symbol>& parameters() const { return m_parameters; }
+		// (equation, state) pairs of the non-zero entries of the Jacobian
+		[[nodiscard]] const detail::sparsity_pattern& jacobian_pattern() const { return m_jacobian_pattern; }
+
+		/**
+		 * @brief Integrates trajectories, and gives their states at each of the output times.
+		 *
+		 * @param times Output times, sorted in increasing or decreasing order. Trajectories start at times[0].
+		 * @param initial_states The dimension() initial states of each trajectory, one trajectory after the other
+		 * @param parameters Values of the parameters : one set shared by every trajectory, or one set per trajectory
+		 * @throws std::invalid_argument If the sizes do not match, or the times are not sorted
+		 */
+		ode_result solve(const std::vector<double>& times, const std::vector<double>& initial_states, const std::vector<double>& parameters = {}, const ode_options& options = {}) const;
+	};
+}
+
+#endif
@@ -0,0 +1,40 @@
+/*
+ *	                            _   _
+ *	  ___ _   _ _ __ ___   __ _| |_| |__  ___
+ *	 / __| | | | '_ ` _ \ / _` | __| '_ \/ __|   Symbolic maths for C++
+ *	 \__ \ |_| | | | | | | (_| | |_| | | \__ \   Version : 0.0.1
+ *	 |___/\__, |_| |_| |_|\__,_|\__|_| |_|___/   https://github.com/dgdzd/symaths
+ *		  |___/
+ *
+ * All source code is distributed under the GNU General Public License v2.0.
+ *
+ */
+
+#ifndef OPTIMIZATION_HPP
+#define OPTIMIZATION_HPP
+
+namespace sym {
+	class expression;
+
+	/**
+	 * @brief Estimates the cost of evaluating a compiled expression once.
+	 *
+	 * The estimate is the sum of detail::instruction_cost over the program compiled_expression would run.
+	 */
+	double estimate_cost(const expression& expr);
+
+	/**
+	 * @brief Rewrites an expression into an equivalent one which is cheaper to evaluate.
+	 *
+	 * Rewrites are only kept when they lower estimate_cost. They are :
+	 * - factoring common multiplicands : ab + ac = a(b + c), which gives the Horner form of polynomials
+	 * - grouping reciprocals : a * b^(-1) * c^(-2) = a * (bc^2)^(-1)
+	 * - fusing exponentials : exp(a) * exp(b) = exp(a + b)
+	 *
+	 * Integer powers are not rewritten : the compiler evaluates them by repeated squaring.
+	 * The result is meant for evaluation, not for display : it is neither reduced nor sorted.
+	 */
+	expression optimize_for_eval(const expression& expr);
+}
+
+#endif
@@ -13,27 +13,170 @@
 #ifndef COMPILE_HPP
 #define COMPILE_HPP
 
+#include "symaths/base_functions.hpp"
+#include "symaths/detail/bounds.hpp"
+#include "symaths/expression.hpp"
+#include "symaths/symbol.hpp"
+
+#include <cstdint>
+#include <string>
+#include <string_view>
 #include <vector>
 
 namespace sym {
 	namespace detail {
+		/*
+		 * Guarded opcodes (div, ln, log10, sqrt) check their operand and produce NaN outside of the
+		 * function's domain. The *_fast variants skip the check : the compiler only emits them when
+		 * domain inference proves the operand is always valid.
+		 *
+		 * powi raises to a constant integer power by repeated squaring.
+		 *
+		 * store copies the top of the stack to a temporary and load pushes it back, so that shared subexpressions
+		 * are evaluated once. pop_out pops the top of the stack into an output. Only programs of
+		 * compiled_vector_expression use them.
+		 */
 		enum opcode : uint8_t {
 			push_cst, push_var, call_fun,
 			neg, add, sub, mul, div, pow,
+			powi,
+			div_fast,
+			ln, ln_fast,
+			log10, log10_fast,
+			sqrt, sqrt_fast,
+			store, load, pop_out,
 		};
 
 		struct instruction {
 			opcode op;
+			uint8_t argc = 0;
 			union {
 				double val;
+				// Also the index of the temporary or of the output
 				size_t var_id;
-				double (*fn)(const double*);
+				long long exponent;
+				// Function called by call_fun
+				const builtin_func_descriptor* func;
 			};
 		};
+
+		// Integer powers above this are left to std::pow
+		constexpr long long max_powi_exponent = 64;
+
+		/**
+		 * @brief Appends instructions to a program, keeping track of the depth of the stack.
+		 */
+		struct program_builder {
+			std::vector<instruction>& program;
+			size_t depth = 0;
+			size_t max_depth = 0;
+
+			void emit_slot(opcode op, size_t slot, int stack_effect);
+			void emit(opcode op, int stack_effect);
+			void emit_constant(double val);
+			void emit_variable(size_t id);
+			void emit_powi(long long exponent);
+			void emit_call(const builtin_func_descriptor* func, size_t argc);
+			void move_stack(int stack_effect);
+		};
+
+		/**
+		 * @brief Estimated cost of an instruction, in floating-point additions.
+		 */
+		double instruction_cost(const instruction& ins);
+
+		/**
+		 * @brief Cost of a builtin function call (guards excluded).
+		 */
+		double function_cost(funcs::builtin_fn_id id);
+
+		// Recognizes constants, including negated ones (the parser emits -1 as a negation)
+		bool numeric_constant(const node* node, double& value);
 	}
 
+	/**
+	 * @brief Expression compiled into a flat stack program, evaluated on doubles.
+	 *
+	 * Variables are given by position : values[i] (or columns[i] in batch mode) is the value of variables[i].
+	 */
 	class compiled_expression {
+		std::vector<detail::instruction> m_program;
+		size_t m_stack_size = 0;
+		size_t m_variables_count = 0;
+
+		friend compiled_expression parse_compiled(std::string_view input, const std::vector<std::string>& variables);
+		friend class mapped_expressions;
+
+	public:
+		// Amount of points evaluated together by eval_batch
+		static constexpr size_t batch_size = 128;
+
+		compiled_expression() = default;
+		compiled_expression(const expression& expr, const std::vector<symbol>& variables);
+
+		[[nodiscard]] double operator()(const double* values) const;
+		[[nodiscard]] double operator()(const std::vector<double>& values) const;
+
+		/**
+		 * @brief Evaluates the expression on count points.
+		 *
+		 * @param columns One array of count values per variable
+		 * @param out Array receiving the count results
+		 * @param count Amount of points
+		 */
+		void eval_batch(const double* const* columns, double* out, size_t count) const;
+
+		[[nodiscard]] const std::vector<detail::instruction>& program() const { return m_program; }
+
+		/**
+		 * @brief Counts the domain checks left in the program, i.e. those which could not be proven useless.
+		 */
+		[[nodiscard]] size_t guards() const;
+
+		/**
+		 * @brief Estimated cost of one evaluation, as the sum of detail::instruction_cost over the program.
+		 */
+		[[nodiscard]] double cost() const;
+	};
+
+	/**
+	 * @brief Several expressions compiled into a single program. Subexpressions shared by several expressions (or
+	 * appearing several times in one) are evaluated once, and kept in temporaries.
+	 */
+	class compiled_vector_expression {
+		std::vector<detail::instruction> m_program;
+		size_t m_stack_size = 0;
+		size_t m_temporaries = 0;
+		size_t m_outputs = 0;
+
+	public:
+		compiled_vector_expression() = default;
+		compiled_vector_expression(const std::vector<expression>& exprs, const std::vector<symbol>& variables);
+
+		// Amount of expressions
+		[[nodiscard]] size_t size() const { return m_outputs; }
+
+		/**
+		 * @brief Evaluates every expression at a point : out[i] is the value of the i-th expression.
+		 *
+		 * @param workspace Scratch memory, which keeps its capacity from one call to the next
+		 */
+		void operator()(const double* values, double* out, std::vector<double>& workspace) const;
+		void operator()(const double* values, double* out) const;
+
+		/**
+		 * @brief Evaluates every expression on count points : out[i] receives the count values of the i-th expression.
+		 */
+		void eval_batch(const double* const* columns, double* const* out, size_t count) const;
+
+		/**
+		 * @brief Evaluates every expression over a box with interval arithmetic : out[i] contains every value the
+		 * i-th expression takes when each variable is within its bounds. It is empty when the expression is nowhere
+		 * defined on the box.
+		 */
+		void eval_bounds(const detail::bounds* values, detail::bounds* out, std::vector<detail::bounds>& workspace) const;
 
+		[[nodiscard]] const std::vector<detail::instruction>& program() const { return m_program; }
 	};
 }
 
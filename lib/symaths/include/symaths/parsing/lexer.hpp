@@ -15,9 +15,16 @@
 
 #include <cstdint>
 #include <string>
+#include <string_view>
 #include <vector>
 
 namespace sym {
+	/**
+	 * @brief Splits an expression into tokens.
+	 *
+	 * Tokens do not copy the input : they refer to it by position, so it must outlive the use of the tokens (see
+	 * text()). Number literals are converted once, while tokenizing.
+	 */
 	class lexer {
 		friend class parser;
 	public:
@@ -42,18 +49,33 @@ namespace sym {
 		};
 		struct token {
 			token_type type = NONE;
-			std::string value;
+			uint32_t offset = 0;
+			uint32_t length = 0;
+			// Value of a number
+			double value = 0;
 		};
 
 	private:
+		std::string_view m_input;
 		std::vector<token> m_tokens;
 
 	public:
 		lexer() = default;
 
-		void tokenize(std::string input);
+		/**
+		 * @brief Splits the input into tokens. The lexer keeps a view of the input, which must outlive it, or the next
+		 * call to tokenize : input() and text() read it.
+		 *
+		 * @throws std::length_error If the input does not fit 32-bit offsets
+		 */
+		void tokenize(std::string_view input);
+		void tokenize(const char* input) { tokenize(std::string_view(input)); }
+		// A temporary string would be destroyed while the lexer still refers to it
+		void tokenize(std::string&&) = delete;
 		[[nodiscard]] const std::vector<token>& tokens() const;
 		[[nodiscard]] std::vector<token>& tokens();
+		[[nodiscard]] std::string_view input() const { return m_input; }
+		[[nodiscard]] std::string_view text(const token& t) const { return m_input.substr(t.offset, t.length); }
 	};
 
 	std::string get_token_type_str(lexer::token_type type);
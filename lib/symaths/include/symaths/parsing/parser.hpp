@@ -14,8 +14,11 @@
 #define PARSER_HPP
 
 #include "symaths/expression.hpp"
+#include "symaths/parsing/compiler.hpp"
 #include "symaths/parsing/lexer.hpp"
 
+#include <filesystem>
+
 namespace sym {
 	namespace detail {
 		class node;
@@ -35,30 +38,96 @@ namespace sym {
 		};
 
 		parser() = default;
-		explicit parser(const lexer& lexer) : m_tokens(lexer.m_tokens) {}
-		explicit parser(lexer&& lexer) : m_tokens(std::move(lexer.m_tokens)) {}
+		// The input of the lexer must outlive the parser
+		explicit parser(const lexer& lexer) : m_input(lexer.m_input), m_tokens(lexer.m_tokens) {}
+		explicit parser(lexer&& lexer) : m_input(lexer.m_input), m_tokens(std::move(lexer.m_tokens)) {}
+		// Creates the nodes in the given manager instead of the one of the current library
+		parser(const lexer& lexer, node_manager_t& nodes) : m_input(lexer.m_input), m_tokens(lexer.m_tokens), m_node_manager(&nodes) {}
+		/*
+		 * Emits instructions evaluating the expression instead of creating nodes : variables[i] is pushed as the i-th
+		 * variable, and the nodes returned by parse() only tell whether parsing succeeded.
+		 */
+		parser(const lexer& lexer, detail::program_builder& program, const std::vector<std::string>& variables)
+			: m_input(lexer.m_input), m_tokens(lexer.m_tokens), m_program(&program), m_variables(&variables) {}
 
 		[[nodiscard]] bool has_tokens() const;
 		[[nodiscard]] const lexer::token& current_token() const;
 		const lexer::token& advance();
 
 		const detail::node* parse(int precedence_limit);
+		[[nodiscard]] const std::vector<error>& errors() const { return m_errors; }
 
 	private:
+		std::string_view m_input;
 		std::vector<lexer::token> m_tokens;
 		std::vector<error> m_errors;
 		size_t m_index = 0;
+		node_manager_t* m_node_manager = nullptr;
+		detail::program_builder* m_program = nullptr;
+		const std::vector<std::string>* m_variables = nullptr;
+
+		[[nodiscard]] node_manager_t& node_manager() const;
+		const detail::node* make_constant(double value);
+		const detail::node* make_variable(std::string_view name);
+		const detail::node* make_negation(const detail::node* n);
+		const detail::node* make_operation(lexer::token_type op, const detail::node* left, const detail::node* right);
+		// base_start is the index of the first instruction of the base, when parsing into a program
+		const detail::node* make_power(const detail::node* base, const detail::node* exponent, size_t base_start);
+		const detail::node* make_call(uint32_t id, const std::vector<const detail::node*>& args);
 
 		const detail::node* parse_expression(int precedence_limit);
 		const detail::node* parse_prefix(const lexer::token& prefix);
-		const detail::node* parse_infix(const detail::node* left, const lexer::token& infix);
+		const detail::node* parse_infix(const detail::node* left, const lexer::token& infix, size_t left_start);
 		std::vector<const detail::node*> parse_func_call();
 		bool consume(lexer::token_type type);
 		bool expect_next(lexer::token_type type);
+		[[nodiscard]] std::string_view text(const lexer::token& t) const { return m_input.substr(t.offset, t.length); }
 	};
 
 	expression parse(const lexer& lexer);
 	expression parse(const std::string& input);
+
+	struct line_error {
+		// Starting from 1
+		size_t line;
+		std::string desc;
+	};
+
+	struct parse_many_result {
+		// Expressions of the lines which were parsed, in the order of the input
+		std::vector<expression> expressions;
+		// Line of each expression, starting from 1
+		std::vector<size_t> lines;
+		// Lines which could not be parsed, in the order of the input
+		std::vector<line_error> errors;
+	};
+
+	/**
+	 * @brief Parses one expression per line into the current library.
+	 *
+	 * Blocks of lines are parsed on several threads, each one interning its nodes in a manager of its own which is
+	 * merged into the library at the end. Blank lines are skipped.
+	 *
+	 * @param threads Amount of threads, 0 to use all the available ones
+	 */
+	parse_many_result parse_many(std::string_view input, size_t threads = 0);
+
+	/**
+	 * @brief Parses a file holding one expression per line into the current library (see parse_many). The file is
+	 * mapped in memory where possible.
+	 * @throws std::runtime_error If the file cannot be read
+	 */
+	parse_many_result parse_file(const std::filesystem::path& path, size_t threads = 0);
+
+	/**
+	 * @brief Parses an expression straight into a compiled program, without creating any node in the library.
+	 *
+	 * Domain checks are all kept, as nothing is known about the operands.
+	 *
+	 * @param variables Names of the variables, by position (see compiled_expression)
+	 * @throws std::invalid_argument If the expression cannot be parsed or uses another variable
+	 */
+	compiled_expression parse_compiled(std::string_view input, const std::vector<std::string>& variables);
 }
 
 #endif
@@ -13,8 +13,12 @@
 #ifndef POLYNOMIAL_HPP
 #define POLYNOMIAL_HPP
 
+#include <complex>
 #include <map>
+#include <memory>
+#include <vector>
 
+#include "symaths/detail/sparse_polynomial.hpp"
 #include "symaths/expression.hpp"
 #include "symaths/symbol.hpp"
 
@@ -31,6 +35,145 @@ namespace sym {
 
 		unsigned long long get_degree() const;
 	};
+
+	/**
+	 * @brief Multiplies polynomials of the same variable. With ground coefficients, the product is exact and uses
+	 * the fastest multiplication of dense_polynomial for its degree.
+	 */
+	polynomial operator*(const polynomial& lhs, const polynomial& rhs);
+
+	/**
+	 * @brief Univariate polynomial with numeric coefficients, stored densely in increasing order of degree.
+	 *
+	 * dense_polynomial<double> evaluates fast, and dense_polynomial<number> keeps exact (rational) coefficients.
+	 */
+	template<typename T>
+	class dense_polynomial {
+	public:
+		// Coefficient of x^k at index k
+		std::vector<T> coeffs;
+
+		dense_polynomial() = default;
+		explicit dense_polynomial(std::vector<T> coeffs) : coeffs(std::move(coeffs)) {}
+		/**
+		 * @brief Evaluates the coefficients of a polynomial, which must be ground.
+		 */
+		explicit dense_polynomial(const polynomial& p);
+
+		[[nodiscard]] size_t degree() const { return coeffs.empty() ? 0 : coeffs.size() - 1; }
+
+		/**
+		 * @brief Evaluates at one point, with Estrin's scheme for high degrees (shorter dependency chains than Horner's).
+		 */
+		[[nodiscard]] T eval(const T& x) const;
+		/**
+		 * @brief Evaluates at n points, with Horner's scheme run over blocks of points so that the loop over the points
+		 * is vectorized.
+		 */
+		void eval_batch(const T* xs, T* out, size_t n) const;
+
+		dense_polynomial operator+(const dense_polynomial& other) const;
+		dense_polynomial operator-(const dense_polynomial& other) const;
+		/**
+		 * @brief Multiplies by schoolbook, Karatsuba or FFT multiplication, whichever is the fastest for the degrees.
+		 * Exact coefficients are multiplied by NTT instead of FFT.
+		 */
+		dense_polynomial operator*(const dense_polynomial& other) const;
+
+		[[nodiscard]] dense_polynomial derivative() const;
+		/**
+		 * @brief Primitive whose value at 0 is constant.
+		 */
+		[[nodiscard]] dense_polynomial integral(const T& constant) const;
+		[[nodiscard]] dense_polynomial integral() const;
+
+		/**
+		 * @brief Builds the expression of the polynomial, in Horner form if horner is true.
+		 */
+		[[nodiscard]] expression to_expression(const symbol& variable, bool horner = false) const;
+	};
+
+	using numeric_polynomial = dense_polynomial<double>;
+	using rational_polynomial = dense_polynomial<number>;
+
+	/**
+	 * @brief Polynomial in several variables with numeric coefficients, which only stores its non-zero terms, sorted
+	 * in decreasing order for a monomial order. The exponents of a term are packed in a few 64 bits words.
+	 *
+	 * Operands of arithmetic operations may have different variables : the result is over all of them.
+	 */
+	class multivariate_polynomial {
+		std::vector<symbol> m_variables;
+		std::shared_ptr<const detail::monomial_layout> m_layout;
+		detail::sparse_polynomial m_terms;
+		// Degree of each variable
+		std::vector<uint64_t> m_degrees;
+		// Index of x^0 of each variable in the table of powers used by eval, then the size of the table
+		std::vector<size_t> m_power_offsets;
+
+		multivariate_polynomial(std::vector<symbol> variables, std::shared_ptr<const detail::monomial_layout> layout, detail::sparse_polynomial terms);
+		static multivariate_polynomial developed(const expression& expr, std::vector<const detail::node*> generators, bool add_symbols, monomial_order order);
+
+		// Both operands over the same layout, which fits exponents up to max_exponent
+		static std::pair<multivariate_polynomial, multivariate_polynomial> unified(const multivariate_polynomial& lhs, const multivariate_polynomial& rhs, uint64_t max_exponent);
+
+	public:
+		/**
+		 * @brief Develops an expression in one pass over its nodes. Its variables are its symbols, in order of appearance.
+		 *
+		 * @throws std::invalid_argument If expr is not a polynomial of its symbols : ground subexpressions (sqrt(2),
+		 * sin(1)...) are evaluated, but symbols must not appear in functions or non natural powers
+		 */
+		explicit multivariate_polynomial(const expression& expr, monomial_order order = monomial_order::grevlex);
+		/**
+		 * @brief Develops an expression whose symbols are among variables, the first variable being the largest.
+		 */
+		multivariate_polynomial(const expression& expr, std::vector<symbol> variables, monomial_order order = monomial_order::grevlex);
+
+		[[nodiscard]] const std::vector<symbol>& variables() const { return m_variables; }
+		[[nodiscard]] monomial_order order() const { return m_layout->order; }
+		// Amount of terms
+		[[nodiscard]] size_t size() const { return m_terms.size(); }
+		[[nodiscard]] const number& coefficient(size_t term) const { return m_terms.coefficient(term); }
+		[[nodiscard]] uint64_t exponent(size_t term, size_t variable) const { return m_layout->exponent(m_terms.monomial(term), variable); }
+		[[nodiscard]] uint64_t degree() const;
+		[[nodiscard]] uint64_t degree(size_t variable) const { return m_degrees[variable]; }
+
+		multivariate_polynomial operator+(const multivariate_polynomial& other) const;
+		multivariate_polynomial operator-(const multivariate_polynomial& other) const;
+		multivariate_polynomial operator-() const;
+		multivariate_polynomial operator*(const multivariate_polynomial& other) const;
+		[[nodiscard]] multivariate_polynomial pow(unsigned long long n) const;
+
+		/**
+		 * @brief Evaluates at a point, given by the values of the variables in order.
+		 */
+		[[nodiscard]] double eval(const double* values) const;
+		/**
+		 * @brief Evaluates at count points : columns[i][k] is the value of the i-th variable at the k-th point. Powers
+		 * of the variables are tabulated over blocks of points, then each term is a product of entries of the tables.
+		 */
+		void eval_batch(const double* const* columns, double* out, size_t count) const;
+
+		[[nodiscard]] expression to_expression() const;
+	};
+
+	/**
+	 * @brief Finds all the complex roots of a polynomial, repeated according to their multiplicity.
+	 *
+	 * All roots are approximated at once by Aberth–Ehrlich iterations, started on circles given by the Newton polygon
+	 * of the coefficients, then polished by Newton's method. Roots are sorted by real part, then imaginary part.
+	 */
+	std::vector<std::complex<double>> find_roots(const numeric_polynomial& p);
+	/**
+	 * @brief Finds the roots of a polynomial whose coefficients must be ground.
+	 */
+	std::vector<std::complex<double>> find_roots(const polynomial& p);
+	/**
+	 * @brief Finds the roots of many polynomials, which are spread over threads (as many as the hardware supports if
+	 * threads is 0).
+	 */
+	std::vector<std::vector<std::complex<double>>> find_roots(const std::vector<numeric_polynomial>& polynomials, size_t threads = 0);
 }
 
 #endif
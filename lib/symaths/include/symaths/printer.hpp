@@ -0,0 +1,87 @@
+/*
+ *	                            _   _
+ *	  ___ _   _ _ __ ___   __ _| |_| |__  ___
+ *	 / __| | | | '_ ` _ \ / _` | __| '_ \/ __|   Symbolic maths for C++
+ *	 \__ \ |_| | | | | | | (_| | |_| | | \__ \   Version : 0.0.1
+ *	 |___/\__, |_| |_| |_|\__,_|\__|_| |_|___/   https://github.com/dgdzd/symaths
+ *		  |___/
+ *
+ * All source code is distributed under the GNU General Public License v2.0.
+ *
+ */
+
+#ifndef PRINTER_HPP
+#define PRINTER_HPP
+
+#include "symaths/expression.hpp"
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+namespace sym {
+	enum class print_format {
+		// Text of expression::string(), following the print policies of the current library
+		plain,
+		latex,
+		// No spaces and explicit products whatever the print policies, which sym::parse reads back
+		compact,
+	};
+
+	/**
+	 * @brief Prints expressions into a single output buffer, which is reused until it is cleared.
+	 *
+	 * The text of a node only depends on the node, the kind of its parent and whether it is a first operand. With
+	 * memoization, the printer remembers where it wrote each compound node in each of these positions and copies that
+	 * text again when the node is shared, instead of traversing it.
+	 */
+	class printer {
+	public:
+		explicit printer(print_format format = print_format::plain, bool memoize = false) : m_format(format), m_memoize(memoize) {}
+
+		/**
+		 * @brief Appends an expression to the buffer.
+		 * @return Its text, valid until the next call
+		 */
+		std::string_view print(const expression& expr) { return print(expr.root, nullptr, true); }
+		// Appends the text of node as an operand of parent
+		std::string_view print(const detail::node* node, const detail::node* parent, bool first);
+
+		[[nodiscard]] const std::string& str() const { return m_out; }
+		// Empties the buffer and forgets the memoized text, keeping the allocated memory
+		void clear();
+
+	private:
+		struct memo_key {
+			const detail::node* node;
+			// 0 without parent, else the index of its alternative plus one
+			uint8_t parent_kind;
+			bool first;
+
+			bool operator==(const memo_key&) const = default;
+		};
+		struct memo_hash {
+			size_t operator()(const memo_key& k) const;
+		};
+		struct span {
+			size_t offset;
+			size_t length;
+		};
+
+		print_format m_format;
+		bool m_memoize;
+		std::string m_out;
+		std::unordered_map<memo_key, span, memo_hash> m_memo;
+
+		void print_node(const detail::node* node, const detail::node* parent, bool first);
+		void print_number(const number& value, const detail::node* parent);
+		void open_parenthesis();
+		void close_parenthesis();
+	};
+
+	std::string to_latex(const expression& expr);
+	std::string to_compact(const expression& expr);
+}
+
+#endif
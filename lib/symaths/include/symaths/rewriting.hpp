@@ -0,0 +1,109 @@
+/*
+ *	                            _   _
+ *	  ___ _   _ _ __ ___   __ _| |_| |__  ___
+ *	 / __| | | | '_ ` _ \ / _` | __| '_ \/ __|   Symbolic maths for C++
+ *	 \__ \ |_| | | | | | | (_| | |_| | | \__ \   Version : 0.0.1
+ *	 |___/\__, |_| |_| |_|\__,_|\__|_| |_|___/   https://github.com/dgdzd/symaths
+ *		  |___/
+ *
+ * All source code is distributed under the GNU General Public License v2.0.
+ *
+ */
+
+#ifndef REWRITING_HPP
+#define REWRITING_HPP
+
+#include "symaths/expression.hpp"
+#include "symaths/symbol.hpp"
+
+#include <cstdint>
+#include <map>
+#include <optional>
+#include <utility>
+#include <vector>
+
+namespace sym {
+	struct rewrite_rule {
+		const detail::node* pattern;
+		const detail::node* replacement;
+		std::vector<const detail::node*> wildcards;
+	};
+
+	/**
+	 * @brief Set of rewrite rules, indexed by a discrimination tree.
+	 *
+	 * In a pattern, wildcards are symbols which match any subexpression. A wildcard appearing several times must
+	 * match the same subexpression each time. Sums and products match whatever the order of their operands, and
+	 * a sum (or a product) at the root of a pattern also matches a part of a larger one : with the rule
+	 * sin(a)^2 + cos(a)^2 -> 1, x + cos(y)^2 + sin(y)^2 is rewritten x + 1.
+	 *
+	 * The index only retrieves the rules whose pattern has the same structure as the node, so matching many
+	 * rules costs about as much as matching the few which really apply.
+	 */
+	class rule_set {
+		using index_key = std::pair<uint64_t, uintptr_t>;
+
+		struct index_node {
+			std::map<index_key, uint32_t> next;
+			uint32_t wildcard = 0;
+			std::vector<uint32_t> rules;
+		};
+
+		std::vector<rewrite_rule> m_rules;
+		std::vector<index_node> m_index;
+
+		// Sums and products are not in the tree : they are indexed by the key of one of their operands.
+		// A rule is retrieved when the node has all the operands it requires.
+		std::map<std::pair<uint64_t, index_key>, std::vector<uint32_t>> m_operand_index;
+		std::vector<uint32_t> m_wildcard_operands_rules;
+		std::vector<std::vector<index_key>> m_required_operands;
+
+	public:
+		// Maximum amount of rules applied by a single call to rewrite, to stop rules which never terminate
+		static constexpr size_t max_rewrites = 1'000'000;
+
+		rule_set();
+
+		/**
+		 * @brief Adds a rule. When several rules match a node, the first added wins.
+		 *
+		 * @param pattern The expression to look for
+		 * @param replacement The expression replacing it, in which wildcards are replaced by what they matched
+		 * @param wildcards The symbols which are wildcards in pattern and replacement
+		 */
+		void add(const expression& pattern, const expression& replacement, const std::vector<symbol>& wildcards);
+		void clear();
+		[[nodiscard]] size_t size() const { return m_rules.size(); }
+		[[nodiscard]] const std::vector<rewrite_rule>& rules() const { return m_rules; }
+
+		/**
+		 * @brief Lists the rules the index retrieves for a node, in the order they are tried.
+		 *
+		 * Not every candidate matches : the index ignores operands of sums and products, and repeated wildcards.
+		 */
+		[[nodiscard]] std::vector<uint32_t> candidates(const detail::node* node) const;
+
+		/**
+		 * @brief Applies the first matching rule at the root of a node, without rewriting its operands.
+		 */
+		[[nodiscard]] std::optional<const detail::node*> apply(const detail::node* node) const;
+
+		/**
+		 * @brief Rewrites an expression until no rule applies anywhere, from the leaves up to the root.
+		 *
+		 * Subexpressions shared in the DAG are only rewritten once.
+		 */
+		[[nodiscard]] expression rewrite(const expression& expr) const;
+
+	private:
+		void collect(uint32_t at, std::vector<const detail::node*>& pending, std::vector<uint32_t>& out) const;
+		void collect_operands(const detail::node* node, std::vector<uint32_t>& out) const;
+	};
+
+	/**
+	 * @brief Rewrites an expression with the rules of the current context (refactoring_rules().rewrite_rules).
+	 */
+	expression rewrite(const expression& expr);
+}
+
+#endif
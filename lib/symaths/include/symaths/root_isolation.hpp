@@ -0,0 +1,59 @@
+/*
+ *	                            _   _
+ *	  ___ _   _ _ __ ___   __ _| |_| |__  ___
+ *	 / __| | | | '_ ` _ \ / _` | __| '_ \/ __|   Symbolic maths for C++
+ *	 \__ \ |_| | | | | | | (_| | |_| | | \__ \   Version : 0.0.1
+ *	 |___/\__, |_| |_| |_|\__,_|\__|_| |_|___/   https://github.com/dgdzd/symaths
+ *		  |___/
+ *
+ * All source code is distributed under the GNU General Public License v2.0.
+ *
+ */
+
+#ifndef ROOT_ISOLATION_HPP
+#define ROOT_ISOLATION_HPP
+
+#include "symaths/domain.hpp"
+#include "symaths/expression.hpp"
+#include "symaths/symbol.hpp"
+
+#include <cstddef>
+#include <vector>
+
+namespace sym {
+	struct isolation_options {
+		// Certified boxes are contracted until their width is below tolerance * max(1, |x|) in every variable
+		double tolerance = 1e-12;
+		// Boxes narrower than this in every variable are not bisected any further
+		double min_width = 1e-9;
+		// 0 for one thread per core
+		size_t threads = 0;
+	};
+
+	struct root_isolation {
+		// Pairwise disjoint boxes, each containing exactly one root
+		std::vector<box> roots;
+		// Boxes of min_width which could neither be certified nor excluded : they may contain roots (multiple roots,
+		// roots on the boundary of a bisection, or functions too ill-conditioned for interval arithmetic)
+		std::vector<box> uncertain;
+	};
+
+	/**
+	 * @brief Isolates the roots of the system functions[i] = 0 (i < n) in a box of n variables.
+	 *
+	 * Boxes are bisected until interval arithmetic either proves that they hold no root, or proves with the
+	 * Krawczyk operator that they hold exactly one, in which case they are contracted around it. Every root in the
+	 * region is in a box of the result (roots or uncertain), but for roots on the boundary of the region. The
+	 * subdivision tree is processed by several threads, which steal the largest pending boxes from each other.
+	 *
+	 * @throws std::invalid_argument If there are not as many functions as variables, the region is not a finite box,
+	 * or the functions depend on other symbols
+	 */
+	root_isolation isolate_roots(const std::vector<expression>& functions, const std::vector<symbol>& variables, const box& region, const isolation_options& options = {});
+	/**
+	 * @brief Isolates the roots of f in [lower;upper].
+	 */
+	root_isolation isolate_roots(const expression& f, const symbol& variable, double lower, double upper, const isolation_options& options = {});
+}
+
+#endif
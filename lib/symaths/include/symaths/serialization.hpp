@@ -0,0 +1,165 @@
+/*
+ *	                            _   _
+ *	  ___ _   _ _ __ ___   __ _| |_| |__  ___
+ *	 / __| | | | '_ ` _ \ / _` | __| '_ \/ __|   Symbolic maths for C++
+ *	 \__ \ |_| | | | | | | (_| | |_| | | \__ \   Version : 0.0.1
+ *	 |___/\__, |_| |_| |_|\__,_|\__|_| |_|___/   https://github.com/dgdzd/symaths
+ *		  |___/
+ *
+ * All source code is distributed under the GNU General Public License v2.0.
+ *
+ */
+
+#ifndef SERIALIZATION_HPP
+#define SERIALIZATION_HPP
+
+#include "symaths/expression.hpp"
+#include "symaths/detail/mapped_file.hpp"
+#include "symaths/parsing/compiler.hpp"
+
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace sym {
+	class library;
+
+	namespace detail {
+		/*
+		 * Binary format of expressions, little endian, every section starting on 8 bytes :
+		 * - header : "SYMB", version, then the amount of symbols, functions, constants, nodes, children and roots (u32
+		 *   each), the size of the strings and of the whole buffer (u64 each)
+		 * - symbols, then functions : offset and length of their name in the strings (u32 each)
+		 * - strings
+		 * - constants : rank of the number (u32, then 4 bytes of padding) and two u64 words holding its value
+		 * - nodes, children first : index of their alternative, symbol, constant or function they refer to, index
+		 *   of their first child in the children and amount of children (u32 each)
+		 * - children : index of each node's children (u32), always lower than the index of the node
+		 * - roots : index of the nodes of the serialized expressions (u32)
+		 */
+		struct node_record {
+			uint32_t kind;
+			uint32_t payload;
+			uint32_t first_child;
+			uint32_t children;
+		};
+
+		/**
+		 * @brief Reads a serialized buffer in place. The header is checked when constructing, and each record when it
+		 * is read.
+		 */
+		class node_table {
+		public:
+			/**
+			 * @throws std::invalid_argument If the buffer is not in the format or is truncated
+			 */
+			explicit node_table(std::string_view bytes);
+
+			[[nodiscard]] size_t size() const { return m_nodes; }
+			[[nodiscard]] size_t roots() const { return m_roots; }
+			[[nodiscard]] uint32_t root(size_t i) const;
+			[[nodiscard]] node_record node(uint32_t index) const;
+			// k-th child of a node, which comes before it
+			[[nodiscard]] uint32_t child(uint32_t index, const node_record& record, size_t k) const;
+			[[nodiscard]] std::string_view symbol(uint32_t i) const;
+			// Id of a function in this process, functions are stored by name
+			[[nodiscard]] uint32_t function(uint32_t i) const;
+			[[nodiscard]] number constant(uint32_t i) const;
+
+			/**
+			 * @brief Interns a node and the ones it depends on into a manager.
+			 * @param made Nodes already interned, by index, nullptr for the others
+			 */
+			const detail::node* intern(node_manager_t& nodes, uint32_t index, std::vector<const detail::node*>& made) const;
+
+		private:
+			std::string_view m_bytes;
+			uint32_t m_symbols = 0;
+			uint32_t m_functions = 0;
+			uint32_t m_constants = 0;
+			uint32_t m_nodes = 0;
+			uint32_t m_children = 0;
+			uint32_t m_roots = 0;
+			const char* m_symbol_entries = nullptr;
+			const char* m_function_entries = nullptr;
+			std::string_view m_strings;
+			const char* m_constant_entries = nullptr;
+			const char* m_node_entries = nullptr;
+			const char* m_child_entries = nullptr;
+			const char* m_root_entries = nullptr;
+
+			[[nodiscard]] std::string_view name(const char* entries, uint32_t i) const;
+		};
+	}
+
+	/**
+	 * @brief Writes expressions in a compact binary format which keeps their shared subexpressions shared : each node
+	 * is written once, followed by its parents.
+	 */
+	std::string serialize(const std::vector<expression>& exprs);
+
+	/**
+	 * @brief Writes every node of a library. Its roots are the nodes no other node refers to.
+	 */
+	std::string serialize(const library& lib);
+
+	/**
+	 * @brief Interns serialized expressions into the current library.
+	 * @return The serialized expressions, or the roots of a serialized library
+	 * @throws std::invalid_argument If the buffer is invalid or calls a function which is not registered
+	 */
+	std::vector<expression> deserialize(std::string_view bytes);
+
+	/**
+	 * @throws std::runtime_error If the file cannot be written
+	 */
+	void save_expressions(const std::filesystem::path& path, const std::vector<expression>& exprs);
+	void save_library(const std::filesystem::path& path, const library& lib);
+
+	/**
+	 * @brief Interns the expressions of a file into the current library (see deserialize).
+	 * @throws std::runtime_error If the file cannot be read
+	 */
+	std::vector<expression> load_expressions(const std::filesystem::path& path);
+
+	/**
+	 * @brief Read-only view of a file of serialized expressions, mapped in memory.
+	 *
+	 * Opening it only checks the header : expressions are compiled straight from the node table, or interned alone,
+	 * without reading the nodes they do not depend on.
+	 */
+	class mapped_expressions {
+		detail::mapped_file m_file;
+
+	public:
+		/**
+		 * @throws std::runtime_error If the file cannot be opened
+		 * @throws std::invalid_argument If it does not hold serialized expressions
+		 */
+		explicit mapped_expressions(const std::filesystem::path& path);
+
+		// Amount of expressions
+		[[nodiscard]] size_t size() const;
+
+		/**
+		 * @brief Compiles the i-th expression without creating any node. As with parse_compiled, domain checks are all
+		 * kept.
+		 *
+		 * @param variables Names of the variables, by position (see compiled_expression)
+		 * @throws std::invalid_argument If the expression uses another variable, or cannot be compiled
+		 */
+		[[nodiscard]] compiled_expression compile(size_t i, const std::vector<std::string>& variables) const;
+
+		/**
+		 * @brief Interns the i-th expression, and only the nodes it depends on, into the current library.
+		 */
+		[[nodiscard]] expression load(size_t i) const;
+
+	private:
+		[[nodiscard]] detail::node_table table() const { return detail::node_table(m_file.view()); }
+	};
+}
+
+#endif
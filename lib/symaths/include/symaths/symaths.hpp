@@ -14,11 +14,21 @@
 #define SYMATHS_LIBRARY_HPP
 
 #include "symaths/differentiation.hpp"
+#include "symaths/domain.hpp"
 #include "symaths/expression.hpp"
 #include "symaths/expressions_manip.hpp"
+#include "symaths/optimization.hpp"
+#include "symaths/printer.hpp"
+#include "symaths/rewriting.hpp"
+#include "symaths/serialization.hpp"
 #include "symaths/symbol.hpp"
+#include "symaths/parsing/compiler.hpp"
 #include "symaths/parsing/parser.hpp"
 
+#include <list>
+#include <string_view>
+#include <unordered_map>
+
 namespace sym {
 	struct print_policies_t {
 		struct sum_t {
@@ -40,7 +50,48 @@ namespace sym {
 
 	struct refactoring_rules_t {
 		bool keep_ground_functions = true;
-		unsigned int max_power_expansion_terms = 6;
+		// Maximum amount of terms of a polynomial developed by expand, larger subexpressions are left partially expanded
+		size_t max_expansion_terms = 100000;
+		// User rules, applied by sym::rewrite
+		rule_set rewrite_rules;
+	};
+
+	/**
+	 * @brief Bounded cache of the expressions returned by sym::parse(const std::string&), keyed by their input with its
+	 * whitespace trimmed and collapsed. The least recently used entry is evicted first.
+	 */
+	class parse_cache_t {
+	public:
+		struct stats_t {
+			size_t hits = 0;
+			size_t misses = 0;
+		};
+
+		// A capacity of 0 disables the cache
+		explicit parse_cache_t(size_t capacity = 0) : m_capacity(capacity) {}
+
+		[[nodiscard]] size_t capacity() const { return m_capacity; }
+		// Evicts the least recently used entries which no longer fit
+		void set_capacity(size_t capacity);
+		[[nodiscard]] size_t size() const { return m_entries.size(); }
+		[[nodiscard]] const stats_t& stats() const { return m_stats; }
+		// Forgets the entries and resets the counters
+		void clear();
+
+		// Counts a hit or a miss, returns nullptr on a miss
+		const detail::node* find(std::string_view key);
+		void insert(std::string key, const detail::node* root);
+
+	private:
+		using entry = std::pair<std::string, const detail::node*>;
+
+		size_t m_capacity;
+		stats_t m_stats;
+		// Most recently used first, the index points into the keys of the entries
+		std::list<entry> m_entries;
+		std::unordered_map<std::string_view, std::list<entry>::iterator> m_index;
+		// Registering a function changes how identifiers followed by a parenthesis are parsed
+		size_t m_registered_functions = 0;
 	};
 
 
@@ -48,6 +99,8 @@ namespace sym {
 		print_policies_t m_print_policies;
 		node_manager_t m_node_manager;
 		refactoring_rules_t m_refactoring_rules;
+		std::unordered_map<const detail::node*, domain> m_symbol_domains;
+		parse_cache_t m_parse_cache;
 
 	public:
 		library();
@@ -59,6 +112,10 @@ namespace sym {
 		[[nodiscard]] node_manager_t& node_manager();
 		[[nodiscard]] const refactoring_rules_t& refactoring_rules() const;
 		[[nodiscard]] refactoring_rules_t& refactoring_rules();
+		[[nodiscard]] const std::unordered_map<const detail::node*, domain>& symbol_domains() const;
+		[[nodiscard]] std::unordered_map<const detail::node*, domain>& symbol_domains();
+		[[nodiscard]] const parse_cache_t& parse_cache() const;
+		[[nodiscard]] parse_cache_t& parse_cache();
 	};
 
 	extern library* current_context;
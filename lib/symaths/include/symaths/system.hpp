@@ -0,0 +1,126 @@
+/*
+ *	                            _   _
+ *	  ___ _   _ _ __ ___   __ _| |_| |__  ___
+ *	 / __| | | | '_ ` _ \ / _` | __| '_ \/ __|   Symbolic maths for C++
+ *	 \__ \ |_| | | | | | | (_| | |_| | | \__ \   Version : 0.0.1
+ *	 |___/\__, |_| |_| |_|\__,_|\__|_| |_|___/   https://github.com/dgdzd/symaths
+ *		  |___/
+ *
+ * All source code is distributed under the GNU General Public License v2.0.
+ *
+ */
+
+#ifndef SYSTEM_HPP
+#define SYSTEM_HPP
+
+#include "symaths/equation.hpp"
+#include "symaths/detail/linear_solvers.hpp"
+#include "symaths/parsing/compiler.hpp"
+
+#include <cstddef>
+#include <vector>
+
+namespace sym {
+	enum class nonlinear_method {
+		// Newton steps, shortened by backtracking until the residuals decrease. Needs as many equations as unknowns.
+		damped_newton,
+		// Gauss-Newton steps on the normal equations, damped by a factor adapted at every step. Also solves
+		// overdetermined systems in the least squares sense.
+		levenberg_marquardt,
+	};
+
+	struct system_options {
+		nonlinear_method method = nonlinear_method::damped_newton;
+		size_t max_iterations = 100;
+		// A system is solved when every |left - right| is below tolerance
+		double tolerance = 1e-10;
+		// Matrices with at most this fraction of non-zero entries are factorized by a sparse LU
+		double sparse_density = 0.1;
+	};
+
+	struct system_result {
+		// Every residual is below the tolerance or, for Levenberg-Marquardt, the gradient of their sum of squares is
+		bool converged = false;
+		size_t iterations = 0;
+		// Largest |left - right| at the last iterate
+		double residual = 0;
+	};
+
+	/**
+	 * @brief System of equations in several unknowns. Other symbols of the equations are parameters, whose values are
+	 * given to each solve.
+	 *
+	 * The Jacobian is differentiated once, and its non-zero entries are compiled with the residuals (left - right)
+	 * into a single program, so that subexpressions they share are evaluated once.
+	 */
+	class system {
+	public:
+		/**
+		 * @brief Memory used by solve, which keeps its capacity from one solve to the next.
+		 */
+		struct workspace {
+			std::vector<double> values;
+			std::vector<double> outputs;
+			std::vector<double> residuals;
+			std::vector<double> trial_residuals;
+			std::vector<double> step;
+			std::vector<double> trial;
+			std::vector<double> gradient;
+			std::vector<double> diagonal;
+			std::vector<double> normal;
+			std::vector<double> program;
+			detail::dense_lu dense;
+			detail::sparse_lu sparse;
+		};
+
+	private:
+		std::vector<equation> m_equations;
+		std::vector<symbol> m_unknowns;
+		std::vector<symbol> m_parameters;
+		detail::sparsity_pattern m_jacobian_pattern;
+		// Pattern of the normal matrix J^T J, and the entries of the Jacobian whose products add to each of its entries
+		detail::sparsity_pattern m_normal_pattern;
+		std::vector<std::pair<size_t, size_t>> m_normal_products;
+		std::vector<size_t> m_normal_starts;
+		std::vector<size_t> m_normal_diagonal;
+		compiled_vector_expression m_residuals;
+		// Residuals, then the non-zero entries of the Jacobian
+		compiled_vector_expression m_residuals_and_jacobian;
+		workspace m_workspace;
+
+		bool is_sparse(size_t n, size_t entries, const system_options& options) const;
+		double evaluate(const std::vector<double>& x, std::vector<double>& residuals, workspace& ws) const;
+		void evaluate_jacobian(const std::vector<double>& x, workspace& ws) const;
+		system_result newton(std::vector<double>& x, const system_options& options, workspace& ws) const;
+		system_result levenberg_marquardt(std::vector<double>& x, const system_options& options, workspace& ws) const;
+
+	public:
+		/**
+		 * @throws std::invalid_argument If there are fewer equations than unknowns
+		 */
+		system(std::vector<equation> equations, std::vector<symbol> unknowns);
+
+		[[nodiscard]] const std::vector<equation>& equations() const { return m_equations; }
+		[[nodiscard]] const std::vector<symbol>& unknowns() const { return m_unknowns; }
+		// Symbols which are not unknowns, in order of appearance
+		[[nodiscard]] const std::vector<symbol>& parameters() const { return m_parameters; }
+		// (equation, unknown) pairs of the non-zero entries of the Jacobian
+		[[nodiscard]] const detail::sparsity_pattern& jacobian_pattern() const { return m_jacobian_pattern; }
+
+		/**
+		 * @brief Solves the system from an initial guess.
+		 *
+		 * @param x Values of the unknowns : the initial guess, then the last iterate
+		 * @param parameters Values of the parameters
+		 * @throws std::invalid_argument If the amount of values is wrong, or damped Newton is used on a system which
+		 * is not square
+		 */
+		system_result solve(std::vector<double>& x, const std::vector<double>& parameters = {}, const system_options& options = {});
+		/**
+		 * @brief Same, with a workspace owned by the caller : several threads may solve the same system at once.
+		 */
+		system_result solve(std::vector<double>& x, const std::vector<double>& parameters, const system_options& options, workspace& ws) const;
+	};
+}
+
+#endif
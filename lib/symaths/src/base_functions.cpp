@@ -4,172 +4,250 @@
 #include "symaths/detail/nodes.hpp"
 #include "symaths/utils/helpers.hpp"
 
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <cmath>
+#include <deque>
+#include <format>
 #include <stdexcept>
+#include <vector>
 
 using namespace sym;
 
 static detail::builtin_func_descriptor builtin_table[funcs::LEN];
 
-number cos_eval(const std::vector<const detail::node*>& args);
+// Functions added by register_function, with ids from funcs::LEN on. A deque keeps their descriptors in place.
+static std::deque<detail::builtin_func_descriptor> registered_functions;
+
+constexpr std::array<std::string_view, funcs::LEN> builtin_names = {
+	"cos", "sin", "tan", "acos", "asin", "atan",
+	"exp", "ln", "log10", "cosh", "sinh", "tanh",
+	"sqrt",
+	"abs",
+};
+
+// Multiplicative hash of the length and of the first, middle and last characters. With the seed below, its top five bits
+// are a perfect hash of the builtin names
+constexpr uint32_t builtin_name_hash(std::string_view name, uint32_t seed) {
+	if (name.empty()) {
+		return 0;
+	}
+	auto at = [&](size_t i) { return static_cast<uint32_t>(static_cast<unsigned char>(name[i])); };
+	uint32_t key = static_cast<uint32_t>(name.size()) | at(0) << 8 | at(name.size() / 2) << 16 | at(name.size() - 1) << 24;
+	return key * seed;
+}
+
+constexpr size_t builtin_hash_slots = 32;
+
+// Odd multipliers are tried in turn, from the golden ratio one
+constexpr uint32_t find_builtin_hash_seed() {
+	for (uint32_t seed = 0x9E3779B1u; seed < 0x9E3779B1u + 100000; seed += 2) {
+		std::array<bool, builtin_hash_slots> taken{};
+		bool collision = false;
+		for (auto name : builtin_names) {
+			auto slot = builtin_name_hash(name, seed) >> 27;
+			collision = collision || taken[slot];
+			taken[slot] = true;
+		}
+		if (!collision) {
+			return seed;
+		}
+	}
+	return ~0u;
+}
+
+constexpr uint32_t builtin_hash_seed = find_builtin_hash_seed();
+static_assert(builtin_hash_seed != ~0u, "The builtin names have no perfect hash");
+
+// Id of the builtin whose name hashes to each slot, funcs::LEN for the empty ones
+constexpr std::array<uint8_t, builtin_hash_slots> builtin_slots = [] {
+	std::array<uint8_t, builtin_hash_slots> slots{};
+	slots.fill(funcs::LEN);
+	for (uint8_t id = 0; id < funcs::LEN; ++id) {
+		slots[builtin_name_hash(builtin_names[id], builtin_hash_seed) >> 27] = id;
+	}
+	return slots;
+}();
+
+// Open addressing table of the registered functions, indexed by the hash of their name : ids, or funcs::none for the
+// empty slots. It is kept at most half full.
+static std::vector<uint32_t> registered_slots;
+
+uint32_t find_registered(std::string_view name, uint32_t hash) {
+	size_t mask = registered_slots.size() - 1;
+	for (size_t i = (hash ^ (hash >> 16)) & mask; registered_slots[i] != funcs::none; i = (i + 1) & mask) {
+		if (registered_functions[registered_slots[i] - funcs::LEN].name == name) {
+			return registered_slots[i];
+		}
+	}
+	return funcs::none;
+}
+
+void insert_registered(const detail::builtin_func_descriptor& f) {
+	size_t mask = registered_slots.size() - 1;
+	uint32_t hash = builtin_name_hash(f.name, builtin_hash_seed);
+	size_t i = (hash ^ (hash >> 16)) & mask;
+	while (registered_slots[i] != funcs::none) {
+		i = (i + 1) & mask;
+	}
+	registered_slots[i] = f.id;
+}
+
+
+number cos_eval(const std::vector<number>& args);
 const detail::node* cos_reduce(const std::vector<const detail::node*>& args);
 const detail::node* cos_derivative(const std::vector<const detail::node*>& args, const detail::node* wrt);
 
-number sin_eval(const std::vector<const detail::node*>& args);
+number sin_eval(const std::vector<number>& args);
 const detail::node* sin_reduce(const std::vector<const detail::node*>& args);
 const detail::node* sin_derivative(const std::vector<const detail::node*>& args, const detail::node* wrt);
 
-number tan_eval(const std::vector<const detail::node*>& args);
+number tan_eval(const std::vector<number>& args);
 const detail::node* tan_reduce(const std::vector<const detail::node*>& args);
 const detail::node* tan_derivative(const std::vector<const detail::node*>& args, const detail::node* wrt);
 
-number acos_eval(const std::vector<const detail::node*>& args);
+number acos_eval(const std::vector<number>& args);
 const detail::node* acos_reduce(const std::vector<const detail::node*>& args);
 const detail::node* acos_derivative(const std::vector<const detail::node*>& args, const detail::node* wrt);
 
-number asin_eval(const std::vector<const detail::node*>& args);
+number asin_eval(const std::vector<number>& args);
 const detail::node* asin_reduce(const std::vector<const detail::node*>& args);
 const detail::node* asin_derivative(const std::vector<const detail::node*>& args, const detail::node* wrt);
 
-number atan_eval(const std::vector<const detail::node*>& args);
+number atan_eval(const std::vector<number>& args);
 const detail::node* atan_reduce(const std::vector<const detail::node*>& args);
 const detail::node* atan_derivative(const std::vector<const detail::node*>& args, const detail::node* wrt);
 
-number exp_eval(const std::vector<const detail::node*>& args);
+number exp_eval(const std::vector<number>& args);
 const detail::node* exp_reduce(const std::vector<const detail::node*>& args);
 const detail::node* exp_derivative(const std::vector<const detail::node*>& args, const detail::node* wrt);
 
-number ln_eval(const std::vector<const detail::node*>& args);
+number ln_eval(const std::vector<number>& args);
 const detail::node* ln_reduce(const std::vector<const detail::node*>& args);
 const detail::node* ln_derivative(const std::vector<const detail::node*>& args, const detail::node* wrt);
 
-number log10_eval(const std::vector<const detail::node*>& args);
+number log10_eval(const std::vector<number>& args);
 const detail::node* log10_reduce(const std::vector<const detail::node*>& args);
 const detail::node* log10_derivative(const std::vector<const detail::node*>& args, const detail::node* wrt);
 
-number cosh_eval(const std::vector<const detail::node*>& args);
+number cosh_eval(const std::vector<number>& args);
 const detail::node* cosh_reduce(const std::vector<const detail::node*>& args);
 const detail::node* cosh_derivative(const std::vector<const detail::node*>& args, const detail::node* wrt);
 
-number sinh_eval(const std::vector<const detail::node*>& args);
+number sinh_eval(const std::vector<number>& args);
 const detail::node* sinh_reduce(const std::vector<const detail::node*>& args);
 const detail::node* sinh_derivative(const std::vector<const detail::node*>& args, const detail::node* wrt);
 
-number tanh_eval(const std::vector<const detail::node*>& args);
+number tanh_eval(const std::vector<number>& args);
 const detail::node* tanh_reduce(const std::vector<const detail::node*>& args);
 const detail::node* tanh_derivative(const std::vector<const detail::node*>& args, const detail::node* wrt);
 
-number sqrt_eval(const std::vector<const detail::node*>& args);
+number sqrt_eval(const std::vector<number>& args);
 const detail::node* sqrt_reduce(const std::vector<const detail::node*>& args);
 const detail::node* sqrt_derivative(const std::vector<const detail::node*>& args, const detail::node* wrt);
 
-number abs_eval(const std::vector<const detail::node*>& args);
+number abs_eval(const std::vector<number>& args);
 const detail::node* abs_reduce(const std::vector<const detail::node*>& args);
 const detail::node* abs_derivative(const std::vector<const detail::node*>& args, const detail::node* wrt);
 
 
-void detail::init_builtin_functions() {
-	using namespace funcs;
+template <auto F>
+double unary_kernel(const double* args) {
+	return F(args[0]);
+}
 
-	builtin_table[static_cast<size_t>(funcs::cos)] = {
-		"cos", cos_eval, cos_reduce, cos_derivative
-	};
-	builtin_table[static_cast<size_t>(funcs::sin)] = {
-		"sin", sin_eval, sin_reduce, sin_derivative
-	};
-	builtin_table[static_cast<size_t>(funcs::tan)] = {
-		"tan", tan_eval, tan_reduce, tan_derivative
-	};
-	builtin_table[static_cast<size_t>(funcs::acos)] = {
-		"acos", acos_eval, acos_reduce, acos_derivative
-	};
-	builtin_table[static_cast<size_t>(funcs::asin)] = {
-		"asin", asin_eval, asin_reduce, asin_derivative
-	};
-	builtin_table[static_cast<size_t>(funcs::atan)] = {
-		"atan", atan_eval, atan_reduce, atan_derivative
-	};
-	builtin_table[static_cast<size_t>(funcs::exp)] = {
-		"exp", exp_eval, exp_reduce, exp_derivative
-	};
-	builtin_table[static_cast<size_t>(funcs::ln)] = {
-		"ln", ln_eval, ln_reduce, ln_derivative
-	};
-	builtin_table[static_cast<size_t>(funcs::log10)] = {
-		"log10", log10_eval, log10_reduce, log10_derivative
-	};
-	builtin_table[static_cast<size_t>(funcs::cosh)] = {
-		"cosh", cosh_eval, cosh_reduce, cosh_derivative
-	};
-	builtin_table[static_cast<size_t>(funcs::sinh)] = {
-		"sinh", sinh_eval, sinh_reduce, sinh_derivative
-	};
-	builtin_table[static_cast<size_t>(funcs::tanh)] = {
-		"tanh", tanh_eval, tanh_reduce, tanh_derivative
-	};
-	builtin_table[static_cast<size_t>(funcs::sqrt)] = {
-		"sqrt", sqrt_eval, sqrt_reduce, sqrt_derivative
-	};
-	builtin_table[static_cast<size_t>(funcs::abs)] = {
-		"abs", abs_eval, abs_reduce, abs_derivative
+template <auto F>
+void unary_batch_kernel(const double* const* args, double* out, size_t count) {
+	const double* x = args[0];
+	for (size_t i = 0; i < count; ++i) {
+		out[i] = F(x[i]);
+	}
+}
+
+template <typename F>
+void set_builtin(funcs::builtin_fn_id id, detail::builtin_func_descriptor::eval_t eval, detail::builtin_func_descriptor::reduce_t reduce, detail::builtin_func_descriptor::derivative_t derivative, F) {
+	builtin_table[id] = {
+		std::string(builtin_names[id]), id, 1, eval, reduce, derivative, unary_kernel<F{}>, unary_batch_kernel<F{}>
 	};
 }
 
-const detail::builtin_func_descriptor& detail::get_func(funcs::builtin_fn_id id) {
-	return builtin_table[static_cast<size_t>(id)];
+void detail::init_builtin_functions() {
+	set_builtin(funcs::cos, cos_eval, cos_reduce, cos_derivative, [](double x) { return std::cos(x); });
+	set_builtin(funcs::sin, sin_eval, sin_reduce, sin_derivative, [](double x) { return std::sin(x); });
+	set_builtin(funcs::tan, tan_eval, tan_reduce, tan_derivative, [](double x) { return std::tan(x); });
+	set_builtin(funcs::acos, acos_eval, acos_reduce, acos_derivative, [](double x) { return std::acos(x); });
+	set_builtin(funcs::asin, asin_eval, asin_reduce, asin_derivative, [](double x) { return std::asin(x); });
+	set_builtin(funcs::atan, atan_eval, atan_reduce, atan_derivative, [](double x) { return std::atan(x); });
+	set_builtin(funcs::exp, exp_eval, exp_reduce, exp_derivative, [](double x) { return std::exp(x); });
+	set_builtin(funcs::ln, ln_eval, ln_reduce, ln_derivative, [](double x) { return std::log(x); });
+	set_builtin(funcs::log10, log10_eval, log10_reduce, log10_derivative, [](double x) { return std::log10(x); });
+	set_builtin(funcs::cosh, cosh_eval, cosh_reduce, cosh_derivative, [](double x) { return std::cosh(x); });
+	set_builtin(funcs::sinh, sinh_eval, sinh_reduce, sinh_derivative, [](double x) { return std::sinh(x); });
+	set_builtin(funcs::tanh, tanh_eval, tanh_reduce, tanh_derivative, [](double x) { return std::tanh(x); });
+	set_builtin(funcs::sqrt, sqrt_eval, sqrt_reduce, sqrt_derivative, [](double x) { return std::sqrt(x); });
+	set_builtin(funcs::abs, abs_eval, abs_reduce, abs_derivative, [](double x) { return std::abs(x); });
 }
 
-funcs::builtin_fn_id detail::get_func_id(const std::string& name) {
-	if (name == "cos") {
-		return funcs::cos;
-	}
-	if (name == "sin") {
-		return funcs::sin;
+const detail::builtin_func_descriptor& detail::get_func(uint32_t id) {
+	if (id < funcs::LEN) {
+		return builtin_table[id];
 	}
-	if (name == "tan") {
-		return funcs::tan;
+	if (id - funcs::LEN < registered_functions.size()) {
+		return registered_functions[id - funcs::LEN];
 	}
-	if (name == "acos") {
-		return funcs::acos;
-	}
-	if (name == "asin") {
-		return funcs::asin;
-	}
-	if (name == "atan") {
-		return funcs::atan;
-	}
-	if (name == "exp") {
-		return funcs::exp;
-	}
-	if (name == "ln") {
-		return funcs::ln;
+	throw std::invalid_argument(std::format("funcs: unknown function id {}", id));
+}
+
+uint32_t detail::get_func_id(std::string_view name) {
+	uint32_t hash = builtin_name_hash(name, builtin_hash_seed);
+	uint8_t id = builtin_slots[hash >> 27];
+	if (id < funcs::LEN && builtin_names[id] == name) {
+		return id;
 	}
-	if (name == "log10") {
-		return funcs::log10;
+	return registered_functions.empty() ? funcs::none : find_registered(name, hash);
+}
+
+size_t detail::registered_functions_count() {
+	return registered_functions.size();
+}
+
+uint32_t sym::register_function(const std::string& name, size_t arity, detail::kernel_t kernel, detail::batch_kernel_t batch_kernel, detail::builtin_func_descriptor::derivative_t derivative) {
+	bool identifier = !name.empty() && std::isalpha(static_cast<unsigned char>(name[0]))
+		&& std::ranges::all_of(name, [](char c) { return std::isalnum(static_cast<unsigned char>(c)); });
+	if (!identifier) {
+		throw std::invalid_argument(std::format("register_function: \"{}\" is not an identifier", name));
 	}
-	if (name == "cosh") {
-		return funcs::cosh;
+	if (detail::get_func_id(name) != funcs::none) {
+		throw std::invalid_argument(std::format("register_function: \"{}\" is already a function", name));
 	}
-	if (name == "sinh") {
-		return funcs::sinh;
+	if (arity == 0 || arity > 8) {
+		throw std::invalid_argument("register_function: functions take 1 to 8 arguments");
 	}
-	if (name == "tanh") {
-		return funcs::tanh;
+	if (!kernel) {
+		throw std::invalid_argument("register_function: the kernel is missing");
 	}
-	if (name == "sqrt") {
-		return funcs::sqrt;
+
+	auto id = static_cast<uint32_t>(funcs::LEN + registered_functions.size());
+	registered_functions.push_back({name, id, arity, nullptr, nullptr, derivative, kernel, batch_kernel});
+
+	if (2 * registered_functions.size() > registered_slots.size()) {
+		registered_slots.assign(std::max<size_t>(16, 2 * registered_slots.size()), funcs::none);
+		for (const auto& f : registered_functions) {
+			insert_registered(f);
+		}
 	}
-	if (name == "abs") {
-		return funcs::abs;
+	else {
+		insert_registered(registered_functions.back());
 	}
-	return funcs::LEN;
+	return id;
 }
 
-
-number cos_eval(const std::vector<const detail::node*>& args) {
+number cos_eval(const std::vector<number>& args) {
 	if (args.size() > 1) {
 		throw std::invalid_argument("funcs:builtin: cos only supports 1 argument");
 	}
-	number value = args[0]->eval(nullptr);
+	const number& value = args[0];
 	return std::visit(overloaded {
 		[&](const numbers::rational& q) -> number { return numbers::real{std::cos(q.double_value())}; },
 		[&](const numbers::complex& z) -> number { return numbers::complex{std::cos(z.val)}; },
@@ -198,11 +276,11 @@ const detail::node* cos_derivative(const std::vector<const detail::node*>& args,
 	});
 }
 
-number sin_eval(const std::vector<const detail::node*>& args) {
+number sin_eval(const std::vector<number>& args) {
 	if (args.size() > 1) {
 		throw std::invalid_argument("funcs:builtin: sin only supports 1 argument");
 	}
-	number value = args[0]->eval(nullptr);
+	const number& value = args[0];
 	return std::visit(overloaded {
 		[&](const numbers::rational& q) -> number { return numbers::real{std::sin(q.double_value())}; },
 		[&](const numbers::complex& z) -> number { return numbers::complex{std::sin(z.val)}; },
@@ -231,11 +309,11 @@ const detail::node* sin_derivative(const std::vector<const detail::node*>& args,
 	});
 }
 
-number tan_eval(const std::vector<const detail::node*>& args) {
+number tan_eval(const std::vector<number>& args) {
 	if (args.size() > 1) {
 		throw std::invalid_argument("funcs:builtin: tan only supports 1 argument");
 	}
-	number value = args[0]->eval(nullptr);
+	const number& value = args[0];
 	return std::visit(overloaded {
 		[&](const numbers::rational& q) -> number { return numbers::real{std::tan(q.double_value())}; },
 		[&](const numbers::complex& z) -> number { return numbers::complex{std::tan(z.val)}; },
@@ -267,11 +345,11 @@ const detail::node* tan_derivative(const std::vector<const detail::node*>& args,
 	});
 }
 
-number acos_eval(const std::vector<const detail::node*>& args) {
+number acos_eval(const std::vector<number>& args) {
 	if (args.size() > 1) {
 		throw std::invalid_argument("funcs:builtin: acos only supports 1 argument");
 	}
-	number value = args[0]->eval(nullptr);
+	const number& value = args[0];
 	return std::visit(overloaded {
 		[&](const numbers::rational& q) -> number { return numbers::real{std::acos(q.double_value())}; },
 		[&](const numbers::complex& z) -> number { return numbers::complex{std::acos(z.val)}; },
@@ -305,11 +383,11 @@ const detail::node* acos_derivative(const std::vector<const detail::node*>& args
 	);
 }
 
-number asin_eval(const std::vector<const detail::node*>& args) {
+number asin_eval(const std::vector<number>& args) {
 	if (args.size() > 1) {
 		throw std::invalid_argument("funcs:builtin: asin only supports 1 argument");
 	}
-	number value = args[0]->eval(nullptr);
+	const number& value = args[0];
 	return std::visit(overloaded {
 		[&](const numbers::rational& q) -> number { return numbers::real{std::asin(q.double_value())}; },
 		[&](const numbers::complex& z) -> number { return numbers::complex{std::asin(z.val)}; },
@@ -341,11 +419,11 @@ const detail::node* asin_derivative(const std::vector<const detail::node*>& args
 	);
 }
 
-number atan_eval(const std::vector<const detail::node*>& args) {
+number atan_eval(const std::vector<number>& args) {
 	if (args.size() > 1) {
 		throw std::invalid_argument("funcs:builtin: atan only supports 1 argument");
 	}
-	number value = args[0]->eval(nullptr);
+	const number& value = args[0];
 	return std::visit(overloaded {
 		[&](const numbers::rational& q) -> number { return numbers::real{std::atan(q.double_value())}; },
 		[&](const numbers::complex& z) -> number { return numbers::complex{std::atan(z.val)}; },
@@ -377,11 +455,11 @@ const detail::node* atan_derivative(const std::vector<const detail::node*>& args
 	);
 }
 
-number exp_eval(const std::vector<const detail::node*>& args) {
+number exp_eval(const std::vector<number>& args) {
 	if (args.size() > 1) {
 		throw std::invalid_argument("funcs:builtin: exp only supports 1 argument");
 	}
-	number value = args[0]->eval(nullptr);
+	const number& value = args[0];
 	return std::visit(overloaded {
 		[&](const numbers::rational& q) -> number { return numbers::real{std::exp(q.double_value())}; },
 		[&](const numbers::complex& z) -> number { return numbers::complex{std::exp(z.val)}; },
@@ -410,11 +488,11 @@ const detail::node* exp_derivative(const std::vector<const detail::node*>& args,
 	});
 }
 
-number ln_eval(const std::vector<const detail::node*>& args) {
+number ln_eval(const std::vector<number>& args) {
 	if (args.size() > 1) {
 		throw std::invalid_argument("funcs:builtin: ln only supports 1 argument");
 	}
-	number value = args[0]->eval(nullptr);
+	const number& value = args[0];
 	return std::visit(overloaded {
 		[&](const numbers::rational& q) -> number { return numbers::real{std::log(q.double_value())}; },
 		[&](const numbers::complex& z) -> number { return numbers::complex{std::log(z.val)}; },
@@ -443,11 +521,11 @@ const detail::node* ln_derivative(const std::vector<const detail::node*>& args,
 	);
 }
 
-number log10_eval(const std::vector<const detail::node*>& args) {
+number log10_eval(const std::vector<number>& args) {
 	if (args.size() > 1) {
 		throw std::invalid_argument("funcs:builtin: log10 only supports 1 argument");
 	}
-	number value = args[0]->eval(nullptr);
+	const number& value = args[0];
 	return std::visit(overloaded {
 		[&](const numbers::rational& q) -> number { return numbers::real{std::log10(q.double_value())}; },
 		[&](const numbers::complex& z) -> number { return numbers::complex{std::log10(z.val)}; },
@@ -476,11 +554,11 @@ const detail::node* log10_derivative(const std::vector<const detail::node*>& arg
 	);
 }
 
-number cosh_eval(const std::vector<const detail::node*>& args) {
+number cosh_eval(const std::vector<number>& args) {
 	if (args.size() > 1) {
 		throw std::invalid_argument("funcs:builtin: cosh only supports 1 argument");
 	}
-	number value = args[0]->eval(nullptr);
+	const number& value = args[0];
 	return std::visit(overloaded {
 		[&](const numbers::rational& q) -> number { return numbers::real{std::cosh(q.double_value())}; },
 		[&](const numbers::complex& z) -> number { return numbers::complex{std::cosh(z.val)}; },
@@ -509,11 +587,11 @@ const detail::node* cosh_derivative(const std::vector<const detail::node*>& args
 	});
 }
 
-number sinh_eval(const std::vector<const detail::node*>& args) {
+number sinh_eval(const std::vector<number>& args) {
 	if (args.size() > 1) {
 		throw std::invalid_argument("funcs:builtin: sinh only supports 1 argument");
 	}
-	number value = args[0]->eval(nullptr);
+	const number& value = args[0];
 	return std::visit(overloaded {
 		[&](const numbers::rational& q) -> number { return numbers::real{std::sinh(q.double_value())}; },
 		[&](const numbers::complex& z) -> number { return numbers::complex{std::sinh(z.val)}; },
@@ -542,11 +620,11 @@ const detail::node* sinh_derivative(const std::vector<const detail::node*>& args
 	});
 }
 
-number tanh_eval(const std::vector<const detail::node*>& args) {
+number tanh_eval(const std::vector<number>& args) {
 	if (args.size() > 1) {
 		throw std::invalid_argument("funcs:builtin: tanh only supports 1 argument");
 	}
-	number value = args[0]->eval(nullptr);
+	const number& value = args[0];
 	return std::visit(overloaded {
 		[&](const numbers::rational& q) -> number { return numbers::real{std::tanh(q.double_value())}; },
 		[&](const numbers::complex& z) -> number { return numbers::complex{std::tanh(z.val)}; },
@@ -578,11 +656,11 @@ const detail::node* tanh_derivative(const std::vector<const detail::node*>& args
 	});
 }
 
-number sqrt_eval(const std::vector<const detail::node*>& args) {
+number sqrt_eval(const std::vector<number>& args) {
 	if (args.size() > 1) {
 		throw std::invalid_argument("funcs:builtin: sqrt only supports 1 argument");
 	}
-	number value = args[0]->eval(nullptr);
+	const number& value = args[0];
 	return std::visit(overloaded {
 		[&](const numbers::rational& q) -> number { return numbers::real{std::sqrt(q.double_value())}; },
 		[&](const numbers::complex& z) -> number { return numbers::complex{std::sqrt(z.val)}; },
@@ -614,11 +692,11 @@ const detail::node* sqrt_derivative(const std::vector<const detail::node*>& args
 	);
 }
 
-number abs_eval(const std::vector<const detail::node*>& args) {
+number abs_eval(const std::vector<number>& args) {
 	if (args.size() > 1) {
 		throw std::invalid_argument("funcs:builtin: abs only supports 1 argument");
 	}
-	number value = args[0]->eval(nullptr);
+	const number& value = args[0];
 	return std::visit(overloaded {
 		[&](const numbers::natural& n)  -> number { return n; },
 		[&](const numbers::integer& n)  -> number { return numbers::integer{std::abs(n.val)}; },
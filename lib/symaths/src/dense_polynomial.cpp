@@ -0,0 +1,233 @@
+#include "symaths/polynomial.hpp"
+
+#include "symaths/detail/polynomial_kernels.hpp"
+#include "symaths/symaths.hpp"
+
+#include <algorithm>
+#include <complex>
+#include <stdexcept>
+
+using namespace sym;
+
+// Amount of coefficients evaluated at once by Estrin's scheme, and of points evaluated at once by eval_batch
+constexpr size_t estrin_chunk = 64;
+constexpr size_t batch_block = 256;
+
+template<typename T>
+T dense_coefficient(unsigned long long k) {
+	if constexpr (std::is_same_v<T, number>) {
+		return numbers::natural{k};
+	}
+	else {
+		return static_cast<T>(k);
+	}
+}
+
+// Estrin's scheme on at most estrin_chunk coefficients : pairs of terms are combined with x, then pairs of pairs with x^2...
+double estrin(const double* c, size_t n, double x) {
+	double buffer[estrin_chunk / 2];
+	size_t m = (n + 1) / 2;
+	for (size_t i = 0; i < m; ++i) {
+		buffer[i] = 2 * i + 1 < n ? c[2 * i] + c[2 * i + 1] * x : c[2 * i];
+	}
+	double xp = x * x;
+	while (m > 1) {
+		size_t next = (m + 1) / 2;
+		for (size_t i = 0; i < next; ++i) {
+			buffer[i] = 2 * i + 1 < m ? buffer[2 * i] + buffer[2 * i + 1] * xp : buffer[2 * i];
+		}
+		m = next;
+		xp *= xp;
+	}
+	return buffer[0];
+}
+
+template<typename T>
+dense_polynomial<T>::dense_polynomial(const polynomial& p) {
+	for (auto* c : p.coeffs) {
+		if (!c->is_ground()) {
+			throw std::invalid_argument("Coefficients of a dense polynomial must be ground.");
+		}
+		number value = c->eval(nullptr);
+		value.downcast();
+		if constexpr (std::is_same_v<T, number>) {
+			coeffs.push_back(value);
+		}
+		else {
+			coeffs.push_back(value.get<T>());
+		}
+	}
+}
+
+template<typename T>
+T dense_polynomial<T>::eval(const T& x) const {
+	if (coeffs.empty()) {
+		return dense_coefficient<T>(0);
+	}
+
+	if constexpr (std::is_same_v<T, double>) {
+		if (coeffs.size() > 16) {
+			// Chunks of coefficients by Estrin's scheme, combined by Horner's scheme in x^estrin_chunk
+			double x_chunk = x;
+			for (size_t k = 1; k < estrin_chunk; k *= 2) {
+				x_chunk *= x_chunk;
+			}
+			size_t chunks = (coeffs.size() + estrin_chunk - 1) / estrin_chunk;
+			double result = 0;
+			for (size_t k = chunks; k-- > 0;) {
+				size_t start = k * estrin_chunk;
+				result = result * x_chunk + estrin(coeffs.data() + start, std::min(estrin_chunk, coeffs.size() - start), x);
+			}
+			return result;
+		}
+	}
+
+	T result = coeffs.back();
+	for (size_t k = coeffs.size() - 1; k-- > 0;) {
+		result = result * x + coeffs[k];
+	}
+	return result;
+}
+
+template<typename T>
+void dense_polynomial<T>::eval_batch(const T* xs, T* out, size_t n) const {
+	if constexpr (std::is_same_v<T, double>) {
+		if (coeffs.empty()) {
+			std::fill_n(out, n, 0.0);
+			return;
+		}
+
+		// Horner's scheme one coefficient at a time over a block of points : the inner loop has no dependency
+		for (size_t start = 0; start < n; start += batch_block) {
+			size_t len = std::min(batch_block, n - start);
+			const double* x = xs + start;
+			double* o = out + start;
+
+			std::fill_n(o, len, coeffs.back());
+			for (size_t k = coeffs.size() - 1; k-- > 0;) {
+				double c = coeffs[k];
+				for (size_t i = 0; i < len; ++i) {
+					o[i] = o[i] * x[i] + c;
+				}
+			}
+		}
+	}
+	else {
+		for (size_t i = 0; i < n; ++i) {
+			out[i] = eval(xs[i]);
+		}
+	}
+}
+
+template<typename T>
+dense_polynomial<T> dense_polynomial<T>::operator+(const dense_polynomial& other) const {
+	dense_polynomial result = coeffs.size() >= other.coeffs.size() ? *this : other;
+	const auto& smaller = coeffs.size() >= other.coeffs.size() ? other.coeffs : coeffs;
+	for (size_t k = 0; k < smaller.size(); ++k) {
+		result.coeffs[k] = result.coeffs[k] + smaller[k];
+	}
+	return result;
+}
+
+template<typename T>
+dense_polynomial<T> dense_polynomial<T>::operator-(const dense_polynomial& other) const {
+	dense_polynomial negated = other;
+	for (auto& c : negated.coeffs) {
+		c = -c;
+	}
+	return *this + negated;
+}
+
+template<typename T>
+dense_polynomial<T> dense_polynomial<T>::operator*(const dense_polynomial& other) const {
+	return dense_polynomial(detail::multiply_dense(coeffs, other.coeffs));
+}
+
+template<typename T>
+dense_polynomial<T> dense_polynomial<T>::derivative() const {
+	dense_polynomial result;
+	for (size_t k = 1; k < coeffs.size(); ++k) {
+		result.coeffs.push_back(coeffs[k] * dense_coefficient<T>(k));
+	}
+	return result;
+}
+
+template<typename T>
+dense_polynomial<T> dense_polynomial<T>::integral(const T& constant) const {
+	dense_polynomial result;
+	result.coeffs.reserve(coeffs.size() + 1);
+	result.coeffs.push_back(constant);
+	for (size_t k = 0; k < coeffs.size(); ++k) {
+		result.coeffs.push_back(coeffs[k] / dense_coefficient<T>(k + 1));
+	}
+	return result;
+}
+
+template<typename T>
+dense_polynomial<T> dense_polynomial<T>::integral() const {
+	return integral(dense_coefficient<T>(0));
+}
+
+template<typename T>
+expression dense_polynomial<T>::to_expression(const symbol& variable, bool horner) const {
+	auto& nm = current_context->node_manager();
+	auto equals = [](const T& c, double value) {
+		if constexpr (std::is_same_v<T, number>) {
+			return number::get_rank(c.p_data) != number::rank::NaN && c.template get<std::complex<double>>() == value;
+		}
+		else {
+			return c == value;
+		}
+	};
+	auto is_zero = [&](const T& c) { return equals(c, 0); };
+
+	if (coeffs.empty()) {
+		return nm.make_constant(numbers::natural{0});
+	}
+	if (horner) {
+		const detail::node* result = nm.make_constant(coeffs.back());
+		for (size_t k = coeffs.size() - 1; k-- > 0;) {
+			result = nm.make_mul({result, variable.ref});
+			if (!is_zero(coeffs[k])) {
+				result = nm.make_add({result, nm.make_constant(coeffs[k])});
+			}
+		}
+		return result;
+	}
+
+	std::vector<const detail::node*> terms;
+	for (size_t k = coeffs.size(); k-- > 0;) {
+		if (is_zero(coeffs[k])) {
+			continue;
+		}
+		if (k == 0) {
+			terms.push_back(nm.make_constant(coeffs[k]));
+		}
+		else {
+			// Negative terms are negations, as parsed expressions are, so that they print as "- c x"
+			const T& c = coeffs[k];
+			bool negative;
+			if constexpr (std::is_same_v<T, number>) {
+				negative = number::get_rank(c.p_data) <= number::rank::Real && c.template get<double>() < 0;
+			}
+			else {
+				negative = c < 0;
+			}
+			T magnitude = negative ? T(-c) : c;
+
+			const detail::node* x = k == 1 ? variable.ref : nm.make_pow(variable.ref, nm.make_constant(numbers::natural{k}));
+			const detail::node* term = equals(magnitude, 1) ? x : nm.make_mul({nm.make_constant(magnitude), x});
+			terms.push_back(negative ? nm.make_negation(term) : term);
+		}
+	}
+	if (terms.empty()) {
+		return nm.make_constant(numbers::natural{0});
+	}
+	if (terms.size() == 1) {
+		return terms.front();
+	}
+	return nm.make_add(terms);
+}
+
+template class sym::dense_polynomial<double>;
+template class sym::dense_polynomial<number>;
@@ -0,0 +1,213 @@
+#include "symaths/detail/linear_solvers.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <numeric>
+
+using namespace sym;
+
+// Rows whose pivot candidate is at least this fraction of the largest one may be chosen for their sparsity
+constexpr double pivot_threshold = 0.1;
+
+bool detail::dense_lu::factorize(size_t n, const sparsity_pattern& pattern, const double* values) {
+	m_n = n;
+	m_lu.assign(n * n, 0.0);
+	m_pivots.resize(n);
+	for (size_t k = 0; k < pattern.size(); ++k) {
+		m_lu[pattern[k].first * n + pattern[k].second] += values[k];
+	}
+	return decompose();
+}
+
+bool detail::dense_lu::factorize(size_t n, const double* matrix) {
+	m_n = n;
+	m_lu.assign(matrix, matrix + n * n);
+	m_pivots.resize(n);
+	return decompose();
+}
+
+bool detail::dense_lu::decompose() {
+	size_t n = m_n;
+	for (size_t k = 0; k < n; ++k) {
+		size_t pivot = k;
+		for (size_t i = k + 1; i < n; ++i) {
+			if (std::abs(m_lu[i * n + k]) > std::abs(m_lu[pivot * n + k])) {
+				pivot = i;
+			}
+		}
+		m_pivots[k] = pivot;
+		if (m_lu[pivot * n + k] == 0) {
+			return false;
+		}
+		if (pivot != k) {
+			std::swap_ranges(m_lu.begin() + k * n, m_lu.begin() + (k + 1) * n, m_lu.begin() + pivot * n);
+		}
+
+		const double* row_k = m_lu.data() + k * n;
+		for (size_t i = k + 1; i < n; ++i) {
+			double* row_i = m_lu.data() + i * n;
+			double l = row_i[k] /= row_k[k];
+			if (l != 0) {
+				for (size_t j = k + 1; j < n; ++j) {
+					row_i[j] -= l * row_k[j];
+				}
+			}
+		}
+	}
+	return true;
+}
+
+void detail::dense_lu::solve(double* b) const {
+	size_t n = m_n;
+	// Rows of L were swapped along with the rows of U, so all swaps come first
+	for (size_t k = 0; k < n; ++k) {
+		std::swap(b[k], b[m_pivots[k]]);
+	}
+	for (size_t k = 0; k < n; ++k) {
+		for (size_t i = k + 1; i < n; ++i) {
+			b[i] -= m_lu[i * n + k] * b[k];
+		}
+	}
+	for (size_t k = n; k-- > 0;) {
+		const double* row = m_lu.data() + k * n;
+		double sum = b[k];
+		for (size_t j = k + 1; j < n; ++j) {
+			sum -= row[j] * b[j];
+		}
+		b[k] = sum / row[k];
+	}
+}
+
+bool detail::sparse_lu::factorize(size_t n, const sparsity_pattern& pattern, const double* values) {
+	m_n = n;
+	m_rows.resize(n);
+	m_column_rows.resize(n);
+	m_multipliers.resize(n);
+	m_pivot_rows.clear();
+	m_pivot_columns.clear();
+	for (size_t i = 0; i < n; ++i) {
+		m_rows[i].clear();
+		m_column_rows[i].clear();
+		m_multipliers[i].clear();
+	}
+
+	for (size_t k = 0; k < pattern.size(); ++k) {
+		auto [i, j] = pattern[k];
+		m_rows[i].push_back({j, values[k]});
+	}
+	for (size_t i = 0; i < n; ++i) {
+		auto& row = m_rows[i];
+		std::ranges::sort(row, {}, &entry::column);
+		// Duplicate entries are summed
+		size_t kept = 0;
+		for (size_t k = 0; k < row.size(); ++k) {
+			if (kept > 0 && row[kept - 1].column == row[k].column) {
+				row[kept - 1].value += row[k].value;
+			}
+			else {
+				row[kept++] = row[k];
+			}
+		}
+		row.resize(kept);
+		for (const auto& e : row) {
+			m_column_rows[e.column].push_back(i);
+		}
+	}
+
+	std::vector<size_t> columns(n);
+	std::iota(columns.begin(), columns.end(), 0);
+	std::ranges::stable_sort(columns, {}, [&](size_t c) { return m_column_rows[c].size(); });
+
+	std::vector<char> pivoted(n, false);
+	auto find = [&](const std::vector<entry>& row, size_t column) {
+		auto it = std::ranges::lower_bound(row, column, {}, &entry::column);
+		return it != row.end() && it->column == column ? &*it : nullptr;
+	};
+
+	for (size_t step = 0; step < n; ++step) {
+		size_t c = columns[step];
+		auto& candidates = m_column_rows[c];
+		// Rows already pivoted, or whose entry in this column cancelled out, are not candidates
+		std::erase_if(candidates, [&](size_t r) { return pivoted[r] || !find(m_rows[r], c); });
+		std::ranges::sort(candidates);
+		candidates.erase(std::unique(candidates.begin(), candidates.end()), candidates.end());
+
+		double largest = 0;
+		for (size_t r : candidates) {
+			largest = std::max(largest, std::abs(find(m_rows[r], c)->value));
+		}
+		if (largest == 0) {
+			return false;
+		}
+		size_t pivot = SIZE_MAX;
+		for (size_t r : candidates) {
+			if (std::abs(find(m_rows[r], c)->value) >= pivot_threshold * largest && (pivot == SIZE_MAX || m_rows[r].size() < m_rows[pivot].size())) {
+				pivot = r;
+			}
+		}
+		pivoted[pivot] = true;
+		m_pivot_rows.push_back(pivot);
+		m_pivot_columns.push_back(c);
+
+		const auto& pivot_row = m_rows[pivot];
+		double pivot_value = find(pivot_row, c)->value;
+		for (size_t r : candidates) {
+			if (r == pivot) {
+				continue;
+			}
+			auto& row = m_rows[r];
+			double l = find(row, c)->value / pivot_value;
+			m_multipliers[step].push_back({r, l});
+
+			// row - l * pivot_row, without the eliminated column
+			m_merged.clear();
+			size_t a = 0, b = 0;
+			while (a < row.size() || b < pivot_row.size()) {
+				if (b == pivot_row.size() || (a < row.size() && row[a].column < pivot_row[b].column)) {
+					m_merged.push_back(row[a++]);
+				}
+				else if (a == row.size() || pivot_row[b].column < row[a].column) {
+					m_merged.push_back({pivot_row[b].column, -l * pivot_row[b].value});
+					m_column_rows[pivot_row[b].column].push_back(r);
+					++b;
+				}
+				else {
+					if (row[a].column != c) {
+						m_merged.push_back({row[a].column, row[a].value - l * pivot_row[b].value});
+					}
+					++a;
+					++b;
+				}
+			}
+			row.swap(m_merged);
+		}
+	}
+	m_solution.resize(n);
+	return true;
+}
+
+void detail::sparse_lu::solve(double* b) const {
+	for (size_t step = 0; step < m_n; ++step) {
+		double pivot = b[m_pivot_rows[step]];
+		for (const auto& [row, l] : m_multipliers[step]) {
+			b[row] -= l * pivot;
+		}
+	}
+	// Each row of U only has entries in columns pivoted at or after its own step
+	for (size_t step = m_n; step-- > 0;) {
+		size_t c = m_pivot_columns[step];
+		double sum = b[m_pivot_rows[step]];
+		double diagonal = 0;
+		for (const auto& e : m_rows[m_pivot_rows[step]]) {
+			if (e.column == c) {
+				diagonal = e.value;
+			}
+			else {
+				sum -= e.value * m_solution[e.column];
+			}
+		}
+		m_solution[c] = sum / diagonal;
+	}
+	std::copy_n(m_solution.begin(), m_n, b);
+}
@@ -0,0 +1,85 @@
+#include "symaths/detail/mapped_file.hpp"
+
+#include <format>
+#include <fstream>
+#include <stdexcept>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define SYMATHS_HAS_MMAP 1
+#endif
+
+using namespace sym;
+
+std::string read_whole_file(const std::filesystem::path& path) {
+	std::ifstream file(path, std::ios::binary);
+	if (!file) {
+		throw std::runtime_error(std::format(R"(Cannot open "{}".)", path.string()));
+	}
+	std::string content(std::filesystem::file_size(path), '\0');
+	if (!file.read(content.data(), static_cast<std::streamsize>(content.size()))) {
+		throw std::runtime_error(std::format(R"(Cannot read "{}".)", path.string()));
+	}
+	return content;
+}
+
+detail::mapped_file::mapped_file(const std::filesystem::path& path) {
+#ifdef SYMATHS_HAS_MMAP
+	int fd = ::open(path.c_str(), O_RDONLY);
+	if (fd < 0) {
+		throw std::runtime_error(std::format(R"(Cannot open "{}".)", path.string()));
+	}
+	struct stat st{};
+	if (::fstat(fd, &st) == 0 && st.st_size > 0) {
+		void* data = ::mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+		if (data != MAP_FAILED) {
+			m_data = static_cast<const char*>(data);
+			m_size = static_cast<size_t>(st.st_size);
+			m_mapped = true;
+		}
+	}
+	::close(fd);
+#endif
+	if (!m_mapped) {
+		m_copy = read_whole_file(path);
+		m_data = m_copy.data();
+		m_size = m_copy.size();
+	}
+}
+
+detail::mapped_file::~mapped_file() {
+	unmap();
+}
+
+detail::mapped_file::mapped_file(mapped_file&& other) noexcept {
+	*this = std::move(other);
+}
+
+detail::mapped_file& detail::mapped_file::operator=(mapped_file&& other) noexcept {
+	if (this != &other) {
+		unmap();
+		m_mapped = other.m_mapped;
+		m_size = other.m_size;
+		m_copy = std::move(other.m_copy);
+		m_data = m_mapped ? other.m_data : m_copy.data();
+		other.m_data = nullptr;
+		other.m_size = 0;
+		other.m_mapped = false;
+	}
+	return *this;
+}
+
+void detail::mapped_file::unmap() {
+#ifdef SYMATHS_HAS_MMAP
+	if (m_mapped) {
+		::munmap(const_cast<char*>(m_data), m_size);
+	}
+#endif
+	m_data = nullptr;
+	m_size = 0;
+	m_mapped = false;
+	m_copy.clear();
+}
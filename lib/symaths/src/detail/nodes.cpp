@@ -1,14 +1,20 @@
 #include "symaths/detail/nodes.hpp"
 
 #include "symaths/base_functions.hpp"
+#include "symaths/detail/sparse_polynomial.hpp"
 #include "symaths/expressions_manip.hpp"
+#include "symaths/printer.hpp"
 #include "symaths/symaths.hpp"
 #include "symaths/utils/helpers.hpp"
 #include "symaths/utils/maths.hpp"
 
 #include <algorithm>
+#include <array>
+#include <bit>
+#include <cmath>
 #include <format>
 #include <map>
+#include <stdexcept>
 
 
 using namespace sym;
@@ -43,8 +49,23 @@ number detail::node::eval(const Context* ctx) const {
 			return pow_calc(x.base->eval(ctx), x.exponent->eval(ctx));
 		},
 		[&](const function_call& x) -> number {
-			const auto& func = get_func(funcs::builtin_fn_id{x.f_id});
-			return func.eval(x.args);
+			const auto& func = get_func(x.f_id);
+			std::vector<number> args;
+			args.reserve(x.args.size());
+			for (auto* arg : x.args) {
+				args.push_back(arg->eval(ctx));
+			}
+			if (func.eval) {
+				return func.eval(args);
+			}
+			if (args.size() != func.arity) {
+				throw std::invalid_argument(std::format("{} takes {} arguments", func.name, func.arity));
+			}
+			std::array<double, 8> values;
+			for (size_t k = 0; k < args.size(); ++k) {
+				values[k] = args[k].get<double>();
+			}
+			return numbers::real{func.kernel(values.data())};
 		}
 	}, p_data);
 	num.downcast();
@@ -80,111 +101,9 @@ bool should_be_preceeded_by_star(const detail::node* parent, const detail::node*
 }
 
 std::string detail::node::string(const node* parent, bool first) const {
-	return std::visit([&](const auto& x) -> std::string {
-		using T = std::decay_t<decltype(x)>;
-
-		if (!current_context) {
-			throw std::runtime_error("node::string(): current context is null");
-		}
-		auto& print_policies = current_context->print_policies();
-
-		if constexpr (std::is_same_v<T, constant>) {
-			if (parent && std::holds_alternative<addition>(parent->p_data)) {
-				return std::format("{}", abs_calc(x.value).string());
-			}
-			if (!first && x.value.template get<double>() < 0 && parent && parent->priority() >= multiplication::priority) {
-				return std::format("({})", x.value.string());
-			}
-			return std::format("{}", x.value.string());
-		}
-
-		else if constexpr (std::is_same_v<T, symbol>) {
-			return x.name;
-		}
-
-		else if constexpr (std::is_same_v<T, negation>) {
-			// If parent is sum then no need to add "-" sign
-			if (parent && std::holds_alternative<addition>(parent->p_data)) {
-				return x.child->string(this, first);
-			}
-
-			if (first && !(parent && parent->priority() > priority())) {
-				return "-" + x.child->string(this, first);
-			}
-
-			return "(-" + x.child->string(this,first) + ")";
-		}
-
-		else if constexpr (std::is_same_v<T, addition>) {
-			bool par = parent && parent->priority() > priority();
-			std::string s;
-			if (par) s += "(";
-			for (int i = 0; i < x.operands.size(); ++i) {
-				auto& op = x.operands[i];
-				if (std::holds_alternative<negation>(op->p_data) || (std::holds_alternative<constant>(op->p_data) && op->eval(nullptr).template get<double>() < 0)) {
-					if (i == 0) {
-						s += "-" + op->string(this, true);
-					}
-					else {
-						s += "-" + std::string(print_policies.sum.operand_spaces, ' ') + op->string(this, false);
-					}
-				}
-				else {
-					if (i != 0) {
-						s += "+" + std::string(print_policies.sum.operand_spaces, ' ');
-					}
-					s += op->string(this, i == 0);
-				}
-			}
-			if (par) s += ")";
-			return s;
-		}
-
-		else if constexpr (std::is_same_v<T, multiplication>) {
-			bool par = parent && parent->priority() > priority();
-			std::string s;
-			if (par) s += "(";
-			for (int i = 0; i < x.operands.size(); ++i) {
-				auto& op = x.operands[i];
-				if (i != 0) {
-					bool is_val = std::holds_alternative<constant>(op->p_data);
-					if (is_val || print_policies.product.use_stars_for_subexprs) {
-						s += "*" + std::string(print_policies.product.operand_spaces, ' ');
-					}
-					else {
-						s += std::string(print_policies.product.operand_spaces, ' ');
-					}
-				}
-				s += op->string(this, i == 0);
-			}
-			if (par) s += ")";
-			return s;
-		}
-
-		else if constexpr (std::is_same_v<T, power>) {
-			bool par = parent && parent->priority() > priority();
-			if (par) {
-				return "(" + x.base->string(this, false) + "^" + x.exponent->string(this, false) + ")";
-			}
-
-			return x.base->string(this, false) + "^" + x.exponent->string(this, false);
-		}
-
-		else if constexpr (std::is_same_v<T, function_call>) {
-			const auto& func = get_func(funcs::builtin_fn_id{x.f_id});
-			std::string s = std::string(func.name) + "(";
-			for (int i = 0; i < x.args.size(); ++i) {
-				auto& arg = x.args[i];
-				if (i != 0) {
-					s += ", ";
-				}
-				s += arg->string(this, i == 0);
-			}
-			return s + ")";
-		}
-
-		return "";
-	}, p_data);
+	printer p;
+	p.print(this, parent, first);
+	return p.str();
 }
 
 bool detail::node::is_ground() const {
@@ -334,42 +253,136 @@ std::vector<const detail::node*> detail::list_symbols(const node* parent) {
 }
 
 
-std::size_t node_hash::operator()(const node_key& k) const {
-	return std::visit([](const auto& x) {
+std::string fingerprint::string() const {
+	constexpr std::string_view digits = "0123456789abcdef";
+	std::string s(32, '0');
+	for (int i = 0; i < 16; ++i) {
+		s[15 - i] = digits[(high >> (4 * i)) & 0xf];
+		s[31 - i] = digits[(low >> (4 * i)) & 0xf];
+	}
+	return s;
+}
+
+/*
+ * Streaming hash of 64-bit words on two lanes, after MurmurHash3 x64 128. It is order dependent, so that pow(a, b) and
+ * pow(b, a), or f(a, b) and f(b, a), do not collide. Only fixed width integers are involved, and the bytes of strings
+ * are read in a fixed order, so the result does not depend on the platform.
+ */
+struct fingerprint_builder {
+	static constexpr uint64_t c1 = 0x87c37b91114253d5ULL;
+	static constexpr uint64_t c2 = 0x4cf5ad432745937fULL;
+
+	uint64_t h1 = 0x243f6a8885a308d3ULL;
+	uint64_t h2 = 0x13198a2e03707344ULL;
+	uint64_t words = 0;
+
+	void add_word(uint64_t w) {
+		h1 ^= std::rotl(w * c1, 31) * c2;
+		h1 = (std::rotl(h1, 27) + h2) * 5 + 0x52dce729;
+		h2 ^= std::rotl(w * c2, 33) * c1;
+		h2 = (std::rotl(h2, 31) + h1) * 5 + 0x38495ab5;
+		++words;
+	}
+
+	void add_real(double d) {
+		// 0.0 and -0.0 compare equal, so nodes holding them are merged
+		if (d == 0) d = 0;
+		add_word(std::isnan(d) ? 0x7ff8000000000000ULL : std::bit_cast<uint64_t>(d));
+	}
+
+	void add_text(std::string_view text) {
+		add_word(static_cast<uint64_t>(text.size()));
+		for (size_t i = 0; i < text.size(); i += 8) {
+			uint64_t w = 0;
+			for (size_t k = 0; k < 8 && i + k < text.size(); ++k) {
+				w |= static_cast<uint64_t>(static_cast<unsigned char>(text[i + k])) << (8 * k);
+			}
+			add_word(w);
+		}
+	}
+
+	void add_child(const detail::node* child) {
+		// Nodes of failed parses may have missing children
+		fingerprint f = child ? child->p_fingerprint : fingerprint{};
+		add_word(f.low);
+		add_word(f.high);
+	}
+
+	static uint64_t fmix(uint64_t k) {
+		k ^= k >> 33;
+		k *= 0xff51afd7ed558ccdULL;
+		k ^= k >> 33;
+		k *= 0xc4ceb9fe1a85ec53ULL;
+		return k ^ (k >> 33);
+	}
+
+	[[nodiscard]] fingerprint finish() const {
+		uint64_t a = h1 ^ words;
+		uint64_t b = h2 ^ words;
+		a += b;
+		b += a;
+		a = fmix(a);
+		b = fmix(b);
+		a += b;
+		b += a;
+		return {a, b};
+	}
+};
+
+fingerprint fingerprint_of(const detail::node::internal_data_t& data) {
+	fingerprint_builder f;
+	f.add_word(static_cast<uint64_t>(data.index()));
+	std::visit([&](const auto& x) {
 		using T = std::decay_t<decltype(x)>;
-		size_t h = typeid(T).hash_code();
 
 		if constexpr (std::is_same_v<T, detail::symbol>)
-			h ^= std::hash<std::string>{}(x.name);
+			f.add_text(std::string_view(x.name));
 
-		else if constexpr (std::is_same_v<T, detail::constant>)
+		else if constexpr (std::is_same_v<T, detail::constant>) {
+			f.add_word(static_cast<uint64_t>(x.value.p_data.index()));
 			std::visit(overloaded {
-				[&](const numbers::natural& n) { h ^= std::hash<unsigned long long>{}(n.val); },
-				[&](const numbers::integer& n) { h ^= std::hash<long long>{}(n.val); },
+				[&](const numbers::natural& n) { f.add_word(static_cast<uint64_t>(n.val)); },
+				[&](const numbers::integer& n) { f.add_word(static_cast<uint64_t>(n.val)); },
 				[&](const numbers::rational& n) {
-					h ^= std::hash<long long>{}(n.num);
-					h ^= std::hash<long long>{}(n.den);
+					f.add_word(static_cast<uint64_t>(n.num));
+					f.add_word(static_cast<uint64_t>(n.den));
 				},
-				[&](const numbers::real& n) { h ^= std::hash<double>{}(n.val); },
+				[&](const numbers::real& n) { f.add_real(n.val); },
 				[&](const numbers::complex& n) {
-					h ^= std::hash<double>{}(n.val.real());
-					h ^= std::hash<double>{}(n.val.imag());
+					f.add_real(n.val.real());
+					f.add_real(n.val.imag());
 				},
-				[&](const numbers::nan& n) { h ^= std::hash<double>{}(std::numeric_limits<double>::signaling_NaN()); },
+				[](const numbers::nan&) {},
 			}, x.value.p_data);
+		}
+
+		else if constexpr (std::is_same_v<T, detail::negation>)
+			f.add_child(x.child);
 
 		else if constexpr (std::is_same_v<T, detail::addition> || std::is_same_v<T, detail::multiplication>) {
+			f.add_word(static_cast<uint64_t>(x.operands.size()));
 			for (auto* c : x.operands)
-				h ^= std::hash<const detail::node*>{}(c) + 0x9e3779b9;
+				f.add_child(c);
 		}
 
 		else if constexpr (std::is_same_v<T, detail::power>) {
-			h ^= std::hash<const detail::node*>{}(x.base);
-			h ^= std::hash<const detail::node*>{}(x.exponent);
+			f.add_child(x.base);
+			f.add_child(x.exponent);
 		}
 
-		return h;
-	}, k.data);
+		// Ids of registered functions depend on the order they were registered in, names do not
+		else if constexpr (std::is_same_v<T, detail::function_call>) {
+			f.add_text(std::string_view(detail::get_func(x.f_id).name));
+			f.add_word(static_cast<uint64_t>(x.args.size()));
+			for (auto* c : x.args)
+				f.add_child(c);
+		}
+	}, data);
+	return f.finish();
+}
+
+std::size_t node_hash::operator()(const node_key& k) const {
+	return static_cast<size_t>(k.print.low);
 }
 
 
@@ -399,14 +412,7 @@ const detail::node* detail::negation::reduced() const {
 }
 
 const detail::node* detail::negation::expanded() const {
-	return std::visit([&](const auto& x) {
-		using T = std::decay_t<decltype(x)>;
-
-		if constexpr (std::is_same_v<T, addition> || std::is_same_v<T, multiplication> || std::is_same_v<T, power> || std::is_same_v<T, negation>) {
-			return current_context->node_manager().make_negation(x.expanded());
-		}
-		return current_context->node_manager().make_negation(child);
-	}, child->p_data);
+	return expand_polynomial(current_context->node_manager().make_negation(child), current_context->refactoring_rules().max_expansion_terms);
 }
 
 double get_biggest_power(const detail::node* node) {
@@ -448,7 +454,14 @@ const detail::node* detail::addition::sorted() const {
 			}
 		}, op->p_data);
 	}
-	std::ranges::sort(sorted_ops, [](const auto& op1, const auto& op2) {
+	// Operands are compared by text, print each of them once beforehand
+	printer p(print_format::plain, true);
+	std::unordered_map<const node*, std::string> reprs;
+	for (const auto& op : sorted_ops) {
+		term term_ = extract_term(op);
+		reprs.emplace(op, term_.symbolic ? std::string(p.print(term_.symbolic, nullptr, true)) : std::string());
+	}
+	std::ranges::sort(sorted_ops, [&](const auto& op1, const auto& op2) {
 		/* First sort value by type :
 		 * 1. Values
 		 * 2. Variables
@@ -469,13 +482,8 @@ const detail::node* detail::addition::sorted() const {
 
 		if (pw1 != pw2) return pw1 > pw2;
 
-		term term1 = extract_term(op1);
-		term term2 = extract_term(op2);
-		std::string repr1, repr2;
-		if (term1.symbolic)
-			repr1 = extract_term(op1).symbolic->string(nullptr);
-		if (term2.symbolic)
-			repr2 = extract_term(op2).symbolic->string(nullptr);
+		const std::string& repr1 = reprs.at(op1);
+		const std::string& repr2 = reprs.at(op2);
 
 		size_t l1 = repr1.size();
 		size_t l2 = repr2.size();
@@ -580,23 +588,7 @@ const detail::node* detail::addition::reduced() const {
 }
 
 const detail::node* detail::addition::expanded() const {
-	// Just expand sub-expressions, since expanding an addition makes no sense
-	std::vector<const node*> new_expr;
-	for (auto op : operands) {
-		new_expr.push_back(std::visit([&](auto& x) {
-			using T = std::decay_t<decltype(x)>;
-
-			if constexpr (std::is_same_v<T, addition> || std::is_same_v<T, multiplication> || std::is_same_v<T, power> || std::is_same_v<T, negation>) {
-				return x.expanded();
-			}
-			return op;
-		}, op->p_data));
-	}
-
-	if (new_expr.size() == 1) {
-		return new_expr.front();
-	}
-	return current_context->node_manager().make_add(new_expr);
+	return expand_polynomial(current_context->node_manager().make_add(operands), current_context->refactoring_rules().max_expansion_terms);
 }
 
 const detail::node* detail::multiplication::sorted() const {
@@ -612,7 +604,13 @@ const detail::node* detail::multiplication::sorted() const {
 			}
 		}, op->p_data);
 	}
-	std::ranges::sort(sorted_ops, [](const auto& op1, const auto& op2) {
+	// Operands are compared by text, print each of them once beforehand
+	printer p(print_format::plain, true);
+	std::unordered_map<const node*, std::string> reprs;
+	for (const auto& op : sorted_ops) {
+		reprs.emplace(op, p.print(op, nullptr, true));
+	}
+	std::ranges::sort(sorted_ops, [&](const auto& op1, const auto& op2) {
 		/* First sort value by type :
 		 * 1. Values
 		 * 2. Variables
@@ -643,11 +641,11 @@ const detail::node* detail::multiplication::sorted() const {
 
 		if (pw1 != pw2) return pw1 > pw2;
 
-		size_t l1 = op1->string(nullptr).size();
-		size_t l2 = op2->string(nullptr).size();
-		if (l1 != l2) return l1 < l2;
+		const std::string& repr1 = reprs.at(op1);
+		const std::string& repr2 = reprs.at(op2);
+		if (repr1.size() != repr2.size()) return repr1.size() < repr2.size();
 
-		return op1->string(nullptr) < op2->string(nullptr);
+		return repr1 < repr2;
 	});
 
 	return current_context->node_manager().make_mul(sorted_ops);
@@ -762,73 +760,8 @@ const detail::node* detail::multiplication::reduced() const {
 }
 
 const detail::node* detail::multiplication::expanded() const {
-	// HOW : recursively develop expressions and subexpressions
-	//    BASE          DEVELOP       REDUCE
-	// (x+3)(x-2) --> x^2-2x+3x-6 --> x^2+x-6
-	//       BASE                 DEVELOP              REDUCE                   DEVELOP                   REDUCE
-	// (x+3)(x-2)(2x+6) --> (x^2-2x+3x-6)(2x+6) --> (x^2+x-6)(2x+6) --> 2x^3+6x^2+2x^2+6x+12x+36 --> 2x^3+8x^2+18x+36
-	//
-	// Algorithm :
-	// Take first two operands of the multiplication
-	// Create an addition node
-	// For each subexpressions in first operand
-	//     For each subexpressions in second operand
-	std::vector<std::vector<const node*>> all_operands;
-
-	for (auto& op : operands) {
-		const node* expanded = op;
-		std::visit([&](auto& x) {
-			using T = std::decay_t<decltype(x)>;
-
-			// Expand all subexpressions
-			if constexpr (std::is_same_v<T, addition> || std::is_same_v<T, multiplication> || std::is_same_v<T, power> || std::is_same_v<T, negation>) {
-				expanded = x.expanded();
-			}
-			if (std::holds_alternative<addition>(expanded->p_data)) {
-				all_operands.push_back(std::get<addition>(expanded->p_data).operands);
-			}
-			else {
-				all_operands.push_back({expanded});
-			}
-		}, op->p_data);
-	}
-
-	std::vector<std::vector<const node*>> products;
-	products.emplace_back();
-
-	for (const auto& group : all_operands) {
-		std::vector<std::vector<const node*>> new_products;
-
-		for (const auto& prefix : products) {
-			for (const auto& item : group) {
-				std::vector<const node*> next = prefix;
-				next.push_back(item);
-				new_products.push_back(std::move(next));
-			}
-		}
-
-		products = std::move(new_products);
-	}
-
-	auto result = std::make_shared<addition>();
-	std::vector<const node*> final_terms;
-	for (const auto& prod : products) {
-		std::vector<const node*> final_group_terms;
-		for (const auto& factor : prod) {
-			if (factor && !(factor->is_ground() && std::abs(factor->eval(nullptr).get<double>() - 1) < 1e-12)) {
-				final_group_terms.push_back(factor);
-			}
-		}
-		final_terms.push_back(current_context->node_manager().make_mul(final_group_terms));
-	}
-	if (final_terms.empty()) {
-		return nullptr;
-	}
-	if (final_terms.size() == 1) {
-		return final_terms.front();
-	}
-
-	return current_context->node_manager().make_add(final_terms);
+	// Products of sums are developed with sparse polynomials, which merge like terms as they are produced
+	return expand_polynomial(current_context->node_manager().make_mul(operands), current_context->refactoring_rules().max_expansion_terms);
 }
 
 const detail::node* detail::power::reduced() const {
@@ -854,46 +787,12 @@ const detail::node* detail::power::reduced() const {
 }
 
 const detail::node* detail::power::expanded() const {
-	return std::visit([&](auto& x) {
-		using T = std::decay_t<decltype(x)>;
-
-		const node* expanded_base = base;
-		if constexpr (std::is_same_v<T, addition> || std::is_same_v<T, multiplication> || std::is_same_v<T, power> || std::is_same_v<T, negation>) {
-			expanded_base = x.expanded();
-		}
-
-		// If the base is a multiplication, it's easy : distribute power to each operand
-		if (std::holds_alternative<multiplication>(expanded_base->p_data)) {
-			multiplication expanded_data = std::get<multiplication>(expanded_base->p_data);
-			std::vector<const node*> final_terms;
-			for (const auto& op : expanded_data.operands) {
-				final_terms.push_back(current_context->node_manager().make_pow(op, exponent));
-			}
-			return current_context->node_manager().make_mul(final_terms);
-		}
-
-		// If the base is an addition, use the multinomial theorem
-		if (std::holds_alternative<addition>(expanded_base->p_data)) {
-			addition expanded_data = std::get<addition>(expanded_base->p_data);
-			auto nd = exponent->eval(nullptr).get<double>();
-			auto n = static_cast<unsigned long long>(nd);
-			unsigned long long m = expanded_data.operands.size();
-
-			unsigned long long terms_amount = utils::newton_binomial_coefficient(m - 1, n + m - 1);
-			if (!exponent->is_ground() ||
-				terms_amount > current_context->refactoring_rules().max_power_expansion_terms ||
-				!utils::is_integer(nd) || nd <= 0) {
-				return current_context->node_manager().make_pow(base, exponent);
-			}
-		}
-
-		return current_context->node_manager().make_pow(base, exponent);
-	}, base->p_data);
+	return expand_polynomial(current_context->node_manager().make_pow(base, exponent), current_context->refactoring_rules().max_expansion_terms);
 }
 
 
 const detail::node* node_manager_t::intern(detail::node::internal_data_t data) {
-	node_key key{data};
+	node_key key{data, fingerprint_of(data)};
 
 	auto it = table.find(key);
 	if (it != table.end())
@@ -901,6 +800,7 @@ const detail::node* node_manager_t::intern(detail::node::internal_data_t data) {
 
 	auto n = std::make_unique<detail::node>();
 	n->p_hash = node_hash{}(key);
+	n->p_fingerprint = key.print;
 	n->p_data = std::move(data);
 
 	arena.push_back(std::move(n));
@@ -908,6 +808,45 @@ const detail::node* node_manager_t::intern(detail::node::internal_data_t data) {
 	return arena.back().get();
 }
 
+std::unordered_map<const detail::node*, const detail::node*> node_manager_t::import(const node_manager_t& other) {
+	std::unordered_map<const detail::node*, const detail::node*> imported;
+	imported.reserve(other.arena.size() + 1);
+	// Nodes of failed parses may have missing children
+	imported.emplace(nullptr, nullptr);
+	auto remap = [&](std::vector<const detail::node*>& nodes) {
+		for (auto& n : nodes) {
+			n = imported.at(n);
+		}
+	};
+
+	// Children are always created before their parents, so they are imported first
+	for (const auto& n : other.arena) {
+		detail::node::internal_data_t data = n->p_data;
+		std::visit(overloaded {
+			[&](detail::negation& x) { x.child = imported.at(x.child); },
+			[&](detail::addition& x) { remap(x.operands); },
+			[&](detail::multiplication& x) { remap(x.operands); },
+			[&](detail::power& x) {
+				x.base = imported.at(x.base);
+				x.exponent = imported.at(x.exponent);
+			},
+			[&](detail::function_call& x) { remap(x.args); },
+			[](auto&) {},
+		}, data);
+		imported.emplace(n.get(), intern(std::move(data)));
+	}
+	return imported;
+}
+
+std::vector<const detail::node*> node_manager_t::nodes() const {
+	std::vector<const detail::node*> nodes;
+	nodes.reserve(arena.size());
+	for (const auto& n : arena) {
+		nodes.push_back(n.get());
+	}
+	return nodes;
+}
+
 template<typename T>
 std::vector<const detail::node*> flatten(const std::vector<const detail::node*>& args) {
 	std::vector<const detail::node*> flat;
@@ -0,0 +1,788 @@
+#include "symaths/detail/polynomial_kernels.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <complex>
+#include <cstdint>
+#include <map>
+#include <numbers>
+#include <numeric>
+
+using namespace sym;
+
+std::vector<double> detail::multiply_schoolbook(const std::vector<double>& a, const std::vector<double>& b) {
+	if (a.empty() || b.empty()) {
+		return {};
+	}
+	std::vector<double> out(a.size() + b.size() - 1, 0.0);
+	for (size_t i = 0; i < a.size(); ++i) {
+		double ai = a[i];
+		double* o = out.data() + i;
+		for (size_t j = 0; j < b.size(); ++j) {
+			o[j] += ai * b[j];
+		}
+	}
+	return out;
+}
+
+// a and b have n coefficients, out receives the 2n - 1 coefficients of the product
+void karatsuba_square(const double* a, const double* b, size_t n, double* out) {
+	std::fill_n(out, 2 * n - 1, 0.0);
+	if (n <= detail::karatsuba_threshold) {
+		for (size_t i = 0; i < n; ++i) {
+			for (size_t j = 0; j < n; ++j) {
+				out[i + j] += a[i] * b[j];
+			}
+		}
+		return;
+	}
+
+	// a = a0 + a1 x^h, b = b0 + b1 x^h, and (a0 + a1)(b0 + b1) - a0 b0 - a1 b1 is the middle term
+	size_t h = n / 2;
+	size_t k = n - h;
+	std::vector<double> sa(k), sb(k), middle(2 * k - 1);
+	for (size_t i = 0; i < k; ++i) {
+		sa[i] = a[h + i] + (i < h ? a[i] : 0.0);
+		sb[i] = b[h + i] + (i < h ? b[i] : 0.0);
+	}
+
+	karatsuba_square(a, b, h, out);
+	karatsuba_square(a + h, b + h, k, out + 2 * h);
+	karatsuba_square(sa.data(), sb.data(), k, middle.data());
+
+	for (size_t i = 0; i < 2 * h - 1; ++i) {
+		middle[i] -= out[i];
+	}
+	for (size_t i = 0; i < 2 * k - 1; ++i) {
+		middle[i] -= out[2 * h + i];
+	}
+	for (size_t i = 0; i < 2 * k - 1; ++i) {
+		out[h + i] += middle[i];
+	}
+}
+
+std::vector<double> detail::multiply_karatsuba(const std::vector<double>& a, const std::vector<double>& b) {
+	const std::vector<double>& small = a.size() <= b.size() ? a : b;
+	const std::vector<double>& large = a.size() <= b.size() ? b : a;
+	if (small.empty()) {
+		return {};
+	}
+
+	// The largest operand is cut in chunks as large as the smallest one
+	size_t n = small.size();
+	std::vector<double> out(a.size() + b.size() - 1, 0.0);
+	std::vector<double> chunk(n), product(2 * n - 1);
+	for (size_t start = 0; start < large.size(); start += n) {
+		size_t len = std::min(n, large.size() - start);
+		std::copy_n(large.begin() + static_cast<std::ptrdiff_t>(start), len, chunk.begin());
+		std::fill(chunk.begin() + static_cast<std::ptrdiff_t>(len), chunk.end(), 0.0);
+
+		karatsuba_square(small.data(), chunk.data(), n, product.data());
+		for (size_t i = 0; i < product.size() && start + i < out.size(); ++i) {
+			out[start + i] += product[i];
+		}
+	}
+	return out;
+}
+
+void bit_reverse_permute(auto& a) {
+	size_t n = a.size();
+	for (size_t i = 1, j = 0; i < n; ++i) {
+		size_t bit = n >> 1;
+		for (; j & bit; bit >>= 1) {
+			j ^= bit;
+		}
+		j ^= bit;
+		if (i < j) {
+			std::swap(a[i], a[j]);
+		}
+	}
+}
+
+// In place radix-2 transform, roots[k] = exp(-2 i pi k / size) for k < size / 2
+void fft(std::vector<std::complex<double>>& a, const std::vector<std::complex<double>>& roots, bool inverse) {
+	size_t n = a.size();
+	bit_reverse_permute(a);
+
+	for (size_t len = 2; len <= n; len <<= 1) {
+		size_t stride = n / len;
+		size_t half = len / 2;
+		for (size_t start = 0; start < n; start += len) {
+			for (size_t k = 0; k < half; ++k) {
+				// Written out : std::complex multiplication handles infinities through a library call
+				double wr = roots[k * stride].real();
+				double wi = inverse ? -roots[k * stride].imag() : roots[k * stride].imag();
+				std::complex<double> u = a[start + k];
+				std::complex<double> x = a[start + k + half];
+				std::complex<double> v(x.real() * wr - x.imag() * wi, x.real() * wi + x.imag() * wr);
+				a[start + k] = u + v;
+				a[start + k + half] = u - v;
+			}
+		}
+	}
+}
+
+std::vector<double> detail::multiply_fft(const std::vector<double>& a, const std::vector<double>& b) {
+	if (a.empty() || b.empty()) {
+		return {};
+	}
+	size_t size = a.size() + b.size() - 1;
+	size_t n = std::bit_ceil(size);
+
+	std::vector<std::complex<double>> roots(std::max<size_t>(n / 2, 1));
+	for (size_t k = 0; k < roots.size(); ++k) {
+		roots[k] = std::polar(1.0, -2 * std::numbers::pi * static_cast<double>(k) / static_cast<double>(n));
+	}
+
+	std::vector<std::complex<double>> c(n);
+	for (size_t i = 0; i < n; ++i) {
+		c[i] = {i < a.size() ? a[i] : 0.0, i < b.size() ? b[i] : 0.0};
+	}
+	fft(c, roots, false);
+
+	// With C = A + iB, A_k = (C_k + conj(C_-k)) / 2 and B_k = (C_k - conj(C_-k)) / 2i
+	std::vector<std::complex<double>> p(n);
+	for (size_t k = 0; k < n; ++k) {
+		std::complex<double> ck = c[k];
+		std::complex<double> cj = std::conj(c[(n - k) & (n - 1)]);
+		std::complex<double> sum = ck + cj, difference = ck - cj;
+		// sum * difference / 4i
+		double re = sum.real() * difference.real() - sum.imag() * difference.imag();
+		double im = sum.real() * difference.imag() + sum.imag() * difference.real();
+		p[k] = {im / 4, -re / 4};
+	}
+	fft(p, roots, true);
+
+	std::vector<double> out(size);
+	for (size_t i = 0; i < size; ++i) {
+		out[i] = p[i].real() / static_cast<double>(n);
+	}
+	return out;
+}
+
+std::vector<double> detail::multiply_dense(const std::vector<double>& a, const std::vector<double>& b) {
+	size_t small = std::min(a.size(), b.size());
+	if (small < karatsuba_threshold) {
+		return multiply_schoolbook(a, b);
+	}
+	if (small < fft_threshold) {
+		return multiply_karatsuba(a, b);
+	}
+	return multiply_fft(a, b);
+}
+
+
+// Primes p = c 2^k + 1 with a primitive root g, allowing transforms of up to 2^k points.
+// They are template arguments, so that reductions modulo p are multiplications instead of divisions.
+constexpr uint32_t ntt_p0 = 998244353, ntt_p1 = 167772161, ntt_p2 = 469762049;
+constexpr uint32_t ntt_root = 3;
+constexpr unsigned int ntt_max_log = 23;
+
+uint32_t pow_mod(uint64_t base, uint64_t e, uint32_t p) {
+	uint64_t result = 1;
+	base %= p;
+	for (; e; e >>= 1) {
+		if (e & 1) {
+			result = result * base % p;
+		}
+		base = base * base % p;
+	}
+	return static_cast<uint32_t>(result);
+}
+
+template<uint32_t P>
+void ntt(std::vector<uint32_t>& a, bool inverse) {
+	size_t n = a.size();
+	bit_reverse_permute(a);
+
+	std::vector<uint32_t> w(n / 2 + 1);
+	for (size_t len = 2; len <= n; len <<= 1) {
+		uint32_t w_len = pow_mod(ntt_root, (P - 1) / len, P);
+		if (inverse) {
+			w_len = pow_mod(w_len, P - 2, P);
+		}
+		size_t half = len / 2;
+		w[0] = 1;
+		for (size_t k = 1; k < half; ++k) {
+			w[k] = static_cast<uint32_t>(static_cast<uint64_t>(w[k - 1]) * w_len % P);
+		}
+
+		for (size_t start = 0; start < n; start += len) {
+			for (size_t k = 0; k < half; ++k) {
+				uint32_t u = a[start + k];
+				auto v = static_cast<uint32_t>(static_cast<uint64_t>(a[start + k + half]) * w[k] % P);
+				a[start + k] = u + v >= P ? u + v - P : u + v;
+				a[start + k + half] = u >= v ? u - v : u + P - v;
+			}
+		}
+	}
+
+	if (inverse) {
+		uint64_t n_inv = pow_mod(n, P - 2, P);
+		for (auto& x : a) {
+			x = static_cast<uint32_t>(x * n_inv % P);
+		}
+	}
+}
+
+template<uint32_t P>
+std::vector<uint32_t> ntt_product(const std::vector<long long>& a, const std::vector<long long>& b, size_t n) {
+	auto reduce = [](long long x) {
+		long long r = x % static_cast<long long>(P);
+		return static_cast<uint32_t>(r < 0 ? r + P : r);
+	};
+	std::vector<uint32_t> fa(n, 0), fb(n, 0);
+	std::ranges::transform(a, fa.begin(), reduce);
+	std::ranges::transform(b, fb.begin(), reduce);
+	ntt<P>(fa, false);
+	ntt<P>(fb, false);
+	for (size_t i = 0; i < n; ++i) {
+		fa[i] = static_cast<uint32_t>(static_cast<uint64_t>(fa[i]) * fb[i] % P);
+	}
+	ntt<P>(fa, true);
+	return fa;
+}
+
+std::optional<std::vector<long long>> detail::multiply_ntt(const std::vector<long long>& a, const std::vector<long long>& b) {
+	if (a.empty() || b.empty()) {
+		return std::vector<long long>{};
+	}
+	size_t size = a.size() + b.size() - 1;
+	size_t n = std::bit_ceil(size);
+	if (std::bit_width(n) - 1 > ntt_max_log) {
+		return std::nullopt;
+	}
+
+	// Every coefficient of the product must fit in 64 bits, which is far below half of the product of the primes
+	auto max_abs = [](const std::vector<long long>& v) {
+		unsigned __int128 m = 0;
+		for (long long x : v) {
+			m = std::max<unsigned __int128>(m, x < 0 ? -static_cast<unsigned __int128>(x) : static_cast<unsigned __int128>(x));
+		}
+		return m;
+	};
+	unsigned __int128 bound = max_abs(a) * max_abs(b);
+	if (bound != 0 && bound > static_cast<unsigned __int128>(INT64_MAX) / std::min(a.size(), b.size())) {
+		return std::nullopt;
+	}
+
+	auto r0 = ntt_product<ntt_p0>(a, b, n);
+	auto r1 = ntt_product<ntt_p1>(a, b, n);
+	auto r2 = ntt_product<ntt_p2>(a, b, n);
+
+	// Garner's algorithm : x = r0 + p0 (k1 + p1 k2)
+	const uint64_t p0 = ntt_p0, p1 = ntt_p1, p2 = ntt_p2;
+	const uint64_t p0_inv_p1 = pow_mod(p0, p1 - 2, static_cast<uint32_t>(p1));
+	const uint64_t p01_inv_p2 = pow_mod(p0 * p1 % p2, p2 - 2, static_cast<uint32_t>(p2));
+	const unsigned __int128 p01 = static_cast<unsigned __int128>(p0) * p1;
+	const unsigned __int128 modulus = p01 * p2;
+
+	std::vector<long long> out(size);
+	for (size_t i = 0; i < size; ++i) {
+		uint64_t k1 = (r1[i] + p1 - r0[i] % p1) % p1 * p0_inv_p1 % p1;
+		unsigned __int128 x01 = r0[i] + static_cast<unsigned __int128>(p0) * k1;
+		uint64_t k2 = (r2[i] + p2 - static_cast<uint64_t>(x01 % p2)) % p2 * p01_inv_p2 % p2;
+		unsigned __int128 x = x01 + p01 * k2;
+		out[i] = x > modulus / 2 ? -static_cast<long long>(modulus - x) : static_cast<long long>(x);
+	}
+	return out;
+}
+
+std::vector<number> multiply_numbers_schoolbook(const std::vector<number>& a, const std::vector<number>& b) {
+	if (a.empty() || b.empty()) {
+		return {};
+	}
+	std::vector<number> out(a.size() + b.size() - 1, number(numbers::natural{0}));
+	for (size_t i = 0; i < a.size(); ++i) {
+		for (size_t j = 0; j < b.size(); ++j) {
+			out[i + j] += a[i] * b[j];
+		}
+	}
+	return out;
+}
+
+// Scales rational coefficients to integers : v = scaled / denominator, or nothing if a coefficient is not rational
+std::optional<std::pair<std::vector<long long>, long long>> scaled_to_integers(const std::vector<number>& v) {
+	long long denominator = 1;
+	for (auto& c : v) {
+		if (auto* q = std::get_if<numbers::rational>(&c.p_data)) {
+			__int128 l = static_cast<__int128>(denominator) / std::gcd(denominator, std::abs(q->den)) * std::abs(q->den);
+			if (l > INT64_MAX) {
+				return std::nullopt;
+			}
+			denominator = static_cast<long long>(l);
+		}
+		else if (!std::holds_alternative<numbers::natural>(c.p_data) && !std::holds_alternative<numbers::integer>(c.p_data)) {
+			return std::nullopt;
+		}
+	}
+
+	std::vector<long long> scaled;
+	scaled.reserve(v.size());
+	for (auto& c : v) {
+		__int128 s = std::visit(overloaded {
+			[&](const numbers::natural& n) -> __int128 { return static_cast<__int128>(n.val) * denominator; },
+			[&](const numbers::integer& n) -> __int128 { return static_cast<__int128>(n.val) * denominator; },
+			[&](const numbers::rational& q) -> __int128 { return static_cast<__int128>(q.num) * (denominator / q.den); },
+			[&](const auto&) -> __int128 { return 0; },
+		}, c.p_data);
+		if (s > INT64_MAX || s < INT64_MIN) {
+			return std::nullopt;
+		}
+		scaled.push_back(static_cast<long long>(s));
+	}
+	return std::pair{std::move(scaled), denominator};
+}
+
+std::vector<number> detail::multiply_dense(const std::vector<number>& a, const std::vector<number>& b) {
+	if (std::min(a.size(), b.size()) < fft_threshold) {
+		return multiply_numbers_schoolbook(a, b);
+	}
+
+	auto sa = scaled_to_integers(a);
+	auto sb = scaled_to_integers(b);
+	if (!sa || !sb) {
+		return multiply_numbers_schoolbook(a, b);
+	}
+	__int128 denominator = static_cast<__int128>(sa->second) * sb->second;
+	auto product = multiply_ntt(sa->first, sb->first);
+	if (!product || denominator > INT64_MAX) {
+		return multiply_numbers_schoolbook(a, b);
+	}
+
+	std::vector<number> out;
+	out.reserve(product->size());
+	for (long long c : *product) {
+		number n = denominator == 1 ? number(numbers::integer{c}) : number(numbers::rational{c, static_cast<long long>(denominator)});
+		n.downcast();
+		out.push_back(n);
+	}
+	return out;
+}
+
+
+uint32_t previous_prime(uint32_t n) {
+	for (uint32_t c = n - 1;; --c) {
+		bool prime = c > 1;
+		for (uint32_t d = 2; d * d <= c && prime; ++d) {
+			prime = c % d != 0;
+		}
+		if (prime) {
+			return c;
+		}
+	}
+}
+
+// Monic gcd modulo p, by Euclid's algorithm
+std::vector<uint32_t> gcd_modulo(std::vector<uint32_t> a, std::vector<uint32_t> b, uint32_t p) {
+	auto trim = [](std::vector<uint32_t>& v) {
+		while (!v.empty() && v.back() == 0) {
+			v.pop_back();
+		}
+	};
+	trim(a);
+	trim(b);
+	while (!b.empty()) {
+		uint64_t inverse = pow_mod(b.back(), p - 2, p);
+		while (a.size() >= b.size()) {
+			uint64_t factor = a.back() * inverse % p;
+			size_t shift = a.size() - b.size();
+			for (size_t i = 0; i < b.size(); ++i) {
+				a[shift + i] = static_cast<uint32_t>((a[shift + i] + p - factor * b[i] % p) % p);
+			}
+			trim(a);
+		}
+		std::swap(a, b);
+	}
+	uint64_t inverse = pow_mod(a.back(), p - 2, p);
+	for (auto& c : a) {
+		c = static_cast<uint32_t>(c * inverse % p);
+	}
+	return a;
+}
+
+// Whether g divides a in Z[x]
+bool divides_exactly(const std::vector<long long>& a, const std::vector<long long>& g) {
+	constexpr __int128 limit = static_cast<__int128>(1) << 100;
+	std::vector<__int128> r(a.begin(), a.end());
+	for (size_t k = r.size(); k-- > g.size() - 1;) {
+		if (r[k] % g.back() != 0) {
+			return false;
+		}
+		__int128 q = r[k] / g.back();
+		if (q > INT64_MAX || q < INT64_MIN) {
+			return false;
+		}
+		for (size_t i = 0; i < g.size(); ++i) {
+			__int128& c = r[k - (g.size() - 1) + i];
+			c -= q * g[i];
+			if (c > limit || c < -limit) {
+				return false;
+			}
+		}
+	}
+	return std::all_of(r.begin(), r.begin() + static_cast<std::ptrdiff_t>(g.size() - 1), [](__int128 c) { return c == 0; });
+}
+
+std::optional<std::vector<long long>> detail::gcd_modular(const std::vector<long long>& a, const std::vector<long long>& b) {
+	constexpr int max_primes = 64;
+	constexpr __int128 max_modulus = static_cast<__int128>(1) << 120;
+
+	// The gcd modulo p of primitive polynomials is their gcd times a unit : it is scaled so that its leading
+	// coefficient is the gcd of the leading coefficients, a multiple of the leading coefficient of the gcd
+	long long leading = std::gcd(a.back(), b.back());
+	size_t degree = SIZE_MAX;
+	std::vector<__int128> candidate;
+	__int128 modulus = 1;
+
+	uint32_t p = 1u << 31;
+	for (int attempt = 0; attempt < max_primes; ++attempt) {
+		p = previous_prime(p);
+		if (a.back() % p == 0 || b.back() % p == 0) {
+			continue;
+		}
+		auto reduce = [&](const std::vector<long long>& v) {
+			std::vector<uint32_t> out(v.size());
+			std::ranges::transform(v, out.begin(), [&](long long c) {
+				long long r = c % static_cast<long long>(p);
+				return static_cast<uint32_t>(r < 0 ? r + p : r);
+			});
+			return out;
+		};
+		std::vector<uint32_t> g = gcd_modulo(reduce(a), reduce(b), p);
+		if (g.size() == 1) {
+			return std::vector<long long>{1};
+		}
+		// Primes dividing a resultant give a gcd of higher degree, which is wrong
+		if (g.size() - 1 > degree) {
+			continue;
+		}
+		uint64_t scale = static_cast<uint64_t>(leading % static_cast<long long>(p) + p) % p;
+		for (auto& c : g) {
+			c = static_cast<uint32_t>(c * scale % p);
+		}
+
+		if (g.size() - 1 < degree) {
+			degree = g.size() - 1;
+			candidate.assign(g.begin(), g.end());
+			modulus = p;
+		}
+		else {
+			if (modulus > max_modulus) {
+				return std::nullopt;
+			}
+			// x = candidate (mod modulus) and x = g (mod p)
+			uint64_t inverse = pow_mod(static_cast<uint64_t>(modulus % p), p - 2, p);
+			for (size_t i = 0; i < g.size(); ++i) {
+				auto residue = static_cast<uint64_t>(candidate[i] % p);
+				uint64_t t = (g[i] + p - residue) % p * inverse % p;
+				candidate[i] += modulus * t;
+			}
+			modulus *= p;
+		}
+
+		// Symmetric representatives, made primitive
+		std::vector<long long> result;
+		bool fits = true;
+		long long content = 0;
+		for (__int128 c : candidate) {
+			__int128 s = c > modulus / 2 ? c - modulus : c;
+			if (s > INT64_MAX || s < INT64_MIN) {
+				fits = false;
+				break;
+			}
+			result.push_back(static_cast<long long>(s));
+			content = std::gcd(content, static_cast<long long>(s));
+		}
+		if (!fits || content == 0) {
+			continue;
+		}
+		if (result.back() < 0) {
+			content = -content;
+		}
+		for (auto& c : result) {
+			c /= content;
+		}
+		if (divides_exactly(a, result) && divides_exactly(b, result)) {
+			return result;
+		}
+	}
+	return std::nullopt;
+}
+
+// Multivariate polynomial modulo p : coefficients by decreasing exponents
+using modular_polynomial = std::map<std::vector<uint64_t>, uint32_t, std::greater<>>;
+// Multivariate polynomial modulo p as a polynomial in its last variable : coefficients dense in the last variable, by
+// decreasing exponents of the other variables
+using modular_recursive = std::map<std::vector<uint64_t>, std::vector<uint32_t>, std::greater<>>;
+
+uint32_t evaluate_modulo(const std::vector<uint32_t>& a, uint64_t x, uint32_t p) {
+	uint64_t result = 0;
+	for (size_t i = a.size(); i-- > 0;) {
+		result = (result * x + a[i]) % p;
+	}
+	return static_cast<uint32_t>(result);
+}
+
+std::vector<uint32_t> multiply_modulo(const std::vector<uint32_t>& a, const std::vector<uint32_t>& b, uint32_t p) {
+	if (a.empty() || b.empty()) {
+		return {};
+	}
+	std::vector<uint32_t> c(a.size() + b.size() - 1, 0);
+	for (size_t i = 0; i < a.size(); ++i) {
+		for (size_t j = 0; j < b.size(); ++j) {
+			c[i + j] = static_cast<uint32_t>((c[i + j] + static_cast<uint64_t>(a[i]) * b[j]) % p);
+		}
+	}
+	return c;
+}
+
+// Quotient modulo p of a by b, which divides it
+std::vector<uint32_t> divide_modulo(std::vector<uint32_t> a, const std::vector<uint32_t>& b, uint32_t p) {
+	if (a.size() < b.size()) {
+		return {};
+	}
+	std::vector<uint32_t> q(a.size() - b.size() + 1);
+	uint64_t inverse = pow_mod(b.back(), p - 2, p);
+	for (size_t k = q.size(); k-- > 0;) {
+		uint64_t factor = a[k + b.size() - 1] * inverse % p;
+		q[k] = static_cast<uint32_t>(factor);
+		for (size_t i = 0; i < b.size(); ++i) {
+			a[k + i] = static_cast<uint32_t>((a[k + i] + p - factor * b[i] % p) % p);
+		}
+	}
+	return q;
+}
+
+modular_recursive split_last(const modular_polynomial& a) {
+	modular_recursive r;
+	for (const auto& [exponents, c] : a) {
+		auto& coefficient = r[std::vector<uint64_t>(exponents.begin(), exponents.end() - 1)];
+		if (coefficient.size() <= exponents.back()) {
+			coefficient.resize(exponents.back() + 1, 0);
+		}
+		coefficient[exponents.back()] = c;
+	}
+	return r;
+}
+
+modular_polynomial evaluate_last(const modular_recursive& a, uint64_t x, uint32_t p) {
+	modular_polynomial out;
+	for (const auto& [exponents, coefficient] : a) {
+		if (uint32_t v = evaluate_modulo(coefficient, x, p)) {
+			out.emplace_hint(out.end(), exponents, v);
+		}
+	}
+	return out;
+}
+
+// Divides the coefficients by their gcd, a polynomial in the last variable, and returns it
+std::vector<uint32_t> remove_content_modulo(modular_recursive& a, uint32_t p) {
+	std::vector<uint32_t> content;
+	for (const auto& [exponents, coefficient] : a) {
+		content = gcd_modulo(std::move(content), coefficient, p);
+	}
+	for (auto& [exponents, coefficient] : a) {
+		coefficient = divide_modulo(std::move(coefficient), content, p);
+	}
+	return content;
+}
+
+// Monic gcd modulo p of non-zero polynomials in the same variables (Brown's algorithm). Primitive polynomials in the
+// last variable have a gcd whose leading coefficient in the other variables divides the gcd of their leading
+// coefficients : scaled by it, the gcd is interpolated from its images at enough points. Points where the image has
+// a larger leading monomial are unlucky, and a smaller one shows the previous points were.
+std::optional<modular_polynomial> gcd_modulo_multivariate(const modular_polynomial& a, const modular_polynomial& b, uint32_t p, size_t& work) {
+	if (work == 0) {
+		return std::nullopt;
+	}
+	--work;
+	modular_recursive ra = split_last(a), rb = split_last(b);
+	std::vector<uint32_t> content = gcd_modulo(remove_content_modulo(ra, p), remove_content_modulo(rb, p), p);
+
+	// Without other variables, primitive polynomials are constants
+	modular_recursive h;
+	if (a.begin()->first.size() == 1) {
+		h.emplace(std::vector<uint64_t>{}, std::vector<uint32_t>{1});
+	}
+	else {
+		auto degree = [](const modular_recursive& r) {
+			size_t d = 0;
+			for (const auto& [exponents, coefficient] : r) {
+				d = std::max(d, coefficient.size() - 1);
+			}
+			return d;
+		};
+		const std::vector<uint32_t>& la = ra.begin()->second;
+		const std::vector<uint32_t>& lb = rb.begin()->second;
+		std::vector<uint32_t> leading = gcd_modulo(la, lb, p);
+		size_t bound = leading.size() - 1 + std::min(degree(ra), degree(rb));
+
+		std::vector<uint32_t> q{1};
+		std::vector<uint64_t> monomial;
+		for (uint64_t x = 0; q.size() <= bound + 1; ++x) {
+			if (x == p) {
+				return std::nullopt;
+			}
+			if (evaluate_modulo(la, x, p) == 0 || evaluate_modulo(lb, x, p) == 0) {
+				continue;
+			}
+			auto image = gcd_modulo_multivariate(evaluate_last(ra, x, p), evaluate_last(rb, x, p), p, work);
+			if (!image) {
+				return std::nullopt;
+			}
+			if (!h.empty() && image->begin()->first > monomial) {
+				continue;
+			}
+			if (h.empty() || image->begin()->first < monomial) {
+				h.clear();
+				q = {1};
+				monomial = image->begin()->first;
+			}
+
+			// Newton interpolation : h += (image - h(x)) q / q(x)
+			uint64_t scale = evaluate_modulo(leading, x, p);
+			uint64_t inverse = pow_mod(evaluate_modulo(q, x, p), p - 2, p);
+			for (const auto& [exponents, c] : *image) {
+				h.try_emplace(exponents);
+			}
+			for (auto& [exponents, coefficient] : h) {
+				auto it = image->find(exponents);
+				uint64_t target = it == image->end() ? 0 : it->second * scale % p;
+				uint64_t t = (target + p - evaluate_modulo(coefficient, x, p)) % p * inverse % p;
+				coefficient.resize(std::max(coefficient.size(), q.size()), 0);
+				for (size_t i = 0; i < q.size(); ++i) {
+					coefficient[i] = static_cast<uint32_t>((coefficient[i] + t * q[i]) % p);
+				}
+			}
+			q = multiply_modulo(q, {static_cast<uint32_t>((p - x) % p), 1}, p);
+		}
+
+		for (auto it = h.begin(); it != h.end();) {
+			while (!it->second.empty() && it->second.back() == 0) {
+				it->second.pop_back();
+			}
+			it = it->second.empty() ? h.erase(it) : std::next(it);
+		}
+		remove_content_modulo(h, p);
+	}
+
+	modular_polynomial result;
+	for (const auto& [exponents, coefficient] : h) {
+		std::vector<uint32_t> product = multiply_modulo(coefficient, content, p);
+		for (size_t e = product.size(); e-- > 0;) {
+			if (product[e] != 0) {
+				std::vector<uint64_t> monomial = exponents;
+				monomial.push_back(e);
+				result.emplace_hint(result.end(), std::move(monomial), product[e]);
+			}
+		}
+	}
+	uint64_t inverse = pow_mod(result.begin()->second, p - 2, p);
+	for (auto& [exponents, c] : result) {
+		c = static_cast<uint32_t>(c * inverse % p);
+	}
+	return result;
+}
+
+std::optional<std::vector<detail::integer_term>> detail::gcd_modular(const std::vector<integer_term>& a, const std::vector<integer_term>& b, const std::function<bool(const std::vector<integer_term>&)>& accept, size_t max_work) {
+	constexpr int max_primes = 64;
+	constexpr __int128 max_modulus = static_cast<__int128>(1) << 120;
+
+	// As for univariate polynomials, the gcd modulo p is scaled so that its leading coefficient is the gcd of the
+	// leading coefficients
+	auto leading = [](const std::vector<integer_term>& v) {
+		return std::ranges::max(v, {}, &integer_term::exponents).coefficient;
+	};
+	long long la = leading(a), lb = leading(b);
+	long long unit = std::gcd(la, lb);
+	std::map<std::vector<uint64_t>, __int128, std::greater<>> candidate;
+	__int128 modulus = 1;
+	size_t work = max_work;
+
+	uint32_t p = 1u << 31;
+	for (int attempt = 0; attempt < max_primes; ++attempt) {
+		p = previous_prime(p);
+		if (la % p == 0 || lb % p == 0) {
+			continue;
+		}
+		auto reduce = [&](const std::vector<integer_term>& v) {
+			modular_polynomial out;
+			for (const auto& t : v) {
+				long long r = t.coefficient % static_cast<long long>(p);
+				if (r != 0) {
+					out.emplace(t.exponents, static_cast<uint32_t>(r < 0 ? r + p : r));
+				}
+			}
+			return out;
+		};
+		auto g = gcd_modulo_multivariate(reduce(a), reduce(b), p, work);
+		if (!g) {
+			return std::nullopt;
+		}
+		const std::vector<uint64_t>& monomial = g->begin()->first;
+		if (std::ranges::all_of(monomial, [](uint64_t e) { return e == 0; })) {
+			return std::vector<integer_term>{{monomial, 1}};
+		}
+		// Primes for which the gcd has a larger leading monomial are unlucky
+		if (!candidate.empty() && monomial > candidate.begin()->first) {
+			continue;
+		}
+
+		auto scale = static_cast<uint64_t>(unit % static_cast<long long>(p));
+		if (candidate.empty() || monomial < candidate.begin()->first) {
+			candidate.clear();
+			for (const auto& [exponents, c] : *g) {
+				candidate.emplace(exponents, c * scale % p);
+			}
+			modulus = p;
+		}
+		else {
+			if (modulus > max_modulus) {
+				return std::nullopt;
+			}
+			// x = candidate (mod modulus) and x = g (mod p)
+			uint64_t inverse = pow_mod(static_cast<uint64_t>(modulus % p), p - 2, p);
+			for (const auto& [exponents, c] : *g) {
+				candidate.try_emplace(exponents, 0);
+			}
+			for (auto& [exponents, c] : candidate) {
+				auto it = g->find(exponents);
+				uint64_t residue = it == g->end() ? 0 : it->second * scale % p;
+				uint64_t t = (residue + p - static_cast<uint64_t>(c % p)) % p * inverse % p;
+				c += modulus * t;
+			}
+			modulus *= p;
+		}
+
+		// Symmetric representatives, made primitive
+		std::vector<integer_term> result;
+		bool fits = true;
+		long long content = 0;
+		for (const auto& [exponents, c] : candidate) {
+			__int128 s = c > modulus / 2 ? c - modulus : c;
+			if (s > INT64_MAX || s < INT64_MIN) {
+				fits = false;
+				break;
+			}
+			if (s != 0) {
+				result.push_back({exponents, static_cast<long long>(s)});
+				content = std::gcd(content, static_cast<long long>(s));
+			}
+		}
+		if (!fits || content == 0) {
+			continue;
+		}
+		if (result.front().coefficient < 0) {
+			content = -content;
+		}
+		for (auto& t : result) {
+			t.coefficient /= content;
+		}
+		if (accept(result)) {
+			return result;
+		}
+	}
+	return std::nullopt;
+}
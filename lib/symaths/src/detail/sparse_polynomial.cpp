@@ -0,0 +1,1283 @@
+#include "symaths/detail/sparse_polynomial.hpp"
+
+#include "symaths/detail/polynomial_kernels.hpp"
+#include "symaths/symaths.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <complex>
+#include <limits>
+#include <numeric>
+#include <optional>
+#include <stdexcept>
+#include <unordered_map>
+
+using namespace sym;
+
+detail::monomial_layout::monomial_layout(std::vector<const node*> generators, uint64_t max_degree, monomial_order order)
+	: generators(std::move(generators)), order(order) {
+	bits = std::max(1u, static_cast<unsigned int>(std::bit_width(max_degree)));
+	per_word = 64 / bits;
+	words = (this->generators.size() + per_word - 1) / per_word + (order == monomial_order::lex ? 0 : 1);
+}
+
+// Word and shift of the exponent of a generator
+std::pair<size_t, size_t> exponent_position(const detail::monomial_layout& layout, size_t generator) {
+	size_t slot = layout.order == monomial_order::grevlex ? layout.generators.size() - 1 - generator : generator;
+	size_t offset = layout.order == monomial_order::lex ? 0 : 1;
+	return {offset + slot / layout.per_word, (layout.per_word - 1 - slot % layout.per_word) * layout.bits};
+}
+
+uint64_t detail::monomial_layout::exponent(const uint64_t* monomial, size_t generator) const {
+	auto [word, shift] = exponent_position(*this, generator);
+	return monomial[word] >> shift & max_exponent();
+}
+
+void detail::monomial_layout::set_exponent(uint64_t* monomial, size_t generator, uint64_t exponent) const {
+	if (order != monomial_order::lex) {
+		monomial[0] += exponent - this->exponent(monomial, generator);
+	}
+	auto [word, shift] = exponent_position(*this, generator);
+	uint64_t mask = max_exponent();
+	monomial[word] = (monomial[word] & ~(mask << shift)) | (exponent & mask) << shift;
+}
+
+
+bool is_zero_coefficient(const number& n) {
+	if (number::get_rank(n.p_data) == number::rank::NaN) {
+		return false;
+	}
+	return n.get<std::complex<double>>() == std::complex<double>(0);
+}
+
+// Numerator and denominator of exact numbers
+std::optional<std::pair<long long, long long>> exact_fraction(const number& n) {
+	if (auto* x = std::get_if<numbers::natural>(&n.p_data)) {
+		if (x->val > static_cast<unsigned long long>(std::numeric_limits<long long>::max())) {
+			return std::nullopt;
+		}
+		return std::pair{static_cast<long long>(x->val), 1LL};
+	}
+	if (auto* x = std::get_if<numbers::integer>(&n.p_data)) {
+		return std::pair{x->val, 1LL};
+	}
+	if (auto* x = std::get_if<numbers::rational>(&n.p_data)) {
+		return x->den < 0 ? std::pair{-x->num, -x->den} : std::pair{x->num, x->den};
+	}
+	return std::nullopt;
+}
+
+// Arithmetic on coefficients : exact numbers stay exact while their numerators and denominators fit in 64 bits, and
+// become reals past it instead of overflowing
+number coefficient_of_fraction(__int128 num, __int128 den) {
+	if (den < 0) {
+		num = -num;
+		den = -den;
+	}
+	__int128 a = num < 0 ? -num : num, b = den;
+	while (b != 0) {
+		__int128 r = a % b;
+		a = b;
+		b = r;
+	}
+	if (a > 1) {
+		num /= a;
+		den /= a;
+	}
+	if (num < std::numeric_limits<long long>::min() || num > std::numeric_limits<long long>::max() || den > std::numeric_limits<long long>::max()) {
+		return numbers::real{static_cast<double>(num) / static_cast<double>(den)};
+	}
+	number n = den == 1 ? number(numbers::integer{static_cast<long long>(num)}) : number(numbers::rational{static_cast<long long>(num), static_cast<long long>(den)});
+	n.downcast();
+	return n;
+}
+
+number add_coefficients(const number& a, const number& b) {
+	auto x = exact_fraction(a);
+	auto y = exact_fraction(b);
+	if (!x || !y) {
+		return a + b;
+	}
+	long long sum;
+	if (x->second == 1 && y->second == 1 && !__builtin_add_overflow(x->first, y->first, &sum)) {
+		number n = numbers::integer{sum};
+		n.downcast();
+		return n;
+	}
+	return coefficient_of_fraction(static_cast<__int128>(x->first) * y->second + static_cast<__int128>(y->first) * x->second, static_cast<__int128>(x->second) * y->second);
+}
+
+number multiply_coefficients(const number& a, const number& b) {
+	auto x = exact_fraction(a);
+	auto y = exact_fraction(b);
+	if (!x || !y) {
+		return a * b;
+	}
+	long long product;
+	if (x->second == 1 && y->second == 1 && !__builtin_mul_overflow(x->first, y->first, &product)) {
+		number n = numbers::integer{product};
+		n.downcast();
+		return n;
+	}
+	return coefficient_of_fraction(static_cast<__int128>(x->first) * y->first, static_cast<__int128>(x->second) * y->second);
+}
+
+number divide_coefficients(const number& a, const number& b) {
+	auto x = exact_fraction(a);
+	auto y = exact_fraction(b);
+	if (!x || !y || y->first == 0) {
+		return a / b;
+	}
+	return coefficient_of_fraction(static_cast<__int128>(x->first) * y->second, static_cast<__int128>(x->second) * y->first);
+}
+
+detail::sparse_polynomial::sparse_polynomial(const monomial_layout& layout) : m_layout(&layout) {}
+
+void detail::sparse_polynomial::push_term(const uint64_t* monomial, const number& coefficient) {
+	if (is_zero_coefficient(coefficient)) {
+		return;
+	}
+	m_monomials.insert(m_monomials.end(), monomial, monomial + m_layout->words);
+	m_coefficients.push_back(coefficient);
+}
+
+detail::sparse_polynomial detail::sparse_polynomial::constant(const monomial_layout& layout, const number& value) {
+	sparse_polynomial p(layout);
+	std::vector<uint64_t> one(layout.words, 0);
+	number v = value;
+	v.downcast();
+	p.push_term(one.data(), v);
+	return p;
+}
+
+detail::sparse_polynomial detail::sparse_polynomial::generator(const monomial_layout& layout, size_t index, uint64_t exponent) {
+	sparse_polynomial p(layout);
+	std::vector<uint64_t> monomial(layout.words, 0);
+	layout.set_exponent(monomial.data(), index, exponent);
+	p.push_term(monomial.data(), numbers::natural{1});
+	return p;
+}
+
+detail::sparse_polynomial detail::sparse_polynomial::sum(const monomial_layout& layout, const std::vector<const sparse_polynomial*>& operands) {
+	std::vector<std::pair<const sparse_polynomial*, size_t>> terms;
+	for (auto* p : operands) {
+		for (size_t t = 0; t < p->size(); ++t) {
+			terms.emplace_back(p, t);
+		}
+	}
+	std::ranges::sort(terms, [&](const auto& a, const auto& b) {
+		return layout.compare(a.first->monomial(a.second), b.first->monomial(b.second)) > 0;
+	});
+
+	sparse_polynomial result(layout);
+	for (size_t i = 0; i < terms.size();) {
+		const uint64_t* monomial = terms[i].first->monomial(terms[i].second);
+		number coefficient = terms[i].first->coefficient(terms[i].second);
+		size_t j = i + 1;
+		for (; j < terms.size() && layout.compare(terms[j].first->monomial(terms[j].second), monomial) == 0; ++j) {
+			coefficient = add_coefficients(coefficient, terms[j].first->coefficient(terms[j].second));
+		}
+		result.push_term(monomial, coefficient);
+		i = j;
+	}
+	return result;
+}
+
+bool detail::sparse_polynomial::is_exact() const {
+	return std::ranges::all_of(m_coefficients, [](const number& c) { return exact_fraction(c).has_value(); });
+}
+
+uint64_t detail::sparse_polynomial::degree(size_t generator) const {
+	uint64_t result = 0;
+	for (size_t t = 0; t < size(); ++t) {
+		result = std::max(result, m_layout->exponent(monomial(t), generator));
+	}
+	return result;
+}
+
+std::optional<detail::sparse_polynomial> detail::sparse_polynomial::add(const sparse_polynomial& other, size_t max_terms) const {
+	sparse_polynomial result(*m_layout);
+	size_t i = 0, j = 0;
+	while (i < size() || j < other.size()) {
+		int c = i == size() ? -1 : j == other.size() ? 1 : m_layout->compare(monomial(i), other.monomial(j));
+		if (c > 0) {
+			result.push_term(monomial(i), coefficient(i));
+			++i;
+		}
+		else if (c < 0) {
+			result.push_term(other.monomial(j), other.coefficient(j));
+			++j;
+		}
+		else {
+			result.push_term(monomial(i), add_coefficients(coefficient(i), other.coefficient(j)));
+			++i;
+			++j;
+		}
+		if (result.size() > max_terms) {
+			return std::nullopt;
+		}
+	}
+	return result;
+}
+
+detail::sparse_polynomial detail::sparse_polynomial::operator+(const sparse_polynomial& other) const {
+	return *add(other, std::numeric_limits<size_t>::max());
+}
+
+detail::sparse_polynomial detail::sparse_polynomial::operator-() const {
+	sparse_polynomial result = *this;
+	for (auto& c : result.m_coefficients) {
+		c = multiply_coefficients(c, numbers::integer{-1});
+	}
+	return result;
+}
+
+std::optional<detail::sparse_polynomial> detail::sparse_polynomial::multiply(const sparse_polynomial& other, size_t max_terms) const {
+	// Rows are the terms of the smallest polynomial, each one multiplied by every term of the other
+	const sparse_polynomial& rows = size() <= other.size() ? *this : other;
+	const sparse_polynomial& columns = size() <= other.size() ? other : *this;
+	size_t words = m_layout->words;
+
+	sparse_polynomial result(*m_layout);
+	if (rows.size() == 0) {
+		return result;
+	}
+
+	// Current column of each row, and the monomial of its current product
+	std::vector<size_t> column(rows.size(), 0);
+	std::vector<uint64_t> products(rows.size() * words);
+	auto product_of = [&](size_t row) { return products.data() + row * words; };
+	auto update = [&](size_t row) {
+		for (size_t w = 0; w < words; ++w) {
+			product_of(row)[w] = rows.monomial(row)[w] + columns.monomial(column[row])[w];
+		}
+	};
+	auto smaller = [&](size_t a, size_t b) { return m_layout->compare(product_of(a), product_of(b)) < 0; };
+
+	// A row only enters the heap once the first product of the previous one is out : it can't be larger before
+	std::vector<size_t> heap{0};
+	update(0);
+
+	std::vector<uint64_t> current(words);
+	while (!heap.empty()) {
+		std::copy_n(product_of(heap.front()), words, current.begin());
+		number sum = numbers::natural{0};
+
+		while (!heap.empty() && m_layout->compare(product_of(heap.front()), current.data()) == 0) {
+			std::ranges::pop_heap(heap, smaller);
+			size_t row = heap.back();
+			heap.pop_back();
+
+			sum = add_coefficients(sum, multiply_coefficients(rows.coefficient(row), columns.coefficient(column[row])));
+
+			if (column[row] == 0 && row + 1 < rows.size()) {
+				update(row + 1);
+				heap.push_back(row + 1);
+				std::ranges::push_heap(heap, smaller);
+			}
+			if (++column[row] < columns.size()) {
+				update(row);
+				heap.push_back(row);
+				std::ranges::push_heap(heap, smaller);
+			}
+		}
+		result.push_term(current.data(), sum);
+		if (result.size() > max_terms) {
+			return std::nullopt;
+		}
+	}
+	return result;
+}
+
+detail::sparse_polynomial detail::sparse_polynomial::operator*(const sparse_polynomial& other) const {
+	return *multiply(other, std::numeric_limits<size_t>::max());
+}
+
+std::optional<detail::sparse_polynomial> detail::sparse_polynomial::pow(unsigned long long n, size_t max_terms) const {
+	std::optional<sparse_polynomial> result = constant(*m_layout, numbers::natural{1});
+	// Multiplying by the base each time keeps the heap as small as the base
+	for (unsigned long long k = 0; k < n && result; ++k) {
+		result = result->multiply(*this, max_terms);
+	}
+	return result;
+}
+
+bool detail::sparse_polynomial::is_constant() const {
+	return is_zero() || (size() == 1 && std::all_of(monomial(0), monomial(0) + m_layout->words, [](uint64_t w) { return w == 0; }));
+}
+
+std::vector<detail::sparse_polynomial> detail::sparse_polynomial::coefficients(size_t generator, size_t count) const {
+	std::vector<sparse_polynomial> result;
+	std::vector<uint64_t> m(m_layout->words);
+	uint64_t current = 0;
+	for (size_t t = 0; t < size(); ++t) {
+		uint64_t e = m_layout->exponent(monomial(t), generator);
+		if (result.empty() || e != current) {
+			if (result.size() == count) {
+				break;
+			}
+			result.emplace_back(*m_layout);
+			current = e;
+		}
+		std::copy_n(monomial(t), m_layout->words, m.begin());
+		m_layout->set_exponent(m.data(), generator, 0);
+		result.back().push_term(m.data(), coefficient(t));
+	}
+	return result;
+}
+
+detail::sparse_polynomial detail::sparse_polynomial::scaled(const number& factor) const {
+	sparse_polynomial result(*m_layout);
+	for (size_t t = 0; t < size(); ++t) {
+		result.push_term(monomial(t), multiply_coefficients(coefficient(t), factor));
+	}
+	return result;
+}
+
+detail::sparse_polynomial detail::sparse_polynomial::repacked(const monomial_layout& layout) const {
+	std::vector<size_t> target(m_layout->generators.size(), SIZE_MAX);
+	for (size_t g = 0; g < target.size(); ++g) {
+		if (auto it = std::ranges::find(layout.generators, m_layout->generators[g]); it != layout.generators.end()) {
+			target[g] = it - layout.generators.begin();
+		}
+	}
+
+	std::vector<uint64_t> monomials(size() * layout.words, 0);
+	for (size_t t = 0; t < size(); ++t) {
+		for (size_t g = 0; g < target.size(); ++g) {
+			uint64_t e = m_layout->exponent(monomial(t), g);
+			if (e == 0) {
+				continue;
+			}
+			if (target[g] == SIZE_MAX || e > layout.max_exponent()) {
+				throw std::logic_error("A generator of the polynomial does not fit in the layout.");
+			}
+			layout.set_exponent(monomials.data() + t * layout.words, target[g], e);
+		}
+	}
+
+	std::vector<size_t> order(size());
+	std::iota(order.begin(), order.end(), 0);
+	std::ranges::sort(order, [&](size_t a, size_t b) {
+		return layout.compare(monomials.data() + a * layout.words, monomials.data() + b * layout.words) > 0;
+	});
+	sparse_polynomial result(layout);
+	for (size_t t : order) {
+		result.push_term(monomials.data() + t * layout.words, coefficient(t));
+	}
+	return result;
+}
+
+std::optional<detail::sparse_polynomial> detail::sparse_polynomial::divide(const sparse_polynomial& divisor) const {
+	if (divisor.is_zero()) {
+		throw std::invalid_argument("Division by zero.");
+	}
+	size_t words = m_layout->words;
+
+	// Leading terms are dropped rather than subtracted, so that they vanish even with inexact coefficients
+	sparse_polynomial divisor_tail(*m_layout);
+	for (size_t t = 1; t < divisor.size(); ++t) {
+		divisor_tail.push_term(divisor.monomial(t), divisor.coefficient(t));
+	}
+
+	sparse_polynomial quotient(*m_layout);
+	sparse_polynomial remainder = *this;
+	std::vector<uint64_t> q(words);
+	while (!remainder.is_zero()) {
+		const uint64_t* r = remainder.monomial(0);
+		for (size_t g = 0; g < m_layout->generators.size(); ++g) {
+			if (m_layout->exponent(r, g) < m_layout->exponent(divisor.monomial(0), g)) {
+				return std::nullopt;
+			}
+		}
+		// No exponent borrows from its neighbour, since each one is at least the one of the divisor
+		for (size_t w = 0; w < words; ++w) {
+			q[w] = r[w] - divisor.monomial(0)[w];
+		}
+		sparse_polynomial term(*m_layout);
+		term.push_term(q.data(), divide_coefficients(remainder.coefficient(0), divisor.coefficient(0)));
+		quotient.push_term(q.data(), term.coefficient(0));
+
+		sparse_polynomial remainder_tail(*m_layout);
+		for (size_t t = 1; t < remainder.size(); ++t) {
+			remainder_tail.push_term(remainder.monomial(t), remainder.coefficient(t));
+		}
+		remainder = remainder_tail + -(term * divisor_tail);
+	}
+	return quotient;
+}
+
+number detail::sparse_polynomial::content() const {
+	if (is_zero()) {
+		return numbers::natural{1};
+	}
+	if (!is_exact()) {
+		return coefficient(0);
+	}
+
+	long long numerators = 0, denominators = 1;
+	for (const auto& c : m_coefficients) {
+		auto [num, den] = *exact_fraction(c);
+		numerators = std::gcd(numerators, num);
+		denominators = std::lcm(denominators, den);
+	}
+	bool negative = exact_fraction(coefficient(0))->first < 0;
+	number result = numbers::rational{negative ? -numerators : numerators, denominators};
+	result.downcast();
+	return result;
+}
+
+const detail::node* detail::sparse_polynomial::to_node() const {
+	auto& nm = current_context->node_manager();
+	const number one = numbers::natural{1};
+	const number minus_one = numbers::integer{-1};
+
+	std::vector<const node*> terms;
+	for (size_t t = 0; t < size(); ++t) {
+		std::vector<const node*> factors;
+		for (size_t g = 0; g < m_layout->generators.size(); ++g) {
+			uint64_t e = m_layout->exponent(monomial(t), g);
+			if (e == 1) {
+				factors.push_back(m_layout->generators[g]);
+			}
+			else if (e > 1) {
+				factors.push_back(nm.make_pow(m_layout->generators[g], nm.make_constant(numbers::natural{e})));
+			}
+		}
+
+		const number& c = coefficient(t);
+		if (factors.empty()) {
+			terms.push_back(nm.make_constant(c));
+			continue;
+		}
+		if (c == minus_one) {
+			terms.push_back(nm.make_negation(factors.size() == 1 ? factors.front() : nm.make_mul(factors)));
+			continue;
+		}
+		if (!(c == one)) {
+			factors.insert(factors.begin(), nm.make_constant(c));
+		}
+		terms.push_back(factors.size() == 1 ? factors.front() : nm.make_mul(factors));
+	}
+
+	if (terms.empty()) {
+		return nm.make_constant(numbers::natural{0});
+	}
+	if (terms.size() == 1) {
+		return terms.front();
+	}
+	return nm.make_add(terms);
+}
+
+
+std::optional<unsigned long long> natural_exponent(const detail::node* exponent) {
+	auto* c = std::get_if<detail::constant>(&exponent->p_data);
+	if (!c) {
+		return std::nullopt;
+	}
+	number n = c->value;
+	n.downcast();
+	if (auto* k = std::get_if<numbers::natural>(&n.p_data)) {
+		return k->val;
+	}
+	return std::nullopt;
+}
+
+uint64_t saturating_add(uint64_t a, uint64_t b) {
+	return a > std::numeric_limits<uint64_t>::max() - b ? std::numeric_limits<uint64_t>::max() : a + b;
+}
+
+uint64_t saturating_mul(uint64_t a, uint64_t b) {
+	return b != 0 && a > std::numeric_limits<uint64_t>::max() / b ? std::numeric_limits<uint64_t>::max() : a * b;
+}
+
+// pow(a * b, e) with e not natural is expanded a^e * b^e
+std::vector<const detail::node*> distributed_power(const detail::power& p) {
+	std::vector<const detail::node*> factors;
+	for (auto* op : std::get<detail::multiplication>(p.base->p_data).operands) {
+		factors.push_back(current_context->node_manager().make_pow(op, p.exponent));
+	}
+	return factors;
+}
+
+// Finds the generators, and bounds the degrees of the polynomials before they are built
+class polynomial_scanner {
+	const std::unordered_map<const detail::node*, const detail::node*>& m_frozen;
+	std::unordered_map<const detail::node*, uint64_t> m_degrees;
+
+	uint64_t add_generator(const detail::node* node, const detail::node* generator) {
+		if (!index.contains(node)) {
+			index.emplace(node, generators.size());
+			generators.push_back(generator);
+		}
+		return 1;
+	}
+
+public:
+	std::vector<const detail::node*> generators;
+	std::unordered_map<const detail::node*, size_t> index;
+	uint64_t max_degree = 1;
+
+	explicit polynomial_scanner(const std::unordered_map<const detail::node*, const detail::node*>& frozen) : m_frozen(frozen) {}
+
+	uint64_t scan(const detail::node* node) {
+		if (auto it = m_degrees.find(node); it != m_degrees.end()) {
+			return it->second;
+		}
+		if (auto it = m_frozen.find(node); it != m_frozen.end()) {
+			return add_generator(node, it->second);
+		}
+
+		uint64_t degree = std::visit([&](const auto& x) -> uint64_t {
+			using T = std::decay_t<decltype(x)>;
+
+			if constexpr (std::is_same_v<T, detail::constant>) {
+				return 0;
+			}
+			else if constexpr (std::is_same_v<T, detail::negation>) {
+				return scan(x.child);
+			}
+			else if constexpr (std::is_same_v<T, detail::addition>) {
+				uint64_t result = 0;
+				for (auto* op : x.operands) {
+					result = std::max(result, scan(op));
+				}
+				return result;
+			}
+			else if constexpr (std::is_same_v<T, detail::multiplication>) {
+				uint64_t result = 0;
+				for (auto* op : x.operands) {
+					result = saturating_add(result, scan(op));
+				}
+				return result;
+			}
+			else if constexpr (std::is_same_v<T, detail::power>) {
+				auto n = natural_exponent(x.exponent);
+				if (n) {
+					return saturating_mul(scan(x.base), *n);
+				}
+				if (!std::holds_alternative<detail::multiplication>(x.base->p_data)) {
+					return add_generator(node, node);
+				}
+				uint64_t result = 0;
+				for (auto* factor : distributed_power(x)) {
+					result = saturating_add(result, scan(factor));
+				}
+				return result;
+			}
+			else {
+				return add_generator(node, node);
+			}
+		}, node->p_data);
+
+		max_degree = std::max(max_degree, degree);
+		m_degrees.emplace(node, degree);
+		return degree;
+	}
+};
+
+// Builds the polynomials of the nodes, until one of them has too many terms
+class polynomial_builder {
+	const detail::monomial_layout& m_layout;
+	const std::unordered_map<const detail::node*, size_t>& m_index;
+	size_t m_max_terms;
+	std::unordered_map<const detail::node*, detail::sparse_polynomial> m_built;
+
+	std::optional<detail::sparse_polynomial> product(const std::vector<const detail::node*>& factors, bool& failed_operand) {
+		std::optional<detail::sparse_polynomial> result = detail::sparse_polynomial::constant(m_layout, numbers::natural{1});
+		for (auto* factor : factors) {
+			auto* p = build(factor);
+			if (!p) {
+				failed_operand = true;
+				return std::nullopt;
+			}
+			result = result->multiply(*p, m_max_terms);
+			if (!result) {
+				return std::nullopt;
+			}
+		}
+		return result;
+	}
+
+	// Whether the polynomials of the operands of a built node are all exact
+	bool exact_operands(const detail::node* node) {
+		auto exact = [&](const detail::node* op) { return build(op)->is_exact(); };
+		return std::visit([&](const auto& x) -> bool {
+			using T = std::decay_t<decltype(x)>;
+
+			if constexpr (std::is_same_v<T, detail::negation>) {
+				return exact(x.child);
+			}
+			else if constexpr (std::is_same_v<T, detail::addition> || std::is_same_v<T, detail::multiplication>) {
+				return std::ranges::all_of(x.operands, exact);
+			}
+			else if constexpr (std::is_same_v<T, detail::power>) {
+				return natural_exponent(x.exponent) ? exact(x.base) : std::ranges::all_of(distributed_power(x), exact);
+			}
+			return false;
+		}, node->p_data);
+	}
+
+public:
+	// The innermost node over the budget, once build failed
+	const detail::node* over_budget = nullptr;
+
+	polynomial_builder(const detail::monomial_layout& layout, const std::unordered_map<const detail::node*, size_t>& index, size_t max_terms)
+		: m_layout(layout), m_index(index), m_max_terms(max_terms) {}
+
+	const detail::sparse_polynomial* build(const detail::node* node) {
+		if (auto it = m_built.find(node); it != m_built.end()) {
+			return &it->second;
+		}
+		if (auto it = m_index.find(node); it != m_index.end()) {
+			return &m_built.emplace(node, detail::sparse_polynomial::generator(m_layout, it->second)).first->second;
+		}
+
+		// An operand over the budget makes its parents fail too, but only the operand is marked over budget
+		bool failed_operand = false;
+		std::optional<detail::sparse_polynomial> p = std::visit([&](const auto& x) -> std::optional<detail::sparse_polynomial> {
+			using T = std::decay_t<decltype(x)>;
+
+			if constexpr (std::is_same_v<T, detail::constant>) {
+				return detail::sparse_polynomial::constant(m_layout, x.value);
+			}
+			else if constexpr (std::is_same_v<T, detail::negation>) {
+				auto* child = build(x.child);
+				if (!child) {
+					failed_operand = true;
+					return std::nullopt;
+				}
+				return -*child;
+			}
+			else if constexpr (std::is_same_v<T, detail::addition>) {
+				std::optional<detail::sparse_polynomial> result = detail::sparse_polynomial(m_layout);
+				for (auto* op : x.operands) {
+					auto* o = build(op);
+					if (!o) {
+						failed_operand = true;
+						return std::nullopt;
+					}
+					result = result->add(*o, m_max_terms);
+					if (!result) {
+						return std::nullopt;
+					}
+				}
+				return result;
+			}
+			else if constexpr (std::is_same_v<T, detail::multiplication>) {
+				return product(x.operands, failed_operand);
+			}
+			else if constexpr (std::is_same_v<T, detail::power>) {
+				auto n = natural_exponent(x.exponent);
+				if (!n) {
+					return product(distributed_power(x), failed_operand);
+				}
+				auto* base = build(x.base);
+				if (!base) {
+					failed_operand = true;
+					return std::nullopt;
+				}
+				return base->pow(*n, m_max_terms);
+			}
+			else {
+				throw std::logic_error("Unknown generator.");
+			}
+		}, node->p_data);
+
+		// Exact coefficients overflowing 64 bits become reals : such a node is left unexpanded, as over the budget
+		if (p && !p->is_exact() && exact_operands(node)) {
+			p.reset();
+		}
+		if (!p) {
+			if (!failed_operand) {
+				over_budget = node;
+			}
+			return nullptr;
+		}
+		return &m_built.emplace(node, std::move(*p)).first->second;
+	}
+};
+
+// Degrees of nodes in a list of generators, which may grow with the symbols found
+class generator_degree_scanner {
+	std::vector<const detail::node*>& m_generators;
+	bool m_add_symbols;
+	std::unordered_map<const detail::node*, uint64_t> m_degrees;
+
+public:
+	generator_degree_scanner(std::vector<const detail::node*>& generators, bool add_symbols) : m_generators(generators), m_add_symbols(add_symbols) {}
+
+	uint64_t scan(const detail::node* node) {
+		if (auto it = m_degrees.find(node); it != m_degrees.end()) {
+			return it->second;
+		}
+
+		uint64_t degree = std::visit([&](const auto& x) -> uint64_t {
+			using T = std::decay_t<decltype(x)>;
+
+			if constexpr (std::is_same_v<T, detail::symbol>) {
+				if (std::ranges::find(m_generators, node) == m_generators.end()) {
+					if (!m_add_symbols) {
+						throw std::invalid_argument("Expression is an invalid polynomial : " + x.name + " is not one of its variables.");
+					}
+					m_generators.push_back(node);
+				}
+				return 1;
+			}
+			else if constexpr (std::is_same_v<T, detail::constant>) {
+				return 0;
+			}
+			else if constexpr (std::is_same_v<T, detail::negation>) {
+				return scan(x.child);
+			}
+			else if constexpr (std::is_same_v<T, detail::addition>) {
+				uint64_t result = 0;
+				for (auto* op : x.operands) {
+					result = std::max(result, scan(op));
+				}
+				return result;
+			}
+			else if constexpr (std::is_same_v<T, detail::multiplication>) {
+				uint64_t result = 0;
+				for (auto* op : x.operands) {
+					result = saturating_add(result, scan(op));
+				}
+				return result;
+			}
+			else if constexpr (std::is_same_v<T, detail::power>) {
+				uint64_t base = scan(x.base);
+				if (auto n = natural_exponent(x.exponent)) {
+					return saturating_mul(base, *n);
+				}
+				if (base > 0 || scan(x.exponent) > 0) {
+					throw std::invalid_argument("Expression is an invalid polynomial : a variable has a non natural exponent.");
+				}
+				return 0;
+			}
+			else {
+				for (auto* arg : x.args) {
+					if (scan(arg) > 0) {
+						throw std::invalid_argument("Expression is an invalid polynomial : a variable is an argument of a function.");
+					}
+				}
+				return 0;
+			}
+		}, node->p_data);
+
+		m_degrees.emplace(node, degree);
+		return degree;
+	}
+};
+
+uint64_t detail::polynomial_degree_bound(const node* node, std::vector<const detail::node*>& generators, bool add_symbols) {
+	return generator_degree_scanner(generators, add_symbols).scan(node);
+}
+
+// Polynomials of nodes over the generators of a layout, ground subexpressions which are not polynomials being evaluated
+class generator_polynomial_builder {
+	const detail::monomial_layout& m_layout;
+	std::unordered_map<const detail::node*, detail::sparse_polynomial> m_built;
+
+public:
+	explicit generator_polynomial_builder(const detail::monomial_layout& layout) : m_layout(layout) {}
+
+	const detail::sparse_polynomial& build(const detail::node* node) {
+		if (auto it = m_built.find(node); it != m_built.end()) {
+			return it->second;
+		}
+
+		auto constant = [&](const number& value) { return detail::sparse_polynomial::constant(m_layout, value); };
+		detail::sparse_polynomial p = std::visit([&](const auto& x) -> detail::sparse_polynomial {
+			using T = std::decay_t<decltype(x)>;
+
+			if constexpr (std::is_same_v<T, detail::symbol>) {
+				auto it = std::ranges::find(m_layout.generators, node);
+				if (it == m_layout.generators.end()) {
+					throw std::invalid_argument("Expression is an invalid polynomial : " + x.name + " is not one of its variables.");
+				}
+				return detail::sparse_polynomial::generator(m_layout, it - m_layout.generators.begin());
+			}
+			else if constexpr (std::is_same_v<T, detail::constant>) {
+				return constant(x.value);
+			}
+			else if constexpr (std::is_same_v<T, detail::negation>) {
+				return -build(x.child);
+			}
+			else if constexpr (std::is_same_v<T, detail::addition>) {
+				std::vector<const detail::sparse_polynomial*> operands;
+				for (auto* op : x.operands) {
+					operands.push_back(&build(op));
+				}
+				return detail::sparse_polynomial::sum(m_layout, operands);
+			}
+			else if constexpr (std::is_same_v<T, detail::multiplication>) {
+				detail::sparse_polynomial result = constant(numbers::natural{1});
+				for (auto* op : x.operands) {
+					result = result * build(op);
+				}
+				return result;
+			}
+			else if constexpr (std::is_same_v<T, detail::power>) {
+				if (auto n = natural_exponent(x.exponent)) {
+					return *build(x.base).pow(*n, std::numeric_limits<size_t>::max());
+				}
+				return constant(node->eval(nullptr));
+			}
+			else {
+				return constant(node->eval(nullptr));
+			}
+		}, node->p_data);
+
+		return m_built.emplace(node, std::move(p)).first->second;
+	}
+};
+
+detail::sparse_polynomial detail::develop_polynomial(const node* node, const monomial_layout& layout) {
+	return generator_polynomial_builder(layout).build(node);
+}
+
+// A node over the budget only gets its operands expanded
+const detail::node* partially_expanded(const detail::node* node, size_t max_terms) {
+	auto& nm = current_context->node_manager();
+	return std::visit([&](const auto& x) -> const detail::node* {
+		using T = std::decay_t<decltype(x)>;
+
+		if constexpr (std::is_same_v<T, detail::negation>) {
+			return nm.make_negation(detail::expand_polynomial(x.child, max_terms));
+		}
+		else if constexpr (std::is_same_v<T, detail::addition> || std::is_same_v<T, detail::multiplication>) {
+			std::vector<const detail::node*> operands;
+			for (auto* op : x.operands) {
+				operands.push_back(detail::expand_polynomial(op, max_terms));
+			}
+			return std::is_same_v<T, detail::addition> ? nm.make_add(operands) : nm.make_mul(operands);
+		}
+		else if constexpr (std::is_same_v<T, detail::power>) {
+			return nm.make_pow(detail::expand_polynomial(x.base, max_terms), x.exponent);
+		}
+		return node;
+	}, node->p_data);
+}
+
+const detail::node* detail::expand_polynomial(const node* node, size_t max_terms) {
+	// Each pass either succeeds, or finds one more node to leave partially expanded
+	std::unordered_map<const detail::node*, const detail::node*> frozen;
+	while (true) {
+		polynomial_scanner scanner(frozen);
+		scanner.scan(node);
+
+		monomial_layout layout(scanner.generators, scanner.max_degree);
+		polynomial_builder builder(layout, scanner.index, max_terms);
+		if (auto* p = builder.build(node)) {
+			return p->to_node();
+		}
+		if (builder.over_budget == node) {
+			return partially_expanded(node, max_terms);
+		}
+		frozen.emplace(builder.over_budget, partially_expanded(builder.over_budget, max_terms));
+	}
+}
+
+
+detail::sparse_polynomial numeric_primitive(const detail::sparse_polynomial& p) {
+	return p.scaled(number(numbers::natural{1}) / p.content());
+}
+
+// First generator a or b depends on, or the amount of generators when both are constants
+size_t main_generator(const detail::sparse_polynomial& a, const detail::sparse_polynomial& b) {
+	size_t generators = a.layout().generators.size();
+	for (size_t g = 0; g < generators; ++g) {
+		if (a.degree(g) > 0 || b.degree(g) > 0) {
+			return g;
+		}
+	}
+	return generators;
+}
+
+// gcd of the coefficients of p in the generator v
+detail::sparse_polynomial content_in(const detail::sparse_polynomial& p, size_t v) {
+	auto coefficients = p.coefficients(v);
+	detail::sparse_polynomial result = numeric_primitive(coefficients.front());
+	for (size_t i = 1; i < coefficients.size() && !result.is_constant(); ++i) {
+		result = detail::polynomial_gcd(result, coefficients[i]);
+	}
+	return result;
+}
+
+// gcd through the Kronecker substitution x_i = x^(d_(i+1) ... d_n), d_i bounding the degrees in x_i : the images are
+// univariate with the same coefficients, and their gcd is found modulo primes. The gcd of the images may be larger
+// than the image of the gcd, so its preimage is only kept if it divides both polynomials.
+std::optional<detail::sparse_polynomial> kronecker_gcd(const detail::sparse_polynomial& a, const detail::sparse_polynomial& b) {
+	constexpr uint64_t max_image_degree = 1 << 14;
+	const detail::monomial_layout& layout = a.layout();
+	size_t generators = layout.generators.size();
+
+	std::vector<uint64_t> radix(generators), bounds(generators);
+	uint64_t size = 1;
+	for (size_t g = generators; g-- > 0;) {
+		radix[g] = size;
+		bounds[g] = std::max(a.degree(g), b.degree(g)) + 1;
+		size = saturating_mul(size, bounds[g]);
+		if (size > max_image_degree) {
+			return std::nullopt;
+		}
+	}
+
+	auto image = [&](const detail::sparse_polynomial& p) -> std::optional<std::vector<long long>> {
+		std::vector<long long> dense(size, 0);
+		for (size_t t = 0; t < p.size(); ++t) {
+			auto f = exact_fraction(p.coefficient(t));
+			if (!f || f->second != 1) {
+				return std::nullopt;
+			}
+			uint64_t k = 0;
+			for (size_t g = 0; g < generators; ++g) {
+				k += layout.exponent(p.monomial(t), g) * radix[g];
+			}
+			dense[k] = f->first;
+		}
+		while (dense.back() == 0) {
+			dense.pop_back();
+		}
+		return dense;
+	};
+	auto ia = image(numeric_primitive(a));
+	auto ib = image(numeric_primitive(b));
+	if (!ia || !ib) {
+		return std::nullopt;
+	}
+	auto g = detail::gcd_modular(*ia, *ib);
+	if (!g) {
+		return std::nullopt;
+	}
+
+	detail::sparse_polynomial result(layout);
+	for (size_t k = 0; k < g->size(); ++k) {
+		if ((*g)[k] == 0) {
+			continue;
+		}
+		detail::sparse_polynomial term = detail::sparse_polynomial::constant(layout, numbers::integer{(*g)[k]});
+		for (size_t i = 0; i < generators; ++i) {
+			if (uint64_t e = k / radix[i] % bounds[i]) {
+				term = term * detail::sparse_polynomial::generator(layout, i, e);
+			}
+		}
+		result = result + term;
+	}
+	if (!a.divide(result) || !b.divide(result)) {
+		return std::nullopt;
+	}
+	return numeric_primitive(result);
+}
+
+// gcd through Brown's modular algorithm, for polynomials whose Kronecker images are too large. Gives up after a bounded
+// amount of work.
+std::optional<detail::sparse_polynomial> brown_gcd(const detail::sparse_polynomial& a, const detail::sparse_polynomial& b) {
+	constexpr size_t max_work = 1 << 18;
+	const detail::monomial_layout& layout = a.layout();
+	size_t generators = layout.generators.size();
+
+	auto terms = [&](const detail::sparse_polynomial& p) -> std::optional<std::vector<detail::integer_term>> {
+		std::vector<detail::integer_term> out;
+		for (size_t t = 0; t < p.size(); ++t) {
+			auto f = exact_fraction(p.coefficient(t));
+			if (!f || f->second != 1) {
+				return std::nullopt;
+			}
+			std::vector<uint64_t> exponents(generators);
+			for (size_t g = 0; g < generators; ++g) {
+				exponents[g] = layout.exponent(p.monomial(t), g);
+			}
+			out.push_back({std::move(exponents), f->first});
+		}
+		return out;
+	};
+	auto ta = terms(numeric_primitive(a));
+	auto tb = terms(numeric_primitive(b));
+	if (!ta || !tb) {
+		return std::nullopt;
+	}
+
+	std::optional<detail::sparse_polynomial> result;
+	auto divides_both = [&](const std::vector<detail::integer_term>& g) {
+		std::vector<detail::sparse_polynomial> parts;
+		parts.reserve(g.size());
+		for (const auto& [exponents, c] : g) {
+			detail::sparse_polynomial term = detail::sparse_polynomial::constant(layout, numbers::integer{c});
+			for (size_t i = 0; i < generators; ++i) {
+				if (exponents[i] != 0) {
+					term = term * detail::sparse_polynomial::generator(layout, i, exponents[i]);
+				}
+			}
+			parts.push_back(std::move(term));
+		}
+		std::vector<const detail::sparse_polynomial*> operands;
+		for (const auto& part : parts) {
+			operands.push_back(&part);
+		}
+		result = detail::sparse_polynomial::sum(layout, operands);
+		return a.divide(*result).has_value() && b.divide(*result).has_value();
+	};
+	if (!detail::gcd_modular(*ta, *tb, divides_both, max_work)) {
+		return std::nullopt;
+	}
+	return numeric_primitive(*result);
+}
+
+detail::sparse_polynomial detail::polynomial_gcd(const sparse_polynomial& a, const sparse_polynomial& b) {
+	const monomial_layout& layout = a.layout();
+	sparse_polynomial one = sparse_polynomial::constant(layout, numbers::natural{1});
+	if (!a.is_exact() || !b.is_exact()) {
+		return one;
+	}
+	if (a.is_zero() || b.is_zero()) {
+		return numeric_primitive(a.is_zero() ? b : a);
+	}
+
+	size_t v = main_generator(a, b);
+	if (v == layout.generators.size()) {
+		return one;
+	}
+	if (auto g = kronecker_gcd(a, b)) {
+		return *g;
+	}
+	if (auto g = brown_gcd(a, b)) {
+		return *g;
+	}
+	if (a.degree(v) == 0) {
+		return polynomial_gcd(a, content_in(b, v));
+	}
+	if (b.degree(v) == 0) {
+		return polynomial_gcd(content_in(a, v), b);
+	}
+	// Past its work budget, the gcd of the contents still divides both polynomials
+	return polynomial_gcd(content_in(a, v), content_in(b, v));
+}
+
+// Degree of the layouts of gcds, with room for the degrees of intermediate products
+uint64_t gcd_degree_bound(uint64_t degree) {
+	uint64_t d = saturating_add(degree, 1);
+	return saturating_mul(4, saturating_mul(d, saturating_mul(d, d)));
+}
+
+const detail::node* detail::polynomial_gcd(const node* a, const node* b) {
+	std::unordered_map<const node*, const node*> frozen;
+	polynomial_scanner scanner(frozen);
+	scanner.scan(a);
+	scanner.scan(b);
+
+	monomial_layout layout(scanner.generators, gcd_degree_bound(scanner.max_degree));
+	polynomial_builder builder(layout, scanner.index, std::numeric_limits<size_t>::max());
+	return polynomial_gcd(*builder.build(a), *builder.build(b)).to_node();
+}
+
+const detail::node* detail::divide_polynomial(const node* dividend, const node* divisor) {
+	std::unordered_map<const node*, const node*> frozen;
+	polynomial_scanner scanner(frozen);
+	scanner.scan(dividend);
+	scanner.scan(divisor);
+
+	monomial_layout layout(scanner.generators, scanner.max_degree);
+	polynomial_builder builder(layout, scanner.index, std::numeric_limits<size_t>::max());
+	auto quotient = builder.build(dividend)->divide(*builder.build(divisor));
+	return quotient ? quotient->to_node() : nullptr;
+}
+
+
+std::optional<long long> signed_exponent(const detail::node* exponent) {
+	auto* c = std::get_if<detail::constant>(&exponent->p_data);
+	if (!c) {
+		return std::nullopt;
+	}
+	number n = c->value;
+	n.downcast();
+	if (auto* k = std::get_if<numbers::natural>(&n.p_data); k && k->val <= static_cast<unsigned long long>(std::numeric_limits<long long>::max())) {
+		return static_cast<long long>(k->val);
+	}
+	if (auto* k = std::get_if<numbers::integer>(&n.p_data)) {
+		return k->val;
+	}
+	return std::nullopt;
+}
+
+struct rational_degrees {
+	uint64_t numerator = 0;
+	uint64_t denominator = 0;
+};
+
+// Finds the generators of rational functions (whose subexpressions are cancelled), and bounds their degrees
+class rational_scanner {
+	std::unordered_map<const detail::node*, rational_degrees> m_degrees;
+	std::unordered_map<const detail::node*, size_t> m_generator_index;
+
+	rational_degrees add_generator(const detail::node* node, const detail::node* generator) {
+		auto [it, inserted] = m_generator_index.emplace(generator, generators.size());
+		if (inserted) {
+			generators.push_back(generator);
+		}
+		index.emplace(node, it->second);
+		return {1, 0};
+	}
+
+public:
+	std::vector<const detail::node*> generators;
+	std::unordered_map<const detail::node*, size_t> index;
+	uint64_t max_degree = 1;
+
+	rational_degrees scan(const detail::node* node) {
+		if (auto it = m_degrees.find(node); it != m_degrees.end()) {
+			return it->second;
+		}
+		auto& nm = current_context->node_manager();
+
+		rational_degrees degrees = std::visit([&](const auto& x) -> rational_degrees {
+			using T = std::decay_t<decltype(x)>;
+
+			if constexpr (std::is_same_v<T, detail::constant>) {
+				return {};
+			}
+			else if constexpr (std::is_same_v<T, detail::negation>) {
+				return scan(x.child);
+			}
+			else if constexpr (std::is_same_v<T, detail::addition> || std::is_same_v<T, detail::multiplication>) {
+				// Sums are put over the product of the denominators
+				rational_degrees result;
+				for (auto* op : x.operands) {
+					rational_degrees d = scan(op);
+					result.numerator = std::is_same_v<T, detail::addition>
+						? saturating_add(std::max(result.numerator, d.numerator), result.denominator + d.denominator)
+						: saturating_add(result.numerator, d.numerator);
+					result.denominator = saturating_add(result.denominator, d.denominator);
+				}
+				return result;
+			}
+			else if constexpr (std::is_same_v<T, detail::power>) {
+				if (auto n = signed_exponent(x.exponent)) {
+					rational_degrees base = scan(x.base);
+					auto k = static_cast<uint64_t>(*n < 0 ? -*n : *n);
+					rational_degrees result{saturating_mul(base.numerator, k), saturating_mul(base.denominator, k)};
+					return *n < 0 ? rational_degrees{result.denominator, result.numerator} : result;
+				}
+				return add_generator(node, nm.make_pow(detail::cancel_rational(x.base), detail::cancel_rational(x.exponent)));
+			}
+			else if constexpr (std::is_same_v<T, detail::function_call>) {
+				std::vector<const detail::node*> args;
+				for (auto* arg : x.args) {
+					args.push_back(detail::cancel_rational(arg));
+				}
+				return add_generator(node, nm.make_func(x.f_id, args));
+			}
+			else {
+				return add_generator(node, node);
+			}
+		}, node->p_data);
+
+		max_degree = std::max({max_degree, degrees.numerator, degrees.denominator});
+		m_degrees.emplace(node, degrees);
+		return degrees;
+	}
+};
+
+struct rational_function {
+	detail::sparse_polynomial numerator;
+	detail::sparse_polynomial denominator;
+};
+
+class rational_builder {
+	const detail::monomial_layout& m_layout;
+	const std::unordered_map<const detail::node*, size_t>& m_index;
+	std::unordered_map<const detail::node*, rational_function> m_built;
+
+	rational_function constant(const number& value) const {
+		return {detail::sparse_polynomial::constant(m_layout, value), detail::sparse_polynomial::constant(m_layout, numbers::natural{1})};
+	}
+
+public:
+	rational_builder(const detail::monomial_layout& layout, const std::unordered_map<const detail::node*, size_t>& index)
+		: m_layout(layout), m_index(index) {}
+
+	const rational_function& build(const detail::node* node) {
+		if (auto it = m_built.find(node); it != m_built.end()) {
+			return it->second;
+		}
+		if (auto it = m_index.find(node); it != m_index.end()) {
+			rational_function f = constant(numbers::natural{1});
+			f.numerator = detail::sparse_polynomial::generator(m_layout, it->second);
+			return m_built.emplace(node, std::move(f)).first->second;
+		}
+
+		rational_function f = std::visit([&](const auto& x) -> rational_function {
+			using T = std::decay_t<decltype(x)>;
+
+			if constexpr (std::is_same_v<T, detail::constant>) {
+				return constant(x.value);
+			}
+			else if constexpr (std::is_same_v<T, detail::negation>) {
+				const rational_function& child = build(x.child);
+				return {-child.numerator, child.denominator};
+			}
+			else if constexpr (std::is_same_v<T, detail::addition>) {
+				// Over the lcm of the denominators
+				rational_function sum = constant(numbers::natural{0});
+				for (auto* op : x.operands) {
+					const rational_function& term = build(op);
+					detail::sparse_polynomial g = detail::polynomial_gcd(sum.denominator, term.denominator);
+					detail::sparse_polynomial sum_factor = *term.denominator.divide(g);
+					detail::sparse_polynomial term_factor = *sum.denominator.divide(g);
+					sum.numerator = sum.numerator * sum_factor + term.numerator * term_factor;
+					sum.denominator = sum.denominator * sum_factor;
+				}
+				return sum;
+			}
+			else if constexpr (std::is_same_v<T, detail::multiplication>) {
+				rational_function product = constant(numbers::natural{1});
+				for (auto* op : x.operands) {
+					const rational_function& factor = build(op);
+					product.numerator = product.numerator * factor.numerator;
+					product.denominator = product.denominator * factor.denominator;
+				}
+				return product;
+			}
+			else if constexpr (std::is_same_v<T, detail::power>) {
+				long long n = *signed_exponent(x.exponent);
+				const rational_function& base = build(x.base);
+				auto k = static_cast<unsigned long long>(n < 0 ? -n : n);
+				if (n < 0 && base.numerator.is_zero()) {
+					throw std::invalid_argument("Division by zero.");
+				}
+				size_t all = std::numeric_limits<size_t>::max();
+				rational_function result{*base.numerator.pow(k, all), *base.denominator.pow(k, all)};
+				if (n < 0) {
+					std::swap(result.numerator, result.denominator);
+				}
+				return result;
+			}
+			else {
+				throw std::logic_error("Unknown generator.");
+			}
+		}, node->p_data);
+
+		return m_built.emplace(node, std::move(f)).first->second;
+	}
+};
+
+const detail::node* detail::cancel_rational(const node* node) {
+	rational_scanner scanner;
+	scanner.scan(node);
+
+	monomial_layout layout(scanner.generators, gcd_degree_bound(scanner.max_degree));
+	rational_builder builder(layout, scanner.index);
+	const rational_function& f = builder.build(node);
+
+	sparse_polynomial g = polynomial_gcd(f.numerator, f.denominator);
+	sparse_polynomial numerator = *f.numerator.divide(g);
+	sparse_polynomial denominator = *f.denominator.divide(g);
+	number unit = number(numbers::natural{1}) / denominator.content();
+	numerator = numerator.scaled(unit);
+	denominator = denominator.scaled(unit);
+
+	if (denominator.is_constant()) {
+		return numerator.to_node();
+	}
+	return current_context->node_manager().make_div(numerator.to_node(), denominator.to_node());
+}
@@ -3,6 +3,9 @@
 #include "symaths/symaths.hpp"
 #include "symaths/base_functions.hpp"
 
+#include <format>
+#include <stdexcept>
+
 using namespace sym;
 
 expression sym::differentiate(const expression& expr, const symbol& symbol) {
@@ -94,7 +97,10 @@ expression sym::differentiate(const expression& expr, const symbol& symbol) {
 		}
 
 		else if constexpr (std::is_same_v<T, detail::function_call>) {
-			auto& f = detail::get_func(funcs::builtin_fn_id{x.f_id});
+			auto& f = detail::get_func(x.f_id);
+			if (!f.derivative) {
+				throw std::logic_error(std::format("differentiate: {} has no derivative", f.name));
+			}
 			return f.derivative(x.args, symbol.ref);
 		}
 
@@ -0,0 +1,293 @@
+#include "symaths/domain.hpp"
+
+#include "symaths/symaths.hpp"
+#include "symaths/detail/nodes.hpp"
+#include "symaths/utils/maths.hpp"
+
+#include <cmath>
+#include <numbers>
+#include <stdexcept>
+
+using namespace sym;
+
+constexpr double infinity = std::numeric_limits<double>::infinity();
+
+domain domain::real() {
+	return {};
+}
+
+domain domain::positive() {
+	return {0, infinity, true, true};
+}
+
+domain domain::non_negative() {
+	return {0, infinity, false, true};
+}
+
+domain domain::negative() {
+	return {-infinity, 0, true, true};
+}
+
+domain domain::non_positive() {
+	return {-infinity, 0, true, false};
+}
+
+domain domain::point(double value) {
+	return {value, value, false, false};
+}
+
+domain domain::between(double lower, double upper, bool lower_open, bool upper_open) {
+	return {lower, upper, lower_open || std::isinf(lower), upper_open || std::isinf(upper)};
+}
+
+bool domain::contains(double value) const {
+	bool above = value > lower || (value == lower && !lower_open);
+	bool below = value < upper || (value == upper && !upper_open);
+	return above && below;
+}
+
+bool domain::is_positive() const {
+	return lower > 0 || (lower == 0 && lower_open);
+}
+
+bool domain::is_negative() const {
+	return upper < 0 || (upper == 0 && upper_open);
+}
+
+bool domain::is_non_negative() const {
+	return lower >= 0;
+}
+
+bool domain::excludes_zero() const {
+	return is_positive() || is_negative();
+}
+
+
+void sym::assume(const symbol& symbol, const domain& d) {
+	if (!current_context) {
+		throw std::runtime_error("sym::assume: current context is null");
+	}
+	current_context->symbol_domains()[symbol.ref] = d;
+}
+
+domain sym::infer_domain(const expression& expr) {
+	detail::domain_cache_t cache;
+	return detail::infer_domain(expr.root, cache);
+}
+
+
+// Internal helpers : interval arithmetic on domains
+struct domain_bound {
+	double value;
+	bool open;
+};
+
+domain domain_from_bounds(domain_bound lower, domain_bound upper) {
+	if (std::isnan(lower.value) || std::isnan(upper.value)) {
+		return domain::real();
+	}
+	return domain::between(lower.value, upper.value, lower.open, upper.open);
+}
+
+domain negate_domain(const domain& d) {
+	return {-d.upper, -d.lower, d.upper_open, d.lower_open};
+}
+
+domain add_domains(const domain& a, const domain& b) {
+	return domain_from_bounds(
+		{a.lower + b.lower, a.lower_open || b.lower_open},
+		{a.upper + b.upper, a.upper_open || b.upper_open}
+	);
+}
+
+domain multiply_domains(const domain& a, const domain& b) {
+	auto corner = [](domain_bound x, domain_bound y) -> domain_bound {
+		double v = x.value * y.value;
+		if (std::isnan(v)) {
+			v = 0; // 0 * inf : the factor is 0 (or tends to it) while the other one stays finite
+		}
+		// A closed zero factor is reached, so is the product
+		bool open = (x.open || y.open) && !(x.value == 0 && !x.open) && !(y.value == 0 && !y.open);
+		return {v, open};
+	};
+
+	domain_bound corners[] = {
+		corner({a.lower, a.lower_open}, {b.lower, b.lower_open}),
+		corner({a.lower, a.lower_open}, {b.upper, b.upper_open}),
+		corner({a.upper, a.upper_open}, {b.lower, b.lower_open}),
+		corner({a.upper, a.upper_open}, {b.upper, b.upper_open}),
+	};
+
+	domain_bound lower = corners[0];
+	domain_bound upper = corners[0];
+	for (auto& c : corners) {
+		if (c.value < lower.value) lower = c;
+		else if (c.value == lower.value) lower.open = lower.open && c.open;
+
+		if (c.value > upper.value) upper = c;
+		else if (c.value == upper.value) upper.open = upper.open && c.open;
+	}
+	return domain_from_bounds(lower, upper);
+}
+
+domain reciprocal_domain(const domain& d) {
+	if (!d.excludes_zero()) {
+		return domain::real();
+	}
+	if (d.is_negative()) {
+		return negate_domain(reciprocal_domain(negate_domain(d)));
+	}
+	return domain_from_bounds({1.0 / d.upper, d.upper_open}, {1.0 / d.lower, d.lower_open});
+}
+
+domain abs_domain(const domain& d) {
+	if (d.lower >= 0) return d;
+	if (d.upper <= 0) return negate_domain(d);
+	if (-d.lower > d.upper) return {0, -d.lower, false, d.lower_open};
+	if (-d.lower < d.upper) return {0, d.upper, false, d.upper_open};
+	return {0, d.upper, false, d.lower_open && d.upper_open};
+}
+
+template<typename F>
+domain map_increasing(const domain& d, F f) {
+	return domain_from_bounds({f(d.lower), d.lower_open}, {f(d.upper), d.upper_open});
+}
+
+domain pow_domain(const domain& base, double c) {
+	if (c == 0) {
+		return domain::point(1);
+	}
+
+	if (utils::is_integer(c)) {
+		auto n = static_cast<long long>(std::round(c));
+		if (n < 0) {
+			return reciprocal_domain(pow_domain(base, static_cast<double>(-n)));
+		}
+		auto f = [&](double v) { return std::pow(v, static_cast<double>(n)); };
+		if (n % 2 == 1) {
+			return map_increasing(base, f);
+		}
+		return map_increasing(abs_domain(base), f);
+	}
+
+	// Non-integer exponents are only real for non-negative bases
+	if (c > 0 && base.is_non_negative()) {
+		return map_increasing(base, [&](double v) { return std::pow(v, c); });
+	}
+	if (c < 0 && base.is_positive()) {
+		return reciprocal_domain(map_increasing(base, [&](double v) { return std::pow(v, -c); }));
+	}
+	return domain::real();
+}
+
+domain function_domain(funcs::builtin_fn_id f_id, const domain& arg) {
+	constexpr double pi = std::numbers::pi;
+
+	switch (f_id) {
+		case funcs::cos:
+		case funcs::sin:
+			return domain::between(-1, 1);
+		case funcs::atan:
+			return map_increasing(arg, [](double v) { return std::atan(v); });
+		case funcs::acos:
+			return domain::between(0, pi);
+		case funcs::asin:
+			return domain::between(-pi / 2, pi / 2);
+		case funcs::exp:
+			return map_increasing(arg, [](double v) { return std::exp(v); });
+		case funcs::ln:
+			if (arg.is_positive()) {
+				return map_increasing(arg, [](double v) { return std::log(v); });
+			}
+			return domain::real();
+		case funcs::log10:
+			if (arg.is_positive()) {
+				return map_increasing(arg, [](double v) { return std::log10(v); });
+			}
+			return domain::real();
+		case funcs::cosh:
+			return map_increasing(abs_domain(arg), [](double v) { return std::cosh(v); });
+		case funcs::sinh:
+			return map_increasing(arg, [](double v) { return std::sinh(v); });
+		case funcs::tanh:
+			return map_increasing(arg, [](double v) { return std::tanh(v); });
+		case funcs::sqrt:
+			if (arg.upper < 0) {
+				return domain::real();
+			}
+			if (arg.lower < 0) {
+				return domain::between(0, std::sqrt(arg.upper), false, arg.upper_open);
+			}
+			return map_increasing(arg, [](double v) { return std::sqrt(v); });
+		case funcs::abs:
+			return abs_domain(arg);
+		default:
+			return domain::real();
+	}
+}
+
+domain detail::infer_domain(const node* node, domain_cache_t& cache) {
+	if (auto it = cache.find(node); it != cache.end()) {
+		return it->second;
+	}
+
+	domain result = std::visit([&](const auto& x) -> domain {
+		using T = std::decay_t<decltype(x)>;
+
+		if constexpr (std::is_same_v<T, constant>) {
+			if (std::holds_alternative<numbers::complex>(x.value.p_data) || std::holds_alternative<numbers::nan>(x.value.p_data)) {
+				return domain::real();
+			}
+			return domain::point(x.value.template get<double>());
+		}
+
+		else if constexpr (std::is_same_v<T, symbol>) {
+			auto& domains = current_context->symbol_domains();
+			if (auto it = domains.find(node); it != domains.end()) {
+				return it->second;
+			}
+			return domain::real();
+		}
+
+		else if constexpr (std::is_same_v<T, negation>) {
+			return negate_domain(infer_domain(x.child, cache));
+		}
+
+		else if constexpr (std::is_same_v<T, addition>) {
+			domain sum = domain::point(0);
+			for (auto* op : x.operands) {
+				sum = add_domains(sum, infer_domain(op, cache));
+			}
+			return sum;
+		}
+
+		else if constexpr (std::is_same_v<T, multiplication>) {
+			domain prod = domain::point(1);
+			for (auto* op : x.operands) {
+				prod = multiply_domains(prod, infer_domain(op, cache));
+			}
+			return prod;
+		}
+
+		else if constexpr (std::is_same_v<T, power>) {
+			domain base = infer_domain(x.base, cache);
+			domain exponent = infer_domain(x.exponent, cache);
+			if (exponent.lower == exponent.upper) {
+				return pow_domain(base, exponent.lower);
+			}
+			return base.is_positive() ? domain::positive() : domain::real();
+		}
+
+		else if constexpr (std::is_same_v<T, function_call>) {
+			if (x.args.size() != 1 || x.f_id >= funcs::LEN) {
+				return domain::real();
+			}
+			return function_domain(funcs::builtin_fn_id{x.f_id}, infer_domain(x.args[0], cache));
+		}
+
+		return domain::real();
+	}, node->p_data);
+
+	cache.emplace(node, result);
+	return result;
+}
@@ -1,18 +1,231 @@
 #include "symaths/equation.hpp"
 
+#include "symaths/polynomial.hpp"
+#include "symaths/symaths.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <exception>
+#include <limits>
+#include <optional>
+#include <stdexcept>
+#include <thread>
+
 using namespace sym;
 
-std::vector<const symbol&> equation::unknowns() {
-	std::vector<const symbol&> symbols;
-	expression eq = m_left - m_right;
+// Amount of starting points handed to a thread at once
+constexpr size_t solve_block = 256;
+// Iterations before which the steps of an iterate may grow
+constexpr size_t halley_free_iterations = 10;
+
+std::vector<symbol> equation::unknowns() const {
+	std::vector<const detail::node*> symbols = detail::list_symbols(m_left.root);
+	for (auto* s : detail::list_symbols(m_right.root)) {
+		if (std::ranges::find(symbols, s) == symbols.end()) {
+			symbols.push_back(s);
+		}
+	}
+	return {symbols.begin(), symbols.end()};
+}
+
+bool equation::is_solvable() const {
+	return unknowns().size() == 1;
+}
+
+// Keeps one root out of each group of roots closer than the tolerance
+void merge_roots(std::vector<double>& roots, double tolerance) {
+	std::ranges::sort(roots);
+	std::vector<double> merged;
+	for (double r : roots) {
+		if (merged.empty() || r - merged.back() > tolerance * std::max(1.0, std::abs(r))) {
+			merged.push_back(r == 0 ? 0.0 : r);
+		}
+	}
+	roots = std::move(merged);
+}
+
+std::vector<expression> constant_roots(std::vector<double> roots, double tolerance) {
+	merge_roots(roots, tolerance);
+	return {roots.begin(), roots.end()};
+}
+
+// Real roots of a polynomial of degree 3 or more : real parts of the complex roots at which the polynomial vanishes
+// up to the rounding errors of its evaluation
+std::vector<double> real_polynomial_roots(const numeric_polynomial& p) {
+	std::vector<double> roots;
+	double tolerance = 4 * static_cast<double>(p.coeffs.size()) * std::numeric_limits<double>::epsilon();
+	for (const auto& z : find_roots(p)) {
+		double x = z.real();
+		double value = 0, bound = 0;
+		for (size_t k = p.coeffs.size(); k-- > 0;) {
+			value = value * x + p.coeffs[k];
+			bound = bound * std::abs(x) + std::abs(p.coeffs[k]);
+		}
+		if (std::abs(value) <= tolerance * bound) {
+			roots.push_back(x);
+		}
+	}
+	return roots;
+}
+
+// Solutions of a polynomial equation, exact up to degree 2
+std::vector<expression> polynomial_roots(const polynomial& p, const solve_options& options) {
+	std::vector<const detail::node*> c = p.coeffs;
+	auto is_zero = [](const detail::node* n) { return n->eval(nullptr).get<double>() == 0; };
+	while (!c.empty() && is_zero(c.back())) {
+		c.pop_back();
+	}
+
+	switch (c.size()) {
+		case 0:
+			throw std::invalid_argument("The equation holds for every value of its unknown.");
+		case 1:
+			return {};
+		case 2:
+			return {reduce(-expression(c[0]) / expression(c[1]))};
+		case 3: {
+			expression a = c[2], b = c[1];
+			expression discriminant = reduce(b * b - 4.0 * a * c[0]);
+			double d = discriminant.root->eval(nullptr).get<double>();
+			if (d < 0) {
+				return {};
+			}
+			if (d == 0) {
+				return {reduce(-b / (2.0 * a))};
+			}
+			std::vector<expression> roots{
+				reduce((-b - sqrt(discriminant)) / (2.0 * a)),
+				reduce((-b + sqrt(discriminant)) / (2.0 * a))
+			};
+			if (roots[0].root->eval(nullptr).get<double>() > roots[1].root->eval(nullptr).get<double>()) {
+				std::swap(roots[0], roots[1]);
+			}
+			return roots;
+		}
+		default:
+			return constant_roots(real_polynomial_roots(numeric_polynomial(p)), options.merge_tolerance);
+	}
+}
+
+struct halley_programs {
+	compiled_expression f;
+	compiled_expression df;
+	compiled_expression d2f;
+};
 
-	std::visit([&](const auto& x) {
-		using T = std::decay_t<decltype(x)>;
+// Runs Halley's method from the starting points [first, first + count) of the grid over [lower, upper]. Iterates
+// are kept in a compact array : those which converge or diverge leave it.
+void halley_block(const halley_programs& p, const solve_options& o, size_t first, size_t count, std::vector<double>& roots) {
+	std::vector<double> x(count), f(count), df(count), d2f(count);
+	std::vector<double> previous_step(count, std::numeric_limits<double>::infinity());
+	double spacing = (o.upper - o.lower) / static_cast<double>(o.starts);
+	for (size_t i = 0; i < count; ++i) {
+		x[i] = o.lower + (static_cast<double>(first + i) + 0.5) * spacing;
+	}
 
-		if constexpr (std::is_same_v<T, detail::symbol>) {
-			if (std::ranges::find(symbols, eq) == symbols.end()) {
-				symbols.push_back(eq);
+	size_t n = count;
+	for (size_t iteration = 0; iteration < o.max_iterations && n > 0; ++iteration) {
+		const double* columns[] = {x.data()};
+		p.f.eval_batch(columns, f.data(), n);
+		p.df.eval_batch(columns, df.data(), n);
+		p.d2f.eval_batch(columns, d2f.data(), n);
+
+		size_t kept = 0;
+		for (size_t i = 0; i < n; ++i) {
+			if (f[i] == 0) {
+				roots.push_back(x[i]);
+				continue;
+			}
+			// Halley's step, or Newton's when the second derivative makes it undefined
+			double denominator = 2 * df[i] * df[i] - f[i] * d2f[i];
+			double step = denominator != 0 && std::isfinite(denominator) ? 2 * f[i] * df[i] / denominator : f[i] / df[i];
+			if (!std::isfinite(step)) {
+				continue;
+			}
+			double next = x[i] - step;
+			if (std::abs(step) <= o.tolerance * std::max(1.0, std::abs(next))) {
+				if (std::abs(f[i]) <= o.residual) {
+					roots.push_back(next);
+				}
+				continue;
+			}
+			// Roots out of the bracket are not kept, so iterates leaving it are dropped. So are those whose steps
+			// stopped shrinking : close enough to a root, steps shrink at every iteration
+			bool contracting = iteration < halley_free_iterations || std::abs(step) < previous_step[i];
+			if (next >= o.lower && next <= o.upper && contracting) {
+				previous_step[kept] = std::abs(step);
+				x[kept++] = next;
 			}
 		}
-	}, eq.root->p_data);
+		n = kept;
+	}
+}
+
+std::vector<expression> halley_roots(const expression& f, const symbol& x, const solve_options& options) {
+	if (!(options.lower < options.upper) || options.starts == 0) {
+		throw std::invalid_argument("Numeric solving needs a non-empty bracket and starting points.");
+	}
+	// Programs are compiled here : the node manager is not shared between threads
+	expression df = differentiate(f, x);
+	halley_programs programs{{f, {x}}, {df, {x}}, {differentiate(df, x), {x}}};
+
+	size_t blocks = (options.starts + solve_block - 1) / solve_block;
+	size_t threads = options.threads == 0 ? std::max(1u, std::thread::hardware_concurrency()) : options.threads;
+	threads = std::max<size_t>(1, std::min(threads, blocks));
+
+	std::vector<std::vector<double>> found(blocks);
+	std::atomic<size_t> next = 0;
+	std::vector<std::exception_ptr> errors(threads);
+	auto work = [&](size_t worker) {
+		try {
+			for (size_t b = next++; b < blocks; b = next++) {
+				size_t first = b * solve_block;
+				halley_block(programs, options, first, std::min(solve_block, options.starts - first), found[b]);
+			}
+		}
+		catch (...) {
+			errors[worker] = std::current_exception();
+			next = blocks;
+		}
+	};
+
+	{
+		std::vector<std::jthread> workers;
+		for (size_t t = 1; t < threads; ++t) {
+			workers.emplace_back(work, t);
+		}
+		work(0);
+	}
+	for (auto& error : errors) {
+		if (error) {
+			std::rethrow_exception(error);
+		}
+	}
+
+	std::vector<double> roots;
+	for (auto& block : found) {
+		roots.insert(roots.end(), block.begin(), block.end());
+	}
+	return constant_roots(std::move(roots), options.merge_tolerance);
+}
+
+std::vector<expression> equation::solve(const solve_options& options) const {
+	std::vector<symbol> variables = unknowns();
+	if (variables.size() != 1) {
+		throw std::invalid_argument("An equation to solve must have exactly one unknown.");
+	}
+	expression f = m_left - m_right;
+
+	std::optional<polynomial> p;
+	try {
+		p.emplace(f);
+	}
+	catch (const std::logic_error&) {
+		// Not a polynomial
+	}
+	if (p) {
+		return polynomial_roots(*p, options);
+	}
+	return halley_roots(f, variables.front(), options);
 }
@@ -58,4 +58,56 @@ sym::expression sym::operator/(const expression& lhs, const expression& rhs) {
 
 sym::expression sym::operator-(const expression& e) {
 	return make_negation(e.root);
-}
\ No newline at end of file
+}
+
+
+// Appends an operand, or the operands of a node of the same kind, which are already flat
+template <typename T>
+void append_operand(std::vector<const sym::detail::node*>& operands, const sym::detail::node* node) {
+	if (const auto* same = std::get_if<T>(&node->p_data)) {
+		operands.insert(operands.end(), same->operands.begin(), same->operands.end());
+	}
+	else {
+		operands.push_back(node);
+	}
+}
+
+sym::sum_builder& sym::sum_builder::add(const expression& term) {
+	append_operand<sym::detail::addition>(m_operands, term.root);
+	return *this;
+}
+
+sym::sum_builder& sym::sum_builder::subtract(const expression& term) {
+	m_operands.push_back(make_negation(term.root));
+	return *this;
+}
+
+sym::expression sym::sum_builder::build() const {
+	if (m_operands.empty()) {
+		return make_constant(0);
+	}
+	if (m_operands.size() == 1) {
+		return m_operands[0];
+	}
+	return make_addition(m_operands);
+}
+
+sym::product_builder& sym::product_builder::multiply(const expression& factor) {
+	append_operand<sym::detail::multiplication>(m_operands, factor.root);
+	return *this;
+}
+
+sym::product_builder& sym::product_builder::divide(const expression& factor) {
+	m_operands.push_back(make_power(factor.root, make_constant(-1)));
+	return *this;
+}
+
+sym::expression sym::product_builder::build() const {
+	if (m_operands.empty()) {
+		return make_constant(1);
+	}
+	if (m_operands.size() == 1) {
+		return m_operands[0];
+	}
+	return make_multiplication(m_operands);
+}
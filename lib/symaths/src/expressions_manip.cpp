@@ -1,5 +1,6 @@
 #include "symaths/expressions_manip.hpp"
 
+#include "symaths/detail/sparse_polynomial.hpp"
 #include "symaths/symaths.hpp"
 
 sym::expression sym::reduce(const expression& expr) {
@@ -26,14 +27,31 @@ sym::expression sym::sort(const expression& expr) {
 }
 
 sym::expression sym::expand(const expression& expr) {
-	return std::visit([&](const auto& x) {
-		using T = std::decay_t<decltype(x)>;
+	return expand(expr, current_context->refactoring_rules().max_expansion_terms);
+}
 
-		if constexpr (std::is_same_v<T, detail::addition> || std::is_same_v<T, detail::multiplication> || std::is_same_v<T, detail::power> || std::is_same_v<T, detail::negation>) {
-			return x.expanded();
-		}
-		return expr.root;
-	}, expr.root->p_data);
+sym::expression sym::expand(const expression& expr, size_t max_terms) {
+	return detail::expand_polynomial(expr.root, max_terms);
+}
+
+sym::expression sym::polynomial_gcd(const expression& a, const expression& b) {
+	return detail::polynomial_gcd(a.root, b.root);
+}
+
+sym::expression sym::divide_exact(const expression& dividend, const expression& divisor) {
+	auto* quotient = detail::divide_polynomial(dividend.root, divisor.root);
+	if (!quotient) {
+		throw std::invalid_argument("The divisor does not divide the dividend.");
+	}
+	return quotient;
+}
+
+sym::expression sym::cancel(const expression& expr) {
+	return detail::cancel_rational(expr.root);
+}
+
+sym::fingerprint sym::hash(const expression& expr) {
+	return expr.root->p_fingerprint;
 }
 
 
@@ -0,0 +1,444 @@
+#include "symaths/integration.hpp"
+
+#include "symaths/parsing/compiler.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <exception>
+#include <limits>
+#include <stdexcept>
+#include <thread>
+
+using namespace sym;
+
+// Points evaluated by a thread at once : whole regions are handed out until their points reach this amount
+constexpr size_t integration_block = 2048;
+// Regions split in a round hold at least this fraction of the total error
+constexpr double split_error_fraction = 0.5;
+constexpr size_t max_cubature_variables = 20;
+
+// Gauss-Kronrod nodes on [0;1] (the 15-point rule is symmetric), with the weights of the Kronrod rule and of the
+// embedded 7-point Gauss rule, whose nodes are the odd ones
+constexpr double kronrod_nodes[] = {
+	0.991455371120812639206854697526329, 0.949107912342758524526189684047851, 0.864864423359769072789712788640926,
+	0.741531185599394439863864773280788, 0.586087235467691130294144845693013, 0.405845151377397166906606412076961,
+	0.207784955007898467600689403773245, 0.0
+};
+constexpr double kronrod_weights[] = {
+	0.022935322010529224963732008058970, 0.063092092629978553290700663189204, 0.104790010322250183839876322541518,
+	0.140653259715525918745189590510238, 0.169004726639267902826583426598550, 0.190350578064785409913256402421014,
+	0.204432940075298892414161999234649, 0.209482141084727828012999174891714
+};
+constexpr double gauss_weights[] = {
+	0.129484966168869693270611432679082, 0.279705391489276667901467771423780, 0.381830050505118944950369775488975,
+	0.417959183673469387755102040816327
+};
+
+// Genz-Malik points are at these fractions of the half-widths
+const double malik_lambda2 = std::sqrt(9.0 / 70);
+const double malik_lambda4 = std::sqrt(9.0 / 10);
+const double malik_lambda5 = std::sqrt(9.0 / 19);
+
+// Change of variable x = x(t) of one dimension, so that infinite ranges become bounded ones
+struct range_map {
+	enum kind_t {
+		finite,
+		// [a;+inf[ : x = a + t / (1 - t), for t in [0;1[
+		upper_infinite,
+		// ]-inf;b] : x = b + t / (1 + t), for t in ]-1;0]
+		lower_infinite,
+		// x = t / (1 - t^2), for t in ]-1;1[
+		entire,
+	} kind;
+	double a;
+	double b;
+
+	// Range of t
+	[[nodiscard]] double t_lower() const { return kind == finite ? a : kind == upper_infinite ? 0 : -1; }
+	[[nodiscard]] double t_upper() const { return kind == finite ? b : kind == lower_infinite ? 0 : 1; }
+
+	// Returns x(t), and multiplies jacobian by dx/dt
+	double operator()(double t, double& jacobian) const {
+		switch (kind) {
+			case finite:
+				return t;
+			case upper_infinite: {
+				double s = 1 / (1 - t);
+				jacobian *= s * s;
+				return a + t * s;
+			}
+			case lower_infinite: {
+				double s = 1 / (1 + t);
+				jacobian *= s * s;
+				return b + t * s;
+			}
+			case entire: {
+				double s = 1 / (1 - t * t);
+				jacobian *= (1 + t * t) * s * s;
+				return t * s;
+			}
+		}
+		return t;
+	}
+};
+
+range_map make_range_map(double a, double b) {
+	if (std::isinf(a) && std::isinf(b)) return {range_map::entire, a, b};
+	if (std::isinf(a)) return {range_map::lower_infinite, a, b};
+	if (std::isinf(b)) return {range_map::upper_infinite, a, b};
+	return {range_map::finite, a, b};
+}
+
+// Box of the t variables, with the integral estimated over it
+struct quadrature_region {
+	std::vector<double> center;
+	std::vector<double> half_width;
+	double value = 0;
+	double error = 0;
+	// Dimension along which the region is split
+	size_t split = 0;
+};
+
+// Offsets of the points of the rule in n dimensions, in fractions of the half-widths : one row of n per point, in the
+// order expected by gauss_kronrod_rule and genz_malik_rule
+std::vector<double> rule_offsets(size_t n) {
+	std::vector<double> offsets(n, 0.0);
+	std::vector<double> table(offsets);
+	auto push = [&] { table.insert(table.end(), offsets.begin(), offsets.end()); };
+	if (n == 1) {
+		for (size_t k = 0; k < 7; ++k) {
+			for (double sign : {-1.0, 1.0}) {
+				offsets[0] = sign * kronrod_nodes[k];
+				push();
+			}
+		}
+		return table;
+	}
+
+	for (size_t i = 0; i < n; ++i) {
+		for (double lambda : {malik_lambda2, malik_lambda4}) {
+			for (double sign : {-1.0, 1.0}) {
+				offsets[i] = sign * lambda;
+				push();
+			}
+		}
+		offsets[i] = 0;
+	}
+	for (size_t i = 0; i < n; ++i) {
+		for (size_t j = i + 1; j < n; ++j) {
+			for (double si : {-1.0, 1.0}) {
+				for (double sj : {-1.0, 1.0}) {
+					offsets[i] = si * malik_lambda4;
+					offsets[j] = sj * malik_lambda4;
+					push();
+				}
+			}
+			offsets[i] = offsets[j] = 0;
+		}
+	}
+	for (size_t corner = 0; corner < (size_t{1} << n); ++corner) {
+		for (size_t i = 0; i < n; ++i) {
+			offsets[i] = (corner >> i & 1) ? malik_lambda5 : -malik_lambda5;
+		}
+		push();
+	}
+	return table;
+}
+
+struct quadrature_problem {
+	const compiled_expression& f;
+	std::vector<range_map> maps;
+	std::vector<double> offsets = rule_offsets(maps.size());
+	// Points per region : 15, or 2^n + 2n^2 + 2n + 1
+	size_t points = offsets.size() / maps.size();
+
+	[[nodiscard]] size_t dimensions() const { return maps.size(); }
+};
+
+// Memory of one thread
+struct quadrature_workspace {
+	std::vector<std::vector<double>> columns;
+	std::vector<const double*> column_pointers;
+	std::vector<double> jacobians;
+	std::vector<double> values;
+};
+
+// Gauss-Kronrod estimate, with the error heuristic of QUADPACK
+void gauss_kronrod_rule(quadrature_region& r, const double* v) {
+	double h = r.half_width[0];
+	double center = v[0];
+	double kronrod = kronrod_weights[7] * center;
+	double gauss = gauss_weights[3] * center;
+	double absolute = std::abs(kronrod);
+	for (size_t k = 0; k < 7; ++k) {
+		double sum = v[1 + 2 * k] + v[2 + 2 * k];
+		kronrod += kronrod_weights[k] * sum;
+		absolute += kronrod_weights[k] * (std::abs(v[1 + 2 * k]) + std::abs(v[2 + 2 * k]));
+		if (k % 2 == 1) {
+			gauss += gauss_weights[k / 2] * sum;
+		}
+	}
+	double mean = kronrod / 2;
+	double deviation = kronrod_weights[7] * std::abs(center - mean);
+	for (size_t k = 0; k < 7; ++k) {
+		deviation += kronrod_weights[k] * (std::abs(v[1 + 2 * k] - mean) + std::abs(v[2 + 2 * k] - mean));
+	}
+
+	r.value = kronrod * h;
+	double error = std::abs((kronrod - gauss) * h);
+	deviation *= std::abs(h);
+	if (deviation != 0 && error != 0) {
+		error = deviation * std::min(1.0, std::pow(200 * error / deviation, 1.5));
+	}
+	r.error = std::max(error, 50 * std::numeric_limits<double>::epsilon() * absolute * std::abs(h));
+	r.split = 0;
+}
+
+// Degree 7 Genz-Malik estimate, whose error is its difference with the embedded degree 5 rule
+void genz_malik_rule(quadrature_region& r, const double* v) {
+	size_t n = r.center.size();
+	double dn = static_cast<double>(n);
+	double center = v[0];
+	double sum2 = 0, sum3 = 0, sum4 = 0, sum5 = 0;
+	double largest_difference = -1;
+	const double* axis = v + 1;
+	for (size_t i = 0; i < n; ++i, axis += 4) {
+		sum2 += axis[0] + axis[1];
+		sum3 += axis[2] + axis[3];
+		// Fourth difference of f along the axis : f is the least polynomial in the variables where it is largest
+		double difference = std::abs(axis[0] + axis[1] - 2 * center - (axis[2] + axis[3] - 2 * center) / 7);
+		if (difference > largest_difference || (difference == largest_difference && r.half_width[i] > r.half_width[r.split])) {
+			largest_difference = difference;
+			r.split = i;
+		}
+	}
+	const double* pairs = axis;
+	size_t pair_points = 2 * n * (n - 1);
+	for (size_t k = 0; k < pair_points; ++k) {
+		sum4 += pairs[k];
+	}
+	const double* corners = pairs + pair_points;
+	for (size_t k = 0; k < (size_t{1} << n); ++k) {
+		sum5 += corners[k];
+	}
+
+	double volume = 1;
+	for (double h : r.half_width) {
+		volume *= 2 * h;
+	}
+	double degree7 = (12824 - 9120 * dn + 400 * dn * dn) / 19683 * center + 980.0 / 6561 * sum2 + (1820 - 400 * dn) / 19683 * sum3 + 200.0 / 19683 * sum4 + 6859.0 / 19683 / std::ldexp(1.0, static_cast<int>(n)) * sum5;
+	double degree5 = (729 - 950 * dn + 50 * dn * dn) / 729 * center + 245.0 / 486 * sum2 + (265 - 100 * dn) / 1458 * sum3 + 25.0 / 729 * sum4;
+	r.value = volume * degree7;
+	r.error = std::abs(volume * (degree7 - degree5));
+}
+
+// Evaluates the rule on the regions [first, last)
+void evaluate_regions(const quadrature_problem& problem, quadrature_region* first, quadrature_region* last, quadrature_workspace& ws) {
+	size_t n = problem.dimensions();
+	size_t per_region = problem.points;
+	size_t count = static_cast<size_t>(last - first) * per_region;
+	ws.columns.resize(n);
+	ws.column_pointers.resize(n);
+	for (size_t d = 0; d < n; ++d) {
+		ws.columns[d].resize(count);
+	}
+
+	ws.jacobians.assign(count, 1.0);
+	for (size_t d = 0; d < n; ++d) {
+		double* column = ws.columns[d].data();
+		for (auto* r = first; r != last; ++r) {
+			double c = r->center[d], h = r->half_width[d];
+			const double* offset = problem.offsets.data() + d;
+			for (size_t k = 0; k < per_region; ++k, offset += n) {
+				*column++ = c + *offset * h;
+			}
+		}
+		if (problem.maps[d].kind != range_map::finite) {
+			for (size_t i = 0; i < count; ++i) {
+				ws.columns[d][i] = problem.maps[d](ws.columns[d][i], ws.jacobians[i]);
+			}
+		}
+		ws.column_pointers[d] = ws.columns[d].data();
+	}
+	ws.values.resize(count);
+	problem.f.eval_batch(ws.column_pointers.data(), ws.values.data(), count);
+	for (size_t i = 0; i < count; ++i) {
+		// Zeros at points mapped far away stay zeros, whatever the jacobian
+		ws.values[i] = ws.values[i] == 0 ? 0 : ws.values[i] * ws.jacobians[i];
+	}
+
+	const double* v = ws.values.data();
+	for (auto* r = first; r != last; ++r, v += per_region) {
+		if (n == 1) {
+			gauss_kronrod_rule(*r, v);
+		}
+		else {
+			genz_malik_rule(*r, v);
+		}
+		if (!std::isfinite(r->value) || !std::isfinite(r->error)) {
+			r->error = std::numeric_limits<double>::infinity();
+		}
+	}
+}
+
+// Evaluates regions, in blocks of whole regions shared between threads
+void evaluate_regions(const quadrature_problem& problem, std::vector<quadrature_region>& regions, std::vector<quadrature_workspace>& workspaces) {
+	size_t per_block = std::max<size_t>(1, integration_block / problem.points);
+	size_t blocks = (regions.size() + per_block - 1) / per_block;
+	size_t threads = std::max<size_t>(1, std::min(workspaces.size(), blocks));
+
+	std::atomic<size_t> next = 0;
+	std::vector<std::exception_ptr> errors(threads);
+	auto work = [&](size_t worker) {
+		try {
+			for (size_t b = next++; b < blocks; b = next++) {
+				size_t first = b * per_block;
+				size_t last = std::min(regions.size(), first + per_block);
+				evaluate_regions(problem, regions.data() + first, regions.data() + last, workspaces[worker]);
+			}
+		}
+		catch (...) {
+			errors[worker] = std::current_exception();
+			next = blocks;
+		}
+	};
+
+	{
+		std::vector<std::jthread> workers;
+		for (size_t t = 1; t < threads; ++t) {
+			workers.emplace_back(work, t);
+		}
+		work(0);
+	}
+	for (auto& error : errors) {
+		if (error) {
+			std::rethrow_exception(error);
+		}
+	}
+}
+
+// Whether halving the region along its split dimension gives distinct points
+bool is_splittable(const quadrature_region& r) {
+	size_t d = r.split;
+	double quarter = r.half_width[d] / 2;
+	return r.center[d] - quarter != r.center[d] && r.center[d] + quarter != r.center[d];
+}
+
+integration_result adaptive_integration(const quadrature_problem& problem, const integration_options& options) {
+	size_t threads = options.threads == 0 ? std::max(1u, std::thread::hardware_concurrency()) : options.threads;
+	std::vector<quadrature_workspace> workspaces(std::max<size_t>(1, threads));
+
+	quadrature_region whole;
+	for (const auto& map : problem.maps) {
+		whole.center.push_back((map.t_lower() + map.t_upper()) / 2);
+		whole.half_width.push_back((map.t_upper() - map.t_lower()) / 2);
+	}
+	std::vector<quadrature_region> fresh{whole};
+	evaluate_regions(problem, fresh, workspaces);
+
+	// Max-heap on the error. Regions which cannot be split are set aside.
+	auto by_error = [](const quadrature_region& a, const quadrature_region& b) { return a.error < b.error; };
+	std::vector<quadrature_region> heap;
+	std::vector<quadrature_region> final_regions;
+	integration_result result;
+	result.evaluations = problem.points;
+
+	// Sums are updated as regions come and go, and summed again before they are trusted : rounds may split a single
+	// region among many
+	auto sum_regions = [&] {
+		result.value = result.error = 0;
+		for (const auto* list : {&heap, &final_regions}) {
+			for (const auto& r : *list) {
+				result.value += r.value;
+				result.error += r.error;
+			}
+		}
+	};
+	while (true) {
+		for (auto& r : fresh) {
+			result.value += r.value;
+			result.error += r.error;
+			if (is_splittable(r)) {
+				heap.push_back(std::move(r));
+				std::ranges::push_heap(heap, by_error);
+			}
+			else {
+				final_regions.push_back(std::move(r));
+			}
+		}
+		fresh.clear();
+
+		auto target = [&] { return std::max(options.absolute_tolerance, options.tolerance * std::abs(result.value)); };
+		if (result.error <= target()) {
+			sum_regions();
+			if (result.error <= target()) {
+				result.converged = true;
+				return result;
+			}
+		}
+
+		// Regions with the largest errors, until they hold a fraction of the error or the budget is spent
+		size_t cost = 2 * problem.points;
+		double selected = 0;
+		while (!heap.empty() && selected < split_error_fraction * result.error && result.evaluations + cost <= options.max_evaluations) {
+			std::ranges::pop_heap(heap, by_error);
+			quadrature_region r = std::move(heap.back());
+			heap.pop_back();
+			selected += r.error;
+			result.value -= r.value;
+			result.error -= r.error;
+			result.evaluations += cost;
+
+			size_t d = r.split;
+			r.half_width[d] /= 2;
+			quadrature_region upper = r;
+			r.center[d] -= r.half_width[d];
+			upper.center[d] += upper.half_width[d];
+			fresh.push_back(std::move(r));
+			fresh.push_back(std::move(upper));
+		}
+		if (fresh.empty()) {
+			sum_regions();
+			return result;
+		}
+		evaluate_regions(problem, fresh, workspaces);
+	}
+}
+
+integration_result sym::integrate(const expression& f, const symbol& variable, double a, double b, double tolerance) {
+	integration_options options;
+	options.tolerance = tolerance;
+	return integrate(f, variable, a, b, options);
+}
+
+integration_result sym::integrate(const expression& f, const symbol& variable, double a, double b, const integration_options& options) {
+	if (a == b) {
+		return {0, 0, 0, true};
+	}
+	if (a > b) {
+		integration_result result = integrate(f, variable, b, a, options);
+		result.value = -result.value;
+		return result;
+	}
+	return integrate(f, std::vector<symbol>{variable}, box{domain::between(a, b)}, options);
+}
+
+integration_result sym::integrate(const expression& f, const std::vector<symbol>& variables, const box& region, const integration_options& options) {
+	if (variables.empty() || region.size() != variables.size() || variables.size() > max_cubature_variables) {
+		throw std::invalid_argument("Integration needs a range for each variable, and at most 20 variables.");
+	}
+	std::vector<range_map> maps;
+	for (const auto& d : region) {
+		if (std::isnan(d.lower) || std::isnan(d.upper) || d.lower > d.upper) {
+			throw std::invalid_argument("Integration ranges must be non-empty.");
+		}
+		if (d.lower == d.upper) {
+			return {0, 0, 0, true};
+		}
+		maps.push_back(make_range_map(d.lower, d.upper));
+	}
+
+	compiled_expression program(f, variables);
+	return adaptive_integration({program, std::move(maps)}, options);
+}
@@ -0,0 +1,211 @@
+#include "symaths/polynomial.hpp"
+
+#include "symaths/symaths.hpp"
+
+#include <algorithm>
+#include <array>
+#include <stdexcept>
+
+using namespace sym;
+
+// Amount of points evaluated at once by eval_batch
+constexpr size_t multivariate_batch_block = 256;
+
+multivariate_polynomial::multivariate_polynomial(std::vector<symbol> variables, std::shared_ptr<const detail::monomial_layout> layout, detail::sparse_polynomial terms)
+	: m_variables(std::move(variables)), m_layout(std::move(layout)), m_terms(std::move(terms)) {
+	m_power_offsets.push_back(0);
+	for (size_t v = 0; v < m_variables.size(); ++v) {
+		m_degrees.push_back(m_terms.degree(v));
+		m_power_offsets.push_back(m_power_offsets.back() + m_degrees.back() + 1);
+	}
+}
+
+multivariate_polynomial multivariate_polynomial::developed(const expression& expr, std::vector<const detail::node*> generators, bool add_symbols, monomial_order order) {
+	uint64_t degree = detail::polynomial_degree_bound(expr.root, generators, add_symbols);
+	auto layout = std::make_shared<const detail::monomial_layout>(generators, degree, order);
+	detail::sparse_polynomial terms = detail::develop_polynomial(expr.root, *layout);
+	return {std::vector<symbol>(generators.begin(), generators.end()), layout, std::move(terms)};
+}
+
+multivariate_polynomial::multivariate_polynomial(const expression& expr, monomial_order order)
+	: multivariate_polynomial(developed(expr, {}, true, order)) {}
+
+multivariate_polynomial::multivariate_polynomial(const expression& expr, std::vector<symbol> variables, monomial_order order)
+	: multivariate_polynomial(developed(expr, [&] {
+		std::vector<const detail::node*> generators;
+		for (const auto& v : variables) {
+			generators.push_back(v.ref);
+		}
+		return generators;
+	}(), false, order)) {}
+
+std::pair<multivariate_polynomial, multivariate_polynomial> multivariate_polynomial::unified(const multivariate_polynomial& lhs, const multivariate_polynomial& rhs, uint64_t max_exponent) {
+	if (lhs.order() != rhs.order()) {
+		throw std::invalid_argument("Polynomials with different monomial orders.");
+	}
+	const detail::monomial_layout& l = *lhs.m_layout;
+	const detail::monomial_layout& r = *rhs.m_layout;
+	bool fits = max_exponent <= l.max_exponent();
+	if (lhs.m_layout == rhs.m_layout && fits) {
+		return {lhs, rhs};
+	}
+	// Same packing : only the layout of rhs is replaced
+	if (fits && l.generators == r.generators && l.bits == r.bits) {
+		return {lhs, multivariate_polynomial(lhs.m_variables, lhs.m_layout, rhs.m_terms.repacked(l))};
+	}
+
+	std::vector<const detail::node*> generators = l.generators;
+	std::vector<symbol> variables = lhs.m_variables;
+	for (const auto& v : rhs.m_variables) {
+		if (std::ranges::find(generators, v.ref) == generators.end()) {
+			generators.push_back(v.ref);
+			variables.push_back(v);
+		}
+	}
+	// Twice the room needed, so that a few more products fit
+	uint64_t room = std::max({max_exponent > UINT64_MAX / 2 ? UINT64_MAX : 2 * max_exponent, l.max_exponent(), r.max_exponent()});
+	auto layout = std::make_shared<const detail::monomial_layout>(generators, room, lhs.order());
+	return {
+		multivariate_polynomial(variables, layout, lhs.m_terms.repacked(*layout)),
+		multivariate_polynomial(variables, layout, rhs.m_terms.repacked(*layout))
+	};
+}
+
+uint64_t multivariate_polynomial::degree() const {
+	uint64_t result = 0;
+	for (size_t t = 0; t < size(); ++t) {
+		uint64_t d = 0;
+		for (size_t v = 0; v < m_variables.size(); ++v) {
+			d += exponent(t, v);
+		}
+		result = std::max(result, d);
+	}
+	return result;
+}
+
+// Largest exponent of any variable
+uint64_t max_variable_degree(const multivariate_polynomial& p) {
+	uint64_t result = 0;
+	for (size_t v = 0; v < p.variables().size(); ++v) {
+		result = std::max(result, p.degree(v));
+	}
+	return result;
+}
+
+multivariate_polynomial multivariate_polynomial::operator+(const multivariate_polynomial& other) const {
+	auto [lhs, rhs] = unified(*this, other, std::max(max_variable_degree(*this), max_variable_degree(other)));
+	return {lhs.m_variables, lhs.m_layout, lhs.m_terms + rhs.m_terms};
+}
+
+multivariate_polynomial multivariate_polynomial::operator-(const multivariate_polynomial& other) const {
+	return *this + -other;
+}
+
+multivariate_polynomial multivariate_polynomial::operator-() const {
+	return {m_variables, m_layout, -m_terms};
+}
+
+multivariate_polynomial multivariate_polynomial::operator*(const multivariate_polynomial& other) const {
+	auto [lhs, rhs] = unified(*this, other, max_variable_degree(*this) + max_variable_degree(other));
+	return {lhs.m_variables, lhs.m_layout, lhs.m_terms * rhs.m_terms};
+}
+
+multivariate_polynomial multivariate_polynomial::pow(unsigned long long n) const {
+	auto [result, base] = unified(*this, *this, max_variable_degree(*this) * n);
+	detail::sparse_polynomial terms = *base.m_terms.pow(n, std::numeric_limits<size_t>::max());
+	return {base.m_variables, base.m_layout, std::move(terms)};
+}
+
+double multivariate_polynomial::eval(const double* values) const {
+	// Powers of each variable up to its degree, then one product per term
+	std::array<double, 64> small_powers;
+	std::vector<double> large_powers;
+	double* powers = small_powers.data();
+	if (m_power_offsets.back() > small_powers.size()) {
+		large_powers.resize(m_power_offsets.back());
+		powers = large_powers.data();
+	}
+	for (size_t v = 0; v < m_variables.size(); ++v) {
+		double* p = powers + m_power_offsets[v];
+		p[0] = 1;
+		for (uint64_t e = 1; e <= m_degrees[v]; ++e) {
+			p[e] = p[e - 1] * values[v];
+		}
+	}
+
+	double result = 0;
+	for (size_t t = 0; t < size(); ++t) {
+		double term = coefficient(t).get<double>();
+		for (size_t v = 0; v < m_variables.size(); ++v) {
+			term *= powers[m_power_offsets[v] + exponent(t, v)];
+		}
+		result += term;
+	}
+	return result;
+}
+
+void multivariate_polynomial::eval_batch(const double* const* columns, double* out, size_t count) const {
+	constexpr size_t block = multivariate_batch_block;
+	size_t variables = m_variables.size();
+
+	// Rows of the tables : x^e for e from 1 to the degree of x
+	std::vector<size_t> first_row(variables);
+	size_t rows = 0;
+	for (size_t v = 0; v < variables; ++v) {
+		first_row[v] = rows;
+		rows += m_degrees[v];
+	}
+
+	// Each term is its coefficient times a list of rows
+	std::vector<double> coefficients(size());
+	std::vector<size_t> factors_start{0};
+	std::vector<size_t> factors;
+	for (size_t t = 0; t < size(); ++t) {
+		coefficients[t] = coefficient(t).get<double>();
+		for (size_t v = 0; v < variables; ++v) {
+			if (uint64_t e = exponent(t, v)) {
+				factors.push_back(first_row[v] + e - 1);
+			}
+		}
+		factors_start.push_back(factors.size());
+	}
+
+	std::vector<double> table(rows * block);
+	std::vector<double> term(block);
+	for (size_t start = 0; start < count; start += block) {
+		size_t len = std::min(block, count - start);
+		for (size_t v = 0; v < variables; ++v) {
+			if (m_degrees[v] == 0) {
+				continue;
+			}
+			double* x = table.data() + first_row[v] * block;
+			std::copy_n(columns[v] + start, len, x);
+			for (uint64_t e = 2; e <= m_degrees[v]; ++e) {
+				double* row = x + (e - 1) * block;
+				double* previous = row - block;
+				for (size_t i = 0; i < len; ++i) {
+					row[i] = previous[i] * x[i];
+				}
+			}
+		}
+
+		double* o = out + start;
+		std::fill_n(o, len, 0.0);
+		for (size_t t = 0; t < size(); ++t) {
+			std::fill_n(term.data(), len, coefficients[t]);
+			for (size_t f = factors_start[t]; f < factors_start[t + 1]; ++f) {
+				const double* row = table.data() + factors[f] * block;
+				for (size_t i = 0; i < len; ++i) {
+					term[i] *= row[i];
+				}
+			}
+			for (size_t i = 0; i < len; ++i) {
+				o[i] += term[i];
+			}
+		}
+	}
+}
+
+expression multivariate_polynomial::to_expression() const {
+	return m_terms.to_node();
+}
@@ -2,6 +2,8 @@
 
 #include "symaths/utils/maths.hpp"
 
+#include <format>
+#include <iterator>
 #include <numeric>
 
 using namespace sym;
@@ -37,7 +39,8 @@ void number::downcast() {
 			return q;
 		},
 		[&](const numbers::real& n) -> internal_data_t {
-			if (std::abs(n.val - std::round(n.val)) < 1e-12) {
+			// Reals out of the range of 64 bits integers stay reals
+			if (std::abs(n.val - std::round(n.val)) < 1e-12 && std::abs(n.val) < 0x1p63) {
 				if (n.val >= 0) {
 					return numbers::natural{static_cast<unsigned long long>(n.val)};
 				}
@@ -48,7 +51,7 @@ void number::downcast() {
 		[&](const numbers::complex& z) -> internal_data_t {
 			if (std::abs(z.val.imag()) < 1e-12) {
 				auto n = numbers::real{z.val.real()};
-				if (std::abs(n.val - std::round(n.val)) < 1e-12) {
+				if (std::abs(n.val - std::round(n.val)) < 1e-12 && std::abs(n.val) < 0x1p63) {
 					if (n.val >= 0) {
 						return numbers::natural{static_cast<unsigned long long>(n.val)};
 					}
@@ -63,18 +66,27 @@ void number::downcast() {
 }
 
 std::string number::string() const {
-	return std::visit(overloaded {
-		[&](const numbers::natural n) -> std::string { return std::format("{}", n.val); },
-		[&](const numbers::integer n) -> std::string { return std::format("{}", n.val); },
-		[&](const numbers::rational n) -> std::string { return std::format("{}/{}", n.num, n.den); },
-		[&](const numbers::real n) -> std::string { return std::format("{}", n.val); },
-		[&](const numbers::complex n) -> std::string {
+	std::string s;
+	append_to(s);
+	return s;
+}
+
+void number::append_to(std::string& out) const {
+	auto it = std::back_inserter(out);
+	std::visit(overloaded {
+		[&](const numbers::natural n) { std::format_to(it, "{}", n.val); },
+		[&](const numbers::integer n) { std::format_to(it, "{}", n.val); },
+		[&](const numbers::rational n) { std::format_to(it, "{}/{}", n.num, n.den); },
+		[&](const numbers::real n) { std::format_to(it, "{}", n.val); },
+		[&](const numbers::complex n) {
 			if (n.val.imag() < 0) {
-				return std::format("{}{}i", n.val.real(), n.val.imag());
+				std::format_to(it, "{}{}i", n.val.real(), n.val.imag());
+			}
+			else {
+				std::format_to(it, "{}+{}i", n.val.real(), n.val.imag());
 			}
-			return std::format("{}+{}i", n.val.real(), n.val.imag());
 		},
-		[&](const numbers::nan&) -> std::string { return "nan"; }
+		[&](const numbers::nan&) { out += "nan"; }
 	}, p_data);
 }
 
@@ -304,7 +316,17 @@ number sym::pow_calc(const number& lhs, const number& rhs) {
 
 	number num = std::visit(overloaded {
 		[&](const numbers::natural& n1, const numbers::natural& n2)   -> number::internal_data_t { return numbers::natural{static_cast<unsigned long long>(std::pow(n1.val, n2.val))}; },
-		[&](const numbers::integer& n1, const numbers::integer& n2)   -> number::internal_data_t { return numbers::integer{static_cast<long long>(std::pow(n1.val, n2.val))}; },
+		[&](const numbers::integer& n1, const numbers::integer& n2)   -> number::internal_data_t {
+			if (n2.val >= 0) {
+				return numbers::integer{static_cast<long long>(std::pow(n1.val, n2.val))};
+			}
+			// Negative powers are rationals, not truncated to integers
+			if (n1.val == 0) {
+				return numbers::nan{};
+			}
+			long long sign = n1.val < 0 && n2.val % 2 != 0 ? -1 : 1;
+			return numbers::rational{sign, static_cast<long long>(std::pow(std::abs(n1.val), -n2.val))};
+		},
 		[&](const numbers::rational& n1, const numbers::rational& n2) -> number::internal_data_t { return numbers::real{std::pow(n1.double_value(), n2.double_value())}; },
 		[&](const numbers::real& n1, const numbers::real& n2)         -> number::internal_data_t { return numbers::real{std::pow(n1.val, n2.val)}; },
 		[&](const numbers::complex& n1, const numbers::complex& n2)   -> number::internal_data_t { return numbers::complex{std::pow(n1.val, n2.val)}; },
@@ -0,0 +1,544 @@
+#include "symaths/ode.hpp"
+
+#include "symaths/symaths.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <exception>
+#include <limits>
+#include <stdexcept>
+#include <thread>
+
+using namespace sym;
+
+// Trajectories stepped in lockstep by one thread
+constexpr size_t ode_lanes = 256;
+// Jacobians of at least this size, and with at most this fraction of non-zero entries, are factorized by a sparse LU
+constexpr size_t ode_sparse_min_size = 32;
+constexpr double ode_sparse_density = 0.1;
+// Step size control : safety factor, and bounds of the ratio between consecutive steps
+constexpr double step_safety = 0.9;
+constexpr double min_step_ratio = 0.2;
+constexpr double max_step_ratio = 5;
+
+// Dormand-Prince tableau. The last row holds the weights of the 5th order solution, at which the last stage is
+// evaluated : it is the first stage of the next step.
+constexpr double dormand_prince_c[] = {0, 1.0 / 5, 3.0 / 10, 4.0 / 5, 8.0 / 9, 1, 1};
+constexpr double dormand_prince_a[7][6] = {
+	{},
+	{1.0 / 5},
+	{3.0 / 40, 9.0 / 40},
+	{44.0 / 45, -56.0 / 15, 32.0 / 9},
+	{19372.0 / 6561, -25360.0 / 2187, 64448.0 / 6561, -212.0 / 729},
+	{9017.0 / 3168, -355.0 / 33, 46732.0 / 5247, 49.0 / 176, -5103.0 / 18656},
+	{35.0 / 384, 0, 500.0 / 1113, 125.0 / 192, -2187.0 / 6784, 11.0 / 84},
+};
+// Weights of the 5th order solution minus those of the embedded 4th order one
+constexpr double dormand_prince_e[] = {71.0 / 57600, 0, -71.0 / 16695, 71.0 / 1920, -17253.0 / 339200, 22.0 / 525, -1.0 / 40};
+
+ode_system::ode_system(std::vector<expression> rhs, std::vector<symbol> states, symbol time, std::vector<symbol> parameters)
+	: m_rhs(std::move(rhs)), m_states(std::move(states)), m_time(time), m_parameters(std::move(parameters)) {
+	size_t n = m_states.size();
+	if (n == 0 || m_rhs.size() != n) {
+		throw std::invalid_argument("An ODE system needs one right-hand side per state.");
+	}
+	std::vector<symbol> variables{m_time};
+	variables.insert(variables.end(), m_states.begin(), m_states.end());
+	variables.insert(variables.end(), m_parameters.begin(), m_parameters.end());
+
+	std::vector<expression> outputs = m_rhs;
+	for (size_t i = 0; i < n; ++i) {
+		std::vector<const detail::node*> symbols = detail::list_symbols(m_rhs[i].root);
+		for (size_t j = 0; j < n; ++j) {
+			if (std::ranges::find(symbols, m_states[j].ref) == symbols.end()) {
+				continue;
+			}
+			expression derivative = differentiate(m_rhs[i], m_states[j]);
+			double value;
+			if (detail::numeric_constant(derivative.root, value) && value == 0) {
+				continue;
+			}
+			m_jacobian_pattern.emplace_back(i, j);
+			outputs.push_back(derivative);
+		}
+	}
+	for (const auto& f : m_rhs) {
+		outputs.push_back(differentiate(f, m_time));
+	}
+	m_rhs_program = compiled_vector_expression(m_rhs, variables);
+	m_rosenbrock_program = compiled_vector_expression(outputs, variables);
+}
+
+struct ode_problem {
+	const compiled_vector_expression& rhs;
+	const compiled_vector_expression& rosenbrock;
+	const detail::sparsity_pattern& jacobian_pattern;
+	// Pattern of I - h d J : the Jacobian, then the diagonal
+	detail::sparsity_pattern w_pattern;
+	size_t n;
+	size_t p;
+	const std::vector<double>& times;
+	const std::vector<double>& initial_states;
+	const std::vector<double>& parameters;
+	const ode_options& options;
+	// 1 when integrating forward in time, -1 backward
+	double direction;
+	bool sparse;
+	ode_result& result;
+};
+
+// Lanes of one block, in structure of arrays : component i of lane l is at [i * ode_lanes + l]. Finished lanes are
+// replaced by the last active one.
+struct ode_block {
+	size_t lanes = 0;
+	std::vector<double> t;
+	// Magnitude of the next step
+	std::vector<double> h;
+	std::vector<double> y;
+	// f(t, y), kept from the last stage of the previous step by Dormand-Prince
+	std::vector<double> f;
+	std::vector<double> params;
+	std::vector<size_t> trajectory;
+	std::vector<size_t> next_output;
+
+	std::vector<double> step;
+	std::vector<char> reaching;
+	std::vector<char> done;
+	std::vector<double> stage_t;
+	std::vector<double> stage_y;
+	std::vector<double> y_new;
+	std::vector<double> k;
+	std::vector<double> error;
+	std::vector<const double*> columns;
+	std::vector<double*> outputs;
+
+	std::vector<double> jacobian;
+	std::vector<double> time_derivative;
+	std::vector<double> w_values;
+	std::vector<double> rhs;
+	std::vector<detail::dense_lu> dense;
+	std::vector<detail::sparse_lu> sparse;
+	std::vector<char> regular;
+};
+
+void ode_move_lane(const ode_problem& pb, ode_block& b, size_t from, size_t to) {
+	b.t[to] = b.t[from];
+	b.h[to] = b.h[from];
+	b.trajectory[to] = b.trajectory[from];
+	b.next_output[to] = b.next_output[from];
+	for (size_t i = 0; i < pb.n; ++i) {
+		b.y[i * ode_lanes + to] = b.y[i * ode_lanes + from];
+		b.f[i * ode_lanes + to] = b.f[i * ode_lanes + from];
+	}
+	for (size_t j = 0; j < pb.p; ++j) {
+		b.params[j * ode_lanes + to] = b.params[j * ode_lanes + from];
+	}
+}
+
+// Evaluates a program at (t, y) on every active lane. Its outputs are the rows of out, count of them.
+void ode_evaluate(const ode_problem& pb, const compiled_vector_expression& program, ode_block& b, const double* t, const double* y, double* out, size_t count) {
+	b.columns[0] = t;
+	for (size_t i = 0; i < pb.n; ++i) {
+		b.columns[1 + i] = y + i * ode_lanes;
+	}
+	for (size_t j = 0; j < pb.p; ++j) {
+		b.columns[1 + pb.n + j] = b.params.data() + j * ode_lanes;
+	}
+	b.outputs.resize(count);
+	for (size_t i = 0; i < count; ++i) {
+		b.outputs[i] = out + i * ode_lanes;
+	}
+	program.eval_batch(b.columns.data(), b.outputs.data(), b.lanes);
+}
+
+// Weighted RMS norm of the local error of a lane
+double ode_error_norm(const ode_problem& pb, const ode_block& b, size_t l) {
+	double sum = 0;
+	for (size_t i = 0; i < pb.n; ++i) {
+		size_t at = i * ode_lanes + l;
+		double scale = pb.options.absolute_tolerance + pb.options.relative_tolerance * std::max(std::abs(b.y[at]), std::abs(b.y_new[at]));
+		double e = b.error[at] / scale;
+		sum += e * e;
+	}
+	double norm = std::sqrt(sum / static_cast<double>(pb.n));
+	return std::isnan(norm) ? std::numeric_limits<double>::infinity() : norm;
+}
+
+// Ratio between the next step and the current one, for a method whose local error is O(h^order)
+double ode_step_ratio(double error, double order) {
+	if (error == 0) {
+		return max_step_ratio;
+	}
+	return std::clamp(step_safety * std::pow(error, -1 / order), min_step_ratio, max_step_ratio);
+}
+
+// Sets up the lanes of trajectories [first, last) at the initial time
+void ode_start_block(const ode_problem& pb, ode_block& b, size_t first, size_t last) {
+	size_t n = pb.n, p = pb.p, L = ode_lanes;
+	b.lanes = last - first;
+	b.t.assign(L, pb.times.front());
+	b.h.resize(L);
+	b.y.resize(n * L);
+	b.f.resize(n * L);
+	b.params.resize(p * L);
+	b.trajectory.resize(L);
+	b.next_output.assign(L, 1);
+	b.step.resize(L);
+	b.reaching.resize(L);
+	b.done.resize(L);
+	b.stage_t.resize(L);
+	b.stage_y.resize(n * L);
+	b.y_new.resize(n * L);
+	b.k.resize(7 * n * L);
+	b.error.resize(n * L);
+	b.columns.resize(1 + n + p);
+
+	bool shared = pb.parameters.size() == p;
+	for (size_t l = 0; l < b.lanes; ++l) {
+		size_t j = first + l;
+		b.trajectory[l] = j;
+		for (size_t i = 0; i < n; ++i) {
+			b.y[i * L + l] = pb.initial_states[j * n + i];
+		}
+		for (size_t q = 0; q < p; ++q) {
+			b.params[q * L + l] = pb.parameters[(shared ? 0 : j * p) + q];
+		}
+	}
+
+	ode_evaluate(pb, pb.rhs, b, b.t.data(), b.y.data(), b.f.data(), n);
+	double span = std::abs(pb.times.back() - pb.times.front());
+	for (size_t l = 0; l < b.lanes; ++l) {
+		if (pb.options.initial_step > 0) {
+			b.h[l] = std::min(pb.options.initial_step, span);
+			continue;
+		}
+		// A step along which the solution changes by about 1 % of its size, in the norm of the tolerances
+		double states = 0, derivatives = 0;
+		for (size_t i = 0; i < n; ++i) {
+			size_t at = i * L + l;
+			double scale = pb.options.absolute_tolerance + pb.options.relative_tolerance * std::abs(b.y[at]);
+			states += (b.y[at] / scale) * (b.y[at] / scale);
+			derivatives += (b.f[at] / scale) * (b.f[at] / scale);
+		}
+		states = std::sqrt(states / static_cast<double>(n));
+		derivatives = std::sqrt(derivatives / static_cast<double>(n));
+		double h = states < 1e-5 || derivatives < 1e-5 || !std::isfinite(derivatives) ? 1e-6 : 0.01 * states / derivatives;
+		b.h[l] = std::min(h, span);
+	}
+}
+
+// Clips the steps of the lanes to their next output time
+void ode_choose_steps(const ode_problem& pb, ode_block& b) {
+	for (size_t l = 0; l < b.lanes; ++l) {
+		double remaining = std::abs(pb.times[b.next_output[l]] - b.t[l]);
+		b.reaching[l] = remaining <= b.h[l];
+		b.step[l] = pb.direction * std::min(b.h[l], remaining);
+		b.done[l] = false;
+	}
+}
+
+void ode_fail(const ode_problem& pb, ode_block& b, size_t l, ode_status status) {
+	size_t j = b.trajectory[l];
+	pb.result.status[j] = status;
+	for (size_t k = b.next_output[l]; k < pb.times.size(); ++k) {
+		std::fill_n(pb.result.states.begin() + static_cast<std::ptrdiff_t>((k * pb.result.trajectories + j) * pb.n), pb.n, std::numeric_limits<double>::quiet_NaN());
+	}
+	b.done[l] = true;
+}
+
+// Accepts the step of a lane from y_new, or shrinks it. Marks the lane done once it reached the last output time.
+// Returns whether the step was accepted.
+bool ode_finish_step(const ode_problem& pb, ode_block& b, size_t l, double error, double order) {
+	size_t j = b.trajectory[l];
+	double ratio = ode_step_ratio(error, order);
+	if (error > 1) {
+		++pb.result.rejected[j];
+		b.h[l] = std::abs(b.step[l]) * ratio;
+		if (b.h[l] <= 16 * std::numeric_limits<double>::epsilon() * std::max(std::abs(b.t[l]), std::numeric_limits<double>::min())) {
+			ode_fail(pb, b, l, ode_status::step_too_small);
+		}
+		return false;
+	}
+
+	for (size_t i = 0; i < pb.n; ++i) {
+		b.y[i * ode_lanes + l] = b.y_new[i * ode_lanes + l];
+	}
+	++pb.result.steps[j];
+	if (b.reaching[l]) {
+		// Steps clipped to an output time do not tell how large the next one may be
+		b.t[l] = pb.times[b.next_output[l]];
+		for (size_t i = 0; i < pb.n; ++i) {
+			pb.result.states[(b.next_output[l] * pb.result.trajectories + j) * pb.n + i] = b.y[i * ode_lanes + l];
+		}
+		b.done[l] = ++b.next_output[l] == pb.times.size();
+		b.h[l] = std::max(b.h[l], std::abs(b.step[l]) * ratio);
+	}
+	else {
+		b.t[l] += b.step[l];
+		b.h[l] = std::abs(b.step[l]) * ratio;
+	}
+	if (!b.done[l] && pb.result.steps[j] >= pb.options.max_steps) {
+		ode_fail(pb, b, l, ode_status::too_many_steps);
+	}
+	return true;
+}
+
+// Replaces finished lanes by the last active ones
+void ode_compact(const ode_problem& pb, ode_block& b) {
+	for (size_t l = b.lanes; l-- > 0;) {
+		if (b.done[l]) {
+			--b.lanes;
+			if (l != b.lanes) {
+				ode_move_lane(pb, b, b.lanes, l);
+				b.done[l] = b.done[b.lanes];
+			}
+		}
+	}
+}
+
+void dormand_prince_block(const ode_problem& pb, ode_block& b) {
+	size_t n = pb.n, L = ode_lanes;
+	double* k = b.k.data();
+	while (b.lanes > 0) {
+		ode_choose_steps(pb, b);
+		std::copy_n(b.f.begin(), n * L, b.k.begin());
+
+		for (size_t s = 1; s < 7; ++s) {
+			double* stage = s == 6 ? b.y_new.data() : b.stage_y.data();
+			for (size_t i = 0; i < n; ++i) {
+				double* out = stage + i * L;
+				const double* y = b.y.data() + i * L;
+				for (size_t l = 0; l < b.lanes; ++l) {
+					out[l] = 0;
+				}
+				for (size_t r = 0; r < s; ++r) {
+					double a = dormand_prince_a[s][r];
+					if (a == 0) {
+						continue;
+					}
+					const double* kr = k + (r * n + i) * L;
+					for (size_t l = 0; l < b.lanes; ++l) {
+						out[l] += a * kr[l];
+					}
+				}
+				for (size_t l = 0; l < b.lanes; ++l) {
+					out[l] = y[l] + b.step[l] * out[l];
+				}
+			}
+			for (size_t l = 0; l < b.lanes; ++l) {
+				b.stage_t[l] = b.t[l] + dormand_prince_c[s] * b.step[l];
+			}
+			ode_evaluate(pb, pb.rhs, b, b.stage_t.data(), stage, k + s * n * L, n);
+		}
+
+		for (size_t i = 0; i < n; ++i) {
+			double* e = b.error.data() + i * L;
+			for (size_t l = 0; l < b.lanes; ++l) {
+				e[l] = 0;
+			}
+			for (size_t r = 0; r < 7; ++r) {
+				double w = dormand_prince_e[r];
+				if (w == 0) {
+					continue;
+				}
+				const double* kr = k + (r * n + i) * L;
+				for (size_t l = 0; l < b.lanes; ++l) {
+					e[l] += w * kr[l];
+				}
+			}
+			for (size_t l = 0; l < b.lanes; ++l) {
+				e[l] *= b.step[l];
+			}
+		}
+
+		for (size_t l = 0; l < b.lanes; ++l) {
+			if (ode_finish_step(pb, b, l, ode_error_norm(pb, b, l), 5)) {
+				for (size_t i = 0; i < n; ++i) {
+					b.f[i * L + l] = k[(6 * n + i) * L + l];
+				}
+			}
+		}
+		ode_compact(pb, b);
+	}
+}
+
+// Solves W x = rhs for each lane whose W is regular, where rhs and x are rows of the block
+void rosenbrock_solve(const ode_problem& pb, ode_block& b, double* rows) {
+	for (size_t l = 0; l < b.lanes; ++l) {
+		if (!b.regular[l]) {
+			continue;
+		}
+		for (size_t i = 0; i < pb.n; ++i) {
+			b.rhs[i] = rows[i * ode_lanes + l];
+		}
+		pb.sparse ? b.sparse[l].solve(b.rhs.data()) : b.dense[l].solve(b.rhs.data());
+		for (size_t i = 0; i < pb.n; ++i) {
+			rows[i * ode_lanes + l] = b.rhs[i];
+		}
+	}
+}
+
+// Shampine's Rosenbrock 2(3) method, where W = I - h d J :
+//   k1 = W^-1 (F0 + h d T)
+//   k2 = W^-1 (F1 - k1) + k1, with F1 = f(t + h/2, y + h/2 k1)
+//   y_new = y + h k2
+//   k3 = W^-1 (F2 - e32 (k2 - F1) - 2 (k1 - F0) + h d T), with F2 = f(t + h, y_new)
+// and the local error is h/6 (k1 - 2 k2 + k3)
+void rosenbrock_block(const ode_problem& pb, ode_block& b) {
+	size_t n = pb.n, L = ode_lanes, entries = pb.jacobian_pattern.size();
+	const double d = 1 / (2 + std::sqrt(2.0));
+	const double e32 = 6 + std::sqrt(2.0);
+	b.jacobian.resize(entries * L);
+	b.time_derivative.resize(n * L);
+	b.w_values.resize(entries + n);
+	b.rhs.resize(n);
+	b.regular.resize(L);
+	pb.sparse ? b.sparse.resize(L) : b.dense.resize(L);
+
+	// Rows of the outputs of the Rosenbrock program
+	std::vector<double> outputs((2 * n + entries) * L);
+	double* k1 = b.k.data();
+	double* k2 = k1 + n * L;
+	double* k3 = k2 + n * L;
+	double* f1 = k3 + n * L;
+	double* f2 = f1 + n * L;
+
+	while (b.lanes > 0) {
+		ode_choose_steps(pb, b);
+		ode_evaluate(pb, pb.rosenbrock, b, b.t.data(), b.y.data(), outputs.data(), 2 * n + entries);
+		const double* f0 = outputs.data();
+		const double* jacobian = f0 + n * L;
+		const double* dt = jacobian + entries * L;
+
+		for (size_t l = 0; l < b.lanes; ++l) {
+			double hd = b.step[l] * d;
+			for (size_t e = 0; e < entries; ++e) {
+				b.w_values[e] = -hd * jacobian[e * L + l];
+			}
+			std::fill_n(b.w_values.begin() + static_cast<std::ptrdiff_t>(entries), n, 1.0);
+			b.regular[l] = pb.sparse ? b.sparse[l].factorize(n, pb.w_pattern, b.w_values.data()) : b.dense[l].factorize(n, pb.w_pattern, b.w_values.data());
+		}
+
+		for (size_t i = 0; i < n; ++i) {
+			for (size_t l = 0; l < b.lanes; ++l) {
+				size_t at = i * L + l;
+				k1[at] = f0[at] + b.step[l] * d * dt[at];
+			}
+		}
+		rosenbrock_solve(pb, b, k1);
+
+		for (size_t i = 0; i < n; ++i) {
+			for (size_t l = 0; l < b.lanes; ++l) {
+				size_t at = i * L + l;
+				b.stage_y[at] = b.y[at] + 0.5 * b.step[l] * k1[at];
+			}
+		}
+		for (size_t l = 0; l < b.lanes; ++l) {
+			b.stage_t[l] = b.t[l] + 0.5 * b.step[l];
+		}
+		ode_evaluate(pb, pb.rhs, b, b.stage_t.data(), b.stage_y.data(), f1, n);
+
+		for (size_t at = 0; at < n * L; ++at) {
+			k2[at] = f1[at] - k1[at];
+		}
+		rosenbrock_solve(pb, b, k2);
+		for (size_t i = 0; i < n; ++i) {
+			for (size_t l = 0; l < b.lanes; ++l) {
+				size_t at = i * L + l;
+				k2[at] += k1[at];
+				b.y_new[at] = b.y[at] + b.step[l] * k2[at];
+			}
+		}
+		for (size_t l = 0; l < b.lanes; ++l) {
+			b.stage_t[l] = b.t[l] + b.step[l];
+		}
+		ode_evaluate(pb, pb.rhs, b, b.stage_t.data(), b.y_new.data(), f2, n);
+
+		for (size_t i = 0; i < n; ++i) {
+			for (size_t l = 0; l < b.lanes; ++l) {
+				size_t at = i * L + l;
+				k3[at] = f2[at] - e32 * (k2[at] - f1[at]) - 2 * (k1[at] - f0[at]) + b.step[l] * d * dt[at];
+			}
+		}
+		rosenbrock_solve(pb, b, k3);
+		for (size_t i = 0; i < n; ++i) {
+			for (size_t l = 0; l < b.lanes; ++l) {
+				size_t at = i * L + l;
+				b.error[at] = b.step[l] / 6 * (k1[at] - 2 * k2[at] + k3[at]);
+			}
+		}
+
+		for (size_t l = 0; l < b.lanes; ++l) {
+			double error = b.regular[l] ? ode_error_norm(pb, b, l) : std::numeric_limits<double>::infinity();
+			ode_finish_step(pb, b, l, error, 3);
+		}
+		ode_compact(pb, b);
+	}
+}
+
+ode_result ode_system::solve(const std::vector<double>& times, const std::vector<double>& initial_states, const std::vector<double>& parameters, const ode_options& options) const {
+	size_t n = m_states.size(), p = m_parameters.size();
+	if (times.size() < 2 || initial_states.empty() || initial_states.size() % n != 0) {
+		throw std::invalid_argument("An ODE solve needs at least two times, and the initial states of whole trajectories.");
+	}
+	size_t count = initial_states.size() / n;
+	if (parameters.size() != p && parameters.size() != count * p) {
+		throw std::invalid_argument("Parameters are given once, or once per trajectory.");
+	}
+	double direction = times.back() >= times.front() ? 1 : -1;
+	for (size_t k = 1; k < times.size(); ++k) {
+		if (direction * (times[k] - times[k - 1]) < 0 || !std::isfinite(times[k])) {
+			throw std::invalid_argument("Output times must be finite and sorted.");
+		}
+	}
+
+	ode_result result;
+	result.trajectories = count;
+	result.dimension = n;
+	result.states.resize(times.size() * count * n);
+	std::copy(initial_states.begin(), initial_states.end(), result.states.begin());
+	result.status.assign(count, ode_status::success);
+	result.steps.assign(count, 0);
+	result.rejected.assign(count, 0);
+
+	ode_problem pb{m_rhs_program, m_rosenbrock_program, m_jacobian_pattern, m_jacobian_pattern, n, p, times, initial_states, parameters, options, direction, false, result};
+	for (size_t i = 0; i < n; ++i) {
+		pb.w_pattern.emplace_back(i, i);
+	}
+	pb.sparse = n >= ode_sparse_min_size && static_cast<double>(pb.w_pattern.size()) <= ode_sparse_density * static_cast<double>(n) * static_cast<double>(n);
+
+	size_t blocks = (count + ode_lanes - 1) / ode_lanes;
+	size_t threads = options.threads == 0 ? std::max(1u, std::thread::hardware_concurrency()) : options.threads;
+	threads = std::max<size_t>(1, std::min(threads, blocks));
+
+	std::atomic<size_t> next = 0;
+	std::vector<std::exception_ptr> errors(threads);
+	auto work = [&](size_t worker) {
+		try {
+			ode_block block;
+			for (size_t b = next++; b < blocks; b = next++) {
+				ode_start_block(pb, block, b * ode_lanes, std::min(count, (b + 1) * ode_lanes));
+				options.method == ode_method::rosenbrock ? rosenbrock_block(pb, block) : dormand_prince_block(pb, block);
+			}
+		}
+		catch (...) {
+			errors[worker] = std::current_exception();
+			next = blocks;
+		}
+	};
+
+	{
+		std::vector<std::jthread> workers;
+		for (size_t t = 1; t < threads; ++t) {
+			workers.emplace_back(work, t);
+		}
+		work(0);
+	}
+	for (auto& error : errors) {
+		if (error) {
+			std::rethrow_exception(error);
+		}
+	}
+	return result;
+}
@@ -0,0 +1,317 @@
+#include "symaths/optimization.hpp"
+
+#include "symaths/symaths.hpp"
+#include "symaths/detail/nodes.hpp"
+#include "symaths/utils/maths.hpp"
+
+#include <algorithm>
+#include <limits>
+#include <optional>
+#include <stdexcept>
+#include <unordered_map>
+
+using namespace sym;
+
+double sym::estimate_cost(const expression& expr) {
+	std::vector<symbol> variables;
+	for (auto* s : detail::list_symbols(expr.root)) {
+		variables.emplace_back(s);
+	}
+	return compiled_expression(expr, variables).cost();
+}
+
+
+// A term of a sum, seen as (-1)^negated * others * base1^e1 * base2^e2 * ...
+struct factored_term {
+	bool negated = false;
+	std::vector<const detail::node*> others;
+	std::vector<std::pair<const detail::node*, long long>> powers;
+
+	void add_power(const detail::node* base, long long exponent) {
+		auto it = std::ranges::find_if(powers, [&](const auto& p) { return p.first == base; });
+		if (it != powers.end()) {
+			it->second += exponent;
+		}
+		else {
+			powers.emplace_back(base, exponent);
+		}
+	}
+
+	[[nodiscard]] long long exponent_of(const detail::node* base) const {
+		auto it = std::ranges::find_if(powers, [&](const auto& p) { return p.first == base; });
+		return it != powers.end() ? it->second : 0;
+	}
+};
+
+void collect_factors(const detail::node* node, factored_term& term) {
+	std::visit([&](const auto& x) {
+		using T = std::decay_t<decltype(x)>;
+
+		if constexpr (std::is_same_v<T, detail::negation>) {
+			term.negated = !term.negated;
+			collect_factors(x.child, term);
+		}
+		else if constexpr (std::is_same_v<T, detail::multiplication>) {
+			for (auto* op : x.operands) {
+				collect_factors(op, term);
+			}
+		}
+		else if constexpr (std::is_same_v<T, detail::power>) {
+			double e;
+			if (detail::numeric_constant(x.exponent, e) && utils::is_integer(e) && e > 0) {
+				term.add_power(x.base, static_cast<long long>(std::round(e)));
+			}
+			else {
+				term.add_power(node, 1);
+			}
+		}
+		else if constexpr (std::is_same_v<T, detail::constant>) {
+			term.others.push_back(node);
+		}
+		else {
+			term.add_power(node, 1);
+		}
+	}, node->p_data);
+}
+
+class eval_optimizer {
+	node_manager_t& nm;
+	std::unordered_map<const detail::node*, const detail::node*> memo;
+
+public:
+	explicit eval_optimizer(node_manager_t& nm) : nm(nm) {}
+
+	const detail::node* optimize(const detail::node* node) {
+		if (auto it = memo.find(node); it != memo.end()) {
+			return it->second;
+		}
+
+		const detail::node* result = std::visit([&](const auto& x) -> const detail::node* {
+			using T = std::decay_t<decltype(x)>;
+
+			if constexpr (std::is_same_v<T, detail::negation>) {
+				return nm.make_negation(optimize(x.child));
+			}
+			else if constexpr (std::is_same_v<T, detail::addition>) {
+				std::vector<const detail::node*> ops;
+				for (auto* op : x.operands) {
+					ops.push_back(optimize(op));
+				}
+				return optimize_sum(std::move(ops));
+			}
+			else if constexpr (std::is_same_v<T, detail::multiplication>) {
+				std::vector<const detail::node*> ops;
+				for (auto* op : x.operands) {
+					ops.push_back(optimize(op));
+				}
+				return optimize_product(ops);
+			}
+			else if constexpr (std::is_same_v<T, detail::power>) {
+				const detail::node* exponent = optimize(x.exponent);
+				double e;
+				if (detail::numeric_constant(exponent, e) && e == 1) {
+					return optimize(x.base);
+				}
+				return nm.make_pow(optimize(x.base), exponent);
+			}
+			else if constexpr (std::is_same_v<T, detail::function_call>) {
+				std::vector<const detail::node*> args;
+				for (auto* arg : x.args) {
+					args.push_back(optimize(arg));
+				}
+				return nm.make_func(x.f_id, args);
+			}
+			return node;
+		}, node->p_data);
+
+		memo.emplace(node, result);
+		return result;
+	}
+
+private:
+	// Zero terms and unit factors are dropped, so that the cost model never counts them
+	const detail::node* sum_of(const std::vector<const detail::node*>& ops) {
+		std::vector<const detail::node*> terms;
+		for (auto* op : ops) {
+			double value;
+			if (!detail::numeric_constant(op, value) || value != 0) {
+				terms.push_back(op);
+			}
+		}
+		if (terms.empty()) {
+			return nm.make_constant(0);
+		}
+		return terms.size() == 1 ? terms.front() : nm.make_add(terms);
+	}
+
+	const detail::node* product_of(const std::vector<const detail::node*>& ops) {
+		std::vector<const detail::node*> factors;
+		for (auto* op : ops) {
+			double value;
+			if (detail::numeric_constant(op, value)) {
+				if (value == 0) {
+					return nm.make_constant(0);
+				}
+				if (value == 1) {
+					continue;
+				}
+			}
+			factors.push_back(op);
+		}
+		if (factors.empty()) {
+			return nm.make_constant(1);
+		}
+		return factors.size() == 1 ? factors.front() : nm.make_mul(factors);
+	}
+
+	const detail::node* rebuild(const factored_term& term) {
+		std::vector<const detail::node*> factors = term.others;
+		for (auto [base, e] : term.powers) {
+			if (e == 1) {
+				factors.push_back(base);
+			}
+			else if (e > 1) {
+				factors.push_back(nm.make_pow(base, nm.make_constant(static_cast<double>(e))));
+			}
+		}
+		const detail::node* result = product_of(factors);
+		return term.negated ? nm.make_negation(result) : result;
+	}
+
+	const detail::node* optimize_product(const std::vector<const detail::node*>& ops) {
+		std::vector<const detail::node*> others;
+		std::vector<const detail::node*> exp_ops, exp_args;
+		std::vector<const detail::node*> reciprocal_ops, denominators;
+
+		for (auto* op : ops) {
+			if (auto* f = std::get_if<detail::function_call>(&op->p_data); f && f->f_id == funcs::exp && f->args.size() == 1) {
+				exp_ops.push_back(op);
+				exp_args.push_back(f->args[0]);
+				continue;
+			}
+
+			if (auto* p = std::get_if<detail::power>(&op->p_data)) {
+				double e;
+				if (detail::numeric_constant(p->exponent, e) && utils::is_integer(e) && e < 0) {
+					reciprocal_ops.push_back(op);
+					denominators.push_back(e == -1 ? p->base : nm.make_pow(p->base, nm.make_constant(-e)));
+					continue;
+				}
+			}
+			others.push_back(op);
+		}
+
+		// Each rewrite replaces a group of factors, and is only kept if the whole product gets cheaper
+		auto cheaper = [&](const std::vector<const detail::node*>& group, const detail::node* rewritten, const std::vector<const detail::node*>& rest) {
+			std::vector<const detail::node*> before = others, after = others;
+			before.append_range(group);
+			before.append_range(rest);
+			after.push_back(rewritten);
+			after.append_range(rest);
+			return estimate_cost(product_of(after)) < estimate_cost(product_of(before));
+		};
+
+		// exp(a) * exp(b) = exp(a + b)
+		const detail::node* fused = nullptr;
+		if (exp_args.size() >= 2) {
+			fused = nm.make_func(funcs::exp, {optimize(nm.make_add(exp_args))});
+		}
+		if (fused && cheaper(exp_ops, fused, reciprocal_ops)) {
+			others.push_back(fused);
+		}
+		else {
+			others.append_range(exp_ops);
+		}
+
+		// a^(-1) * b^(-1) = (ab)^(-1) : one division instead of two
+		const detail::node* grouped = nullptr;
+		if (denominators.size() >= 2) {
+			grouped = nm.make_pow(optimize(nm.make_mul(denominators)), nm.make_constant(-1));
+		}
+		if (grouped && cheaper(reciprocal_ops, grouped, {})) {
+			others.push_back(grouped);
+		}
+		else {
+			others.append_range(reciprocal_ops);
+		}
+
+		return product_of(others);
+	}
+
+	// Factors the multiplicand shared by the most terms out of the sum, if any
+	std::optional<std::vector<const detail::node*>> factor_once(const std::vector<const detail::node*>& ops) {
+		std::vector<factored_term> terms(ops.size());
+		std::vector<std::pair<const detail::node*, size_t>> counts;
+		for (size_t i = 0; i < ops.size(); ++i) {
+			collect_factors(ops[i], terms[i]);
+			for (auto [base, e] : terms[i].powers) {
+				if (e <= 0) continue;
+				auto it = std::ranges::find_if(counts, [&](const auto& c) { return c.first == base; });
+				if (it != counts.end()) {
+					it->second++;
+				}
+				else {
+					counts.emplace_back(base, 1);
+				}
+			}
+		}
+
+		auto best = std::ranges::max_element(counts, {}, [](const auto& c) { return c.second; });
+		if (best == counts.end() || best->second < 2) {
+			return std::nullopt;
+		}
+		const detail::node* base = best->first;
+
+		long long m = std::numeric_limits<long long>::max();
+		for (auto& t : terms) {
+			if (long long e = t.exponent_of(base); e > 0) {
+				m = std::min(m, e);
+			}
+		}
+
+		std::vector<const detail::node*> rest, inner;
+		for (size_t i = 0; i < ops.size(); ++i) {
+			if (terms[i].exponent_of(base) <= 0) {
+				rest.push_back(ops[i]);
+				continue;
+			}
+			terms[i].add_power(base, -m);
+			inner.push_back(rebuild(terms[i]));
+		}
+
+		const detail::node* factor = m == 1 ? base : nm.make_pow(base, nm.make_constant(static_cast<double>(m)));
+		rest.push_back(product_of({factor, optimize_sum(std::move(inner))}));
+		return rest;
+	}
+
+	// Repeatedly factors the sum while it lowers the cost ; on polynomials, this gives the Horner form
+	const detail::node* optimize_sum(std::vector<const detail::node*> ops) {
+		const detail::node* current = sum_of(ops);
+		double current_cost = estimate_cost(current);
+
+		while (ops.size() > 1) {
+			auto factored = factor_once(ops);
+			if (!factored) {
+				break;
+			}
+
+			const detail::node* candidate = sum_of(*factored);
+			double candidate_cost = estimate_cost(candidate);
+			if (candidate_cost >= current_cost) {
+				break;
+			}
+			ops = std::move(*factored);
+			current = candidate;
+			current_cost = candidate_cost;
+		}
+		return current;
+	}
+};
+
+expression sym::optimize_for_eval(const expression& expr) {
+	if (!current_context) {
+		throw std::runtime_error("sym::optimize_for_eval: current context is null");
+	}
+	eval_optimizer optimizer(current_context->node_manager());
+	return optimizer.optimize(expr.root);
+}
@@ -0,0 +1,780 @@
+#include "symaths/parsing/compiler.hpp"
+
+#include "symaths/symaths.hpp"
+#include "symaths/detail/nodes.hpp"
+#include "symaths/utils/maths.hpp"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cmath>
+#include <format>
+#include <limits>
+#include <numbers>
+#include <optional>
+#include <stdexcept>
+#include <unordered_map>
+
+using namespace sym;
+
+constexpr double quiet_nan = std::numeric_limits<double>::quiet_NaN();
+
+struct compiler_state : detail::program_builder {
+	const std::vector<symbol>& variables;
+	detail::domain_cache_t domains;
+	// Shared subexpressions, with their temporary once it holds their value
+	std::unordered_map<const detail::node*, std::optional<size_t>> shared;
+	size_t temporaries = 0;
+
+	compiler_state(std::vector<detail::instruction>& program, const std::vector<symbol>& variables) : program_builder{program}, variables(variables) {}
+
+	bool proven(const detail::node* node, bool (domain::*predicate)() const) {
+		return (detail::infer_domain(node, domains).*predicate)();
+	}
+};
+
+void detail::program_builder::emit_slot(opcode op, size_t slot, int stack_effect) {
+	instruction ins{};
+	ins.op = op;
+	ins.var_id = slot;
+	program.push_back(ins);
+	move_stack(stack_effect);
+}
+
+void detail::program_builder::emit(opcode op, int stack_effect) {
+	instruction ins{};
+	ins.op = op;
+	program.push_back(ins);
+	move_stack(stack_effect);
+}
+
+void detail::program_builder::emit_constant(double val) {
+	instruction ins{};
+	ins.op = push_cst;
+	ins.val = val;
+	program.push_back(ins);
+	move_stack(1);
+}
+
+void detail::program_builder::emit_variable(size_t id) {
+	instruction ins{};
+	ins.op = push_var;
+	ins.var_id = id;
+	program.push_back(ins);
+	move_stack(1);
+}
+
+void detail::program_builder::emit_powi(long long exponent) {
+	instruction ins{};
+	ins.op = powi;
+	ins.exponent = exponent;
+	program.push_back(ins);
+}
+
+void detail::program_builder::emit_call(const builtin_func_descriptor* func, size_t argc) {
+	instruction ins{};
+	ins.op = call_fun;
+	ins.argc = static_cast<uint8_t>(argc);
+	ins.func = func;
+	program.push_back(ins);
+	move_stack(1 - static_cast<int>(argc));
+}
+
+void detail::program_builder::move_stack(int stack_effect) {
+	depth += stack_effect;
+	max_depth = std::max(max_depth, depth);
+}
+
+bool detail::numeric_constant(const node* node, double& value) {
+	if (std::holds_alternative<constant>(node->p_data)) {
+		const number& n = std::get<constant>(node->p_data).value;
+		if (std::holds_alternative<numbers::complex>(n.p_data) || std::holds_alternative<numbers::nan>(n.p_data)) {
+			return false;
+		}
+		value = n.get<double>();
+		return true;
+	}
+	if (std::holds_alternative<negation>(node->p_data) && numeric_constant(std::get<negation>(node->p_data).child, value)) {
+		value = -value;
+		return true;
+	}
+	return false;
+}
+
+// Returns the constant integer exponent of a power node, 0 otherwise
+long long integer_exponent(const detail::node* node) {
+	if (!std::holds_alternative<detail::power>(node->p_data)) {
+		return 0;
+	}
+	double e;
+	if (detail::numeric_constant(std::get<detail::power>(node->p_data).exponent, e) && utils::is_integer(e) && std::abs(e) <= detail::max_powi_exponent) {
+		return static_cast<long long>(std::round(e));
+	}
+	return 0;
+}
+
+// Returns the base of a b^(-n) node (n is a positive integer), nullptr otherwise
+const detail::node* reciprocal_base(const detail::node* node, long long& n) {
+	n = -integer_exponent(node);
+	if (n > 0) {
+		return std::get<detail::power>(node->p_data).base;
+	}
+	return nullptr;
+}
+
+void compile_node(const detail::node* node, compiler_state& state);
+
+// Emits base^n, then divides the top of the stack by it
+void compile_division(const detail::node* base, long long n, compiler_state& state) {
+	compile_node(base, state);
+	if (n > 1) {
+		state.emit_powi(n);
+	}
+	state.emit(state.proven(base, &domain::excludes_zero) ? detail::div_fast : detail::div, -1);
+}
+
+void compile_operation(const detail::node* node, compiler_state& state);
+
+void compile_node(const detail::node* node, compiler_state& state) {
+	auto it = state.shared.find(node);
+	if (it == state.shared.end()) {
+		compile_operation(node, state);
+	}
+	else if (it->second) {
+		state.emit_slot(detail::load, *it->second, 1);
+	}
+	else {
+		compile_operation(node, state);
+		// The iterator may have been invalidated by the compilation of the operands
+		state.shared[node] = state.temporaries;
+		state.emit_slot(detail::store, state.temporaries++, 0);
+	}
+}
+
+void compile_operation(const detail::node* node, compiler_state& state) {
+	double cst;
+	if (detail::numeric_constant(node, cst)) {
+		state.emit_constant(cst);
+		return;
+	}
+
+	std::visit([&](const auto& x) {
+		using T = std::decay_t<decltype(x)>;
+
+		if constexpr (std::is_same_v<T, detail::constant>) {
+			throw std::invalid_argument(std::format("compiled_expression: cannot compile the constant {}", x.value.string()));
+		}
+
+		else if constexpr (std::is_same_v<T, detail::symbol>) {
+			auto it = std::ranges::find_if(state.variables, [&](const symbol& s) { return s.ref == node; });
+			if (it == state.variables.end()) {
+				throw std::invalid_argument(std::format("compiled_expression: unknown variable \"{}\"", x.name));
+			}
+			state.emit_variable(it - state.variables.begin());
+		}
+
+		else if constexpr (std::is_same_v<T, detail::negation>) {
+			compile_node(x.child, state);
+			state.emit(detail::neg, 0);
+		}
+
+		else if constexpr (std::is_same_v<T, detail::addition>) {
+			compile_node(x.operands[0], state);
+			for (size_t i = 1; i < x.operands.size(); ++i) {
+				auto* op = x.operands[i];
+				if (std::holds_alternative<detail::negation>(op->p_data)) {
+					compile_node(std::get<detail::negation>(op->p_data).child, state);
+					state.emit(detail::sub, -1);
+				}
+				else {
+					compile_node(op, state);
+					state.emit(detail::add, -1);
+				}
+			}
+		}
+
+		else if constexpr (std::is_same_v<T, detail::multiplication>) {
+			// a * b^(-1) * c^(-2) is compiled as (a / b) / c^2
+			std::vector<const detail::node*> numerators;
+			std::vector<std::pair<const detail::node*, long long>> denominators;
+			for (auto* op : x.operands) {
+				long long n;
+				if (auto* base = reciprocal_base(op, n)) {
+					denominators.emplace_back(base, n);
+				}
+				else {
+					numerators.push_back(op);
+				}
+			}
+
+			if (numerators.empty()) {
+				state.emit_constant(1);
+			}
+			for (size_t i = 0; i < numerators.size(); ++i) {
+				compile_node(numerators[i], state);
+				if (i != 0) {
+					state.emit(detail::mul, -1);
+				}
+			}
+			for (auto [base, n] : denominators) {
+				compile_division(base, n, state);
+			}
+		}
+
+		else if constexpr (std::is_same_v<T, detail::power>) {
+			long long n;
+			if (auto* base = reciprocal_base(node, n)) {
+				state.emit_constant(1);
+				compile_division(base, n, state);
+				return;
+			}
+			if (n = integer_exponent(node); n > 1) {
+				compile_node(x.base, state);
+				state.emit_powi(n);
+				return;
+			}
+			compile_node(x.base, state);
+			compile_node(x.exponent, state);
+			state.emit(detail::pow, -1);
+		}
+
+		else if constexpr (std::is_same_v<T, detail::function_call>) {
+			const auto& func = detail::get_func(x.f_id);
+			if (x.args.size() > 8) {
+				throw std::invalid_argument("compiled_expression: functions are limited to 8 arguments");
+			}
+			if (!func.eval && x.args.size() != func.arity) {
+				throw std::invalid_argument(std::format("compiled_expression: {} takes {} arguments", func.name, func.arity));
+			}
+			for (auto* arg : x.args) {
+				compile_node(arg, state);
+			}
+
+			if (x.args.size() == 1) {
+				switch (x.f_id) {
+					case funcs::ln:
+						state.emit(state.proven(x.args[0], &domain::is_positive) ? detail::ln_fast : detail::ln, 0);
+						return;
+					case funcs::log10:
+						state.emit(state.proven(x.args[0], &domain::is_positive) ? detail::log10_fast : detail::log10, 0);
+						return;
+					case funcs::sqrt:
+						state.emit(state.proven(x.args[0], &domain::is_non_negative) ? detail::sqrt_fast : detail::sqrt, 0);
+						return;
+					default:
+						break;
+				}
+			}
+			state.emit_call(&func, x.args.size());
+		}
+	}, node->p_data);
+}
+
+compiled_expression::compiled_expression(const expression& expr, const std::vector<symbol>& variables) : m_variables_count(variables.size()) {
+	compiler_state state{m_program, variables};
+	compile_node(expr.root, state);
+	m_stack_size = state.max_depth;
+}
+
+double powi_calc(double base, long long n) {
+	double result = 1;
+	while (n) {
+		if (n & 1) result *= base;
+		base *= base;
+		n >>= 1;
+	}
+	return result;
+}
+
+// Runs a program on one point. Temporaries and outputs are only used by the programs of compiled_vector_expression.
+// Returns the bottom of the stack.
+double run_program(const std::vector<detail::instruction>& program, const double* values, double* stack, double* temporaries, double* outputs) {
+	size_t top = 0;
+	for (const auto& ins : program) {
+		switch (ins.op) {
+			case detail::push_cst: stack[top++] = ins.val; break;
+			case detail::push_var: stack[top++] = values[ins.var_id]; break;
+			case detail::call_fun: {
+				top -= ins.argc;
+				stack[top] = ins.func->kernel(stack + top);
+				++top;
+				break;
+			}
+			case detail::neg: stack[top - 1] = -stack[top - 1]; break;
+			case detail::add: --top; stack[top - 1] += stack[top]; break;
+			case detail::sub: --top; stack[top - 1] -= stack[top]; break;
+			case detail::mul: --top; stack[top - 1] *= stack[top]; break;
+			case detail::div: --top; stack[top - 1] = stack[top] != 0 ? stack[top - 1] / stack[top] : quiet_nan; break;
+			case detail::div_fast: --top; stack[top - 1] /= stack[top]; break;
+			case detail::pow: --top; stack[top - 1] = std::pow(stack[top - 1], stack[top]); break;
+			case detail::powi: stack[top - 1] = powi_calc(stack[top - 1], ins.exponent); break;
+			case detail::ln: stack[top - 1] = stack[top - 1] > 0 ? std::log(stack[top - 1]) : quiet_nan; break;
+			case detail::ln_fast: stack[top - 1] = std::log(stack[top - 1]); break;
+			case detail::log10: stack[top - 1] = stack[top - 1] > 0 ? std::log10(stack[top - 1]) : quiet_nan; break;
+			case detail::log10_fast: stack[top - 1] = std::log10(stack[top - 1]); break;
+			case detail::sqrt: stack[top - 1] = stack[top - 1] >= 0 ? std::sqrt(stack[top - 1]) : quiet_nan; break;
+			case detail::sqrt_fast: stack[top - 1] = std::sqrt(stack[top - 1]); break;
+			case detail::store: temporaries[ins.var_id] = stack[top - 1]; break;
+			case detail::load: stack[top++] = temporaries[ins.var_id]; break;
+			case detail::pop_out: outputs[ins.var_id] = stack[--top]; break;
+		}
+	}
+	return stack[0];
+}
+
+// Runs a program on the points [start, start + n) of the columns. Each stack slot (and each temporary) holds a whole
+// block of values, so every instruction runs as a tight loop. registers has one extra slot, as scratch space for powi.
+void run_program_block(const std::vector<detail::instruction>& program, const double* const* columns, size_t start, size_t n, double* registers, double* temporaries, double* const* outputs) {
+	std::array<double, 8> args;
+	size_t top = 0;
+	auto slot = [&](size_t i) { return registers + i * compiled_expression::batch_size; };
+
+	for (const auto& ins : program) {
+		switch (ins.op) {
+			case detail::push_cst: {
+				std::fill_n(slot(top++), n, ins.val);
+				break;
+			}
+			case detail::push_var: {
+				std::copy_n(columns[ins.var_id] + start, n, slot(top++));
+				break;
+			}
+			case detail::call_fun: {
+				top -= ins.argc;
+				double* r = slot(top);
+				if (ins.func->batch_kernel) {
+					// The results go to the scratch slot above the arguments, then replace the first one
+					std::array<const double*, 8> arg_slots;
+					for (size_t k = 0; k < ins.argc; ++k) {
+						arg_slots[k] = slot(top + k);
+					}
+					ins.func->batch_kernel(arg_slots.data(), slot(top + ins.argc), n);
+					std::copy_n(slot(top + ins.argc), n, r);
+				}
+				else {
+					for (size_t i = 0; i < n; ++i) {
+						for (size_t k = 0; k < ins.argc; ++k) {
+							args[k] = slot(top + k)[i];
+						}
+						r[i] = ins.func->kernel(args.data());
+					}
+				}
+				++top;
+				break;
+			}
+			case detail::neg: {
+				double* a = slot(top - 1);
+				for (size_t i = 0; i < n; ++i) a[i] = -a[i];
+				break;
+			}
+			case detail::add: {
+				--top;
+				double* a = slot(top - 1);
+				const double* b = slot(top);
+				for (size_t i = 0; i < n; ++i) a[i] += b[i];
+				break;
+			}
+			case detail::sub: {
+				--top;
+				double* a = slot(top - 1);
+				const double* b = slot(top);
+				for (size_t i = 0; i < n; ++i) a[i] -= b[i];
+				break;
+			}
+			case detail::mul: {
+				--top;
+				double* a = slot(top - 1);
+				const double* b = slot(top);
+				for (size_t i = 0; i < n; ++i) a[i] *= b[i];
+				break;
+			}
+			case detail::div: {
+				--top;
+				double* a = slot(top - 1);
+				const double* b = slot(top);
+				for (size_t i = 0; i < n; ++i) a[i] = b[i] != 0 ? a[i] / b[i] : quiet_nan;
+				break;
+			}
+			case detail::div_fast: {
+				--top;
+				double* a = slot(top - 1);
+				const double* b = slot(top);
+				for (size_t i = 0; i < n; ++i) a[i] /= b[i];
+				break;
+			}
+			case detail::pow: {
+				--top;
+				double* a = slot(top - 1);
+				const double* b = slot(top);
+				for (size_t i = 0; i < n; ++i) a[i] = std::pow(a[i], b[i]);
+				break;
+			}
+			case detail::powi: {
+				// Squares of the base are built in place while the result accumulates in the scratch slot
+				double* a = slot(top - 1);
+				double* r = slot(top);
+				std::fill_n(r, n, 1.0);
+				for (long long e = ins.exponent; e; e >>= 1) {
+					if (e & 1) {
+						for (size_t i = 0; i < n; ++i) r[i] *= a[i];
+					}
+					if (e > 1) {
+						for (size_t i = 0; i < n; ++i) a[i] *= a[i];
+					}
+				}
+				std::copy_n(r, n, a);
+				break;
+			}
+			case detail::ln: {
+				double* a = slot(top - 1);
+				for (size_t i = 0; i < n; ++i) a[i] = a[i] > 0 ? std::log(a[i]) : quiet_nan;
+				break;
+			}
+			case detail::ln_fast: {
+				double* a = slot(top - 1);
+				for (size_t i = 0; i < n; ++i) a[i] = std::log(a[i]);
+				break;
+			}
+			case detail::log10: {
+				double* a = slot(top - 1);
+				for (size_t i = 0; i < n; ++i) a[i] = a[i] > 0 ? std::log10(a[i]) : quiet_nan;
+				break;
+			}
+			case detail::log10_fast: {
+				double* a = slot(top - 1);
+				for (size_t i = 0; i < n; ++i) a[i] = std::log10(a[i]);
+				break;
+			}
+			case detail::sqrt: {
+				double* a = slot(top - 1);
+				for (size_t i = 0; i < n; ++i) a[i] = a[i] >= 0 ? std::sqrt(a[i]) : quiet_nan;
+				break;
+			}
+			case detail::sqrt_fast: {
+				double* a = slot(top - 1);
+				for (size_t i = 0; i < n; ++i) a[i] = std::sqrt(a[i]);
+				break;
+			}
+			case detail::store: {
+				std::copy_n(slot(top - 1), n, temporaries + ins.var_id * compiled_expression::batch_size);
+				break;
+			}
+			case detail::load: {
+				std::copy_n(temporaries + ins.var_id * compiled_expression::batch_size, n, slot(top++));
+				break;
+			}
+			case detail::pop_out: {
+				std::copy_n(slot(--top), n, outputs[ins.var_id] + start);
+				break;
+			}
+		}
+	}
+}
+
+double compiled_expression::operator()(const double* values) const {
+	std::array<double, 64> small_stack;
+	std::vector<double> large_stack;
+	double* stack = small_stack.data();
+	if (m_stack_size > small_stack.size()) {
+		large_stack.resize(m_stack_size);
+		stack = large_stack.data();
+	}
+	return run_program(m_program, values, stack, nullptr, nullptr);
+}
+
+double compiled_expression::operator()(const std::vector<double>& values) const {
+	if (values.size() < m_variables_count) {
+		throw std::invalid_argument("compiled_expression: not enough values");
+	}
+	return (*this)(values.data());
+}
+
+void compiled_expression::eval_batch(const double* const* columns, double* out, size_t count) const {
+	std::vector<double> registers((m_stack_size + 1) * batch_size);
+	for (size_t start = 0; start < count; start += batch_size) {
+		size_t n = std::min(batch_size, count - start);
+		run_program_block(m_program, columns, start, n, registers.data(), nullptr, nullptr);
+		std::copy_n(registers.data(), n, out + start);
+	}
+}
+
+// Counts the parents of every node reachable from the roots, each node being visited once
+void count_parents(const detail::node* node, std::unordered_map<const detail::node*, size_t>& parents) {
+	if (parents[node]++ > 0) {
+		return;
+	}
+	std::visit([&](const auto& x) {
+		using T = std::decay_t<decltype(x)>;
+
+		if constexpr (std::is_same_v<T, detail::negation>) {
+			count_parents(x.child, parents);
+		}
+		else if constexpr (std::is_same_v<T, detail::addition> || std::is_same_v<T, detail::multiplication>) {
+			for (auto* op : x.operands) {
+				count_parents(op, parents);
+			}
+		}
+		else if constexpr (std::is_same_v<T, detail::power>) {
+			count_parents(x.base, parents);
+			count_parents(x.exponent, parents);
+		}
+		else if constexpr (std::is_same_v<T, detail::function_call>) {
+			for (auto* arg : x.args) {
+				count_parents(arg, parents);
+			}
+		}
+	}, node->p_data);
+}
+
+compiled_vector_expression::compiled_vector_expression(const std::vector<expression>& exprs, const std::vector<symbol>& variables) : m_outputs(exprs.size()) {
+	compiler_state state{m_program, variables};
+
+	// Constants and symbols are as cheap to push as temporaries are to load
+	std::unordered_map<const detail::node*, size_t> parents;
+	for (const auto& e : exprs) {
+		count_parents(e.root, parents);
+	}
+	for (auto [node, count] : parents) {
+		double cst;
+		if (count > 1 && !std::holds_alternative<detail::symbol>(node->p_data) && !detail::numeric_constant(node, cst)) {
+			state.shared.emplace(node, std::nullopt);
+		}
+	}
+
+	for (size_t i = 0; i < exprs.size(); ++i) {
+		compile_node(exprs[i].root, state);
+		state.emit_slot(detail::pop_out, i, -1);
+	}
+	m_stack_size = state.max_depth;
+	m_temporaries = state.temporaries;
+}
+
+// Widens the result of a function of the C library, which may be off by one ulp
+detail::bounds widened(double lower, double upper) {
+	return {detail::round_down(detail::round_down(lower)), detail::round_up(detail::round_up(upper))};
+}
+
+// Whether offset + k period is in the interval for some integer k. Values close to it count, so that rounding errors
+// only widen the results.
+bool contains_periodic(const detail::bounds& a, double offset, double period) {
+	double k = std::ceil((a.lower - offset) / period - 1e-9);
+	return offset + k * period <= a.upper + 1e-9 * period;
+}
+
+// [a^n] for a natural n, by repeated squaring of intervals whose bounds are non-negative
+detail::bounds non_negative_powi(detail::bounds a, long long n) {
+	detail::bounds result = detail::bounds::point(1);
+	for (; n; n >>= 1) {
+		if (n & 1) result = result * a;
+		if (n > 1) a = a * a;
+	}
+	return result;
+}
+
+detail::bounds powi_bounds(const detail::bounds& a, long long n) {
+	if (a.is_empty()) return detail::bounds::empty();
+	double mig = a.contains(0) ? 0 : std::min(std::abs(a.lower), std::abs(a.upper));
+	double mag = std::max(std::abs(a.lower), std::abs(a.upper));
+	if (n % 2 == 0) {
+		return non_negative_powi({mig, mag}, n);
+	}
+	// Odd powers are increasing, and odd
+	auto power = [&](double x) {
+		detail::bounds p = non_negative_powi(detail::bounds::point(std::abs(x)), n);
+		return x < 0 ? -p : p;
+	};
+	return {power(a.lower).lower, power(a.upper).upper};
+}
+
+detail::bounds builtin_bounds(funcs::builtin_fn_id id, const detail::bounds& a) {
+	using detail::bounds;
+	constexpr double pi = std::numbers::pi;
+	if (a.is_empty()) return bounds::empty();
+
+	switch (id) {
+		case funcs::sin:
+		case funcs::cos: {
+			if (a.width() >= 2 * pi) return {-1, 1};
+			// Maxima and minima of sin are at pi/2 and -pi/2, those of cos at 0 and pi
+			double shift = id == funcs::sin ? pi / 2 : 0;
+			double (*f)(double) = id == funcs::sin ? static_cast<double (*)(double)>(std::sin) : static_cast<double (*)(double)>(std::cos);
+			double fl = f(a.lower), fu = f(a.upper);
+			bounds r = widened(std::min(fl, fu), std::max(fl, fu));
+			if (contains_periodic(a, shift, 2 * pi)) r.upper = 1;
+			if (contains_periodic(a, shift - pi, 2 * pi)) r.lower = -1;
+			return intersection(r, {-1, 1});
+		}
+		case funcs::tan:
+			if (!std::isfinite(a.width()) || contains_periodic(a, pi / 2, pi)) return bounds::entire();
+			return widened(std::tan(a.lower), std::tan(a.upper));
+		case funcs::acos: {
+			bounds d = intersection(a, {-1, 1});
+			if (d.is_empty()) return bounds::empty();
+			return widened(std::acos(d.upper), std::acos(d.lower));
+		}
+		case funcs::asin: {
+			bounds d = intersection(a, {-1, 1});
+			if (d.is_empty()) return bounds::empty();
+			return widened(std::asin(d.lower), std::asin(d.upper));
+		}
+		case funcs::atan: return widened(std::atan(a.lower), std::atan(a.upper));
+		case funcs::exp: {
+			bounds r = widened(std::exp(a.lower), std::exp(a.upper));
+			r.lower = std::max(r.lower, 0.0);
+			return r;
+		}
+		case funcs::ln:
+		case funcs::log10: {
+			if (a.upper <= 0) return bounds::empty();
+			double (*f)(double) = id == funcs::ln ? static_cast<double (*)(double)>(std::log) : static_cast<double (*)(double)>(std::log10);
+			bounds r = widened(f(std::max(a.lower, 0.0)), f(a.upper));
+			return r;
+		}
+		case funcs::cosh: {
+			double mig = a.contains(0) ? 0 : std::min(std::abs(a.lower), std::abs(a.upper));
+			bounds r = widened(std::cosh(mig), std::cosh(std::max(std::abs(a.lower), std::abs(a.upper))));
+			r.lower = std::max(r.lower, 1.0);
+			return r;
+		}
+		case funcs::sinh: return widened(std::sinh(a.lower), std::sinh(a.upper));
+		case funcs::tanh: return intersection(widened(std::tanh(a.lower), std::tanh(a.upper)), {-1, 1});
+		case funcs::sqrt: {
+			if (a.upper < 0) return bounds::empty();
+			bounds r = widened(std::sqrt(std::max(a.lower, 0.0)), std::sqrt(a.upper));
+			r.lower = std::max(r.lower, 0.0);
+			return r;
+		}
+		case funcs::abs: {
+			double mig = a.contains(0) ? 0 : std::min(std::abs(a.lower), std::abs(a.upper));
+			return {mig, std::max(std::abs(a.lower), std::abs(a.upper))};
+		}
+		default:
+			return bounds::entire();
+	}
+}
+
+detail::bounds pow_bounds(const detail::bounds& a, const detail::bounds& b) {
+	if (a.is_empty() || b.is_empty()) return detail::bounds::empty();
+	if (a.upper < 0 || (a.upper == 0 && b.upper <= 0)) return detail::bounds::empty();
+	// Negative bases have a power for some integer exponents only : nothing is known then
+	if (a.lower < 0) return detail::bounds::entire();
+	return builtin_bounds(funcs::exp, b * builtin_bounds(funcs::ln, a));
+}
+
+// Interval version of run_program
+void run_program_bounds(const std::vector<detail::instruction>& program, const detail::bounds* values, detail::bounds* stack, detail::bounds* temporaries, detail::bounds* outputs) {
+	size_t top = 0;
+	for (const auto& ins : program) {
+		switch (ins.op) {
+			case detail::push_cst: stack[top++] = detail::bounds::point(ins.val); break;
+			case detail::push_var: stack[top++] = values[ins.var_id]; break;
+			case detail::call_fun: {
+				top -= ins.argc;
+				// Nothing is known about registered functions
+				bool builtin = ins.argc == 1 && ins.func->id < funcs::LEN;
+				stack[top] = builtin ? builtin_bounds(funcs::builtin_fn_id{ins.func->id}, stack[top]) : detail::bounds::entire();
+				++top;
+				break;
+			}
+			case detail::neg: stack[top - 1] = -stack[top - 1]; break;
+			case detail::add: --top; stack[top - 1] = stack[top - 1] + stack[top]; break;
+			case detail::sub: --top; stack[top - 1] = stack[top - 1] - stack[top]; break;
+			case detail::mul: --top; stack[top - 1] = stack[top - 1] * stack[top]; break;
+			case detail::div:
+			case detail::div_fast: --top; stack[top - 1] = stack[top - 1] / stack[top]; break;
+			case detail::pow: --top; stack[top - 1] = pow_bounds(stack[top - 1], stack[top]); break;
+			case detail::powi: stack[top - 1] = powi_bounds(stack[top - 1], ins.exponent); break;
+			case detail::ln:
+			case detail::ln_fast: stack[top - 1] = builtin_bounds(funcs::ln, stack[top - 1]); break;
+			case detail::log10:
+			case detail::log10_fast: stack[top - 1] = builtin_bounds(funcs::log10, stack[top - 1]); break;
+			case detail::sqrt:
+			case detail::sqrt_fast: stack[top - 1] = builtin_bounds(funcs::sqrt, stack[top - 1]); break;
+			case detail::store: temporaries[ins.var_id] = stack[top - 1]; break;
+			case detail::load: stack[top++] = temporaries[ins.var_id]; break;
+			case detail::pop_out: outputs[ins.var_id] = stack[--top]; break;
+		}
+	}
+}
+
+void compiled_vector_expression::operator()(const double* values, double* out, std::vector<double>& workspace) const {
+	workspace.resize(m_stack_size + m_temporaries);
+	run_program(m_program, values, workspace.data(), workspace.data() + m_stack_size, out);
+}
+
+void compiled_vector_expression::operator()(const double* values, double* out) const {
+	std::vector<double> workspace;
+	(*this)(values, out, workspace);
+}
+
+void compiled_vector_expression::eval_bounds(const detail::bounds* values, detail::bounds* out, std::vector<detail::bounds>& workspace) const {
+	workspace.resize(m_stack_size + m_temporaries);
+	run_program_bounds(m_program, values, workspace.data(), workspace.data() + m_stack_size, out);
+}
+
+void compiled_vector_expression::eval_batch(const double* const* columns, double* const* out, size_t count) const {
+	constexpr size_t block = compiled_expression::batch_size;
+	std::vector<double> registers((m_stack_size + 1 + m_temporaries) * block);
+	for (size_t start = 0; start < count; start += block) {
+		size_t n = std::min(block, count - start);
+		run_program_block(m_program, columns, start, n, registers.data(), registers.data() + (m_stack_size + 1) * block, out);
+	}
+}
+
+size_t compiled_expression::guards() const {
+	return std::ranges::count_if(m_program, [](const detail::instruction& ins) {
+		return ins.op == detail::div || ins.op == detail::ln || ins.op == detail::log10 || ins.op == detail::sqrt;
+	});
+}
+
+double compiled_expression::cost() const {
+	double total = 0;
+	for (const auto& ins : m_program) {
+		total += detail::instruction_cost(ins);
+	}
+	return total;
+}
+
+double detail::function_cost(funcs::builtin_fn_id id) {
+	switch (id) {
+		case funcs::abs: return 1;
+		case funcs::sqrt: return 6;
+		case funcs::exp: return 20;
+		case funcs::ln: return 20;
+		case funcs::log10: return 22;
+		case funcs::cos:
+		case funcs::sin:
+		case funcs::tanh: return 25;
+		default: return 30;
+	}
+}
+
+double detail::instruction_cost(const instruction& ins) {
+	switch (ins.op) {
+		case push_cst:
+		case push_var: return 0.5;
+		case call_fun: return ins.func->id < funcs::LEN ? function_cost(funcs::builtin_fn_id{ins.func->id}) : 30;
+		case neg:
+		case add:
+		case sub:
+		case mul: return 1;
+		case div: return 5;
+		case div_fast: return 4;
+		case pow: return 40;
+		case powi: {
+			// One multiplication per bit, plus one per set bit except the first
+			auto e = static_cast<unsigned long long>(ins.exponent);
+			return static_cast<double>(std::bit_width(e) - 1 + std::popcount(e) - 1);
+		}
+		case ln: return function_cost(funcs::ln) + 1;
+		case ln_fast: return function_cost(funcs::ln);
+		case log10: return function_cost(funcs::log10) + 1;
+		case log10_fast: return function_cost(funcs::log10);
+		case sqrt: return function_cost(funcs::sqrt) + 1;
+		case sqrt_fast: return function_cost(funcs::sqrt);
+		case store:
+		case load:
+		case pop_out: return 0.5;
+	}
+	return 0;
+}
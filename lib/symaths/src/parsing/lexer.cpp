@@ -1,129 +1,106 @@
 #include "symaths/parsing/lexer.hpp"
 
-#include <cctype>
-#include <map>
-#include <optional>
+#include <array>
+#include <charconv>
+#include <limits>
+#include <stdexcept>
+#include <system_error>
 
 using namespace sym;
 
-std::map<char, lexer::token_type> op_types = {
-	{'+', lexer::token_type::op_addition},
-	{'-', lexer::token_type::op_subtraction},
-	{'*', lexer::token_type::op_multiplication},
-	{'/', lexer::token_type::op_division},
-	{'^', lexer::token_type::op_power},
-	{'%', lexer::token_type::op_modulo},
+enum char_class : uint8_t {
+	cc_other,
+	cc_space,
+	cc_letter,
+	cc_digit,
+	// Characters which are a token by themselves
+	cc_single,
 };
 
-bool isoperation(char c) {
-	static const std::string operations = "+-*/^%";
-	return operations.contains(c);
-}
+// Classes of the ASCII characters : others are errors
+constexpr std::array<char_class, 256> char_classes = [] {
+	std::array<char_class, 256> classes{};
+	for (unsigned char c : std::string_view(" \t\n\v\f\r")) classes[c] = cc_space;
+	for (int c = 'a'; c <= 'z'; ++c) classes[c] = cc_letter;
+	for (int c = 'A'; c <= 'Z'; ++c) classes[c] = cc_letter;
+	for (int c = '0'; c <= '9'; ++c) classes[c] = cc_digit;
+	for (unsigned char c : std::string_view("+-*/^%(),")) classes[c] = cc_single;
+	return classes;
+}();
+
+constexpr std::array<lexer::token_type, 256> single_char_tokens = [] {
+	std::array<lexer::token_type, 256> types{};
+	types.fill(lexer::error);
+	types['+'] = lexer::op_addition;
+	types['-'] = lexer::op_subtraction;
+	types['*'] = lexer::op_multiplication;
+	types['/'] = lexer::op_division;
+	types['^'] = lexer::op_power;
+	types['%'] = lexer::op_modulo;
+	types['('] = lexer::open_parenthesis;
+	types[')'] = lexer::close_parenthesis;
+	types[','] = lexer::comma;
+	return types;
+}();
 
 bool isoperation(lexer::token_type type) {
-	return type == lexer::token_type::op_addition || type == lexer::token_type::op_subtraction
-	|| type == lexer::token_type::op_multiplication || type == lexer::token_type::op_division
-	|| type == lexer::token_type::op_power || type == lexer::token_type::op_modulo;
+	return type >= lexer::op_addition && type <= lexer::op_modulo;
 }
 
-lexer::token next_token(char*& pc) {
-	std::optional<lexer::token> current_token;
+char_class classify(std::string_view input, size_t i) {
+	return i < input.size() ? char_classes[static_cast<unsigned char>(input[i])] : cc_other;
+}
 
-	char& c = *pc;
-	while (c != '\0') {
-		if (isalpha(c)) {
-			if (!current_token) {
-				// New number
-				current_token = {lexer::identifier, std::string(1, c)};
-			}
-			else if (current_token.value().type != lexer::identifier) {
-				return current_token.value();
-			}
-			else {
-				current_token.value().value += c;
-			}
+void lexer::tokenize(std::string_view input) {
+	if (input.size() >= std::numeric_limits<uint32_t>::max()) {
+		throw std::length_error("The input of the lexer is too long.");
+	}
+	m_input = input;
+	m_tokens.clear();
+	auto push = [&](token_type type, size_t start, size_t end, double value = 0) {
+		m_tokens.push_back({type, static_cast<uint32_t>(start), static_cast<uint32_t>(end - start), value});
+	};
+
+	size_t i = 0;
+	while (i < input.size()) {
+		size_t start = i;
+		char_class c = classify(input, i);
+		if (c == cc_space) {
+			++i;
 		}
-
-		else if (isdigit(c)) {
-			if (!current_token) {
-				// New number
-				current_token = {lexer::number, std::string(1, c)};
-			}
-			else if (auto t = current_token.value().type; !(t == lexer::number || t == lexer::identifier)) {
-				return current_token.value_or(lexer::token{lexer::NONE, ""});
-			}
-			else {
-				current_token.value().value += c;
+		else if (c == cc_letter) {
+			// Letters, then letters or digits
+			while (classify(input, i) == cc_letter || classify(input, i) == cc_digit) {
+				++i;
 			}
+			push(identifier, start, i);
 		}
-
-		else if (isspace(c)) {
-			if (current_token) {
-				pc++;
-				return current_token.value();
+		// Digits, with an optional decimal part : numbers may also start with their decimal point
+		else if (c == cc_digit || (input[i] == '.' && classify(input, i + 1) == cc_digit)) {
+			while (classify(input, i) == cc_digit) {
+				++i;
 			}
-		}
-
-		else if (isoperation(c)) {
-			if (!current_token) {
-				current_token = {op_types[c], std::string(1, c)};
+			if (i < input.size() && input[i] == '.' && classify(input, i + 1) == cc_digit) {
+				++i;
+				while (classify(input, i) == cc_digit) {
+					++i;
+				}
 			}
-			else if (isoperation(current_token.value().type)) {
-				return current_token.value_or(lexer::token{lexer::NONE, ""});
+			// Literals out of the range of doubles are errors, rather than numbers of value 0
+			double value = 0;
+			if (std::from_chars(input.data() + start, input.data() + i, value).ec != std::errc{}) {
+				push(error, start, i);
 			}
 			else {
-				return current_token.value();
+				push(number, start, i, value);
 			}
 		}
-
-		else if (c == '(') {
-			if (!current_token) {
-				pc++;
-				return {lexer::open_parenthesis, "("};
-			}
-			return current_token.value();
-		}
-
-		else if (c == ')') {
-			if (!current_token) {
-				pc++;
-				return {lexer::close_parenthesis, ")"};
-			}
-			return current_token.value();
-		}
-
-		else if (c == ',') {
-			if (!current_token) {
-				pc++;
-				return {lexer::comma, ","};
-			}
-			return current_token.value();
-		}
-
 		else {
-			if (!current_token) {
-				pc++;
-				return {lexer::error, std::string(1, c)};
-			}
-			return current_token.value();
-		}
-
-		c = *++pc; // Get reference to next char
-	}
-
-	return current_token.value_or(lexer::token{lexer::NONE, ""});
-}
-
-void lexer::tokenize(std::string input) {
-	m_tokens.clear();
-	char* cursor = input.data();
-	while (*cursor != '\0') {
-		auto tok = next_token(cursor);
-		if (tok.type != NONE) {
-			m_tokens.push_back(tok);
+			++i;
+			push(c == cc_single ? single_char_tokens[static_cast<unsigned char>(input[start])] : error, start, i);
 		}
 	}
-	m_tokens.emplace_back(eof, "");
+	push(eof, input.size(), input.size());
 }
 
 const std::vector<lexer::token>& lexer::tokens() const {
@@ -1,10 +1,19 @@
 #include "symaths/parsing/parser.hpp"
 
 #include "symaths/symaths.hpp"
+#include "symaths/detail/mapped_file.hpp"
 #include "symaths/detail/nodes.hpp"
+#include "symaths/utils/maths.hpp"
 
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <cmath>
+#include <exception>
 #include <format>
 #include <map>
+#include <stdexcept>
+#include <thread>
 
 using namespace sym;
 
@@ -49,6 +58,128 @@ const lexer::token& parser::current_token() const {
 	return m_tokens[m_index];
 }
 
+node_manager_t& parser::node_manager() const {
+	return m_node_manager ? *m_node_manager : current_context->node_manager();
+}
+
+// Stands for the value left on the stack by the instructions emitted so far, when parsing into a program
+const detail::node emitted_value{};
+
+const detail::node* parser::make_constant(double value) {
+	if (!m_program) {
+		return node_manager().make_constant(value);
+	}
+	m_program->emit_constant(value);
+	return &emitted_value;
+}
+
+const detail::node* parser::make_variable(std::string_view name) {
+	if (!m_program) {
+		return node_manager().make_symbol(std::string(name));
+	}
+	auto it = std::ranges::find(*m_variables, name);
+	if (it == m_variables->end()) {
+		m_errors.emplace_back(unknown_identifier, std::format(R"(Unknown variable "{}".)", name));
+		return nullptr;
+	}
+	m_program->emit_variable(it - m_variables->begin());
+	return &emitted_value;
+}
+
+const detail::node* parser::make_negation(const detail::node* n) {
+	if (!m_program) {
+		return node_manager().make_negation(n);
+	}
+	// Negated constants stay constants, so that x^-1 has a constant exponent
+	if (auto& last = m_program->program.back(); last.op == detail::push_cst) {
+		last.val = -last.val;
+	}
+	else {
+		m_program->emit(detail::neg, 0);
+	}
+	return &emitted_value;
+}
+
+const detail::node* parser::make_operation(lexer::token_type op, const detail::node* left, const detail::node* right) {
+	if (!m_program) {
+		auto& nm = node_manager();
+		switch (op) {
+			case lexer::op_addition: return nm.make_add({left, right});
+			case lexer::op_subtraction: return nm.make_add({left, nm.make_negation(right)});
+			case lexer::op_multiplication: return nm.make_mul({left, right});
+			default: return nm.make_div(left, right);
+		}
+	}
+
+	switch (op) {
+		case lexer::op_addition: m_program->emit(detail::add, -1); break;
+		case lexer::op_subtraction: m_program->emit(detail::sub, -1); break;
+		case lexer::op_multiplication: m_program->emit(detail::mul, -1); break;
+		default: m_program->emit(detail::div, -1); break;
+	}
+	return &emitted_value;
+}
+
+const detail::node* parser::make_power(const detail::node* base, const detail::node* exponent, size_t base_start) {
+	if (!m_program) {
+		return node_manager().make_pow(base, exponent);
+	}
+
+	// Small constant integer exponents are raised by repeated squaring, like the compiler does
+	auto& program = m_program->program;
+	const detail::instruction& last = program.back();
+	long long n = 0;
+	if (last.op == detail::push_cst && utils::is_integer(last.val) && std::abs(last.val) <= detail::max_powi_exponent) {
+		n = static_cast<long long>(std::round(last.val));
+	}
+	if (n > 1) {
+		program.pop_back();
+		m_program->move_stack(-1);
+		m_program->emit_powi(n);
+	}
+	// base^(-n) is 1 / base^n with a guarded division, so that 0^(-n) is NaN as in compiled_expression
+	else if (n < 0) {
+		program.pop_back();
+		m_program->move_stack(-1);
+		detail::instruction one{};
+		one.op = detail::push_cst;
+		one.val = 1;
+		program.insert(program.begin() + static_cast<std::ptrdiff_t>(base_start), one);
+		// The 1 stays below the base while it is evaluated, which needs one more slot at most
+		++m_program->max_depth;
+		m_program->move_stack(1);
+		if (n < -1) {
+			m_program->emit_powi(-n);
+		}
+		m_program->emit(detail::div, -1);
+	}
+	else {
+		m_program->emit(detail::pow, -1);
+	}
+	return &emitted_value;
+}
+
+const detail::node* parser::make_call(uint32_t id, const std::vector<const detail::node*>& args) {
+	if (std::ranges::find(args, nullptr) != args.end()) {
+		return nullptr;
+	}
+	const auto& func = detail::get_func(id);
+	if (args.size() != func.arity) {
+		m_errors.emplace_back(unsupported, std::format("{} takes {} argument(s), but got {}.", func.name, func.arity, args.size()));
+		return nullptr;
+	}
+	if (!m_program) {
+		return node_manager().make_func(id, args);
+	}
+	if (id == funcs::ln || id == funcs::log10 || id == funcs::sqrt) {
+		m_program->emit(id == funcs::ln ? detail::ln : id == funcs::log10 ? detail::log10 : detail::sqrt, 0);
+	}
+	else {
+		m_program->emit_call(&func, args.size());
+	}
+	return &emitted_value;
+}
+
 const lexer::token& parser::advance() {
 	return m_tokens[m_index++];
 }
@@ -88,42 +219,46 @@ const detail::node* parser::parse(int precedence_limit) {
 }
 
 const detail::node* parser::parse_expression(int precedence_limit) {
+	// Whatever left stands for is evaluated by the instructions emitted from here
+	size_t left_start = m_program ? m_program->program.size() : 0;
 	const lexer::token& prefix = advance();
 	const detail::node* left = parse_prefix(prefix);
 	if (!left) {
 		return nullptr;
 	}
 
-	while (has_tokens() && get_precedence(current_token().type) > precedence_limit) {
+	while (left && has_tokens() && get_precedence(current_token().type) > precedence_limit) {
 		const lexer::token& infix = advance();
-		left = parse_infix(left, infix);
+		left = parse_infix(left, infix, left_start);
 	}
 	return left;
 }
 
 const detail::node* parser::parse_prefix(const lexer::token& prefix) {
-	auto& nm = current_context->node_manager();
 	switch (prefix.type) {
 		case lexer::number: {
-			return nm.make_constant(std::stod(prefix.value));
+			return make_constant(prefix.value);
 		}
 		case lexer::identifier: {
-			auto func_id = detail::get_func_id(prefix.value);
-			if (func_id != funcs::LEN) {
+			auto func_id = detail::get_func_id(text(prefix));
+			if (func_id != funcs::none) {
 				if (consume(lexer::open_parenthesis)) {
 					std::vector<const detail::node*> args = parse_func_call();
-					return nm.make_func(func_id, args);
+					return make_call(func_id, args);
 				}
 				return nullptr;
 			}
-			return nm.make_symbol(prefix.value);
+			return make_variable(text(prefix));
 		}
 		case lexer::op_addition: {
 			return parse_expression(0);
 		}
 		case lexer::op_subtraction: {
 			const detail::node* n = parse_expression(get_precedence(lexer::op_subtraction, true));
-			return nm.make_negation(n);
+			if (!n) {
+				return nullptr;
+			}
+			return make_negation(n);
 		}
 		case lexer::open_parenthesis: {
 			const detail::node* n = parse_expression(0);
@@ -140,60 +275,84 @@ const detail::node* parser::parse_prefix(const lexer::token& prefix) {
 	}
 }
 
-const detail::node* parser::parse_infix(const detail::node* left, const lexer::token& infix) {
-	auto& nm = current_context->node_manager();
+const detail::node* parser::parse_infix(const detail::node* left, const lexer::token& infix, size_t left_start) {
 	int p = get_precedence(infix.type);
 	const lexer::token& prefix = m_tokens[m_index - 2];
 	switch (infix.type) {
 		case lexer::op_addition: {
 			const detail::node* right = parse_expression(p);
-			return nm.make_add({left, right});
+			if (!right) {
+				return nullptr;
+			}
+			return make_operation(lexer::op_addition, left, right);
 		}
 		case lexer::op_subtraction: {
 			const detail::node* right = parse_expression(p);
-			return nm.make_add({left, nm.make_negation(right)});
+			if (!right) {
+				return nullptr;
+			}
+			return make_operation(lexer::op_subtraction, left, right);
 		}
 		case lexer::op_multiplication: {
 			const detail::node* right = parse_expression(p);
-			return nm.make_mul({left, right});
+			if (!right) {
+				return nullptr;
+			}
+			return make_operation(lexer::op_multiplication, left, right);
 		}
 		case lexer::op_division: {
 			const detail::node* right = parse_expression(p);
-			return nm.make_div(left, right);
+			if (!right) {
+				return nullptr;
+			}
+			return make_operation(lexer::op_division, left, right);
 		}
 		case lexer::op_power: {
 			const detail::node* right = parse_expression(p - 1); // Right-associativity : a^b^c = a^(b^c)
-			return nm.make_pow(left, right);
+			if (!right) {
+				return nullptr;
+			}
+			return make_power(left, right, left_start);
 		}
 		case lexer::op_modulo: {
 			m_errors.emplace_back(unsupported, "Modulo is not yet supported.");
 			return nullptr;
 			const detail::node* right = parse_expression(p);
-			return nm.make_mul({left, right});
+			return make_operation(lexer::op_multiplication, left, right);
 		}
 		case lexer::open_parenthesis: {
-			auto func_id = detail::get_func_id(prefix.value);
-			if (func_id != funcs::LEN) {
+			auto func_id = detail::get_func_id(text(prefix));
+			if (func_id != funcs::none) {
 				std::vector<const detail::node*> args = parse_func_call();
-				return nm.make_func(func_id, args);
+				return make_call(func_id, args);
 			}
 			const detail::node* right = parse_expression(0);
+			if (!right) {
+				return nullptr;
+			}
 			advance();
-			return nm.make_mul({left, right});
+			return make_operation(lexer::op_multiplication, left, right);
 		}
 
 		// Handle implicit multiplication
 		case lexer::identifier: {
-			auto func_id = detail::get_func_id(infix.value);
-			if (func_id != funcs::LEN) {
+			auto func_id = detail::get_func_id(text(infix));
+			if (func_id != funcs::none) {
 				if (consume(lexer::open_parenthesis)) {
 					std::vector<const detail::node*> args = parse_func_call();
-					return nm.make_mul({left, nm.make_func(func_id, args)});
+					const detail::node* right = make_call(func_id, args);
+					if (!right) {
+						return nullptr;
+					}
+					return make_operation(lexer::op_multiplication, left, right);
 				}
 				return nullptr;
 			}
-			const detail::node* right = nm.make_symbol(infix.value);
-			return nm.make_mul({left, right});
+			const detail::node* right = make_variable(text(infix));
+			if (!right) {
+				return nullptr;
+			}
+			return make_operation(lexer::op_multiplication, left, right);
 		}
 
 		default: {
@@ -231,9 +390,160 @@ expression sym::parse(const lexer& lexer) {
 	return p.parse(0);
 }
 
+// Trims the whitespace and collapses its runs into single spaces, which the lexer does not tell apart
+std::string normalize_parse_input(std::string_view input) {
+	std::string key;
+	key.reserve(input.size());
+	bool space = false;
+	for (char c : input) {
+		if (std::isspace(static_cast<unsigned char>(c))) {
+			space = !key.empty();
+			continue;
+		}
+		if (space) {
+			key.push_back(' ');
+			space = false;
+		}
+		key.push_back(c);
+	}
+	return key;
+}
+
 expression sym::parse(const std::string& input) {
+	if (!current_context || current_context->parse_cache().capacity() == 0) {
+		lexer l;
+		l.tokenize(input);
+		parser p(l);
+		return p.parse(0);
+	}
+	auto& cache = current_context->parse_cache();
+	std::string key = normalize_parse_input(input);
+	if (const detail::node* root = cache.find(key)) {
+		return root;
+	}
 	lexer l;
-	l.tokenize(input);
+	l.tokenize(key);
 	parser p(l);
-	return p.parse(0);
+	const detail::node* root = p.parse(0);
+	if (root && p.errors().empty()) {
+		cache.insert(std::move(key), root);
+	}
+	return root;
+}
+
+// Lines parsed by a thread at once
+constexpr size_t parse_block = 256;
+
+// Parses a whole line, returns nullptr and sets the error when it fails
+const detail::node* parse_line(std::string_view line, lexer& lexer, node_manager_t& nodes, std::string& error) {
+	lexer.tokenize(line);
+	parser p(lexer, nodes);
+	const detail::node* root = p.parse(0);
+	if (!p.errors().empty()) {
+		error = p.errors().front().desc;
+		return nullptr;
+	}
+	if (!root) {
+		error = "Invalid expression.";
+		return nullptr;
+	}
+	if (p.has_tokens()) {
+		error = std::format(R"(Unexpected "{}".)", lexer.text(p.current_token()));
+		return nullptr;
+	}
+	return root;
+}
+
+parse_many_result sym::parse_many(std::string_view input, size_t threads) {
+	std::vector<std::string_view> lines;
+	for (size_t start = 0; start < input.size();) {
+		size_t end = std::min(input.find('\n', start), input.size());
+		lines.push_back(input.substr(start, end - start));
+		start = end + 1;
+	}
+
+	size_t blocks = (lines.size() + parse_block - 1) / parse_block;
+	threads = threads == 0 ? std::max(1u, std::thread::hardware_concurrency()) : threads;
+	threads = std::max<size_t>(1, std::min(threads, blocks));
+
+	// The first thread creates its nodes in the library directly, the others in managers merged afterwards
+	std::vector<node_manager_t> managers(threads - 1);
+	std::vector<const detail::node*> roots(lines.size(), nullptr);
+	std::vector<std::string> line_errors(lines.size());
+	std::vector<size_t> owners(blocks);
+
+	std::atomic<size_t> next = 0;
+	std::vector<std::exception_ptr> errors(threads);
+	auto work = [&](size_t worker) {
+		try {
+			auto& nodes = worker == 0 ? current_context->node_manager() : managers[worker - 1];
+			lexer lexer;
+			for (size_t b = next++; b < blocks; b = next++) {
+				owners[b] = worker;
+				for (size_t i = b * parse_block; i < std::min(lines.size(), (b + 1) * parse_block); ++i) {
+					if (lines[i].find_first_not_of(" \t\n\v\f\r") != std::string_view::npos) {
+						roots[i] = parse_line(lines[i], lexer, nodes, line_errors[i]);
+					}
+				}
+			}
+		}
+		catch (...) {
+			errors[worker] = std::current_exception();
+			next = blocks;
+		}
+	};
+
+	{
+		std::vector<std::jthread> workers;
+		for (size_t t = 1; t < threads; ++t) {
+			workers.emplace_back(work, t);
+		}
+		work(0);
+	}
+	for (auto& error : errors) {
+		if (error) {
+			std::rethrow_exception(error);
+		}
+	}
+
+	std::vector<std::unordered_map<const detail::node*, const detail::node*>> imported;
+	for (const auto& manager : managers) {
+		imported.push_back(current_context->node_manager().import(manager));
+	}
+
+	parse_many_result result;
+	for (size_t i = 0; i < lines.size(); ++i) {
+		if (!line_errors[i].empty()) {
+			result.errors.emplace_back(i + 1, std::move(line_errors[i]));
+		}
+		else if (roots[i]) {
+			size_t owner = owners[i / parse_block];
+			result.expressions.emplace_back(owner == 0 ? roots[i] : imported[owner - 1].at(roots[i]));
+			result.lines.push_back(i + 1);
+		}
+	}
+	return result;
+}
+
+parse_many_result sym::parse_file(const std::filesystem::path& path, size_t threads) {
+	detail::mapped_file file(path);
+	return parse_many(file.view(), threads);
+}
+
+compiled_expression sym::parse_compiled(std::string_view input, const std::vector<std::string>& variables) {
+	lexer lexer;
+	lexer.tokenize(input);
+	compiled_expression compiled;
+	detail::program_builder program{compiled.m_program};
+	parser p(lexer, program, variables);
+	const detail::node* root = p.parse(0);
+	if (!p.errors().empty()) {
+		throw std::invalid_argument(std::format("parse_compiled: {}", p.errors().front().desc));
+	}
+	if (!root || p.has_tokens()) {
+		throw std::invalid_argument(std::format(R"(parse_compiled: invalid expression "{}")", input));
+	}
+	compiled.m_stack_size = program.max_depth;
+	compiled.m_variables_count = variables.size();
+	return compiled;
 }
@@ -3,67 +3,89 @@
 #include "symaths/symaths.hpp"
 #include "symaths/expressions_manip.hpp"
 
+#include <algorithm>
+#include <cmath>
 #include <stdexcept>
 #include <symaths/utils/maths.hpp>
 
 using namespace sym;
 
-void polynomial::validate_expr(const detail::node* node, const detail::node* variable) {
-	std::visit([&](const auto& x) -> void {
-		using T = std::decay_t<decltype(x)>;
-
-		if constexpr (std::is_same_v<T, detail::negation>) {
-			validate_expr(x.child, variable);
+// Splits a term into its ground coefficient and the rest (nullptr for a constant term)
+std::pair<const detail::node*, const detail::node*> split_polynomial_term(const detail::node* node) {
+	auto& nm = current_context->node_manager();
+	if (node->is_ground()) {
+		return {node, nullptr};
+	}
+	if (auto* neg = std::get_if<detail::negation>(&node->p_data)) {
+		auto [c, rest] = split_polynomial_term(neg->child);
+		return {nm.make_negation(c), rest};
+	}
+	if (auto* mul = std::get_if<detail::multiplication>(&node->p_data)) {
+		std::vector<const detail::node*> coefficient, rest;
+		for (auto* op : mul->operands) {
+			(op->is_ground() ? coefficient : rest).push_back(op);
 		}
+		return {
+			coefficient.empty() ? nm.make_constant(1) : coefficient.size() == 1 ? coefficient.front() : nm.make_mul(coefficient),
+			rest.size() == 1 ? rest.front() : nm.make_mul(rest)
+		};
+	}
+	return {nm.make_constant(1), node};
+}
 
-		if constexpr (std::is_same_v<T, detail::addition>) {
-			for (auto op : x.operands) {
-				detail::expr_term t = detail::extract_term_advanced(op);
-				if (!t.symbolic) {
-					if (coeffs.empty()) {
-						coeffs.push_back(t.coefficient);
-					}
-					else {
-						coeffs[0] = reduce(current_context->node_manager().make_add({coeffs[0], t.coefficient})).root;
-					}
-					continue;
-				}
+void polynomial::validate_expr(const detail::node* node, const detail::node* variable) {
+	// A polynomial which is not a sum has a single term
+	std::vector<const detail::node*> terms{node};
+	if (auto* sum = std::get_if<detail::addition>(&node->p_data)) {
+		terms = sum->operands;
+	}
+	std::vector<std::vector<const detail::node*>> parts;
 
-				auto symlist = detail::list_symbols(t.symbolic);
-				if (symlist[0] != variable) {
-					throw std::invalid_argument("Wrong polynomial variable.");
-				}
+	for (auto* op : terms) {
+		auto [coefficient, symbolic] = split_polynomial_term(op);
 
-				std::visit([&](const auto& x1) -> void {
-					using T = std::decay_t<decltype(x1)>;
+		unsigned long long n = 0;
+		if (symbolic) {
+			auto symlist = detail::list_symbols(symbolic);
+			if (symlist[0] != variable) {
+				throw std::invalid_argument("Wrong polynomial variable.");
+			}
 
-					if constexpr (std::is_same_v<T, detail::symbol>) {
-						if (coeffs.size() <= 1) {
-							auto* zero = current_context->node_manager().make_constant(0);
-							coeffs.resize(2, zero);
-						}
-						coeffs[1] = reduce(current_context->node_manager().make_add({coeffs[1], t.coefficient})).root;
-					}
+			if (symbolic == variable) {
+				n = 1;
+			}
+			else if (auto* power = std::get_if<detail::power>(&symbolic->p_data); power && power->base == variable) {
+				if (!power->exponent->is_ground()) {
+					throw std::logic_error("Exponent must be ground");
+				}
+				double e = power->exponent->eval(nullptr).get<double>();
+				if (!utils::is_integer(e) || e < 0) {
+					throw std::invalid_argument("Exponent is not an integer.");
+				}
+				n = static_cast<unsigned long long>(std::llround(e));
+			}
+			else {
+				throw std::invalid_argument("Expression is an invalid polynomial : " + symbolic->string(nullptr) + " is not a power of the variable.");
+			}
+		}
 
-					if constexpr (std::is_same_v<T, detail::power>) {
-						if (!x1.exponent->is_ground()) {
-							throw std::logic_error("Exponent must be ground");
-						}
-						if (!utils::is_integer(x1.exponent->eval(nullptr).template get<double>())) {
-							throw std::invalid_argument("Exponent is not an integer.");
-						}
+		if (n >= parts.size()) {
+			parts.resize(n + 1);
+		}
+		parts[n].push_back(coefficient);
+	}
 
-						auto n = x1.exponent->eval(nullptr).template get<unsigned long long>();
-						if (n >= coeffs.size()) {
-							auto* zero = current_context->node_manager().make_constant(0);
-							coeffs.resize(n + 1, zero);
-						}
-						coeffs[n] = reduce(current_context->node_manager().make_add({coeffs[n], t.coefficient})).root;
-					}
-				}, t.symbolic->p_data);
-			}
+	// Each coefficient is reduced once, with all its parts
+	auto& nm = current_context->node_manager();
+	coeffs.clear();
+	for (auto& part : parts) {
+		if (part.empty()) {
+			coeffs.push_back(nm.make_constant(0));
+		}
+		else {
+			coeffs.push_back(reduce(part.size() == 1 ? part.front() : nm.make_add(part)).root);
 		}
-	}, node->p_data);
+	}
 }
 
 polynomial::polynomial(const expression& root) : expr(reduce(expand(root))) {
@@ -80,3 +102,20 @@ polynomial::polynomial(const expression& root) : expr(reduce(expand(root))) {
 unsigned long long polynomial::get_degree() const {
 	return coeffs.size() - 1;
 }
+
+polynomial sym::operator*(const polynomial& lhs, const polynomial& rhs) {
+	bool lhs_constant = lhs.coeffs.size() <= 1;
+	bool rhs_constant = rhs.coeffs.size() <= 1;
+	if (!lhs_constant && !rhs_constant && lhs.symb.ref != rhs.symb.ref) {
+		throw std::invalid_argument("Polynomials of different variables.");
+	}
+	const symbol& variable = lhs_constant ? rhs.symb : lhs.symb;
+
+	auto ground = [](const polynomial& p) {
+		return std::ranges::all_of(p.coeffs, [](const detail::node* c) { return c->is_ground(); });
+	};
+	if (ground(lhs) && ground(rhs)) {
+		return polynomial((rational_polynomial(lhs) * rational_polynomial(rhs)).to_expression(variable));
+	}
+	return polynomial(lhs.expr * rhs.expr);
+}
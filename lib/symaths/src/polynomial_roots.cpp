@@ -0,0 +1,212 @@
+#include "symaths/polynomial.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <exception>
+#include <limits>
+#include <numbers>
+#include <stdexcept>
+#include <thread>
+
+using namespace sym;
+
+constexpr size_t aberth_max_iterations = 200;
+constexpr int newton_polish_steps = 3;
+// A root is found when |p(z)| is within this many rounding errors of Horner's scheme at z
+constexpr double root_residual = 4 * std::numeric_limits<double>::epsilon();
+
+struct root_evaluation {
+	// p'(z) / p(z)
+	std::complex<double> log_derivative;
+	// |p(z)| relative to the bound of the rounding errors of its evaluation
+	double residual;
+};
+
+// Without hypot, which std::norm and std::abs call
+std::complex<double> reciprocal(std::complex<double> z) {
+	double norm = z.real() * z.real() + z.imag() * z.imag();
+	return {z.real() / norm, -z.imag() / norm};
+}
+
+double abs_bound(std::complex<double> z) {
+	return std::abs(z.real()) + std::abs(z.imag());
+}
+
+root_evaluation evaluate_at_root(const std::vector<double>& c, std::complex<double> z) {
+	size_t n = c.size() - 1;
+	// Outside of the unit disk, p(z) = z^n q(1 / z) with q the reversed polynomial, so that nothing overflows
+	bool inside = std::abs(z) <= 1;
+	std::complex<double> x = inside ? z : reciprocal(z);
+	// Exact modulus here, any overestimate would grow as its n-th power in the bound
+	double ax = std::abs(x);
+
+	std::complex<double> v = inside ? c[n] : c[0];
+	std::complex<double> dv = 0;
+	double bound = abs_bound(v);
+	for (size_t k = 1; k <= n; ++k) {
+		dv = dv * x + v;
+		v = v * x + (inside ? c[n - k] : c[k]);
+		bound = bound * ax + abs_bound(v);
+	}
+
+	if (v == 0.0) {
+		return {0, 0};
+	}
+	std::complex<double> ratio = dv * reciprocal(v);
+	return {inside ? ratio : x * (static_cast<double>(n) - x * ratio), abs_bound(v) / bound};
+}
+
+// Starting points on circles whose radii are the slopes of the upper convex hull of (k, log |c_k|), which follow
+// the magnitudes of the roots
+std::vector<std::complex<double>> initial_roots(const std::vector<double>& c) {
+	size_t n = c.size() - 1;
+	std::vector<size_t> hull;
+	auto log_abs = [&](size_t k) { return std::log(std::abs(c[k])); };
+	for (size_t k = 0; k <= n; ++k) {
+		if (c[k] == 0) {
+			continue;
+		}
+		while (hull.size() >= 2) {
+			size_t i = hull[hull.size() - 2], j = hull.back();
+			double cross = (log_abs(j) - log_abs(i)) * static_cast<double>(k - i) - (log_abs(k) - log_abs(i)) * static_cast<double>(j - i);
+			if (cross > 0) {
+				break;
+			}
+			hull.pop_back();
+		}
+		hull.push_back(k);
+	}
+
+	std::vector<std::complex<double>> z;
+	z.reserve(n);
+	constexpr double offset = 0.7;
+	for (size_t h = 1; h < hull.size(); ++h) {
+		size_t i = hull[h - 1], j = hull[h];
+		double count = static_cast<double>(j - i);
+		double radius = std::exp((log_abs(i) - log_abs(j)) / count);
+		for (size_t m = 0; m < j - i; ++m) {
+			double angle = 2 * std::numbers::pi * (static_cast<double>(m) / count + static_cast<double>(i) / static_cast<double>(n)) + offset;
+			z.push_back(std::polar(radius, angle));
+		}
+	}
+	return z;
+}
+
+// Degree at least 2, non-zero constant and leading coefficients
+std::vector<std::complex<double>> aberth_roots(const std::vector<double>& c) {
+	size_t n = c.size() - 1;
+	std::vector<std::complex<double>> z = initial_roots(c);
+	std::vector<char> converged(n, false);
+	size_t remaining = n;
+
+	// Each root moves by its Newton correction, deflated by the other roots, which are updated in place
+	for (size_t iteration = 0; iteration < aberth_max_iterations && remaining > 0; ++iteration) {
+		for (size_t i = 0; i < n; ++i) {
+			if (converged[i]) {
+				continue;
+			}
+			root_evaluation e = evaluate_at_root(c, z[i]);
+			std::complex<double> s = 0;
+			for (size_t j = 0; j < n; ++j) {
+				if (j != i) {
+					s += reciprocal(z[i] - z[j]);
+				}
+			}
+			std::complex<double> denominator = e.log_derivative - s;
+			std::complex<double> correction = e.residual == 0 || denominator == 0.0 ? 0 : reciprocal(denominator);
+			z[i] -= correction;
+
+			if (e.residual <= root_residual || std::abs(correction) <= std::numeric_limits<double>::epsilon() * std::abs(z[i])) {
+				converged[i] = true;
+				--remaining;
+			}
+		}
+	}
+
+	// Newton steps are only kept while they lower the residual : they cannot improve clustered (multiple) roots
+	for (auto& root : z) {
+		root_evaluation e = evaluate_at_root(c, root);
+		for (int step = 0; step < newton_polish_steps && e.residual > 0 && e.log_derivative != 0.0; ++step) {
+			std::complex<double> candidate = root - reciprocal(e.log_derivative);
+			root_evaluation next = evaluate_at_root(c, candidate);
+			if (next.residual >= e.residual) {
+				break;
+			}
+			root = candidate;
+			e = next;
+		}
+	}
+	return z;
+}
+
+std::vector<std::complex<double>> sym::find_roots(const numeric_polynomial& p) {
+	std::vector<double> c = p.coeffs;
+	if (!std::ranges::all_of(c, [](double x) { return std::isfinite(x); })) {
+		throw std::invalid_argument("Coefficients of a polynomial must be finite to find its roots.");
+	}
+	while (!c.empty() && c.back() == 0) {
+		c.pop_back();
+	}
+	if (c.empty()) {
+		throw std::invalid_argument("The zero polynomial has infinitely many roots.");
+	}
+
+	// Roots at 0 are exact
+	size_t zeros = std::ranges::find_if(c, [](double x) { return x != 0; }) - c.begin();
+	std::vector<std::complex<double>> roots(zeros, 0.0);
+	c.erase(c.begin(), c.begin() + static_cast<std::ptrdiff_t>(zeros));
+
+	if (c.size() == 2) {
+		roots.emplace_back(-c[0] / c[1]);
+	}
+	else if (c.size() > 2) {
+		std::ranges::copy(aberth_roots(c), std::back_inserter(roots));
+	}
+
+	std::ranges::sort(roots, [](const std::complex<double>& a, const std::complex<double>& b) {
+		return a.real() != b.real() ? a.real() < b.real() : a.imag() < b.imag();
+	});
+	return roots;
+}
+
+std::vector<std::complex<double>> sym::find_roots(const polynomial& p) {
+	return find_roots(numeric_polynomial(p));
+}
+
+std::vector<std::vector<std::complex<double>>> sym::find_roots(const std::vector<numeric_polynomial>& polynomials, size_t threads) {
+	std::vector<std::vector<std::complex<double>>> results(polynomials.size());
+	if (threads == 0) {
+		threads = std::max(1u, std::thread::hardware_concurrency());
+	}
+	threads = std::max<size_t>(1, std::min(threads, polynomials.size()));
+
+	// Polynomials are handed out one at a time, since their degrees (thus their costs) may differ
+	std::atomic<size_t> next = 0;
+	std::vector<std::exception_ptr> errors(threads);
+	auto work = [&](size_t worker) {
+		try {
+			for (size_t i = next++; i < polynomials.size(); i = next++) {
+				results[i] = find_roots(polynomials[i]);
+			}
+		}
+		catch (...) {
+			errors[worker] = std::current_exception();
+			next = polynomials.size();
+		}
+	};
+
+	{
+		std::vector<std::jthread> workers;
+		for (size_t t = 1; t < threads; ++t) {
+			workers.emplace_back(work, t);
+		}
+		work(0);
+	}
+	for (auto& error : errors) {
+		if (error) {
+			std::rethrow_exception(error);
+		}
+	}
+	return results;
+}
@@ -0,0 +1,223 @@
+#include "symaths/printer.hpp"
+
+#include "symaths/symaths.hpp"
+#include "symaths/base_functions.hpp"
+#include "symaths/detail/nodes.hpp"
+
+#include <array>
+#include <format>
+#include <functional>
+#include <iterator>
+#include <stdexcept>
+
+using namespace sym;
+
+// LaTeX commands of the builtins printed as name(args), sqrt and abs have their own notation
+constexpr std::array<std::string_view, funcs::LEN> latex_function_names = {
+	"\\cos", "\\sin", "\\tan", "\\arccos", "\\arcsin", "\\arctan",
+	"\\exp", "\\ln", "\\log_{10}", "\\cosh", "\\sinh", "\\tanh",
+	"", "",
+};
+
+size_t printer::memo_hash::operator()(const memo_key& k) const {
+	return std::hash<const void*>{}(k.node) ^ (static_cast<size_t>(k.parent_kind) << 1 | k.first) * 0x9E3779B97F4A7C15ull;
+}
+
+void printer::clear() {
+	m_out.clear();
+	m_memo.clear();
+}
+
+std::string_view printer::print(const detail::node* node, const detail::node* parent, bool first) {
+	size_t start = m_out.size();
+	print_node(node, parent, first);
+	return std::string_view(m_out).substr(start);
+}
+
+void printer::open_parenthesis() {
+	m_out += m_format == print_format::latex ? "\\left(" : "(";
+}
+
+void printer::close_parenthesis() {
+	m_out += m_format == print_format::latex ? "\\right)" : ")";
+}
+
+void printer::print_number(const number& value, const detail::node* parent) {
+	const auto* q = std::get_if<numbers::rational>(&value.p_data);
+	if (q && m_format == print_format::latex) {
+		std::format_to(std::back_inserter(m_out), "{}\\frac{{{}}}{{{}}}", q->num < 0 ? "-" : "", q->num < 0 ? -q->num : q->num, q->den);
+	}
+	// A quotient would bind to its neighbours when read back
+	else if (q && m_format == print_format::compact && parent && !std::holds_alternative<detail::addition>(parent->p_data)) {
+		std::format_to(std::back_inserter(m_out), "({}/{})", q->num, q->den);
+	}
+	else {
+		value.append_to(m_out);
+	}
+}
+
+void printer::print_node(const detail::node* node, const detail::node* parent, bool first) {
+	bool compound = !std::holds_alternative<detail::symbol>(node->p_data) && !std::holds_alternative<detail::constant>(node->p_data);
+	memo_key key{node, static_cast<uint8_t>(parent ? parent->p_data.index() + 1 : 0), first};
+	if (m_memoize && compound) {
+		if (auto it = m_memo.find(key); it != m_memo.end()) {
+			m_out.append(m_out, it->second.offset, it->second.length);
+			return;
+		}
+	}
+	size_t start = m_out.size();
+
+	bool plain = m_format == print_format::plain;
+	bool latex = m_format == print_format::latex;
+	if (plain && !current_context) {
+		throw std::runtime_error("node::string(): current context is null");
+	}
+	// The other formats do not depend on the print policies
+	static const print_policies_t no_policies{};
+	const print_policies_t& policies = plain ? current_context->print_policies() : no_policies;
+	bool parenthesized = parent && parent->priority() > node->priority();
+
+	std::visit([&](const auto& x) {
+		using T = std::decay_t<decltype(x)>;
+
+		if constexpr (std::is_same_v<T, detail::constant>) {
+			if (parent && std::holds_alternative<detail::addition>(parent->p_data)) {
+				print_number(abs_calc(x.value), parent);
+			}
+			else if (!first && x.value.template get<double>() < 0 && parent && parent->priority() >= detail::multiplication::priority) {
+				open_parenthesis();
+				print_number(x.value, parent);
+				close_parenthesis();
+			}
+			else {
+				print_number(x.value, parent);
+			}
+		}
+
+		else if constexpr (std::is_same_v<T, detail::symbol>) {
+			m_out += x.name;
+		}
+
+		else if constexpr (std::is_same_v<T, detail::negation>) {
+			// If parent is sum then no need to add "-" sign
+			if (parent && std::holds_alternative<detail::addition>(parent->p_data)) {
+				print_node(x.child, node, first);
+			}
+			else if (first && !parenthesized) {
+				m_out += '-';
+				print_node(x.child, node, first);
+			}
+			else {
+				open_parenthesis();
+				m_out += '-';
+				print_node(x.child, node, first);
+				close_parenthesis();
+			}
+		}
+
+		else if constexpr (std::is_same_v<T, detail::addition>) {
+			if (parenthesized) open_parenthesis();
+			for (size_t i = 0; i < x.operands.size(); ++i) {
+				auto& op = x.operands[i];
+				if (std::holds_alternative<detail::negation>(op->p_data) || (std::holds_alternative<detail::constant>(op->p_data) && op->eval(nullptr).template get<double>() < 0)) {
+					m_out += '-';
+					if (i != 0) {
+						m_out.append(policies.sum.operand_spaces, ' ');
+					}
+				}
+				else if (i != 0) {
+					m_out += '+';
+					m_out.append(policies.sum.operand_spaces, ' ');
+				}
+				print_node(op, node, i == 0);
+			}
+			if (parenthesized) close_parenthesis();
+		}
+
+		else if constexpr (std::is_same_v<T, detail::multiplication>) {
+			if (parenthesized) open_parenthesis();
+			for (size_t i = 0; i < x.operands.size(); ++i) {
+				auto& op = x.operands[i];
+				if (i != 0) {
+					bool is_val = std::holds_alternative<detail::constant>(op->p_data);
+					if (latex) {
+						m_out += is_val ? " \\cdot " : " ";
+					}
+					else {
+						if (is_val || policies.product.use_stars_for_subexprs || m_format == print_format::compact) {
+							m_out += '*';
+						}
+						m_out.append(policies.product.operand_spaces, ' ');
+					}
+				}
+				print_node(op, node, i == 0);
+			}
+			if (parenthesized) close_parenthesis();
+		}
+
+		else if constexpr (std::is_same_v<T, detail::power>) {
+			if (parenthesized) open_parenthesis();
+			print_node(x.base, node, false);
+			if (latex) {
+				// The braces group the exponent
+				m_out += "^{";
+				print_node(x.exponent, nullptr, true);
+				m_out += '}';
+			}
+			else {
+				m_out += '^';
+				print_node(x.exponent, node, false);
+			}
+			if (parenthesized) close_parenthesis();
+		}
+
+		else if constexpr (std::is_same_v<T, detail::function_call>) {
+			if (latex && x.f_id == funcs::sqrt) {
+				m_out += "\\sqrt{";
+				print_node(x.args[0], node, true);
+				m_out += '}';
+				return;
+			}
+			if (latex && x.f_id == funcs::abs) {
+				m_out += "\\left|";
+				print_node(x.args[0], node, true);
+				m_out += "\\right|";
+				return;
+			}
+			if (!latex) {
+				m_out += detail::get_func(x.f_id).name;
+			}
+			else if (x.f_id < funcs::LEN) {
+				m_out += latex_function_names[x.f_id];
+			}
+			else {
+				m_out += "\\operatorname{" + detail::get_func(x.f_id).name + "}";
+			}
+			open_parenthesis();
+			for (size_t i = 0; i < x.args.size(); ++i) {
+				if (i != 0) {
+					m_out += m_format == print_format::compact ? "," : ", ";
+				}
+				print_node(x.args[i], node, i == 0);
+			}
+			close_parenthesis();
+		}
+	}, node->p_data);
+
+	if (m_memoize && compound) {
+		m_memo.emplace(key, span{start, m_out.size() - start});
+	}
+}
+
+
+std::string sym::to_latex(const expression& expr) {
+	printer p(print_format::latex);
+	p.print(expr);
+	return p.str();
+}
+
+std::string sym::to_compact(const expression& expr) {
+	printer p(print_format::compact);
+	p.print(expr);
+	return p.str();
+}
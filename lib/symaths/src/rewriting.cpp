@@ -0,0 +1,531 @@
+#include "symaths/rewriting.hpp"
+
+#include "symaths/symaths.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <stdexcept>
+#include <unordered_map>
+#include <unordered_set>
+
+using namespace sym;
+
+/*
+ * The discrimination tree indexes the preorder walk of each pattern. Each step is either a key describing a node
+ * (its type, the symbol, the value of the constant, the function and its arity), or a wildcard which skips a whole
+ * subexpression. Operands of sums and products are not walked since they match in any order : a pattern rooted at
+ * a sum or a product is indexed by the keys of its operands instead.
+ */
+
+enum rewrite_key_kind : uint64_t {
+	key_symbol, key_constant, key_special_constant, key_negation, key_addition, key_multiplication, key_power, key_call
+};
+
+std::pair<uint64_t, uintptr_t> rewrite_index_key(const detail::node* node) {
+	return std::visit([&](const auto& x) -> std::pair<uint64_t, uintptr_t> {
+		using T = std::decay_t<decltype(x)>;
+
+		if constexpr (std::is_same_v<T, detail::symbol>) {
+			return {key_symbol, reinterpret_cast<uintptr_t>(node)};
+		}
+		else if constexpr (std::is_same_v<T, detail::constant>) {
+			auto rank = number::get_rank(x.value.p_data);
+			if (rank == number::rank::Complex || rank == number::rank::NaN) {
+				return {key_special_constant, reinterpret_cast<uintptr_t>(node)};
+			}
+			// 2 and 2.0 are different nodes, but the same key
+			return {key_constant, std::bit_cast<uintptr_t>(x.value.template get<double>() + 0.0)};
+		}
+		else if constexpr (std::is_same_v<T, detail::negation>) {
+			return {key_negation, 0};
+		}
+		else if constexpr (std::is_same_v<T, detail::addition>) {
+			return {key_addition, 0};
+		}
+		else if constexpr (std::is_same_v<T, detail::multiplication>) {
+			return {key_multiplication, 0};
+		}
+		else if constexpr (std::is_same_v<T, detail::power>) {
+			return {key_power, 0};
+		}
+		else {
+			return {key_call | static_cast<uint64_t>(x.f_id) << 8 | static_cast<uint64_t>(x.args.size()) << 40, 0};
+		}
+	}, node->p_data);
+}
+
+// Operands walked by the index after the node itself, in preorder
+void push_indexed_children(const detail::node* node, std::vector<const detail::node*>& pending) {
+	std::visit([&](const auto& x) {
+		using T = std::decay_t<decltype(x)>;
+
+		if constexpr (std::is_same_v<T, detail::negation>) {
+			pending.push_back(x.child);
+		}
+		else if constexpr (std::is_same_v<T, detail::power>) {
+			pending.push_back(x.exponent);
+			pending.push_back(x.base);
+		}
+		else if constexpr (std::is_same_v<T, detail::function_call>) {
+			for (auto it = x.args.rbegin(); it != x.args.rend(); ++it) {
+				pending.push_back(*it);
+			}
+		}
+	}, node->p_data);
+}
+
+bool same_constant(const detail::node* a, const detail::node* b) {
+	auto* ca = std::get_if<detail::constant>(&a->p_data);
+	auto* cb = std::get_if<detail::constant>(&b->p_data);
+	if (!ca || !cb) {
+		return false;
+	}
+	return rewrite_index_key(a) == rewrite_index_key(b);
+}
+
+class rule_matcher {
+	const rewrite_rule& rule;
+
+public:
+	std::vector<std::pair<const detail::node*, const detail::node*>> bindings;
+
+	explicit rule_matcher(const rewrite_rule& rule) : rule(rule) {}
+
+	bool is_wildcard(const detail::node* node) const {
+		return std::ranges::find(rule.wildcards, node) != rule.wildcards.end();
+	}
+
+	// Matches the root of the rule, which may only match a part of the operands of a sum or a product
+	bool match_root(const detail::node* term, std::vector<const detail::node*>& rest) {
+		if (term->p_data.index() == rule.pattern->p_data.index() && !is_wildcard(rule.pattern)) {
+			const std::vector<const detail::node*>* patterns = nullptr;
+			const std::vector<const detail::node*>* terms = nullptr;
+			if (auto* p = std::get_if<detail::addition>(&rule.pattern->p_data)) {
+				patterns = &p->operands;
+				terms = &std::get<detail::addition>(term->p_data).operands;
+			}
+			else if (auto* p = std::get_if<detail::multiplication>(&rule.pattern->p_data)) {
+				patterns = &p->operands;
+				terms = &std::get<detail::multiplication>(term->p_data).operands;
+			}
+
+			if (patterns) {
+				std::vector<bool> used(terms->size(), false);
+				if (patterns->size() > terms->size() || !match_operands(ordered(*patterns), *terms, used, 0)) {
+					return false;
+				}
+				for (size_t i = 0; i < terms->size(); ++i) {
+					if (!used[i]) {
+						rest.push_back((*terms)[i]);
+					}
+				}
+				return true;
+			}
+		}
+		return match(rule.pattern, term);
+	}
+
+	const detail::node* instantiate(const detail::node* node, node_manager_t& nm) const {
+		if (is_wildcard(node)) {
+			auto it = std::ranges::find_if(bindings, [&](const auto& b) { return b.first == node; });
+			return it != bindings.end() ? it->second : node;
+		}
+
+		return std::visit([&](const auto& x) -> const detail::node* {
+			using T = std::decay_t<decltype(x)>;
+
+			if constexpr (std::is_same_v<T, detail::negation>) {
+				return nm.make_negation(instantiate(x.child, nm));
+			}
+			else if constexpr (std::is_same_v<T, detail::addition> || std::is_same_v<T, detail::multiplication>) {
+				std::vector<const detail::node*> ops;
+				for (auto* op : x.operands) {
+					ops.push_back(instantiate(op, nm));
+				}
+				return std::is_same_v<T, detail::addition> ? nm.make_add(ops) : nm.make_mul(ops);
+			}
+			else if constexpr (std::is_same_v<T, detail::power>) {
+				return nm.make_pow(instantiate(x.base, nm), instantiate(x.exponent, nm));
+			}
+			else if constexpr (std::is_same_v<T, detail::function_call>) {
+				std::vector<const detail::node*> args;
+				for (auto* arg : x.args) {
+					args.push_back(instantiate(arg, nm));
+				}
+				return nm.make_func(x.f_id, args);
+			}
+			return node;
+		}, node->p_data);
+	}
+
+private:
+	// Wildcards last : other operands constrain the search more
+	std::vector<const detail::node*> ordered(const std::vector<const detail::node*>& patterns) const {
+		std::vector<const detail::node*> result = patterns;
+		std::ranges::stable_partition(result, [&](const detail::node* p) { return !is_wildcard(p); });
+		return result;
+	}
+
+	bool match(const detail::node* pattern, const detail::node* term) {
+		if (is_wildcard(pattern)) {
+			auto it = std::ranges::find_if(bindings, [&](const auto& b) { return b.first == pattern; });
+			if (it != bindings.end()) {
+				return it->second == term;
+			}
+			bindings.emplace_back(pattern, term);
+			return true;
+		}
+		if (pattern == term) {
+			return true;
+		}
+		if (pattern->p_data.index() != term->p_data.index()) {
+			return false;
+		}
+
+		size_t mark = bindings.size();
+		bool matched = std::visit([&](const auto& p) {
+			using T = std::decay_t<decltype(p)>;
+			const auto& t = std::get<T>(term->p_data);
+
+			if constexpr (std::is_same_v<T, detail::constant>) {
+				return same_constant(pattern, term);
+			}
+			else if constexpr (std::is_same_v<T, detail::negation>) {
+				return match(p.child, t.child);
+			}
+			else if constexpr (std::is_same_v<T, detail::addition> || std::is_same_v<T, detail::multiplication>) {
+				std::vector<bool> used(t.operands.size(), false);
+				return p.operands.size() == t.operands.size() && match_operands(ordered(p.operands), t.operands, used, 0);
+			}
+			else if constexpr (std::is_same_v<T, detail::power>) {
+				return match(p.base, t.base) && match(p.exponent, t.exponent);
+			}
+			else if constexpr (std::is_same_v<T, detail::function_call>) {
+				if (p.f_id != t.f_id || p.args.size() != t.args.size()) {
+					return false;
+				}
+				for (size_t i = 0; i < p.args.size(); ++i) {
+					if (!match(p.args[i], t.args[i])) {
+						return false;
+					}
+				}
+				return true;
+			}
+			return false;
+		}, pattern->p_data);
+
+		if (!matched) {
+			bindings.resize(mark);
+		}
+		return matched;
+	}
+
+	// Assigns each pattern operand from i to a distinct term operand
+	bool match_operands(const std::vector<const detail::node*>& patterns, const std::vector<const detail::node*>& terms, std::vector<bool>& used, size_t i) {
+		if (i == patterns.size()) {
+			return true;
+		}
+		for (size_t j = 0; j < terms.size(); ++j) {
+			if (used[j]) continue;
+
+			size_t mark = bindings.size();
+			if (match(patterns[i], terms[j])) {
+				used[j] = true;
+				if (match_operands(patterns, terms, used, i + 1)) {
+					return true;
+				}
+				used[j] = false;
+			}
+			bindings.resize(mark);
+		}
+		return false;
+	}
+};
+
+
+sym::rule_set::rule_set() {
+	m_index.emplace_back();
+}
+
+void sym::rule_set::add(const expression& pattern, const expression& replacement, const std::vector<symbol>& wildcards) {
+	rewrite_rule rule{pattern.root, replacement.root, {}};
+	for (auto& w : wildcards) {
+		if (!std::holds_alternative<detail::symbol>(w.ref->p_data)) {
+			throw std::invalid_argument("rule_set::add: wildcards must be symbols");
+		}
+		rule.wildcards.push_back(w.ref);
+	}
+	for (auto* w : rule.wildcards) {
+		if (replacement.root->depends_on(w) && !pattern.root->depends_on(w)) {
+			throw std::invalid_argument("rule_set::add: a wildcard of the replacement does not appear in the pattern");
+		}
+	}
+
+	auto id = static_cast<uint32_t>(m_rules.size());
+	rule_matcher matcher(rule);
+	m_required_operands.emplace_back();
+
+	const std::vector<const detail::node*>* operands = nullptr;
+	if (auto* sum = std::get_if<detail::addition>(&rule.pattern->p_data)) {
+		operands = &sum->operands;
+	}
+	else if (auto* product = std::get_if<detail::multiplication>(&rule.pattern->p_data)) {
+		operands = &product->operands;
+	}
+	if (operands) {
+		auto& required = m_required_operands.back();
+		for (auto* op : *operands) {
+			if (!matcher.is_wildcard(op)) {
+				required.push_back(rewrite_index_key(op));
+			}
+		}
+		std::ranges::sort(required);
+
+		if (required.empty()) {
+			m_wildcard_operands_rules.push_back(id);
+		}
+		else {
+			// Functions and symbols are the most selective keys, and they sort last
+			m_operand_index[{rule.pattern->p_data.index(), required.back()}].push_back(id);
+		}
+		m_rules.push_back(std::move(rule));
+		return;
+	}
+
+	uint32_t at = 0;
+	std::vector<const detail::node*> pending{rule.pattern};
+	while (!pending.empty()) {
+		const detail::node* p = pending.back();
+		pending.pop_back();
+
+		if (matcher.is_wildcard(p)) {
+			if (!m_index[at].wildcard) {
+				m_index[at].wildcard = static_cast<uint32_t>(m_index.size());
+				m_index.emplace_back();
+			}
+			at = m_index[at].wildcard;
+			continue;
+		}
+
+		auto key = rewrite_index_key(p);
+		auto it = m_index[at].next.find(key);
+		if (it == m_index[at].next.end()) {
+			it = m_index[at].next.emplace(key, static_cast<uint32_t>(m_index.size())).first;
+			m_index.emplace_back();
+		}
+		at = it->second;
+		push_indexed_children(p, pending);
+	}
+	m_index[at].rules.push_back(id);
+	m_rules.push_back(std::move(rule));
+}
+
+void sym::rule_set::clear() {
+	m_rules.clear();
+	m_index.clear();
+	m_index.emplace_back();
+	m_operand_index.clear();
+	m_wildcard_operands_rules.clear();
+	m_required_operands.clear();
+}
+
+void sym::rule_set::collect(uint32_t at, std::vector<const detail::node*>& pending, std::vector<uint32_t>& out) const {
+	const index_node& current = m_index[at];
+	if (pending.empty()) {
+		out.append_range(current.rules);
+		return;
+	}
+
+	const detail::node* term = pending.back();
+	pending.pop_back();
+
+	if (current.wildcard) {
+		collect(current.wildcard, pending, out);
+	}
+	if (auto it = current.next.find(rewrite_index_key(term)); it != current.next.end()) {
+		size_t mark = pending.size();
+		push_indexed_children(term, pending);
+		collect(it->second, pending, out);
+		pending.resize(mark);
+	}
+
+	pending.push_back(term);
+}
+
+void sym::rule_set::collect_operands(const detail::node* node, std::vector<uint32_t>& out) const {
+	const std::vector<const detail::node*>* operands = nullptr;
+	if (auto* sum = std::get_if<detail::addition>(&node->p_data)) {
+		operands = &sum->operands;
+	}
+	else if (auto* product = std::get_if<detail::multiplication>(&node->p_data)) {
+		operands = &product->operands;
+	}
+	if (!operands) {
+		return;
+	}
+
+	std::vector<index_key> keys;
+	for (auto* op : *operands) {
+		keys.push_back(rewrite_index_key(op));
+	}
+	std::ranges::sort(keys);
+
+	auto has_required = [&](uint32_t id) {
+		return m_rules[id].pattern->p_data.index() == node->p_data.index() && std::ranges::includes(keys, m_required_operands[id]);
+	};
+
+	for (auto it = keys.begin(); it != keys.end(); it = std::upper_bound(it, keys.end(), *it)) {
+		auto found = m_operand_index.find({node->p_data.index(), *it});
+		if (found == m_operand_index.end()) continue;
+
+		for (uint32_t id : found->second) {
+			if (has_required(id)) {
+				out.push_back(id);
+			}
+		}
+	}
+	for (uint32_t id : m_wildcard_operands_rules) {
+		if (has_required(id)) {
+			out.push_back(id);
+		}
+	}
+}
+
+std::vector<uint32_t> sym::rule_set::candidates(const detail::node* node) const {
+	std::vector<uint32_t> result;
+	std::vector<const detail::node*> pending{node};
+	collect(0, pending, result);
+	collect_operands(node, result);
+	std::ranges::sort(result);
+	return result;
+}
+
+std::optional<const detail::node*> sym::rule_set::apply(const detail::node* node) const {
+	if (!current_context) {
+		throw std::runtime_error("rule_set::apply: current context is null");
+	}
+	auto& nm = current_context->node_manager();
+
+	for (uint32_t id : candidates(node)) {
+		rule_matcher matcher(m_rules[id]);
+		std::vector<const detail::node*> rest;
+		if (!matcher.match_root(node, rest)) {
+			continue;
+		}
+
+		const detail::node* result = matcher.instantiate(m_rules[id].replacement, nm);
+		if (!rest.empty()) {
+			rest.push_back(result);
+			result = std::holds_alternative<detail::addition>(node->p_data) ? nm.make_add(rest) : nm.make_mul(rest);
+		}
+		return result;
+	}
+	return std::nullopt;
+}
+
+class rule_rewriter {
+	const rule_set& rules;
+	node_manager_t& nm;
+	std::unordered_map<const detail::node*, const detail::node*> memo;
+	// Nodes whose rewriting has started but not finished
+	std::unordered_set<const detail::node*> pending;
+	size_t rewrites = 0;
+
+public:
+	rule_rewriter(const rule_set& rules, node_manager_t& nm) : rules(rules), nm(nm) {}
+
+	const detail::node* rewrite(const detail::node* node) {
+		if (auto it = memo.find(node); it != memo.end()) {
+			return it->second;
+		}
+
+		// The rules are applied in a loop, so that the stack does not grow with the amount of rewrites. Reaching a
+		// pending node again means the rules cycle, or grow an expression around itself.
+		std::vector<const detail::node*> chain;
+		const detail::node* current = node;
+		const detail::node* result = nullptr;
+		while (!result) {
+			if (auto it = memo.find(current); it != memo.end()) {
+				result = it->second;
+				break;
+			}
+			if (!pending.insert(current).second) {
+				throw std::runtime_error("rule_set::rewrite: the rules do not terminate");
+			}
+			chain.push_back(current);
+
+			const detail::node* rebuilt = rewrite_children(current);
+			if (rebuilt != current && !pending.insert(rebuilt).second) {
+				throw std::runtime_error("rule_set::rewrite: the rules do not terminate");
+			}
+			chain.push_back(rebuilt);
+
+			auto applied = rules.apply(rebuilt);
+			if (!applied) {
+				result = rebuilt;
+			}
+			else if (++rewrites > rule_set::max_rewrites) {
+				throw std::runtime_error("rule_set::rewrite: too many rewrites, the rules may not terminate");
+			}
+			else {
+				current = *applied;
+			}
+		}
+
+		for (auto* n : chain) {
+			pending.erase(n);
+			memo.emplace(n, result);
+		}
+		return result;
+	}
+
+private:
+	const detail::node* rewrite_children(const detail::node* node) {
+		return std::visit([&](const auto& x) -> const detail::node* {
+			using T = std::decay_t<decltype(x)>;
+
+			if constexpr (std::is_same_v<T, detail::negation>) {
+				const detail::node* child = rewrite(x.child);
+				return child == x.child ? node : nm.make_negation(child);
+			}
+			else if constexpr (std::is_same_v<T, detail::addition> || std::is_same_v<T, detail::multiplication>) {
+				std::vector<const detail::node*> ops;
+				for (auto* op : x.operands) {
+					ops.push_back(rewrite(op));
+				}
+				if (ops == x.operands) {
+					return node;
+				}
+				return std::is_same_v<T, detail::addition> ? nm.make_add(ops) : nm.make_mul(ops);
+			}
+			else if constexpr (std::is_same_v<T, detail::power>) {
+				const detail::node* base = rewrite(x.base);
+				const detail::node* exponent = rewrite(x.exponent);
+				return base == x.base && exponent == x.exponent ? node : nm.make_pow(base, exponent);
+			}
+			else if constexpr (std::is_same_v<T, detail::function_call>) {
+				std::vector<const detail::node*> args;
+				for (auto* arg : x.args) {
+					args.push_back(rewrite(arg));
+				}
+				return args == x.args ? node : nm.make_func(x.f_id, args);
+			}
+			return node;
+		}, node->p_data);
+	}
+};
+
+expression sym::rule_set::rewrite(const expression& expr) const {
+	if (!current_context) {
+		throw std::runtime_error("rule_set::rewrite: current context is null");
+	}
+	rule_rewriter rewriter(*this, current_context->node_manager());
+	return rewriter.rewrite(expr.root);
+}
+
+expression sym::rewrite(const expression& expr) {
+	if (!current_context) {
+		throw std::runtime_error("sym::rewrite: current context is null");
+	}
+	return current_context->refactoring_rules().rewrite_rules.rewrite(expr);
+}
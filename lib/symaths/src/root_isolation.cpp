@@ -0,0 +1,268 @@
+#include "symaths/root_isolation.hpp"
+
+#include "symaths/symaths.hpp"
+#include "symaths/detail/bounds.hpp"
+#include "symaths/detail/linear_solvers.hpp"
+#include "symaths/detail/task_tree.hpp"
+#include "symaths/parsing/compiler.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <thread>
+
+using namespace sym;
+
+// Boxes are split slightly off their middle, so that roots at simple values (such as 0 in a symmetric region) do not
+// end up on the boundary of both halves
+constexpr double bisection_ratio = 0.4921875;
+// A Krawczyk step which leaves a box wider than this fraction of its width is followed by a bisection
+constexpr double krawczyk_progress = 0.75;
+// Steps contracting a certified box
+constexpr size_t max_contractions = 64;
+
+using interval_box = std::vector<detail::bounds>;
+
+struct krawczyk_problem {
+	size_t n;
+	detail::sparsity_pattern jacobian_pattern;
+	compiled_vector_expression functions;
+	// Functions, then the non-zero entries of the Jacobian
+	compiled_vector_expression functions_and_jacobian;
+	isolation_options options;
+};
+
+// Memory of one worker, and the boxes it found
+struct krawczyk_workspace {
+	std::vector<detail::bounds> stack;
+	std::vector<detail::bounds> outputs;
+	std::vector<detail::bounds> midpoint;
+	std::vector<detail::bounds> midpoint_values;
+	std::vector<detail::bounds> jacobian;
+	std::vector<double> matrix;
+	std::vector<double> inverse;
+	std::vector<double> column;
+	interval_box next;
+	detail::dense_lu lu;
+	std::vector<box> roots;
+	std::vector<box> uncertain;
+};
+
+enum class krawczyk_outcome {
+	// The box holds no root
+	excluded,
+	// The box holds exactly one root
+	certified,
+	// The box was intersected with its image, which may not be smaller
+	contracted,
+	// The operator could not be built (Jacobian unbounded or singular at the midpoint)
+	stalled,
+};
+
+double max_width(const interval_box& x) {
+	double result = 0;
+	for (const auto& b : x) {
+		result = std::max(result, b.width());
+	}
+	return result;
+}
+
+// One step of the Krawczyk operator K(X) = m - Y F(m) + (I - Y J(X)) (X - m), where m is the midpoint of X and Y
+// the inverse of the midpoint of J(X). Every root in X is in K(X), and if K(X) is in the interior of X, X holds
+// exactly one root. x becomes K(X) ∩ X.
+krawczyk_outcome krawczyk_step(const krawczyk_problem& p, interval_box& x, krawczyk_workspace& ws) {
+	size_t n = p.n;
+	ws.outputs.resize(n + p.jacobian_pattern.size());
+	p.functions_and_jacobian.eval_bounds(x.data(), ws.outputs.data(), ws.stack);
+	for (size_t i = 0; i < n; ++i) {
+		if (!ws.outputs[i].contains(0)) {
+			return krawczyk_outcome::excluded;
+		}
+	}
+
+	ws.jacobian.assign(n * n, detail::bounds::point(0));
+	ws.matrix.assign(n * n, 0.0);
+	for (size_t k = 0; k < p.jacobian_pattern.size(); ++k) {
+		auto [i, j] = p.jacobian_pattern[k];
+		const detail::bounds& entry = ws.outputs[n + k];
+		if (entry.is_empty() || !std::isfinite(entry.lower) || !std::isfinite(entry.upper)) {
+			return krawczyk_outcome::stalled;
+		}
+		ws.jacobian[i * n + j] = entry;
+		ws.matrix[i * n + j] = entry.midpoint();
+	}
+	if (!ws.lu.factorize(n, ws.matrix.data())) {
+		return krawczyk_outcome::stalled;
+	}
+	ws.inverse.resize(n * n);
+	ws.column.resize(n);
+	for (size_t j = 0; j < n; ++j) {
+		std::fill(ws.column.begin(), ws.column.end(), 0.0);
+		ws.column[j] = 1;
+		ws.lu.solve(ws.column.data());
+		for (size_t i = 0; i < n; ++i) {
+			ws.inverse[i * n + j] = ws.column[i];
+		}
+	}
+
+	ws.midpoint.resize(n);
+	ws.midpoint_values.resize(n);
+	for (size_t i = 0; i < n; ++i) {
+		ws.midpoint[i] = detail::bounds::point(x[i].midpoint());
+	}
+	p.functions.eval_bounds(ws.midpoint.data(), ws.midpoint_values.data(), ws.stack);
+	for (const auto& value : ws.midpoint_values) {
+		if (value.is_empty()) {
+			return krawczyk_outcome::stalled;
+		}
+	}
+
+	bool interior = true;
+	ws.next.resize(n);
+	for (size_t i = 0; i < n; ++i) {
+		const double* y = ws.inverse.data() + i * n;
+		detail::bounds k = ws.midpoint[i];
+		for (size_t j = 0; j < n; ++j) {
+			k = k - detail::bounds::point(y[j]) * ws.midpoint_values[j];
+		}
+		for (size_t c = 0; c < n; ++c) {
+			detail::bounds coefficient = detail::bounds::point(i == c ? 1 : 0);
+			for (size_t j = 0; j < n; ++j) {
+				coefficient = coefficient - detail::bounds::point(y[j]) * ws.jacobian[j * n + c];
+			}
+			k = k + coefficient * (x[c] - ws.midpoint[c]);
+		}
+		interior = interior && x[i].lower < k.lower && k.upper < x[i].upper;
+		ws.next[i] = intersection(k, x[i]);
+		if (ws.next[i].is_empty()) {
+			return krawczyk_outcome::excluded;
+		}
+	}
+	x.swap(ws.next);
+	return interior ? krawczyk_outcome::certified : krawczyk_outcome::contracted;
+}
+
+bool narrow_enough(const interval_box& x, double tolerance) {
+	return std::ranges::all_of(x, [&](const detail::bounds& b) {
+		return b.width() <= tolerance * std::max({1.0, std::abs(b.lower), std::abs(b.upper)});
+	});
+}
+
+box to_box(const interval_box& x) {
+	box result;
+	for (const auto& b : x) {
+		result.push_back(domain::between(b.lower, b.upper));
+	}
+	return result;
+}
+
+// Processes a box until it is excluded, certified, too narrow, or bisected into two tasks
+template <typename Push>
+void isolate_box(const krawczyk_problem& p, interval_box& x, krawczyk_workspace& ws, Push& push) {
+	while (true) {
+		double width = max_width(x);
+		krawczyk_outcome outcome = krawczyk_step(p, x, ws);
+		if (outcome == krawczyk_outcome::excluded) {
+			return;
+		}
+		if (outcome == krawczyk_outcome::certified) {
+			// The root stays in the intersection of the box with its image, which converges quadratically to it
+			for (size_t k = 0; k < max_contractions && !narrow_enough(x, p.options.tolerance); ++k) {
+				double previous = max_width(x);
+				if (krawczyk_step(p, x, ws) == krawczyk_outcome::excluded || max_width(x) >= previous) {
+					break;
+				}
+			}
+			ws.roots.push_back(to_box(x));
+			return;
+		}
+		if (outcome == krawczyk_outcome::contracted && max_width(x) <= krawczyk_progress * width) {
+			continue;
+		}
+		if (max_width(x) < p.options.min_width) {
+			ws.uncertain.push_back(to_box(x));
+			return;
+		}
+
+		// Bisection along the widest variable
+		size_t widest = std::ranges::max_element(x, {}, &detail::bounds::width) - x.begin();
+		double split = x[widest].lower + bisection_ratio * x[widest].width();
+		interval_box upper = x;
+		x[widest].upper = split;
+		upper[widest].lower = split;
+		push(std::move(x));
+		push(std::move(upper));
+		return;
+	}
+}
+
+// Lexicographic order on the lower bounds
+void sort_boxes(std::vector<box>& boxes) {
+	std::ranges::sort(boxes, [](const box& a, const box& b) {
+		for (size_t i = 0; i < a.size(); ++i) {
+			if (a[i].lower != b[i].lower) {
+				return a[i].lower < b[i].lower;
+			}
+		}
+		return false;
+	});
+}
+
+root_isolation sym::isolate_roots(const std::vector<expression>& functions, const std::vector<symbol>& variables, const box& region, const isolation_options& options) {
+	size_t n = variables.size();
+	if (n == 0 || functions.size() != n || region.size() != n) {
+		throw std::invalid_argument("Root isolation needs as many functions as variables, and a range for each variable.");
+	}
+	interval_box start;
+	for (const auto& d : region) {
+		if (!std::isfinite(d.lower) || !std::isfinite(d.upper) || d.lower > d.upper) {
+			throw std::invalid_argument("Roots are isolated in a finite, non-empty box.");
+		}
+		start.push_back({d.lower, d.upper});
+	}
+
+	// Programs are compiled here : the node manager is not shared between threads
+	krawczyk_problem p{n, {}, {}, {}, options};
+	std::vector<expression> outputs = functions;
+	for (size_t i = 0; i < n; ++i) {
+		std::vector<const detail::node*> symbols = detail::list_symbols(functions[i].root);
+		for (const auto* s : symbols) {
+			if (std::ranges::find(variables, s, &symbol::ref) == variables.end()) {
+				throw std::invalid_argument("The functions depend on symbols which are not variables.");
+			}
+		}
+		for (size_t j = 0; j < n; ++j) {
+			if (std::ranges::find(symbols, variables[j].ref) == symbols.end()) {
+				continue;
+			}
+			expression derivative = differentiate(functions[i], variables[j]);
+			double value;
+			if (detail::numeric_constant(derivative.root, value) && value == 0) {
+				continue;
+			}
+			p.jacobian_pattern.emplace_back(i, j);
+			outputs.push_back(derivative);
+		}
+	}
+	p.functions = compiled_vector_expression(functions, variables);
+	p.functions_and_jacobian = compiled_vector_expression(outputs, variables);
+
+	size_t threads = options.threads == 0 ? std::max(1u, std::thread::hardware_concurrency()) : options.threads;
+	std::vector<krawczyk_workspace> workspaces(threads);
+	detail::run_task_tree(std::vector<interval_box>{start}, threads, [&](interval_box& x, size_t worker, auto& push) {
+		isolate_box(p, x, workspaces[worker], push);
+	});
+
+	root_isolation result;
+	for (auto& ws : workspaces) {
+		result.roots.insert(result.roots.end(), ws.roots.begin(), ws.roots.end());
+		result.uncertain.insert(result.uncertain.end(), ws.uncertain.begin(), ws.uncertain.end());
+	}
+	sort_boxes(result.roots);
+	sort_boxes(result.uncertain);
+	return result;
+}
+
+root_isolation sym::isolate_roots(const expression& f, const symbol& variable, double lower, double upper, const isolation_options& options) {
+	return isolate_roots(std::vector<expression>{f}, std::vector<symbol>{variable}, box{domain::between(lower, upper)}, options);
+}
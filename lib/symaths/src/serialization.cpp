@@ -0,0 +1,647 @@
+#include "symaths/serialization.hpp"
+
+#include "symaths/symaths.hpp"
+#include "symaths/base_functions.hpp"
+#include "symaths/detail/nodes.hpp"
+#include "symaths/utils/maths.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstring>
+#include <format>
+#include <fstream>
+#include <stdexcept>
+#include <unordered_map>
+#include <unordered_set>
+
+
+using namespace sym;
+
+constexpr char serialized_magic[4] = {'S', 'Y', 'M', 'B'};
+constexpr uint32_t serialized_version = 1;
+constexpr size_t serialized_header_size = 48;
+constexpr size_t constant_entry_size = 24;
+constexpr size_t node_entry_size = 16;
+
+// Index of the alternative T of the data of nodes, which the records store as their kind
+template <typename T, size_t I = 0>
+constexpr uint32_t node_kind() {
+	if constexpr (std::is_same_v<std::variant_alternative_t<I, detail::node::internal_data_t>, T>) {
+		return I;
+	}
+	else {
+		return node_kind<T, I + 1>();
+	}
+}
+
+template <typename T>
+T read_le(const char* p) {
+	T v;
+	std::memcpy(&v, p, sizeof(T));
+	if constexpr (std::endian::native == std::endian::big) {
+		v = std::byteswap(v);
+	}
+	return v;
+}
+
+template <typename T>
+void write_le(std::string& out, T v) {
+	if constexpr (std::endian::native == std::endian::big) {
+		v = std::byteswap(v);
+	}
+	out.append(reinterpret_cast<const char*>(&v), sizeof(T));
+}
+
+uint64_t align8(uint64_t n) {
+	return (n + 7) & ~uint64_t{7};
+}
+
+std::vector<const detail::node*> node_children(const detail::node* n) {
+	return std::visit(overloaded {
+		[](const detail::negation& x) { return std::vector{x.child}; },
+		[](const detail::addition& x) { return x.operands; },
+		[](const detail::multiplication& x) { return x.operands; },
+		[](const detail::power& x) { return std::vector{x.base, x.exponent}; },
+		[](const detail::function_call& x) { return x.args; },
+		[](const auto&) { return std::vector<const detail::node*>{}; },
+	}, n->p_data);
+}
+
+
+detail::node_table::node_table(std::string_view bytes) : m_bytes(bytes) {
+	const char* p = bytes.data();
+	if (bytes.size() < serialized_header_size || std::memcmp(p, serialized_magic, sizeof(serialized_magic)) != 0) {
+		throw std::invalid_argument("node_table: the buffer does not hold serialized expressions");
+	}
+	if (uint32_t version = read_le<uint32_t>(p + 4); version != serialized_version) {
+		throw std::invalid_argument(std::format("node_table: unsupported version {}", version));
+	}
+	m_symbols = read_le<uint32_t>(p + 8);
+	m_functions = read_le<uint32_t>(p + 12);
+	m_constants = read_le<uint32_t>(p + 16);
+	m_nodes = read_le<uint32_t>(p + 20);
+	m_children = read_le<uint32_t>(p + 24);
+	m_roots = read_le<uint32_t>(p + 28);
+	uint64_t strings = read_le<uint64_t>(p + 32);
+	uint64_t total = read_le<uint64_t>(p + 40);
+	if (total != bytes.size() || strings > bytes.size()) {
+		throw std::invalid_argument("node_table: the buffer is truncated");
+	}
+
+	// Offsets are checked before pointing into the buffer
+	uint64_t symbols = serialized_header_size;
+	uint64_t functions = symbols + 8ull * m_symbols;
+	uint64_t strings_begin = functions + 8ull * m_functions;
+	uint64_t constants = align8(strings_begin + strings);
+	uint64_t nodes = constants + constant_entry_size * m_constants;
+	uint64_t children = nodes + node_entry_size * m_nodes;
+	uint64_t roots = align8(children + 4ull * m_children);
+	if (align8(roots + 4ull * m_roots) != total) {
+		throw std::invalid_argument("node_table: the buffer is truncated");
+	}
+	m_symbol_entries = p + symbols;
+	m_function_entries = p + functions;
+	m_strings = bytes.substr(strings_begin, strings);
+	m_constant_entries = p + constants;
+	m_node_entries = p + nodes;
+	m_child_entries = p + children;
+	m_root_entries = p + roots;
+}
+
+uint32_t detail::node_table::root(size_t i) const {
+	if (i >= m_roots) {
+		throw std::invalid_argument(std::format("node_table: no expression {}", i));
+	}
+	uint32_t index = read_le<uint32_t>(m_root_entries + 4 * i);
+	if (index >= m_nodes) {
+		throw std::invalid_argument("node_table: invalid root");
+	}
+	return index;
+}
+
+detail::node_record detail::node_table::node(uint32_t index) const {
+	if (index >= m_nodes) {
+		throw std::invalid_argument(std::format("node_table: no node {}", index));
+	}
+	const char* p = m_node_entries + node_entry_size * index;
+	node_record r{read_le<uint32_t>(p), read_le<uint32_t>(p + 4), read_le<uint32_t>(p + 8), read_le<uint32_t>(p + 12)};
+
+	bool valid = static_cast<uint64_t>(r.first_child) + r.children <= m_children;
+	if (r.kind == node_kind<detail::symbol>() || r.kind == node_kind<detail::constant>()) {
+		valid = valid && r.children == 0;
+	}
+	else if (r.kind == node_kind<detail::negation>()) {
+		valid = valid && r.children == 1;
+	}
+	else if (r.kind == node_kind<detail::power>()) {
+		valid = valid && r.children == 2;
+	}
+	else if (r.kind == node_kind<detail::addition>() || r.kind == node_kind<detail::multiplication>()) {
+		valid = valid && r.children != 0;
+	}
+	else {
+		valid = valid && r.kind == node_kind<detail::function_call>();
+	}
+	if (!valid) {
+		throw std::invalid_argument(std::format("node_table: invalid node {}", index));
+	}
+	// Builtins and registered functions all take a fixed amount of arguments
+	if (r.kind == node_kind<detail::function_call>()) {
+		const auto& func = get_func(function(r.payload));
+		if (r.children != func.arity) {
+			throw std::invalid_argument(std::format("node_table: invalid node {}, {} takes {} arguments", index, func.name, func.arity));
+		}
+	}
+	return r;
+}
+
+uint32_t detail::node_table::child(uint32_t index, const node_record& record, size_t k) const {
+	uint32_t c = read_le<uint32_t>(m_child_entries + 4 * (record.first_child + k));
+	if (c >= index) {
+		throw std::invalid_argument(std::format("node_table: node {} does not come after its children", index));
+	}
+	return c;
+}
+
+std::string_view detail::node_table::name(const char* entries, uint32_t i) const {
+	uint32_t offset = read_le<uint32_t>(entries + 8 * i);
+	uint32_t length = read_le<uint32_t>(entries + 8 * i + 4);
+	if (static_cast<uint64_t>(offset) + length > m_strings.size()) {
+		throw std::invalid_argument("node_table: invalid name");
+	}
+	return m_strings.substr(offset, length);
+}
+
+std::string_view detail::node_table::symbol(uint32_t i) const {
+	if (i >= m_symbols) {
+		throw std::invalid_argument(std::format("node_table: no symbol {}", i));
+	}
+	return name(m_symbol_entries, i);
+}
+
+uint32_t detail::node_table::function(uint32_t i) const {
+	if (i >= m_functions) {
+		throw std::invalid_argument(std::format("node_table: no function {}", i));
+	}
+	std::string_view function_name = name(m_function_entries, i);
+	uint32_t id = get_func_id(function_name);
+	if (id == funcs::none) {
+		throw std::invalid_argument(std::format(R"(node_table: unknown function "{}")", function_name));
+	}
+	return id;
+}
+
+number detail::node_table::constant(uint32_t i) const {
+	if (i >= m_constants) {
+		throw std::invalid_argument(std::format("node_table: no constant {}", i));
+	}
+	const char* p = m_constant_entries + constant_entry_size * i;
+	uint32_t rank = read_le<uint32_t>(p);
+	uint64_t a = read_le<uint64_t>(p + 8);
+	uint64_t b = read_le<uint64_t>(p + 16);
+	switch (static_cast<number::rank>(rank)) {
+		case number::rank::Natural: return numbers::natural{a};
+		case number::rank::Integer: return numbers::integer{static_cast<long long>(a)};
+		case number::rank::Rational:
+			if (static_cast<long long>(b) <= 0) {
+				throw std::invalid_argument(std::format("node_table: invalid constant {}", i));
+			}
+			return numbers::rational(static_cast<long long>(a), static_cast<long long>(b));
+		case number::rank::Real: return numbers::real{std::bit_cast<double>(a)};
+		case number::rank::Complex: return numbers::complex{{std::bit_cast<double>(a), std::bit_cast<double>(b)}};
+		case number::rank::NaN: return numbers::nan{};
+	}
+	throw std::invalid_argument(std::format("node_table: invalid constant {}", i));
+}
+
+const detail::node* detail::node_table::intern(node_manager_t& nodes, uint32_t index, std::vector<const detail::node*>& made) const {
+	if (made.at(index)) {
+		return made[index];
+	}
+	node_record r = node(index);
+	std::vector<const detail::node*> children(r.children);
+	for (size_t k = 0; k < r.children; ++k) {
+		children[k] = intern(nodes, child(index, r, k), made);
+	}
+
+	detail::node::internal_data_t data;
+	if (r.kind == node_kind<detail::symbol>()) {
+		data = detail::symbol{std::string(symbol(r.payload))};
+	}
+	else if (r.kind == node_kind<detail::constant>()) {
+		data = detail::constant{constant(r.payload)};
+	}
+	else if (r.kind == node_kind<negation>()) {
+		data = negation{children[0]};
+	}
+	else if (r.kind == node_kind<addition>()) {
+		data = addition{std::move(children)};
+	}
+	else if (r.kind == node_kind<multiplication>()) {
+		data = multiplication{std::move(children)};
+	}
+	else if (r.kind == node_kind<power>()) {
+		data = power{children[0], children[1]};
+	}
+	else {
+		data = function_call{function(r.payload), std::move(children)};
+	}
+	made[index] = nodes.intern(std::move(data));
+	return made[index];
+}
+
+
+// Gathers the nodes to serialize, children first
+struct node_table_writer {
+	std::unordered_map<const detail::node*, uint32_t> index;
+	std::vector<const detail::node*> order;
+
+	void push(const detail::node* n) {
+		index.emplace(n, static_cast<uint32_t>(order.size()));
+		order.push_back(n);
+	}
+
+	// Returns false if the node has missing operands
+	bool add(const detail::node* n) {
+		if (!n) {
+			return false;
+		}
+		if (index.contains(n)) {
+			return true;
+		}
+		for (auto* c : node_children(n)) {
+			if (!add(c)) {
+				return false;
+			}
+		}
+		push(n);
+		return true;
+	}
+
+	[[nodiscard]] std::string write(const std::vector<uint32_t>& roots) const;
+};
+
+void write_constant(std::string& out, const number& value) {
+	uint64_t a = 0;
+	uint64_t b = 0;
+	std::visit(overloaded {
+		[&](const numbers::natural& n) { a = n.val; },
+		[&](const numbers::integer& n) { a = static_cast<uint64_t>(n.val); },
+		[&](const numbers::rational& n) {
+			a = static_cast<uint64_t>(n.num);
+			b = static_cast<uint64_t>(n.den);
+		},
+		[&](const numbers::real& n) { a = std::bit_cast<uint64_t>(n.val); },
+		[&](const numbers::complex& n) {
+			a = std::bit_cast<uint64_t>(n.val.real());
+			b = std::bit_cast<uint64_t>(n.val.imag());
+		},
+		[](const numbers::nan&) {},
+	}, value.p_data);
+	write_le(out, static_cast<uint32_t>(value.p_data.index()));
+	write_le(out, uint32_t{0});
+	write_le(out, a);
+	write_le(out, b);
+}
+
+std::string node_table_writer::write(const std::vector<uint32_t>& roots) const {
+	std::vector<detail::node_record> records;
+	std::vector<uint32_t> children;
+	std::vector<std::string_view> symbols;
+	std::vector<std::string_view> functions;
+	std::unordered_map<uint32_t, uint32_t> function_ids;
+	std::vector<const number*> constants;
+	records.reserve(order.size());
+	for (auto* n : order) {
+		detail::node_record r{static_cast<uint32_t>(n->p_data.index()), 0, static_cast<uint32_t>(children.size()), 0};
+		std::visit(overloaded {
+			// Symbols are interned by name, so their names are all different
+			[&](const detail::symbol& x) {
+				r.payload = static_cast<uint32_t>(symbols.size());
+				symbols.push_back(x.name);
+			},
+			[&](const detail::constant& x) {
+				r.payload = static_cast<uint32_t>(constants.size());
+				constants.push_back(&x.value);
+			},
+			[&](const detail::function_call& x) {
+				auto [it, inserted] = function_ids.emplace(x.f_id, static_cast<uint32_t>(functions.size()));
+				if (inserted) {
+					functions.push_back(detail::get_func(x.f_id).name);
+				}
+				r.payload = it->second;
+			},
+			[](const auto&) {},
+		}, n->p_data);
+		for (auto* c : node_children(n)) {
+			children.push_back(index.at(c));
+		}
+		r.children = static_cast<uint32_t>(children.size()) - r.first_child;
+		records.push_back(r);
+	}
+
+	uint64_t strings = 0;
+	for (auto name : symbols) strings += name.size();
+	for (auto name : functions) strings += name.size();
+
+	std::string out(serialized_magic, sizeof(serialized_magic));
+	write_le(out, serialized_version);
+	for (size_t count : {symbols.size(), functions.size(), constants.size(), records.size(), children.size(), roots.size()}) {
+		write_le(out, static_cast<uint32_t>(count));
+	}
+	write_le(out, strings);
+	// Size of the buffer, written at the end
+	write_le(out, uint64_t{0});
+
+	uint32_t offset = 0;
+	for (const auto* names : {&symbols, &functions}) {
+		for (auto name : *names) {
+			write_le(out, offset);
+			write_le(out, static_cast<uint32_t>(name.size()));
+			offset += static_cast<uint32_t>(name.size());
+		}
+	}
+	for (const auto* names : {&symbols, &functions}) {
+		for (auto name : *names) {
+			out += name;
+		}
+	}
+	out.resize(align8(out.size()), '\0');
+	for (const auto* value : constants) {
+		write_constant(out, *value);
+	}
+	for (const auto& r : records) {
+		write_le(out, r.kind);
+		write_le(out, r.payload);
+		write_le(out, r.first_child);
+		write_le(out, r.children);
+	}
+	for (uint32_t c : children) {
+		write_le(out, c);
+	}
+	out.resize(align8(out.size()), '\0');
+	for (uint32_t r : roots) {
+		write_le(out, r);
+	}
+	out.resize(align8(out.size()), '\0');
+
+	std::string size;
+	write_le(size, static_cast<uint64_t>(out.size()));
+	out.replace(40, size.size(), size);
+	return out;
+}
+
+std::string sym::serialize(const std::vector<expression>& exprs) {
+	node_table_writer writer;
+	std::vector<uint32_t> roots;
+	for (const auto& e : exprs) {
+		if (!writer.add(e.root)) {
+			throw std::invalid_argument("serialize: the expression has missing operands");
+		}
+		roots.push_back(writer.index.at(e.root));
+	}
+	return writer.write(roots);
+}
+
+std::string sym::serialize(const library& lib) {
+	node_table_writer writer;
+	std::unordered_set<const detail::node*> referenced;
+	// The nodes are already ordered children first. Those of failed parses, and their parents, are left out.
+	for (auto* n : lib.node_manager().nodes()) {
+		auto children = node_children(n);
+		if (std::ranges::all_of(children, [&](const detail::node* c) { return writer.index.contains(c); })) {
+			writer.push(n);
+			referenced.insert(children.begin(), children.end());
+		}
+	}
+	std::vector<uint32_t> roots;
+	for (uint32_t i = 0; i < writer.order.size(); ++i) {
+		if (!referenced.contains(writer.order[i])) {
+			roots.push_back(i);
+		}
+	}
+	return writer.write(roots);
+}
+
+std::vector<expression> sym::deserialize(std::string_view bytes) {
+	if (!current_context) {
+		throw std::runtime_error("sym::deserialize: current context is null");
+	}
+	detail::node_table table(bytes);
+	std::vector<const detail::node*> made(table.size());
+	for (uint32_t i = 0; i < table.size(); ++i) {
+		table.intern(current_context->node_manager(), i, made);
+	}
+	std::vector<expression> exprs;
+	exprs.reserve(table.roots());
+	for (size_t i = 0; i < table.roots(); ++i) {
+		exprs.emplace_back(made[table.root(i)]);
+	}
+	return exprs;
+}
+
+void write_serialized(const std::filesystem::path& path, const std::string& bytes) {
+	std::ofstream file(path, std::ios::binary);
+	if (!file || !file.write(bytes.data(), static_cast<std::streamsize>(bytes.size()))) {
+		throw std::runtime_error(std::format(R"(Cannot write "{}".)", path.string()));
+	}
+}
+
+void sym::save_expressions(const std::filesystem::path& path, const std::vector<expression>& exprs) {
+	write_serialized(path, serialize(exprs));
+}
+
+void sym::save_library(const std::filesystem::path& path, const library& lib) {
+	write_serialized(path, serialize(lib));
+}
+
+std::vector<expression> sym::load_expressions(const std::filesystem::path& path) {
+	detail::mapped_file file(path);
+	return deserialize(file.view());
+}
+
+
+sym::mapped_expressions::mapped_expressions(const std::filesystem::path& path) : m_file(path) {
+	// Checks the header
+	(void)table();
+}
+
+size_t sym::mapped_expressions::size() const {
+	return table().roots();
+}
+
+// Emits the instructions of serialized nodes, as compile_node does for nodes. Domains are not inferred.
+struct table_compiler : detail::program_builder {
+	const detail::node_table& table;
+	const std::vector<std::string>& variables;
+};
+
+// Recognizes constants, including negated ones
+bool record_constant(const detail::node_table& table, uint32_t index, double& value) {
+	detail::node_record r = table.node(index);
+	if (r.kind == node_kind<detail::constant>()) {
+		number n = table.constant(r.payload);
+		if (std::holds_alternative<numbers::complex>(n.p_data) || std::holds_alternative<numbers::nan>(n.p_data)) {
+			return false;
+		}
+		value = n.get<double>();
+		return true;
+	}
+	if (r.kind == node_kind<detail::negation>() && record_constant(table, table.child(index, r, 0), value)) {
+		value = -value;
+		return true;
+	}
+	return false;
+}
+
+// Returns the constant integer exponent of a power record, 0 otherwise
+long long record_integer_exponent(const detail::node_table& table, uint32_t index) {
+	detail::node_record r = table.node(index);
+	if (r.kind != node_kind<detail::power>()) {
+		return 0;
+	}
+	double e;
+	if (record_constant(table, table.child(index, r, 1), e) && utils::is_integer(e) && std::abs(e) <= detail::max_powi_exponent) {
+		return static_cast<long long>(std::round(e));
+	}
+	return 0;
+}
+
+void compile_record(uint32_t index, table_compiler& state);
+
+// Emits base^n, then divides the top of the stack by it
+void compile_record_division(uint32_t base, long long n, table_compiler& state) {
+	compile_record(base, state);
+	if (n > 1) {
+		state.emit_powi(n);
+	}
+	state.emit(detail::div, -1);
+}
+
+void compile_record(uint32_t index, table_compiler& state) {
+	const auto& table = state.table;
+	double cst;
+	if (record_constant(table, index, cst)) {
+		state.emit_constant(cst);
+		return;
+	}
+
+	detail::node_record r = table.node(index);
+	auto child = [&](size_t k) { return table.child(index, r, k); };
+	if (r.kind == node_kind<detail::constant>()) {
+		throw std::invalid_argument(std::format("mapped_expressions: cannot compile the constant {}", table.constant(r.payload).string()));
+	}
+
+	else if (r.kind == node_kind<detail::symbol>()) {
+		std::string_view name = table.symbol(r.payload);
+		auto it = std::ranges::find(state.variables, name);
+		if (it == state.variables.end()) {
+			throw std::invalid_argument(std::format(R"(mapped_expressions: unknown variable "{}")", name));
+		}
+		state.emit_variable(it - state.variables.begin());
+	}
+
+	else if (r.kind == node_kind<detail::negation>()) {
+		compile_record(child(0), state);
+		state.emit(detail::neg, 0);
+	}
+
+	else if (r.kind == node_kind<detail::addition>()) {
+		compile_record(child(0), state);
+		for (size_t k = 1; k < r.children; ++k) {
+			uint32_t op = child(k);
+			detail::node_record op_record = table.node(op);
+			if (op_record.kind == node_kind<detail::negation>()) {
+				compile_record(table.child(op, op_record, 0), state);
+				state.emit(detail::sub, -1);
+			}
+			else {
+				compile_record(op, state);
+				state.emit(detail::add, -1);
+			}
+		}
+	}
+
+	else if (r.kind == node_kind<detail::multiplication>()) {
+		// a * b^(-1) * c^(-2) is compiled as (a / b) / c^2
+		std::vector<uint32_t> numerators;
+		std::vector<std::pair<uint32_t, long long>> denominators;
+		for (size_t k = 0; k < r.children; ++k) {
+			uint32_t op = child(k);
+			if (long long n = -record_integer_exponent(table, op); n > 0) {
+				denominators.emplace_back(table.child(op, table.node(op), 0), n);
+			}
+			else {
+				numerators.push_back(op);
+			}
+		}
+
+		if (numerators.empty()) {
+			state.emit_constant(1);
+		}
+		for (size_t i = 0; i < numerators.size(); ++i) {
+			compile_record(numerators[i], state);
+			if (i != 0) {
+				state.emit(detail::mul, -1);
+			}
+		}
+		for (auto [base, n] : denominators) {
+			compile_record_division(base, n, state);
+		}
+	}
+
+	else if (r.kind == node_kind<detail::power>()) {
+		long long n = record_integer_exponent(table, index);
+		if (n < 0) {
+			state.emit_constant(1);
+			compile_record_division(child(0), -n, state);
+			return;
+		}
+		compile_record(child(0), state);
+		if (n > 1) {
+			state.emit_powi(n);
+			return;
+		}
+		compile_record(child(1), state);
+		state.emit(detail::pow, -1);
+	}
+
+	else {
+		uint32_t f_id = table.function(r.payload);
+		// The amount of arguments was checked when reading the record
+		const auto& func = detail::get_func(f_id);
+		for (size_t k = 0; k < r.children; ++k) {
+			compile_record(child(k), state);
+		}
+
+		if (r.children == 1) {
+			switch (f_id) {
+				case funcs::ln: state.emit(detail::ln, 0); return;
+				case funcs::log10: state.emit(detail::log10, 0); return;
+				case funcs::sqrt: state.emit(detail::sqrt, 0); return;
+				default: break;
+			}
+		}
+		state.emit_call(&func, r.children);
+	}
+}
+
+compiled_expression sym::mapped_expressions::compile(size_t i, const std::vector<std::string>& variables) const {
+	detail::node_table t = table();
+	compiled_expression compiled;
+	table_compiler state{{compiled.m_program}, t, variables};
+	compile_record(t.root(i), state);
+	compiled.m_stack_size = state.max_depth;
+	compiled.m_variables_count = variables.size();
+	return compiled;
+}
+
+expression sym::mapped_expressions::load(size_t i) const {
+	if (!current_context) {
+		throw std::runtime_error("sym::mapped_expressions::load: current context is null");
+	}
+	detail::node_table t = table();
+	std::vector<const detail::node*> made(t.size());
+	return t.intern(current_context->node_manager(), t.root(i), made);
+}
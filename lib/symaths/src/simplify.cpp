@@ -0,0 +1,1023 @@
+#include "symaths/expressions_manip.hpp"
+
+#include "symaths/domain.hpp"
+#include "symaths/symaths.hpp"
+#include "symaths/utils/maths.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <optional>
+#include <stdexcept>
+#include <unordered_map>
+#include <unordered_set>
+
+using namespace sym;
+
+/*
+ * Equality saturation : instead of rewriting the expression in place, every form found by the rules is added
+ * to an e-graph, where equivalent expressions share the same e-class. Rules never destroy a form, so their
+ * order does not matter. Once the budget is exhausted, the cheapest expression of the root e-class is extracted.
+ */
+
+using eclass_id = uint32_t;
+
+enum class enode_kind : uint8_t { leaf, neg, add, mul, pow, call };
+
+// Cost of an instruction without operand
+double opcode_cost(detail::opcode op) {
+	detail::instruction ins{};
+	ins.op = op;
+	return detail::instruction_cost(ins);
+}
+
+// An operation whose operands are e-classes. Symbols and constants are leaves pointing to their interned node.
+struct enode {
+	enode_kind kind;
+	uint32_t f_id = 0;
+	const detail::node* leaf = nullptr;
+	std::vector<eclass_id> children;
+
+	bool operator==(const enode&) const = default;
+};
+
+struct enode_hash {
+	size_t operator()(const enode& n) const {
+		size_t h = std::hash<const detail::node*>{}(n.leaf) ^ (static_cast<size_t>(n.kind) << 32 | n.f_id);
+		for (eclass_id c : n.children) {
+			h ^= std::hash<eclass_id>{}(c) + 0x9e3779b9 + (h << 6) + (h >> 2);
+		}
+		return h;
+	}
+};
+
+struct eclass {
+	std::vector<enode> nodes;
+	std::vector<std::pair<enode, eclass_id>> parents;
+	// Set when the class is a known constant
+	std::optional<double> value;
+	// One expression of the class, on which domains are inferred
+	const detail::node* witness = nullptr;
+};
+
+class egraph {
+	node_manager_t& nm;
+	std::vector<eclass_id> uf;
+	std::unordered_map<eclass_id, eclass> m_classes;
+	std::unordered_map<enode, eclass_id, enode_hash> memo;
+	std::unordered_map<const detail::node*, eclass_id> terms;
+	// Classes of known value : 2 and 2.0 are different nodes, but the same class
+	std::unordered_map<double, eclass_id> values;
+	std::vector<eclass_id> pending;
+	size_t m_unions = 0;
+
+public:
+	explicit egraph(node_manager_t& nm) : nm(nm) {}
+
+	eclass_id find(eclass_id id) {
+		while (uf[id] != id) {
+			uf[id] = uf[uf[id]];
+			id = uf[id];
+		}
+		return id;
+	}
+
+	[[nodiscard]] size_t size() const { return memo.size(); }
+	[[nodiscard]] size_t unions() const { return m_unions; }
+
+	std::optional<double> value(eclass_id id) {
+		return m_classes.at(find(id)).value;
+	}
+
+	const detail::node* witness(eclass_id id) {
+		return m_classes.at(find(id)).witness;
+	}
+
+	// Nodes of the given kind in a class. A class holding a symbol or a constant is never decomposed :
+	// the leaf is its simplest form, and rewriting its other forms (x = (x^(-1))^(-1) = ...) never ends.
+	std::vector<enode> nodes(eclass_id id, enode_kind kind) {
+		std::vector<enode> result;
+		if (atomic(id)) {
+			return result;
+		}
+		for (auto& n : m_classes.at(find(id)).nodes) {
+			if (n.kind == kind) {
+				result.push_back(n);
+			}
+		}
+		return result;
+	}
+
+	std::vector<eclass_id> call_args(eclass_id id, funcs::builtin_fn_id f) {
+		std::vector<eclass_id> result;
+		if (atomic(id)) {
+			return result;
+		}
+		for (auto& n : m_classes.at(find(id)).nodes) {
+			if (n.kind == enode_kind::call && n.f_id == f && n.children.size() == 1) {
+				result.push_back(find(n.children[0]));
+			}
+		}
+		return result;
+	}
+
+	// The constant leaf of a class of known value
+	const detail::node* constant_node(eclass_id id) {
+		for (auto& n : m_classes.at(find(id)).nodes) {
+			if (n.kind == enode_kind::leaf && std::holds_alternative<detail::constant>(n.leaf->p_data)) {
+				return n.leaf;
+			}
+		}
+		return nullptr;
+	}
+
+	bool atomic(eclass_id id) {
+		return std::ranges::any_of(m_classes.at(find(id)).nodes, [](const enode& n) { return n.kind == enode_kind::leaf; });
+	}
+
+	std::vector<std::pair<eclass_id, enode>> snapshot() const {
+		std::vector<std::pair<eclass_id, enode>> result;
+		for (auto& [id, c] : m_classes) {
+			for (auto& n : c.nodes) {
+				result.emplace_back(id, n);
+			}
+		}
+		return result;
+	}
+
+	eclass_id add(enode n) {
+		n = canonical(std::move(n));
+		if (auto it = memo.find(n); it != memo.end()) {
+			return find(it->second);
+		}
+
+		auto id = static_cast<eclass_id>(uf.size());
+		uf.push_back(id);
+		eclass& c = m_classes[id];
+		c.witness = build(n, [&](eclass_id child) { return witness(child); });
+		c.value = fold(n);
+		for (eclass_id child : n.children) {
+			m_classes.at(child).parents.emplace_back(n, id);
+		}
+		c.nodes.push_back(n);
+		memo.emplace(n, id);
+
+		if (c.value) {
+			set_value(id, *c.value, n.kind != enode_kind::leaf);
+		}
+		return find(id);
+	}
+
+	eclass_id make(enode_kind kind, std::vector<eclass_id> children, uint32_t f_id = 0) {
+		return add(enode{kind, f_id, nullptr, std::move(children)});
+	}
+
+	eclass_id constant(double v) {
+		number num = numbers::real{v};
+		num.downcast();
+		return add(enode{enode_kind::leaf, 0, nm.make_constant(num), {}});
+	}
+
+	eclass_id add_term(const detail::node* node) {
+		if (auto it = terms.find(node); it != terms.end()) {
+			return find(it->second);
+		}
+
+		eclass_id id = std::visit([&](const auto& x) {
+			using T = std::decay_t<decltype(x)>;
+
+			if constexpr (std::is_same_v<T, detail::negation>) {
+				return make(enode_kind::neg, {add_term(x.child)});
+			}
+			else if constexpr (std::is_same_v<T, detail::addition> || std::is_same_v<T, detail::multiplication>) {
+				std::vector<eclass_id> children;
+				for (auto* op : x.operands) {
+					children.push_back(add_term(op));
+				}
+				return make(std::is_same_v<T, detail::addition> ? enode_kind::add : enode_kind::mul, std::move(children));
+			}
+			else if constexpr (std::is_same_v<T, detail::power>) {
+				return make(enode_kind::pow, {add_term(x.base), add_term(x.exponent)});
+			}
+			else if constexpr (std::is_same_v<T, detail::function_call>) {
+				std::vector<eclass_id> children;
+				for (auto* arg : x.args) {
+					children.push_back(add_term(arg));
+				}
+				return make(enode_kind::call, std::move(children), x.f_id);
+			}
+			return add(enode{enode_kind::leaf, 0, node, {}});
+		}, node->p_data);
+
+		terms.emplace(node, id);
+		return id;
+	}
+
+	bool merge(eclass_id a, eclass_id b) {
+		a = find(a);
+		b = find(b);
+		if (a == b) {
+			return false;
+		}
+		if (m_classes.at(a).parents.size() < m_classes.at(b).parents.size()) {
+			std::swap(a, b);
+		}
+
+		uf[b] = a;
+		eclass other = std::move(m_classes.at(b));
+		m_classes.erase(b);
+
+		eclass& c = m_classes.at(a);
+		c.nodes.append_range(other.nodes);
+		c.parents.append_range(other.parents);
+		if (!c.value) {
+			c.value = other.value;
+		}
+		pending.push_back(a);
+		++m_unions;
+		return true;
+	}
+
+	// Restores the invariants broken by merge : the hash-consing table only holds canonical nodes,
+	// and nodes which became identical share the same class
+	void rebuild() {
+		while (!pending.empty()) {
+			std::vector<eclass_id> todo = std::move(pending);
+			pending.clear();
+			for (auto& id : todo) {
+				id = find(id);
+			}
+			std::ranges::sort(todo);
+			auto [first, last] = std::ranges::unique(todo);
+			todo.erase(first, last);
+
+			for (eclass_id id : todo) {
+				repair(find(id));
+			}
+		}
+
+		for (auto& [id, c] : m_classes) {
+			std::unordered_set<enode, enode_hash> unique;
+			for (auto& n : c.nodes) {
+				unique.insert(canonical(n));
+			}
+			c.nodes.assign(unique.begin(), unique.end());
+		}
+	}
+
+	const detail::node* extract(eclass_id root);
+
+private:
+	enode canonical(enode n) {
+		for (auto& c : n.children) {
+			c = find(c);
+		}
+		if (n.kind == enode_kind::add || n.kind == enode_kind::mul) {
+			std::ranges::sort(n.children);
+		}
+		return n;
+	}
+
+	void set_value(eclass_id id, double v, bool add_leaf) {
+		if (auto it = values.find(v); it != values.end()) {
+			merge(id, it->second);
+		}
+		else {
+			values.emplace(v, id);
+		}
+		if (add_leaf) {
+			merge(id, constant(v));
+		}
+	}
+
+	void repair(eclass_id id) {
+		std::vector<std::pair<enode, eclass_id>> parents = std::move(m_classes.at(id).parents);
+		m_classes.at(id).parents.clear();
+
+		for (auto& [n, p] : parents) {
+			memo.erase(n);
+			n = canonical(std::move(n));
+			memo[n] = find(p);
+		}
+
+		std::unordered_map<enode, eclass_id, enode_hash> unique;
+		for (auto& [n, p] : parents) {
+			if (auto it = unique.find(n); it != unique.end()) {
+				merge(it->second, p);
+			}
+			unique[n] = find(p);
+		}
+
+		auto& c = m_classes.at(find(id));
+		for (auto& [n, p] : unique) {
+			c.parents.emplace_back(n, p);
+		}
+
+		// A parent may have become constant through this class
+		for (auto& [n, p] : unique) {
+			if (m_classes.at(find(p)).value) {
+				continue;
+			}
+			if (auto v = fold(n)) {
+				m_classes.at(find(p)).value = v;
+				set_value(p, *v, true);
+			}
+		}
+	}
+
+	// Folds constant operations, as long as the result stays exact : 1 + 2 becomes 3, but 2^(-1) stays as is.
+	// Like reduce, ground function calls are kept.
+	std::optional<double> fold(const enode& n) {
+		if (n.kind == enode_kind::leaf) {
+			if (auto* c = std::get_if<detail::constant>(&n.leaf->p_data)) {
+				auto rank = number::get_rank(c->value.p_data);
+				if (rank != number::rank::Complex && rank != number::rank::NaN) {
+					return c->value.get<double>();
+				}
+			}
+			return std::nullopt;
+		}
+		if (n.kind == enode_kind::call) {
+			return std::nullopt;
+		}
+
+		std::vector<double> values;
+		bool exact = true;
+		for (eclass_id child : n.children) {
+			auto v = m_classes.at(find(child)).value;
+			if (!v) {
+				return std::nullopt;
+			}
+			values.push_back(*v);
+			exact = exact && utils::is_integer(*v);
+		}
+
+		double result = 0;
+		switch (n.kind) {
+			case enode_kind::neg:
+				result = -values[0];
+				break;
+			case enode_kind::add:
+				for (double v : values) result += v;
+				break;
+			case enode_kind::mul:
+				result = 1;
+				for (double v : values) result *= v;
+				break;
+			case enode_kind::pow:
+				result = std::pow(values[0], values[1]);
+				break;
+			default:
+				return std::nullopt;
+		}
+
+		if (!std::isfinite(result) || (exact && !utils::is_integer(result))) {
+			return std::nullopt;
+		}
+		return result;
+	}
+
+	template<typename F>
+	const detail::node* build(const enode& n, F&& child) {
+		std::vector<const detail::node*> ops;
+		for (eclass_id c : n.children) {
+			ops.push_back(child(c));
+		}
+
+		switch (n.kind) {
+			case enode_kind::neg:
+				return nm.make_negation(ops[0]);
+			case enode_kind::add:
+				return nm.make_add(ops);
+			case enode_kind::mul:
+				return nm.make_mul(ops);
+			case enode_kind::pow:
+				return nm.make_pow(ops[0], ops[1]);
+			case enode_kind::call:
+				return nm.make_func(n.f_id, ops);
+			default:
+				return n.leaf;
+		}
+	}
+
+	// Evaluation cost of the operation alone, consistent with compiled_expression::cost
+	double cost(const enode& n) {
+		switch (n.kind) {
+			case enode_kind::leaf:
+				return 0.5;
+			case enode_kind::neg:
+				return 1;
+			case enode_kind::add:
+			case enode_kind::mul:
+				return static_cast<double>(n.children.size() - 1);
+			case enode_kind::pow: {
+				auto e = value(n.children[1]);
+				if (!e || !utils::is_integer(*e) || std::abs(*e) > 64 || *e == 0) {
+					return opcode_cost(detail::pow);
+				}
+				// The exponent is not pushed on the stack : its leaf cost is given back
+				detail::instruction ins{};
+				ins.op = detail::powi;
+				ins.exponent = std::abs(std::llround(*e));
+				double c = ins.exponent > 1 ? detail::instruction_cost(ins) - 0.5 : 0;
+				return *e < 0 ? c + opcode_cost(detail::div) : c;
+			}
+			case enode_kind::call:
+				return n.f_id < funcs::LEN ? detail::function_cost(static_cast<funcs::builtin_fn_id>(n.f_id)) : 30;
+		}
+		return 0;
+	}
+};
+
+const detail::node* egraph::extract(eclass_id root) {
+	// Bottom-up fixed point : the cost of a class is the cost of its cheapest node
+	std::unordered_map<eclass_id, std::pair<double, const enode*>> best;
+	bool changed = true;
+	while (changed) {
+		changed = false;
+		for (auto& [id, c] : m_classes) {
+			for (auto& n : c.nodes) {
+				double total = cost(n);
+				bool known = true;
+				for (eclass_id child : n.children) {
+					auto it = best.find(find(child));
+					if (it == best.end()) {
+						known = false;
+						break;
+					}
+					total += it->second.first;
+				}
+				if (!known) {
+					continue;
+				}
+
+				auto it = best.find(id);
+				if (it == best.end() || total < it->second.first - 1e-9) {
+					best[id] = {total, &n};
+					changed = true;
+				}
+			}
+		}
+	}
+
+	std::unordered_map<eclass_id, const detail::node*> built;
+	std::function<const detail::node*(eclass_id)> build_class = [&](eclass_id id) {
+		id = find(id);
+		if (auto it = built.find(id); it != built.end()) {
+			return it->second;
+		}
+		const detail::node* result = build(*best.at(id).second, build_class);
+		built.emplace(id, result);
+		return result;
+	};
+	return build_class(root);
+}
+
+
+class saturation_rules {
+	egraph& g;
+	detail::domain_cache_t domains;
+
+	struct addend {
+		double coefficient;
+		eclass_id rest;
+	};
+
+	struct factor_split {
+		eclass_id factor;
+		std::vector<eclass_id> rest;
+	};
+
+public:
+	explicit saturation_rules(egraph& g) : g(g) {}
+
+	void apply(eclass_id id, const enode& n) {
+		switch (n.kind) {
+			case enode_kind::neg:
+				for (auto& m : g.nodes(n.children[0], enode_kind::neg)) {
+					g.merge(id, m.children[0]);
+				}
+				break;
+			case enode_kind::add:
+				collect_like_terms(id, n);
+				pythagorean_identity(id, n);
+				factor_sum(id, n);
+				break;
+			case enode_kind::mul:
+				collect_powers(id, n);
+				break;
+			case enode_kind::pow:
+				rewrite_power(id, n);
+				break;
+			case enode_kind::call:
+				if (n.children.size() == 1) {
+					rewrite_call(id, n);
+				}
+				break;
+			default:
+				break;
+		}
+	}
+
+private:
+	bool proven(eclass_id id, bool (domain::*predicate)() const) {
+		return (detail::infer_domain(g.witness(id), domains).*predicate)();
+	}
+
+	bool has_value(eclass_id id, double v) {
+		auto x = g.value(id);
+		return x && *x == v;
+	}
+
+	eclass_id sum_of(const std::vector<eclass_id>& ops) {
+		if (ops.empty()) {
+			return g.constant(0);
+		}
+		return ops.size() == 1 ? ops.front() : g.make(enode_kind::add, ops);
+	}
+
+	eclass_id product_of(const std::vector<eclass_id>& ops) {
+		if (ops.empty()) {
+			return g.constant(1);
+		}
+		return ops.size() == 1 ? ops.front() : g.make(enode_kind::mul, ops);
+	}
+
+	// k * rest
+	eclass_id scaled(double k, eclass_id rest) {
+		if (k == 1) {
+			return rest;
+		}
+		if (k == -1) {
+			return g.make(enode_kind::neg, {rest});
+		}
+		return g.make(enode_kind::mul, {g.constant(k), rest});
+	}
+
+	// Ways of writing a term as coefficient * rest
+	std::vector<addend> addends(eclass_id c) {
+		std::vector<addend> result{{1, g.find(c)}};
+		for (auto& m : g.nodes(c, enode_kind::neg)) {
+			result.push_back({-1, g.find(m.children[0])});
+		}
+		for (auto& m : g.nodes(c, enode_kind::mul)) {
+			double k = 1;
+			std::vector<eclass_id> others;
+			for (eclass_id op : m.children) {
+				if (auto v = g.value(op)) {
+					k *= *v;
+				}
+				else {
+					others.push_back(op);
+				}
+			}
+			if (!others.empty() && others.size() < m.children.size()) {
+				result.push_back({k, g.find(product_of(others))});
+			}
+		}
+		return result;
+	}
+
+	// ax + bx + c + d = (a + b)x + (c + d)
+	void collect_like_terms(eclass_id id, const enode& n) {
+		double constant = 0;
+		size_t constants = 0;
+		std::vector<std::vector<addend>> options;
+		for (eclass_id op : n.children) {
+			if (auto v = g.value(op)) {
+				constant += *v;
+				++constants;
+			}
+			else {
+				options.push_back(addends(op));
+			}
+		}
+
+		// Amount of terms in which each rest appears
+		std::unordered_map<eclass_id, size_t> counts;
+		for (auto& opts : options) {
+			std::unordered_set<eclass_id> seen;
+			for (auto& a : opts) {
+				if (seen.insert(a.rest).second) {
+					counts[a.rest]++;
+				}
+			}
+		}
+
+		bool changed = constants > 1 || (constants == 1 && constant == 0);
+		std::vector<eclass_id> order;
+		std::unordered_map<eclass_id, double> coefficients;
+		for (auto& opts : options) {
+			const addend* chosen = &opts.front();
+			for (auto& a : opts) {
+				if (counts[a.rest] > counts[chosen->rest]) {
+					chosen = &a;
+				}
+			}
+			changed = changed || counts[chosen->rest] > 1;
+			if (!coefficients.contains(chosen->rest)) {
+				order.push_back(chosen->rest);
+			}
+			coefficients[chosen->rest] += chosen->coefficient;
+		}
+		if (!changed) {
+			return;
+		}
+
+		std::vector<eclass_id> result;
+		for (eclass_id rest : order) {
+			if (double k = coefficients[rest]; k != 0) {
+				result.push_back(scaled(k, rest));
+			}
+		}
+		if (constant != 0) {
+			result.push_back(g.constant(constant));
+		}
+		g.merge(id, sum_of(result));
+	}
+
+	// Arguments a such that c contains f(a)^2
+	std::vector<eclass_id> squared_calls(eclass_id c, funcs::builtin_fn_id f) {
+		std::vector<eclass_id> result;
+		for (auto& m : g.nodes(c, enode_kind::pow)) {
+			if (has_value(m.children[1], 2)) {
+				result.append_range(g.call_args(m.children[0], f));
+			}
+		}
+		return result;
+	}
+
+	// k sin(a)^2 + k cos(a)^2 = k
+	void pythagorean_identity(eclass_id id, const enode& n) {
+		for (size_t i = 0; i < n.children.size(); ++i) {
+			for (auto& a : addends(n.children[i])) {
+				for (eclass_id arg : squared_calls(a.rest, funcs::sin)) {
+					for (size_t j = 0; j < n.children.size(); ++j) {
+						if (j == i) continue;
+
+						for (auto& b : addends(n.children[j])) {
+							if (b.coefficient != a.coefficient || std::ranges::count(squared_calls(b.rest, funcs::cos), arg) == 0) {
+								continue;
+							}
+
+							std::vector<eclass_id> result{g.constant(a.coefficient)};
+							for (size_t k = 0; k < n.children.size(); ++k) {
+								if (k != i && k != j) {
+									result.push_back(n.children[k]);
+								}
+							}
+							g.merge(id, sum_of(result));
+							return;
+						}
+					}
+				}
+			}
+		}
+	}
+
+	// Ways of writing a term as factor * rest
+	std::vector<factor_split> factor_splits(eclass_id c) {
+		std::vector<factor_split> result{{g.find(c), {}}};
+		auto lowered_power = [&](const enode& p, std::vector<eclass_id> rest) {
+			auto e = g.value(p.children[1]);
+			if (e && utils::is_integer(*e) && *e >= 2) {
+				rest.push_back(*e == 2 ? p.children[0] : g.make(enode_kind::pow, {p.children[0], g.constant(*e - 1)}));
+				result.push_back({g.find(p.children[0]), std::move(rest)});
+			}
+		};
+
+		for (auto& p : g.nodes(c, enode_kind::pow)) {
+			lowered_power(p, {});
+		}
+		for (auto& m : g.nodes(c, enode_kind::mul)) {
+			for (size_t i = 0; i < m.children.size(); ++i) {
+				std::vector<eclass_id> others = m.children;
+				others.erase(others.begin() + static_cast<long>(i));
+				result.push_back({g.find(m.children[i]), others});
+				for (auto& p : g.nodes(m.children[i], enode_kind::pow)) {
+					lowered_power(p, others);
+				}
+			}
+		}
+		return result;
+	}
+
+	// ab + ac + d = a(b + c) + d, with the factor shared by the most terms
+	void factor_sum(eclass_id id, const enode& n) {
+		std::vector<std::vector<factor_split>> splits;
+		std::unordered_map<eclass_id, size_t> counts;
+		for (eclass_id op : n.children) {
+			splits.push_back(factor_splits(op));
+			std::unordered_set<eclass_id> seen;
+			for (auto& s : splits.back()) {
+				if (!g.value(s.factor) && seen.insert(s.factor).second) {
+					counts[s.factor]++;
+				}
+			}
+		}
+
+		auto best = std::ranges::max_element(counts, {}, [](const auto& c) { return c.second; });
+		if (best == counts.end() || best->second < 2) {
+			return;
+		}
+		eclass_id factor = best->first;
+
+		std::vector<eclass_id> others, inner;
+		for (size_t i = 0; i < n.children.size(); ++i) {
+			auto it = std::ranges::find_if(splits[i], [&](const auto& s) { return s.factor == factor; });
+			if (it == splits[i].end()) {
+				others.push_back(n.children[i]);
+			}
+			else {
+				inner.push_back(product_of(it->rest));
+			}
+		}
+		others.push_back(g.make(enode_kind::mul, {factor, sum_of(inner)}));
+		g.merge(id, sum_of(others));
+	}
+
+	// x^a * x^b * k * l = (kl) x^(a + b), exp(a) * exp(b) = exp(a + b), sin(a) / cos(a) = tan(a)
+	void collect_powers(eclass_id id, const enode& n) {
+		double k = 1;
+		size_t constants = 0;
+		bool changed = false;
+		std::vector<eclass_id> factors;
+		for (eclass_id op : n.children) {
+			if (auto v = g.value(op)) {
+				k *= *v;
+				++constants;
+				continue;
+			}
+			auto negations = g.nodes(op, enode_kind::neg);
+			if (!negations.empty()) {
+				k = -k;
+				factors.push_back(negations.front().children[0]);
+				changed = true;
+			}
+			else {
+				factors.push_back(op);
+			}
+		}
+		if (k == 0) {
+			g.merge(id, g.constant(0));
+			return;
+		}
+		changed = changed || constants > 1 || (constants == 1 && k == 1);
+
+		// Ways of writing each factor as base^exponent
+		std::vector<std::vector<std::pair<eclass_id, eclass_id>>> options;
+		std::unordered_map<eclass_id, size_t> counts;
+		for (eclass_id f : factors) {
+			auto& opts = options.emplace_back();
+			opts.emplace_back(g.find(f), g.constant(1));
+			for (auto& p : g.nodes(f, enode_kind::pow)) {
+				opts.emplace_back(g.find(p.children[0]), p.children[1]);
+			}
+			std::unordered_set<eclass_id> seen;
+			for (auto& [base, e] : opts) {
+				if (seen.insert(base).second) {
+					counts[base]++;
+				}
+			}
+		}
+
+		std::vector<eclass_id> order;
+		std::unordered_map<eclass_id, std::vector<eclass_id>> exponents;
+		for (auto& opts : options) {
+			auto chosen = opts.front();
+			for (auto& o : opts) {
+				if (counts[o.first] > counts[chosen.first]) {
+					chosen = o;
+				}
+			}
+			if (!exponents.contains(chosen.first)) {
+				order.push_back(chosen.first);
+			}
+			exponents[chosen.first].push_back(chosen.second);
+		}
+
+		std::vector<std::pair<eclass_id, eclass_id>> powers;
+		for (eclass_id base : order) {
+			auto& e = exponents[base];
+			changed = changed || e.size() > 1;
+			powers.emplace_back(base, sum_of(e));
+		}
+
+		// sin(a)^e * cos(a)^(-e) = tan(a)^e
+		for (auto& [base, e] : powers) {
+			auto ev = g.value(e);
+			if (!ev) continue;
+			for (eclass_id arg : g.call_args(base, funcs::sin)) {
+				auto it = std::ranges::find_if(powers, [&](const auto& p) {
+					return has_value(p.second, -*ev) && std::ranges::count(g.call_args(p.first, funcs::cos), arg) > 0;
+				});
+				if (it != powers.end()) {
+					base = g.make(enode_kind::call, {arg}, funcs::tan);
+					it->second = g.constant(0);
+					changed = true;
+					break;
+				}
+			}
+		}
+
+		// exp(a) * exp(b) = exp(a + b)
+		std::vector<eclass_id> result, exp_args;
+		for (auto& [base, e] : powers) {
+			if (has_value(e, 0)) {
+				changed = true;
+				continue;
+			}
+			if (auto args = g.call_args(base, funcs::exp); !args.empty() && has_value(e, 1)) {
+				exp_args.push_back(args.front());
+				continue;
+			}
+			result.push_back(has_value(e, 1) ? base : g.make(enode_kind::pow, {base, e}));
+		}
+		if (exp_args.size() > 1) {
+			changed = true;
+			result.push_back(g.make(enode_kind::call, {sum_of(exp_args)}, funcs::exp));
+		}
+		else if (exp_args.size() == 1) {
+			result.push_back(g.make(enode_kind::call, {exp_args.front()}, funcs::exp));
+		}
+
+		if (!changed) {
+			return;
+		}
+		if (k != 1 && k != -1) {
+			result.push_back(g.constant(std::abs(k)));
+		}
+		eclass_id product = product_of(result);
+		g.merge(id, k < 0 ? g.make(enode_kind::neg, {product}) : product);
+	}
+
+	void rewrite_power(eclass_id id, const enode& n) {
+		eclass_id base = n.children[0];
+		eclass_id exponent = n.children[1];
+		auto e = g.value(exponent);
+
+		if (e == 1.0) {
+			g.merge(id, base);
+			return;
+		}
+		if (e == 0.0 || has_value(base, 1)) {
+			g.merge(id, g.constant(1));
+			return;
+		}
+		if (!e || !utils::is_integer(*e)) {
+			return;
+		}
+
+		// (x^a)^n = x^(an) when a is an integer or x >= 0 : (x^0.5)^2 is not x for x < 0
+		for (auto& p : g.nodes(base, enode_kind::pow)) {
+			auto a = g.value(p.children[1]);
+			if ((a && utils::is_integer(*a)) || proven(p.children[0], &domain::is_non_negative)) {
+				g.merge(id, g.make(enode_kind::pow, {p.children[0], g.make(enode_kind::mul, {p.children[1], exponent})}));
+			}
+		}
+		// (xy)^n = x^n y^n
+		for (auto& m : g.nodes(base, enode_kind::mul)) {
+			std::vector<eclass_id> factors;
+			for (eclass_id op : m.children) {
+				factors.push_back(g.make(enode_kind::pow, {op, exponent}));
+			}
+			g.merge(id, g.make(enode_kind::mul, factors));
+		}
+		// (-x)^n = x^n or -x^n
+		for (auto& m : g.nodes(base, enode_kind::neg)) {
+			eclass_id p = g.make(enode_kind::pow, {m.children[0], exponent});
+			g.merge(id, std::fmod(*e, 2) == 0 ? p : g.make(enode_kind::neg, {p}));
+		}
+		// sqrt(x)^(2k) = x^k when x >= 0
+		if (*e > 0 && std::fmod(*e, 2) == 0) {
+			for (eclass_id arg : g.call_args(base, funcs::sqrt)) {
+				if (proven(arg, &domain::is_non_negative)) {
+					g.merge(id, *e == 2 ? arg : g.make(enode_kind::pow, {arg, g.constant(*e / 2)}));
+				}
+			}
+		}
+	}
+
+	void rewrite_call(eclass_id id, const enode& n) {
+		eclass_id arg = n.children[0];
+
+		// Ground calls are only folded when the result is exact : exp(0) = 1, but exp(1) stays as is
+		if (g.value(arg) && n.f_id < funcs::LEN && g.constant_node(arg)) {
+			number v = detail::get_func(n.f_id).eval({g.constant_node(arg)->eval(nullptr)});
+			auto rank = number::get_rank(v.p_data);
+			if (rank != number::rank::Complex && rank != number::rank::NaN && utils::is_integer(v.get<double>())) {
+				g.merge(id, g.constant(std::round(v.get<double>())));
+			}
+			return;
+		}
+
+		switch (n.f_id) {
+			case funcs::exp:
+				// exp(ln(x)) = x and exp(k ln(x)) = x^k when x > 0
+				for (eclass_id x : g.call_args(arg, funcs::ln)) {
+					if (proven(x, &domain::is_positive)) {
+						g.merge(id, x);
+					}
+				}
+				for (auto& m : g.nodes(arg, enode_kind::mul)) {
+					if (m.children.size() != 2) continue;
+					for (size_t i = 0; i < 2; ++i) {
+						if (!g.value(m.children[i])) continue;
+						for (eclass_id x : g.call_args(m.children[1 - i], funcs::ln)) {
+							if (proven(x, &domain::is_positive)) {
+								g.merge(id, g.make(enode_kind::pow, {x, m.children[i]}));
+							}
+						}
+					}
+				}
+				break;
+
+			case funcs::ln:
+				// ln(exp(x)) = x, and ln(x^k) = k ln(x) when x > 0
+				for (eclass_id x : g.call_args(arg, funcs::exp)) {
+					g.merge(id, x);
+				}
+				for (auto& p : g.nodes(arg, enode_kind::pow)) {
+					if (proven(p.children[0], &domain::is_positive)) {
+						g.merge(id, g.make(enode_kind::mul, {p.children[1], g.make(enode_kind::call, {p.children[0]}, funcs::ln)}));
+					}
+				}
+				break;
+
+			case funcs::sqrt:
+				// sqrt(x^2) = |x|
+				for (auto& p : g.nodes(arg, enode_kind::pow)) {
+					if (has_value(p.children[1], 2)) {
+						g.merge(id, g.make(enode_kind::call, {p.children[0]}, funcs::abs));
+					}
+				}
+				break;
+
+			case funcs::abs:
+				if (proven(arg, &domain::is_non_negative) || !g.call_args(arg, funcs::abs).empty()) {
+					g.merge(id, arg);
+				}
+				for (auto& m : g.nodes(arg, enode_kind::neg)) {
+					g.merge(id, g.make(enode_kind::call, {m.children[0]}, funcs::abs));
+				}
+				break;
+
+			// Odd functions : f(-x) = -f(x)
+			case funcs::sin:
+			case funcs::tan:
+			case funcs::asin:
+			case funcs::atan:
+			case funcs::sinh:
+			case funcs::tanh:
+				for (auto& m : g.nodes(arg, enode_kind::neg)) {
+					g.merge(id, g.make(enode_kind::neg, {g.make(enode_kind::call, {m.children[0]}, n.f_id)}));
+				}
+				break;
+
+			// Even functions : f(-x) = f(x)
+			case funcs::cos:
+			case funcs::cosh:
+				for (auto& m : g.nodes(arg, enode_kind::neg)) {
+					g.merge(id, g.make(enode_kind::call, {m.children[0]}, n.f_id));
+				}
+				break;
+
+			default:
+				break;
+		}
+	}
+};
+
+expression sym::simplify(const expression& expr, const simplify_budget& budget) {
+	if (!current_context) {
+		throw std::runtime_error("sym::simplify: current context is null");
+	}
+	auto start = std::chrono::steady_clock::now();
+
+	egraph g(current_context->node_manager());
+	eclass_id root = g.add_term(expr.root);
+	g.rebuild();
+
+	saturation_rules rules(g);
+	bool exhausted = false;
+	for (size_t i = 0; i < budget.max_iterations && !exhausted; ++i) {
+		size_t nodes = g.size();
+		size_t unions = g.unions();
+
+		for (auto& [id, n] : g.snapshot()) {
+			rules.apply(id, n);
+			if (g.size() > budget.max_nodes || std::chrono::steady_clock::now() - start > budget.timeout) {
+				exhausted = true;
+				break;
+			}
+		}
+		g.rebuild();
+
+		// Saturated : no rule found anything new
+		if (g.size() == nodes && g.unions() == unions) {
+			break;
+		}
+	}
+
+	return sort(g.extract(root));
+}
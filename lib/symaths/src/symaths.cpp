@@ -52,6 +52,65 @@ const sym::refactoring_rules_t& sym::library::refactoring_rules() const {
 	return m_refactoring_rules;
 }
 
+std::unordered_map<const sym::detail::node*, sym::domain>& sym::library::symbol_domains() {
+	return m_symbol_domains;
+}
+
+const std::unordered_map<const sym::detail::node*, sym::domain>& sym::library::symbol_domains() const {
+	return m_symbol_domains;
+}
+
+sym::parse_cache_t& sym::library::parse_cache() {
+	return m_parse_cache;
+}
+
+const sym::parse_cache_t& sym::library::parse_cache() const {
+	return m_parse_cache;
+}
+
+void sym::parse_cache_t::set_capacity(size_t capacity) {
+	m_capacity = capacity;
+	while (m_entries.size() > m_capacity) {
+		m_index.erase(m_entries.back().first);
+		m_entries.pop_back();
+	}
+}
+
+void sym::parse_cache_t::clear() {
+	m_index.clear();
+	m_entries.clear();
+	m_stats = {};
+}
+
+const sym::detail::node* sym::parse_cache_t::find(std::string_view key) {
+	if (m_registered_functions != detail::registered_functions_count()) {
+		m_index.clear();
+		m_entries.clear();
+		m_registered_functions = detail::registered_functions_count();
+	}
+	auto it = m_index.find(key);
+	if (it == m_index.end()) {
+		++m_stats.misses;
+		return nullptr;
+	}
+	++m_stats.hits;
+	m_entries.splice(m_entries.begin(), m_entries, it->second);
+	return it->second->second;
+}
+
+void sym::parse_cache_t::insert(std::string key, const detail::node* root) {
+	if (m_capacity == 0 || m_index.contains(key)) {
+		return;
+	}
+	if (m_entries.size() == m_capacity) {
+		m_index.erase(m_entries.back().first);
+		m_entries.pop_back();
+	}
+	m_entries.emplace_front(std::move(key), root);
+	m_index.emplace(m_entries.front().first, m_entries.begin());
+}
+
+
 const sym::detail::node* sym::make_constant(double val) {
 	if (!current_context) {
 		throw std::runtime_error("sym::make_constant: current context is null");
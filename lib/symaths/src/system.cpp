@@ -0,0 +1,307 @@
+#include "symaths/system.hpp"
+
+#include "symaths/symaths.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <numeric>
+#include <stdexcept>
+#include <unordered_map>
+
+using namespace sym;
+
+// Below this amount of unknowns, dense factorizations are always the fastest
+constexpr size_t sparse_min_size = 32;
+// Armijo condition of the backtracking line search, and shortest step it tries
+constexpr double armijo_slope = 1e-4;
+constexpr double min_newton_step = 1e-10;
+// Levenberg-Marquardt damping : initial value, factors when a step fails or succeeds, and bounds
+constexpr double initial_damping = 1e-3;
+constexpr double damping_increase = 4;
+constexpr double damping_decrease = 1.0 / 3;
+constexpr double min_damping = 1e-12;
+constexpr double max_damping = 1e16;
+
+double max_abs(const std::vector<double>& v, size_t n) {
+	double result = 0;
+	for (size_t i = 0; i < n; ++i) {
+		result = std::max(result, std::abs(v[i]));
+	}
+	return result;
+}
+
+double squared_norm(const std::vector<double>& v, size_t n) {
+	double result = 0;
+	for (size_t i = 0; i < n; ++i) {
+		result += v[i] * v[i];
+	}
+	return result;
+}
+
+system::system(std::vector<equation> equations, std::vector<symbol> unknowns) : m_equations(std::move(equations)), m_unknowns(std::move(unknowns)) {
+	size_t m = m_equations.size(), n = m_unknowns.size();
+	if (n == 0 || m < n) {
+		throw std::invalid_argument("A system needs unknowns, and at least as many equations.");
+	}
+
+	std::vector<symbol> variables = m_unknowns;
+	std::vector<expression> residuals;
+	std::vector<expression> outputs;
+	for (const auto& eq : m_equations) {
+		residuals.push_back(eq.left() - eq.right());
+		for (const auto& s : eq.unknowns()) {
+			if (std::ranges::find(variables, s.ref, &symbol::ref) == variables.end()) {
+				variables.push_back(s);
+				m_parameters.push_back(s);
+			}
+		}
+	}
+	outputs = residuals;
+
+	// Only unknowns which appear in an equation may have a non-zero derivative
+	for (size_t i = 0; i < m; ++i) {
+		std::vector<const detail::node*> symbols = detail::list_symbols(residuals[i].root);
+		for (size_t j = 0; j < n; ++j) {
+			if (std::ranges::find(symbols, m_unknowns[j].ref) == symbols.end()) {
+				continue;
+			}
+			expression derivative = differentiate(residuals[i], m_unknowns[j]);
+			double value;
+			if (detail::numeric_constant(derivative.root, value) && value == 0) {
+				continue;
+			}
+			m_jacobian_pattern.emplace_back(i, j);
+			outputs.push_back(derivative);
+		}
+	}
+	m_residuals = compiled_vector_expression(residuals, variables);
+	m_residuals_and_jacobian = compiled_vector_expression(outputs, variables);
+
+	// The entries of a row of J are contiguous : each pair of them adds to an entry of J^T J
+	std::vector<size_t> row_starts(m + 1, 0);
+	for (auto [i, j] : m_jacobian_pattern) {
+		++row_starts[i + 1];
+	}
+	std::partial_sum(row_starts.begin(), row_starts.end(), row_starts.begin());
+	size_t products = 0;
+	for (size_t i = 0; i < m; ++i) {
+		products += (row_starts[i + 1] - row_starts[i]) * (row_starts[i + 1] - row_starts[i]);
+	}
+	// Otherwise J^T J is dense enough to be built as a dense matrix
+	if (n >= sparse_min_size && products <= n * n / 4) {
+		std::unordered_map<size_t, size_t> index;
+		std::vector<std::vector<std::pair<size_t, size_t>>> sources;
+		auto entry = [&](size_t a, size_t b) {
+			auto [it, inserted] = index.emplace(a * n + b, m_normal_pattern.size());
+			if (inserted) {
+				m_normal_pattern.emplace_back(a, b);
+				sources.emplace_back();
+			}
+			return it->second;
+		};
+		for (size_t j = 0; j < n; ++j) {
+			m_normal_diagonal.push_back(entry(j, j));
+		}
+		for (size_t i = 0; i < m; ++i) {
+			for (size_t a = row_starts[i]; a < row_starts[i + 1]; ++a) {
+				for (size_t b = row_starts[i]; b < row_starts[i + 1]; ++b) {
+					sources[entry(m_jacobian_pattern[a].second, m_jacobian_pattern[b].second)].emplace_back(a, b);
+				}
+			}
+		}
+		m_normal_starts.push_back(0);
+		for (const auto& s : sources) {
+			m_normal_products.insert(m_normal_products.end(), s.begin(), s.end());
+			m_normal_starts.push_back(m_normal_products.size());
+		}
+	}
+}
+
+bool system::is_sparse(size_t n, size_t entries, const system_options& options) const {
+	return n >= sparse_min_size && static_cast<double>(entries) <= options.sparse_density * static_cast<double>(n) * static_cast<double>(n);
+}
+
+// Evaluates the residuals into residuals, and returns the sum of their squares
+double system::evaluate(const std::vector<double>& x, std::vector<double>& residuals, workspace& ws) const {
+	std::ranges::copy(x, ws.values.begin());
+	m_residuals(ws.values.data(), residuals.data(), ws.program);
+	double norm = squared_norm(residuals, m_equations.size());
+	return std::isfinite(norm) ? norm : std::numeric_limits<double>::infinity();
+}
+
+// Evaluates the residuals and the Jacobian at x into ws.outputs
+void system::evaluate_jacobian(const std::vector<double>& x, workspace& ws) const {
+	std::ranges::copy(x, ws.values.begin());
+	m_residuals_and_jacobian(ws.values.data(), ws.outputs.data(), ws.program);
+}
+
+system_result system::newton(std::vector<double>& x, const system_options& options, workspace& ws) const {
+	size_t n = m_unknowns.size();
+	if (m_equations.size() != n) {
+		throw std::invalid_argument("Damped Newton needs as many equations as unknowns.");
+	}
+	bool sparse = is_sparse(n, m_jacobian_pattern.size(), options);
+	system_result result;
+
+	double cost = evaluate(x, ws.residuals, ws);
+	for (; result.iterations < options.max_iterations && max_abs(ws.residuals, n) > options.tolerance; ++result.iterations) {
+		evaluate_jacobian(x, ws);
+		const double* jacobian = ws.outputs.data() + n;
+		bool regular = sparse ? ws.sparse.factorize(n, m_jacobian_pattern, jacobian) : ws.dense.factorize(n, m_jacobian_pattern, jacobian);
+		if (!regular) {
+			break;
+		}
+		for (size_t i = 0; i < n; ++i) {
+			ws.step[i] = -ws.outputs[i];
+		}
+		sparse ? ws.sparse.solve(ws.step.data()) : ws.dense.solve(ws.step.data());
+
+		// Along a Newton step, the sum of squares initially decreases twice as fast as the step grows
+		for (double t = 1;; t /= 2) {
+			if (t < min_newton_step) {
+				result.residual = max_abs(ws.residuals, n);
+				return result;
+			}
+			for (size_t j = 0; j < n; ++j) {
+				ws.trial[j] = x[j] + t * ws.step[j];
+			}
+			double trial_cost = evaluate(ws.trial, ws.trial_residuals, ws);
+			if (trial_cost <= (1 - 2 * armijo_slope * t) * cost) {
+				cost = trial_cost;
+				break;
+			}
+		}
+		x.swap(ws.trial);
+		ws.residuals.swap(ws.trial_residuals);
+	}
+
+	result.residual = max_abs(ws.residuals, n);
+	result.converged = result.residual <= options.tolerance;
+	return result;
+}
+
+system_result system::levenberg_marquardt(std::vector<double>& x, const system_options& options, workspace& ws) const {
+	size_t m = m_equations.size(), n = m_unknowns.size();
+	bool sparse = !m_normal_pattern.empty() && is_sparse(n, m_normal_pattern.size(), options);
+	system_result result;
+	double damping = initial_damping;
+
+	double cost = evaluate(x, ws.residuals, ws);
+	for (; result.iterations < options.max_iterations && max_abs(ws.residuals, m) > options.tolerance; ++result.iterations) {
+		evaluate_jacobian(x, ws);
+		const double* jacobian = ws.outputs.data() + m;
+
+		// Gradient J^T r and normal matrix J^T J
+		std::fill_n(ws.gradient.begin(), n, 0.0);
+		for (size_t k = 0; k < m_jacobian_pattern.size(); ++k) {
+			auto [i, j] = m_jacobian_pattern[k];
+			ws.gradient[j] += jacobian[k] * ws.outputs[i];
+		}
+		// A least squares solution
+		if (max_abs(ws.gradient, n) <= options.tolerance) {
+			result.converged = true;
+			break;
+		}
+		if (sparse) {
+			ws.normal.resize(m_normal_pattern.size());
+			for (size_t k = 0; k < m_normal_pattern.size(); ++k) {
+				double sum = 0;
+				for (size_t p = m_normal_starts[k]; p < m_normal_starts[k + 1]; ++p) {
+					sum += jacobian[m_normal_products[p].first] * jacobian[m_normal_products[p].second];
+				}
+				ws.normal[k] = sum;
+			}
+			for (size_t j = 0; j < n; ++j) {
+				ws.diagonal[j] = ws.normal[m_normal_diagonal[j]];
+			}
+		}
+		else {
+			ws.normal.assign(n * n, 0.0);
+			size_t start = 0;
+			while (start < m_jacobian_pattern.size()) {
+				size_t end = start;
+				while (end < m_jacobian_pattern.size() && m_jacobian_pattern[end].first == m_jacobian_pattern[start].first) {
+					++end;
+				}
+				for (size_t a = start; a < end; ++a) {
+					double* row = ws.normal.data() + m_jacobian_pattern[a].second * n;
+					for (size_t b = start; b < end; ++b) {
+						row[m_jacobian_pattern[b].second] += jacobian[a] * jacobian[b];
+					}
+				}
+				start = end;
+			}
+			for (size_t j = 0; j < n; ++j) {
+				ws.diagonal[j] = ws.normal[j * n + j];
+			}
+		}
+
+		// The damping grows until a step lowers the sum of squares
+		bool improved = false;
+		while (!improved && damping <= max_damping) {
+			// Marquardt's scaling by the diagonal, which makes the step independent of the scale of the unknowns
+			for (size_t j = 0; j < n; ++j) {
+				double d = damping * std::max(ws.diagonal[j], min_damping);
+				if (sparse) {
+					ws.normal[m_normal_diagonal[j]] = ws.diagonal[j] + d;
+				}
+				else {
+					ws.normal[j * n + j] = ws.diagonal[j] + d;
+				}
+				ws.step[j] = -ws.gradient[j];
+			}
+			bool regular = sparse ? ws.sparse.factorize(n, m_normal_pattern, ws.normal.data()) : ws.dense.factorize(n, ws.normal.data());
+			if (regular) {
+				sparse ? ws.sparse.solve(ws.step.data()) : ws.dense.solve(ws.step.data());
+				for (size_t j = 0; j < n; ++j) {
+					ws.trial[j] = x[j] + ws.step[j];
+				}
+				double trial_cost = evaluate(ws.trial, ws.trial_residuals, ws);
+				if (trial_cost < cost) {
+					cost = trial_cost;
+					improved = true;
+					damping = std::max(damping * damping_decrease, min_damping);
+					break;
+				}
+			}
+			damping *= damping_increase;
+		}
+		if (!improved) {
+			break;
+		}
+		x.swap(ws.trial);
+		ws.residuals.swap(ws.trial_residuals);
+	}
+
+	result.residual = max_abs(ws.residuals, m);
+	result.converged = result.converged || result.residual <= options.tolerance;
+	return result;
+}
+
+system_result system::solve(std::vector<double>& x, const std::vector<double>& parameters, const system_options& options) {
+	return solve(x, parameters, options, m_workspace);
+}
+
+system_result system::solve(std::vector<double>& x, const std::vector<double>& parameters, const system_options& options, workspace& ws) const {
+	size_t m = m_equations.size(), n = m_unknowns.size();
+	if (x.size() != n || parameters.size() != m_parameters.size()) {
+		throw std::invalid_argument("Wrong amount of values of the unknowns or of the parameters.");
+	}
+
+	// Values of the program : the unknowns, then the parameters
+	ws.values.resize(n + parameters.size());
+	std::ranges::copy(parameters, ws.values.begin() + static_cast<std::ptrdiff_t>(n));
+	ws.outputs.resize(m_residuals_and_jacobian.size());
+	ws.residuals.resize(m);
+	ws.trial_residuals.resize(m);
+	ws.step.resize(n);
+	ws.trial.resize(n);
+	ws.gradient.resize(n);
+	ws.diagonal.resize(n);
+
+	if (options.method == nonlinear_method::damped_newton) {
+		return newton(x, options, ws);
+	}
+	return levenberg_marquardt(x, options, ws);
+}
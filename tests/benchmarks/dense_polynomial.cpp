@@ -0,0 +1,61 @@
+#include <symaths/polynomial.hpp>
+#include <symaths/symaths.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <format>
+#include <iostream>
+#include <limits>
+#include <vector>
+
+// Evaluates high degree polynomials over a large array of points : dense batch evaluation (Horner over blocks of points),
+// point by point evaluation (Estrin) and the compiled expression of the Horner form
+
+constexpr size_t points = 1 << 20;
+constexpr int runs = 5;
+
+template<typename F>
+double measure(F&& f) {
+	double best = std::numeric_limits<double>::max();
+	for (int r = 0; r < runs; ++r) {
+		auto start = std::chrono::steady_clock::now();
+		f();
+		std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+		best = std::min(best, elapsed.count());
+	}
+	return best;
+}
+
+int main() {
+	sym::library lib;
+	sym::symbol x("x");
+
+	std::vector<double> xs(points), out(points);
+	for (size_t i = 0; i < points; ++i) {
+		xs[i] = -1 + 2.0 * static_cast<double>(i) / points;
+	}
+
+	std::cout << std::format("{:<8} {:>12} {:>12} {:>12} {:>14}\n", "degree", "batch ms", "scalar ms", "compiled ms", "ns per point");
+	for (size_t degree : {8, 32, 128, 512}) {
+		// Coefficients of a fit of cos(4x) on [-1, 1]
+		std::vector<double> coeffs(degree + 1, 0.0);
+		double term = 1;
+		for (size_t k = 0; k <= degree; k += 2) {
+			coeffs[k] = (k / 2 % 2 ? -1 : 1) * term;
+			term *= 16.0 / static_cast<double>((k + 1) * (k + 2));
+		}
+		sym::numeric_polynomial p(coeffs);
+
+		double batch = measure([&] { p.eval_batch(xs.data(), out.data(), points); });
+		double scalar = measure([&] {
+			for (size_t i = 0; i < points; ++i) {
+				out[i] = p.eval(xs[i]);
+			}
+		});
+		sym::compiled_expression c(p.to_expression(x, true), {x});
+		std::vector<const double*> columns = {xs.data()};
+		double compiled = measure([&] { c.eval_batch(columns.data(), out.data(), points); });
+
+		std::cout << std::format("{:<8} {:>12.2f} {:>12.2f} {:>12.2f} {:>14.3f}\n", degree, batch, scalar, compiled, batch * 1e6 / points);
+	}
+}
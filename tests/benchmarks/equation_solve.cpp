@@ -0,0 +1,45 @@
+#include <symaths/equation.hpp>
+#include <symaths/symaths.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <format>
+#include <iostream>
+#include <thread>
+
+// Solves transcendental equations numerically, on one thread and on all of them
+
+int main() {
+	sym::library lib{};
+	sym::symbol x("x");
+	size_t hardware = std::max(1u, std::thread::hardware_concurrency());
+
+	struct test_equation {
+		const char* name;
+		sym::equation eq;
+	};
+	test_equation equations[] = {
+		{"sin(x) = 1/2", {sym::sin(x), 0.5}},
+		{"cos(x) = x/50", {sym::cos(x), x / 50.0}},
+		{"exp(-x^2/100) sin(3x) = 0.1", {sym::exp(-sym::pow(x, 2.0) / 100.0) * sym::sin(3.0 * x), 0.1}},
+	};
+
+	std::cout << std::format("{:<30} {:>8} {:>8} {:>8} {:>12} {:>14} {:>14}\n", "equation", "starts", "threads", "roots", "ms", "roots per s", "starts per s");
+	for (const auto& [name, eq] : equations) {
+		for (size_t starts : {size_t{4096}, size_t{65536}}) {
+			for (size_t threads : {size_t{1}, hardware}) {
+				sym::solve_options options;
+				options.starts = starts;
+				options.threads = threads;
+
+				auto start = std::chrono::steady_clock::now();
+				auto roots = eq.solve(options);
+				std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+
+				double seconds = elapsed.count() / 1e3;
+				std::cout << std::format("{:<30} {:>8} {:>8} {:>8} {:>12.2f} {:>14.0f} {:>14.0f}\n", name, starts, threads, roots.size(), elapsed.count(), static_cast<double>(roots.size()) / seconds, static_cast<double>(starts) / seconds);
+			}
+		}
+	}
+}
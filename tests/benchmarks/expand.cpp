@@ -0,0 +1,54 @@
+#include <symaths/symaths.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <format>
+#include <iostream>
+#include <limits>
+#include <string>
+#include <vector>
+
+// Expands products of dense multivariate polynomials (Fateman's benchmark : f * (f + 1) with f = (1 + x + y + z + t)^n),
+// with and without a term budget
+
+constexpr int runs = 3;
+
+size_t terms_count(const sym::expression& expr) {
+	if (auto* sum = std::get_if<sym::detail::addition>(&expr.root->p_data)) {
+		return sum->operands.size();
+	}
+	return 1;
+}
+
+int main() {
+	sym::library lib;
+	sym::symbol x("x");
+	sym::symbol y("y");
+	sym::symbol z("z");
+	sym::symbol t("t");
+
+	std::cout << std::format("{:<6} {:>12} {:>12} {:>12}\n", "n", "f terms", "terms", "ms");
+	for (double n : {4.0, 6.0, 8.0, 10.0}) {
+		sym::expression f = sym::pow(1.0 + x + y + z + t, n);
+		sym::expression product = f * (f + 1.0);
+
+		double best = std::numeric_limits<double>::max();
+		sym::expression result = product;
+		for (int r = 0; r < runs; ++r) {
+			auto start = std::chrono::steady_clock::now();
+			result = sym::expand(product);
+			std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+			best = std::min(best, elapsed.count());
+		}
+		std::cout << std::format("{:<6} {:>12} {:>12} {:>12.2f}\n", n, terms_count(sym::expand(f)), terms_count(result), best);
+	}
+
+	// Over the budget, the expansion stops as soon as a product has too many terms and keeps it partially expanded
+	sym::expression f = sym::pow(1.0 + x + y + z + t, 10.0);
+	for (size_t budget : {1000, 2000, 100000}) {
+		auto start = std::chrono::steady_clock::now();
+		sym::expression result = sym::expand(f * (f + 1.0), budget);
+		std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+		std::cout << std::format("budget {:>8} : {:>8} terms, {:.2f} ms\n", budget, terms_count(result), elapsed.count());
+	}
+}
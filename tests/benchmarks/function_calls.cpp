@@ -0,0 +1,66 @@
+#include <symaths/symaths.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <format>
+#include <iostream>
+#include <limits>
+#include <string_view>
+#include <vector>
+
+// Looks functions up by name, and evaluates calls to builtin and registered functions in batches
+
+constexpr size_t lookups = 1000000;
+constexpr size_t points = 1000000;
+constexpr int runs = 5;
+
+template <typename F>
+double best_of(F&& f) {
+	double best = std::numeric_limits<double>::max();
+	for (int r = 0; r < runs; ++r) {
+		auto start = std::chrono::steady_clock::now();
+		f();
+		std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+		best = std::min(best, elapsed.count());
+	}
+	return best;
+}
+
+int main() {
+	sym::library lib{};
+	sym::register_function("softplus", 1, [](const double* a) { return std::log1p(std::exp(a[0])); },
+		[](const double* const* args, double* out, size_t count) {
+			for (size_t i = 0; i < count; ++i) {
+				out[i] = std::log1p(std::exp(args[0][i]));
+			}
+		});
+
+	std::vector<std::string_view> names = {"x", "sin", "omega", "tanh", "abs", "k1", "log10", "softplus"};
+	size_t found = 0;
+	double lookup_ms = best_of([&] {
+		found = 0;
+		for (size_t i = 0; i < lookups; ++i) {
+			found += sym::detail::get_func_id(names[i % names.size()]) != sym::funcs::none;
+		}
+	});
+
+	sym::symbol x("x");
+	sym::symbol y("y");
+	std::vector<double> xs(points), ys(points), out(points);
+	for (size_t i = 0; i < points; ++i) {
+		xs[i] = 0.5 + static_cast<double>(i % 1000) / 1000;
+		ys[i] = static_cast<double>(i % 777) / 777;
+	}
+	const double* columns[] = {xs.data(), ys.data()};
+
+	sym::compiled_expression builtins(sym::sin(x) * sym::cos(y) + sym::exp(-x) + sym::atan(x * y), {x, y});
+	double builtin_ms = best_of([&] { builtins.eval_batch(columns, out.data(), points); });
+	sym::compiled_expression registered(sym::parse("softplus(x) * y + softplus(y)"), {x, y});
+	double registered_ms = best_of([&] { registered.eval_batch(columns, out.data(), points); });
+
+	std::cout << std::format("{:<12} {:>10} {:>10} {:>14}\n", "step", "count", "ms", "ns/item");
+	std::cout << std::format("{:<12} {:>10} {:>10.2f} {:>14.2f}\n", "lookup", found, lookup_ms, lookup_ms * 1e6 / lookups);
+	std::cout << std::format("{:<12} {:>10} {:>10.2f} {:>14.2f}\n", "builtins", points, builtin_ms, builtin_ms * 1e6 / points);
+	std::cout << std::format("{:<12} {:>10} {:>10.2f} {:>14.2f}\n", "registered", points, registered_ms, registered_ms * 1e6 / points);
+}
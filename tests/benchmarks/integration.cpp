@@ -0,0 +1,66 @@
+#include <symaths/integration.hpp>
+#include <symaths/symaths.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <format>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Adaptive quadrature on one thread and on all of them, against evaluating the integrand one point at a time
+
+constexpr size_t scalar_points = 200000;
+
+int main() {
+	sym::library lib{};
+	sym::symbol x("x"), y("y"), z("z");
+	size_t hardware = std::max(1u, std::thread::hardware_concurrency());
+
+	struct test_integral {
+		const char* name;
+		sym::expression f;
+		std::vector<sym::symbol> variables;
+		sym::box region;
+		double tolerance;
+	};
+	test_integral integrals[] = {
+		{"sin(50x) exp(-x) on [0;10]", sym::sin(50.0 * x) * sym::exp(-x), {x}, {sym::domain::between(0, 10)}, 1e-10},
+		{"1/(1e-6 + (x-1/3)^2) on [0;1]", 1.0 / (1e-6 + sym::pow(x - 1.0 / 3, 2.0)), {x}, {sym::domain::between(0, 1)}, 1e-10},
+		{"exp(-x^2-y^2) on R^2", sym::exp(-(sym::pow(x, 2.0) + sym::pow(y, 2.0))), {x, y}, {sym::domain::real(), sym::domain::real()}, 1e-8},
+		{"cos(x+2y+3z) on [0;4]^3", sym::cos(x + 2.0 * y + 3.0 * z), {x, y, z}, {sym::domain::between(0, 4), sym::domain::between(0, 4), sym::domain::between(0, 4)}, 1e-6},
+	};
+
+	std::cout << std::format("{:<32} {:>8} {:>12} {:>10} {:>10} {:>14} {:>18}\n", "integral", "threads", "evaluations", "error", "ms", "evals per s", "pointwise ms");
+	for (const auto& [name, f, variables, region, tolerance] : integrals) {
+		// Time of the same amount of evaluations one point at a time, extrapolated from a sample
+		sym::compiled_expression program(f, variables);
+		std::vector<double> point(variables.size());
+		double sum = 0;
+		auto start = std::chrono::steady_clock::now();
+		for (size_t i = 0; i < scalar_points; ++i) {
+			std::ranges::fill(point, 0.5 + 1e-5 * static_cast<double>(i));
+			sum += program(point);
+		}
+		std::chrono::duration<double, std::milli> sample = std::chrono::steady_clock::now() - start;
+		if (!std::isfinite(sum)) {
+			std::cout << std::format("{} is not finite on the sample\n", name);
+		}
+		double per_point = sample.count() / scalar_points;
+
+		for (size_t threads : {size_t{1}, hardware}) {
+			sym::integration_options options;
+			options.threads = threads;
+			options.tolerance = tolerance;
+
+			start = std::chrono::steady_clock::now();
+			auto result = sym::integrate(f, variables, region, options);
+			std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+
+			double evaluations = static_cast<double>(result.evaluations);
+			std::cout << std::format("{:<32} {:>8} {:>12} {:>10.1e} {:>10.2f} {:>14.0f} {:>18.2f}\n", name, threads, result.evaluations, result.error, elapsed.count(), evaluations / (elapsed.count() / 1e3), evaluations * per_point);
+		}
+	}
+}
@@ -0,0 +1,68 @@
+#include <symaths/ode.hpp>
+#include <symaths/symaths.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <format>
+#include <iostream>
+#include <numeric>
+#include <thread>
+#include <vector>
+
+// Integrates many trajectories at once, against one solve per trajectory
+
+constexpr size_t trajectories = 4096;
+
+int main() {
+	sym::library lib{};
+	sym::symbol t("t"), x("x"), y("y"), a("a"), mu("mu");
+	size_t hardware = std::max(1u, std::thread::hardware_concurrency());
+
+	struct test_system {
+		const char* name;
+		sym::ode_system system;
+		sym::ode_method method;
+		double end;
+		std::vector<double> initial;
+		double first_parameter;
+		double parameter_step;
+	};
+	test_system systems[] = {
+		{"Lotka-Volterra, Dormand-Prince", {{a * x - x * y, x * y - y}, {x, y}, t, {a}}, sym::ode_method::dormand_prince, 20, {1, 0.5}, 0.5, 1e-3},
+		{"forced pendulum, Dormand-Prince", {{y, -sym::sin(x) - a * y + sym::cos(t)}, {x, y}, t, {a}}, sym::ode_method::dormand_prince, 20, {0.1, 0}, 0.05, 1e-4},
+		{"Van der Pol (stiff), Rosenbrock", {{y, mu * (1.0 - sym::pow(x, 2.0)) * y - x}, {x, y}, t, {mu}}, sym::ode_method::rosenbrock, 20, {2, 0}, 100, 0.1},
+	};
+
+	std::cout << std::format("{:<34} {:>8} {:>8} {:>10} {:>12} {:>16}\n", "system", "mode", "threads", "steps", "ms", "trajectories/s");
+	for (const auto& [name, system, method, end, initial, first_parameter, parameter_step] : systems) {
+		std::vector<double> states, parameters;
+		for (size_t j = 0; j < trajectories; ++j) {
+			states.insert(states.end(), initial.begin(), initial.end());
+			parameters.push_back(first_parameter + parameter_step * static_cast<double>(j));
+		}
+		sym::ode_options options;
+		options.method = method;
+		options.relative_tolerance = 1e-6;
+		options.absolute_tolerance = 1e-9;
+
+		auto report = [&](const char* mode, size_t threads, size_t steps, std::chrono::duration<double, std::milli> elapsed) {
+			std::cout << std::format("{:<34} {:>8} {:>8} {:>10} {:>12.2f} {:>16.0f}\n", name, mode, threads, steps, elapsed.count(), static_cast<double>(trajectories) / (elapsed.count() / 1e3));
+		};
+
+		for (size_t threads : {size_t{1}, hardware}) {
+			options.threads = threads;
+			auto start = std::chrono::steady_clock::now();
+			auto result = system.solve({0, end}, states, parameters, options);
+			report("batch", threads, std::accumulate(result.steps.begin(), result.steps.end(), size_t{0}), std::chrono::steady_clock::now() - start);
+		}
+
+		options.threads = 1;
+		size_t steps = 0;
+		auto start = std::chrono::steady_clock::now();
+		for (size_t j = 0; j < trajectories; ++j) {
+			auto result = system.solve({0, end}, initial, {parameters[j]}, options);
+			steps += result.steps[0];
+		}
+		report("single", 1, steps, std::chrono::steady_clock::now() - start);
+	}
+}
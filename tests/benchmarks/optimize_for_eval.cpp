@@ -0,0 +1,63 @@
+#include <symaths/symaths.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <format>
+#include <iostream>
+#include <limits>
+#include <string>
+#include <vector>
+
+// Compares the cost estimate and the measured batch evaluation time of expressions before and after optimize_for_eval
+
+constexpr size_t points = 1 << 20;
+constexpr int runs = 5;
+
+double measure(const sym::compiled_expression& c, const std::vector<const double*>& columns, std::vector<double>& out) {
+	double best = std::numeric_limits<double>::max();
+	for (int r = 0; r < runs; ++r) {
+		auto start = std::chrono::steady_clock::now();
+		c.eval_batch(columns.data(), out.data(), points);
+		std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+		best = std::min(best, elapsed.count());
+	}
+	return best;
+}
+
+int main() {
+	sym::library lib;
+	sym::symbol x("x");
+	sym::symbol y("y");
+	sym::symbol z("z");
+
+	std::vector<std::pair<std::string, sym::expression>> cases = {
+		{"dense polynomial (degree 8)", 2 * sym::pow(x, 8) - 3 * sym::pow(x, 7) + sym::pow(x, 6) + 5 * sym::pow(x, 5)
+			- sym::pow(x, 4) + 7 * sym::pow(x, 3) - 2 * sym::pow(x, 2) + x - 9},
+		{"bivariate polynomial", sym::pow(x, 3) * sym::pow(y, 2) + 3 * sym::pow(x, 2) * sym::pow(y, 2) - x * sym::pow(y, 2)
+			+ 4 * sym::pow(x, 2) * y + x * y + 2},
+		{"exponentials", sym::exp(x) * sym::exp(2 * y) * sym::exp(-z)},
+		{"reciprocals", x / y / z / (x + 2)},
+		{"common factors", x * y * z + x * y * sym::sin(z) + x * y * sym::cos(z) + x},
+	};
+
+	std::vector<double> xs(points), ys(points), zs(points), out(points);
+	for (size_t i = 0; i < points; ++i) {
+		xs[i] = 0.5 + 1e-6 * static_cast<double>(i);
+		ys[i] = 1.5 - 1e-6 * static_cast<double>(i);
+		zs[i] = 0.25 + 2e-6 * static_cast<double>(i);
+	}
+	std::vector<const double*> columns = {xs.data(), ys.data(), zs.data()};
+
+	std::cout << std::format("{:<30} {:>10} {:>10} {:>10} {:>10} {:>10} {:>10}\n",
+		"case", "cost", "opt cost", "est. x", "ms", "opt ms", "meas. x");
+	for (auto& [name, expr] : cases) {
+		sym::expression opt = sym::optimize_for_eval(expr);
+		sym::compiled_expression before(expr, {x, y, z});
+		sym::compiled_expression after(opt, {x, y, z});
+
+		double t0 = measure(before, columns, out);
+		double t1 = measure(after, columns, out);
+		std::cout << std::format("{:<30} {:>10.1f} {:>10.1f} {:>10.2f} {:>10.2f} {:>10.2f} {:>10.2f}\n",
+			name, before.cost(), after.cost(), before.cost() / after.cost(), t0, t1, t0 / t1);
+	}
+}
@@ -0,0 +1,44 @@
+#include <symaths/symaths.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <format>
+#include <iostream>
+#include <limits>
+#include <string>
+#include <thread>
+
+// Parses a file-sized batch of model lines into a fresh library with 1 to N threads
+
+constexpr size_t lines = 200000;
+constexpr int runs = 3;
+
+int main() {
+	std::string input;
+	for (size_t i = 0; i < lines; ++i) {
+		input += std::format("{} * exp(-k{} * t) + sin(omega * t + {}) / (1 + x{}^2) - sqrt(a * b{} + 12)\n", i % 97 + 1, i % 13, i % 7, i % 5, i % 11);
+	}
+
+	size_t max_threads = std::max(4u, std::thread::hardware_concurrency());
+	std::cout << std::format("{:<10} {:>10} {:>12} {:>10}\n", "threads", "ms", "lines/s", "speedup");
+	double serial_ms = 0;
+	for (size_t threads = 1; threads <= max_threads; threads *= 2) {
+		double best = std::numeric_limits<double>::max();
+		for (int r = 0; r < runs; ++r) {
+			sym::library lib{};
+			sym::make_context_current(lib);
+			auto start = std::chrono::steady_clock::now();
+			sym::parse_many_result result = sym::parse_many(input, threads);
+			std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+			best = std::min(best, elapsed.count());
+			if (result.expressions.size() != lines) {
+				std::cerr << "Unexpected parsing errors\n";
+				return 1;
+			}
+		}
+		if (threads == 1) {
+			serial_ms = best;
+		}
+		std::cout << std::format("{:<10} {:>10.2f} {:>12.0f} {:>10.2f}\n", threads, best, lines / best * 1e3, serial_ms / best);
+	}
+}
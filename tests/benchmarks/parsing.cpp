@@ -0,0 +1,98 @@
+#include <symaths/symaths.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <format>
+#include <iostream>
+#include <limits>
+#include <string>
+#include <vector>
+
+// Tokenizes and parses a batch of model strings, parses a workload repeating some of them with and without the parse
+// cache, then parses and evaluates them once through the DAG or straight to bytecode
+
+constexpr size_t models = 20000;
+// Distinct models in the repeated workload
+constexpr size_t distinct = 500;
+constexpr int runs = 5;
+
+template <typename F>
+double best_of(F&& f) {
+	double best = std::numeric_limits<double>::max();
+	for (int r = 0; r < runs; ++r) {
+		auto start = std::chrono::steady_clock::now();
+		f();
+		std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+		best = std::min(best, elapsed.count());
+	}
+	return best;
+}
+
+int main() {
+	sym::library lib{};
+
+	std::vector<std::string> inputs;
+	size_t bytes = 0;
+	for (size_t i = 0; i < models; ++i) {
+		inputs.push_back(std::format("{} * exp(-k{} * t) + sin(omega * t + {}) / (1 + x{}^2) - sqrt(a * b{} + 12)", i % 97 + 1, i % 13, i % 7, i % 5, i % 11));
+		bytes += inputs.back().size();
+	}
+
+	size_t tokens = 0;
+	double lex_ms = best_of([&] {
+		sym::lexer lexer;
+		tokens = 0;
+		for (const auto& input : inputs) {
+			lexer.tokenize(input);
+			tokens += lexer.tokens().size();
+		}
+	});
+	double parse_ms = best_of([&] {
+		for (const auto& input : inputs) {
+			sym::expression e = sym::parse(input);
+		}
+	});
+
+	double repeated_ms = best_of([&] {
+		for (size_t i = 0; i < models; ++i) {
+			sym::expression e = sym::parse(inputs[i % distinct]);
+		}
+	});
+	lib.parse_cache().set_capacity(2 * distinct);
+	double cached_ms = best_of([&] {
+		for (size_t i = 0; i < models; ++i) {
+			sym::expression e = sym::parse(inputs[i % distinct]);
+		}
+	});
+	lib.parse_cache().set_capacity(0);
+
+	// Parse, compile and evaluate each model once, with and without the expression DAG
+	std::vector<std::string> names = {"t", "omega", "a"};
+	for (int i = 0; i < 13; ++i) {
+		names.push_back(std::format("k{}", i));
+		names.push_back(std::format("x{}", i));
+		names.push_back(std::format("b{}", i));
+	}
+	std::vector<sym::symbol> variables(names.begin(), names.end());
+	std::vector<double> values(names.size(), 0.5);
+	double sum = 0;
+	double dag_ms = best_of([&] {
+		for (const auto& input : inputs) {
+			sum += sym::compiled_expression(sym::parse(input), variables)(values);
+		}
+	});
+	double bytecode_ms = best_of([&] {
+		for (const auto& input : inputs) {
+			sum += sym::parse_compiled(input, names)(values);
+		}
+	});
+
+	std::cout << std::format("{:<10} {:>10} {:>12} {:>10} {:>12} {:>14}\n", "step", "models", "tokens", "ms", "MB/s", "models/s");
+	std::cout << std::format("{:<10} {:>10} {:>12} {:>10.2f} {:>12.1f} {:>14.0f}\n", "tokenize", models, tokens, lex_ms, static_cast<double>(bytes) / lex_ms / 1e3, models / lex_ms * 1e3);
+	std::cout << std::format("{:<10} {:>10} {:>12} {:>10.2f} {:>12.1f} {:>14.0f}\n", "parse", models, tokens, parse_ms, static_cast<double>(bytes) / parse_ms / 1e3, models / parse_ms * 1e3);
+	std::cout << std::format("{:<10} {:>10} {:>12} {:>10.2f} {:>12.1f} {:>14.0f}\n", "repeated", models, tokens, repeated_ms, static_cast<double>(bytes) / repeated_ms / 1e3, models / repeated_ms * 1e3);
+	std::cout << std::format("{:<10} {:>10} {:>12} {:>10.2f} {:>12.1f} {:>14.0f}\n", "cached", models, tokens, cached_ms, static_cast<double>(bytes) / cached_ms / 1e3, models / cached_ms * 1e3);
+	std::cout << std::format("{:<10} {:>10} {:>12} {:>10.2f} {:>12.1f} {:>14.0f}\n", "dag eval", models, tokens, dag_ms, static_cast<double>(bytes) / dag_ms / 1e3, models / dag_ms * 1e3);
+	std::cout << std::format("{:<10} {:>10} {:>12} {:>10.2f} {:>12.1f} {:>14.0f}\n", "bytecode", models, tokens, bytecode_ms, static_cast<double>(bytes) / bytecode_ms / 1e3, models / bytecode_ms * 1e3);
+	std::cout << std::format("checksum {}\n", sum);
+}
@@ -0,0 +1,52 @@
+#include <symaths/detail/polynomial_kernels.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <format>
+#include <iostream>
+#include <limits>
+#include <vector>
+
+// Times each multiplication kernel around their crossover sizes (karatsuba_threshold and fft_threshold)
+
+template<typename F>
+double measure(F&& f) {
+	double best = std::numeric_limits<double>::max();
+	size_t repeats = 1;
+	// Repeats small products so that each measure lasts long enough
+	for (int r = 0; r < 5; ++r) {
+		auto start = std::chrono::steady_clock::now();
+		for (size_t i = 0; i < repeats; ++i) {
+			f();
+		}
+		std::chrono::duration<double, std::micro> elapsed = std::chrono::steady_clock::now() - start;
+		best = std::min(best, elapsed.count() / static_cast<double>(repeats));
+		if (elapsed.count() < 10000) {
+			repeats *= 4;
+		}
+	}
+	return best;
+}
+
+int main() {
+	std::cout << std::format("karatsuba threshold : {}, fft threshold : {}\n", sym::detail::karatsuba_threshold, sym::detail::fft_threshold);
+	std::cout << std::format("{:<8} {:>14} {:>14} {:>14} {:>14}\n", "size", "schoolbook us", "karatsuba us", "fft us", "ntt us");
+
+	for (size_t n : {8, 16, 32, 64, 128, 256, 512, 1024, 4096, 10000}) {
+		std::vector<double> a(n), b(n);
+		std::vector<long long> ia(n), ib(n);
+		for (size_t i = 0; i < n; ++i) {
+			a[i] = std::sin(static_cast<double>(i));
+			b[i] = std::cos(static_cast<double>(i));
+			ia[i] = static_cast<long long>(i * 7919 % 2001) - 1000;
+			ib[i] = static_cast<long long>(i * 104729 % 1999) - 999;
+		}
+
+		double schoolbook = n <= 4096 ? measure([&] { return sym::detail::multiply_schoolbook(a, b); }) : NAN;
+		double karatsuba = measure([&] { return sym::detail::multiply_karatsuba(a, b); });
+		double fft = measure([&] { return sym::detail::multiply_fft(a, b); });
+		double ntt = measure([&] { return sym::detail::multiply_ntt(ia, ib); });
+		std::cout << std::format("{:<8} {:>14.2f} {:>14.2f} {:>14.2f} {:>14.2f}\n", n, schoolbook, karatsuba, fft, ntt);
+	}
+}
@@ -0,0 +1,52 @@
+#include <symaths/polynomial.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <format>
+#include <iostream>
+#include <random>
+#include <thread>
+#include <vector>
+
+// Finds the roots of batches of random polynomials, on one thread and on all of them
+
+constexpr size_t polynomials = 2000;
+
+int main() {
+	std::mt19937_64 rng(42);
+	std::uniform_real_distribution<double> coefficient(-1, 1);
+	size_t hardware = std::max(1u, std::thread::hardware_concurrency());
+
+	std::cout << std::format("{:<8} {:>10} {:>14} {:>14} {:>14}\n", "degree", "threads", "ms", "roots per s", "max residual");
+	for (size_t degree : {10, 50, 200}) {
+		std::vector<sym::numeric_polynomial> batch;
+		for (size_t i = 0; i < polynomials; ++i) {
+			std::vector<double> coeffs(degree + 1);
+			std::ranges::generate(coeffs, [&] { return coefficient(rng); });
+			batch.emplace_back(coeffs);
+		}
+
+		for (size_t threads : {size_t{1}, hardware}) {
+			auto start = std::chrono::steady_clock::now();
+			auto roots = sym::find_roots(batch, threads);
+			std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+
+			// |p(z)| relative to the sum of |c_k| |z|^k
+			double residual = 0;
+			for (size_t p = 0; p < batch.size(); ++p) {
+				for (auto z : roots[p]) {
+					std::complex<double> v = 0;
+					double bound = 0;
+					for (size_t k = degree + 1; k-- > 0;) {
+						v = v * z + batch[p].coeffs[k];
+						bound = bound * std::abs(z) + std::abs(batch[p].coeffs[k]);
+					}
+					residual = std::max(residual, std::abs(v) / bound);
+				}
+			}
+
+			double count = static_cast<double>(polynomials * degree);
+			std::cout << std::format("{:<8} {:>10} {:>14.2f} {:>14.0f} {:>14.2e}\n", degree, threads, elapsed.count(), count / elapsed.count() * 1e3, residual);
+		}
+	}
+}
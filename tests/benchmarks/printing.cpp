@@ -0,0 +1,60 @@
+#include <symaths/symaths.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <format>
+#include <iostream>
+#include <limits>
+#include <string>
+#include <vector>
+
+// Prints an expression made of deeply shared subexpressions, and sorts a large sum whose terms are compared by text
+
+constexpr int depth = 9;
+constexpr size_t terms = 2000;
+constexpr int runs = 5;
+
+template <typename F>
+double best_of(F&& f) {
+	double best = std::numeric_limits<double>::max();
+	for (int r = 0; r < runs; ++r) {
+		auto start = std::chrono::steady_clock::now();
+		f();
+		std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+		best = std::min(best, elapsed.count());
+	}
+	return best;
+}
+
+int main() {
+	sym::library lib{};
+	sym::symbol x("x");
+	sym::symbol y("y");
+
+	// Each level uses the previous one three times, so the text triples while the DAG grows by a few nodes
+	sym::expression shared = x + y;
+	for (int i = 0; i < depth; ++i) {
+		shared = sym::sin(shared) * y + sym::pow(shared, i + 2) - shared;
+	}
+	size_t chars = 0;
+	double string_ms = best_of([&] { chars = shared.string().size(); });
+	double memoized_ms = best_of([&] {
+		sym::printer p(sym::print_format::plain, true);
+		chars = p.print(shared).size();
+	});
+	double latex_ms = best_of([&] { sym::to_latex(shared); });
+
+	std::vector<const sym::detail::node*> operands;
+	for (size_t i = 0; i < terms; ++i) {
+		sym::symbol k(std::format("k{}", i % 97));
+		operands.push_back((sym::cos(k * x + static_cast<double>(i)) * sym::pow(y, static_cast<double>(i % 5 + 1))).root);
+	}
+	sym::expression sum = sym::make_addition(operands);
+	double sort_ms = best_of([&] { sym::sort(sum); });
+
+	std::cout << std::format("{:<10} {:>10} {:>10}\n", "step", "chars", "ms");
+	std::cout << std::format("{:<10} {:>10} {:>10.2f}\n", "string", chars, string_ms);
+	std::cout << std::format("{:<10} {:>10} {:>10.2f}\n", "memoized", chars, memoized_ms);
+	std::cout << std::format("{:<10} {:>10} {:>10.2f}\n", "latex", chars, latex_ms);
+	std::cout << std::format("{:<10} {:>10} {:>10.2f}\n", "sort", terms, sort_ms);
+}
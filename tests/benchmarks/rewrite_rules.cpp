@@ -0,0 +1,120 @@
+#include <symaths/symaths.hpp>
+
+#include <chrono>
+#include <cstdint>
+#include <format>
+#include <iostream>
+#include <unordered_set>
+#include <vector>
+
+// Rewrites large expressions with 500 rules, and compares the amount of candidates the index retrieves
+// with the amount of rules a linear scan would try
+
+constexpr size_t rules_count = 500;
+constexpr size_t terms_count = 20000;
+
+void distinct_nodes(const sym::detail::node* node, std::unordered_set<const sym::detail::node*>& seen) {
+	if (!seen.insert(node).second) {
+		return;
+	}
+	std::visit([&](const auto& x) {
+		using T = std::decay_t<decltype(x)>;
+
+		if constexpr (std::is_same_v<T, sym::detail::negation>) {
+			distinct_nodes(x.child, seen);
+		}
+		else if constexpr (std::is_same_v<T, sym::detail::addition> || std::is_same_v<T, sym::detail::multiplication>) {
+			for (auto* op : x.operands) distinct_nodes(op, seen);
+		}
+		else if constexpr (std::is_same_v<T, sym::detail::power>) {
+			distinct_nodes(x.base, seen);
+			distinct_nodes(x.exponent, seen);
+		}
+		else if constexpr (std::is_same_v<T, sym::detail::function_call>) {
+			for (auto* arg : x.args) distinct_nodes(arg, seen);
+		}
+	}, node->p_data);
+}
+
+sym::expression call(uint32_t f, const sym::expression& arg) {
+	return sym::make_func(f, arg.root);
+}
+
+int main() {
+	sym::library lib;
+	sym::symbol a("a");
+	std::vector<sym::symbol> variables;
+	for (int i = 0; i < 16; ++i) {
+		variables.emplace_back(std::format("x{}", i));
+	}
+
+	// Valid identities spread over every builtin function
+	sym::rule_set rules;
+	for (size_t k = 0; rules.size() < rules_count; ++k) {
+		auto f = static_cast<uint32_t>(k % sym::funcs::LEN);
+		auto c = static_cast<double>(2 + k / sym::funcs::LEN);
+		switch (k % 3) {
+			case 0:
+				rules.add(sym::pow(sym::pow(call(f, a), c), 2), sym::pow(call(f, a), 2 * c), {a});
+				break;
+			case 1:
+				rules.add(sym::pow(call(f, a), c) * call(f, a), sym::pow(call(f, a), c + 1), {a});
+				break;
+			default:
+				rules.add(sym::exp(c * sym::ln(sym::abs(call(f, a)))), sym::pow(sym::abs(call(f, a)), c), {a});
+				break;
+		}
+	}
+
+	uint64_t state = 42;
+	auto next = [&](uint64_t bound) {
+		state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+		return (state >> 33) % bound;
+	};
+
+	std::vector<const sym::detail::node*> terms;
+	for (size_t i = 0; i < terms_count; ++i) {
+		sym::expression x = variables[next(variables.size())];
+		auto f = static_cast<uint32_t>(next(sym::funcs::LEN));
+		auto c = static_cast<double>(2 + next(rules_count / sym::funcs::LEN));
+		switch (next(4)) {
+			case 0:
+				terms.push_back(sym::pow(sym::pow(call(f, x + c), c), 2).root);
+				break;
+			case 1:
+				terms.push_back((sym::pow(call(f, x), c) * call(f, x) * x).root);
+				break;
+			case 2:
+				terms.push_back(sym::exp(c * sym::ln(sym::abs(call(f, x * c)))).root);
+				break;
+			default:
+				terms.push_back((sym::sin(x) * sym::cos(x * c) + sym::pow(x, c)).root);
+				break;
+		}
+	}
+	sym::expression expr = sym::make_addition(terms);
+
+	std::unordered_set<const sym::detail::node*> nodes;
+	distinct_nodes(expr.root, nodes);
+	size_t candidates = 0;
+	for (auto* n : nodes) {
+		candidates += rules.candidates(n).size();
+	}
+
+	double best = std::numeric_limits<double>::max();
+	sym::expression result = expr;
+	for (int run = 0; run < 5; ++run) {
+		auto start = std::chrono::steady_clock::now();
+		result = rules.rewrite(expr);
+		std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+		best = std::min(best, elapsed.count());
+	}
+
+	std::unordered_set<const sym::detail::node*> result_nodes;
+	distinct_nodes(result.root, result_nodes);
+
+	std::cout << std::format("rules : {}, distinct nodes : {} -> {}\n", rules.size(), nodes.size(), result_nodes.size());
+	std::cout << std::format("candidates per node : {:.3f} (linear scan : {})\n",
+		static_cast<double>(candidates) / static_cast<double>(nodes.size()), rules.size());
+	std::cout << std::format("rewrite : {:.2f} ms, {:.1f} ns per node\n", best, best * 1e6 / static_cast<double>(nodes.size()));
+}
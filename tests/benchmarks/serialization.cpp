@@ -0,0 +1,83 @@
+#include <symaths/symaths.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <format>
+#include <iostream>
+#include <limits>
+#include <string>
+#include <vector>
+
+// Loads a set of expressions sharing subexpressions by parsing their text, deserializing them, or compiling them from
+// a mapped file
+
+constexpr size_t count = 2000;
+constexpr int runs = 5;
+
+template <typename F>
+double best_of(F&& f) {
+	double best = std::numeric_limits<double>::max();
+	for (int r = 0; r < runs; ++r) {
+		auto start = std::chrono::steady_clock::now();
+		f();
+		std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+		best = std::min(best, elapsed.count());
+	}
+	return best;
+}
+
+int main() {
+	sym::library lib{};
+	std::vector<std::string> texts;
+	for (size_t i = 0; i < count; ++i) {
+		texts.push_back(std::format("sin(x * {}) * (x + y)^2 + cos(y - {}) / (x^2 + {}) - exp(-x * y) * {}", i % 50, i % 7, i + 1, i));
+	}
+	std::vector<sym::expression> exprs;
+	for (const auto& t : texts) {
+		exprs.push_back(sym::parse(t));
+	}
+	std::string bytes = sym::serialize(exprs);
+	std::filesystem::path path = std::filesystem::temp_directory_path() / "symaths_serialization_bench.bin";
+	sym::save_expressions(path, exprs);
+
+	// Each run loads into a fresh library, as a new process would
+	double parse_ms = best_of([&] {
+		sym::library fresh;
+		sym::make_context_current(fresh);
+		for (const auto& t : texts) {
+			sym::parse(t);
+		}
+	});
+	double deserialize_ms = best_of([&] {
+		sym::library fresh;
+		sym::make_context_current(fresh);
+		sym::deserialize(bytes);
+	});
+	double compile_ms = best_of([&] {
+		sym::library fresh;
+		sym::make_context_current(fresh);
+		for (const auto& t : texts) {
+			sym::parse_compiled(t, {"x", "y"});
+		}
+	});
+	double mapped_ms = best_of([&] {
+		sym::mapped_expressions mapped(path);
+		for (size_t i = 0; i < mapped.size(); ++i) {
+			(void)mapped.compile(i, {"x", "y"});
+		}
+	});
+	sym::make_context_current(lib);
+	std::filesystem::remove(path);
+
+	size_t text_bytes = 0;
+	for (const auto& t : texts) {
+		text_bytes += t.size();
+	}
+	std::cout << std::format("text: {} bytes, serialized: {} bytes\n", text_bytes, bytes.size());
+	std::cout << std::format("{:<16} {:>10} {:>14}\n", "step", "ms", "us/expr");
+	std::cout << std::format("{:<16} {:>10.2f} {:>14.2f}\n", "parse", parse_ms, parse_ms * 1e3 / count);
+	std::cout << std::format("{:<16} {:>10.2f} {:>14.2f}\n", "deserialize", deserialize_ms, deserialize_ms * 1e3 / count);
+	std::cout << std::format("{:<16} {:>10.2f} {:>14.2f}\n", "parse_compiled", compile_ms, compile_ms * 1e3 / count);
+	std::cout << std::format("{:<16} {:>10.2f} {:>14.2f}\n", "mapped compile", mapped_ms, mapped_ms * 1e3 / count);
+}
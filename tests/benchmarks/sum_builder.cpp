@@ -0,0 +1,60 @@
+#include <symaths/symaths.hpp>
+
+#include <chrono>
+#include <format>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Builds sum_i c_i * x_i by chaining operator+ and with a sum_builder, and counts the nodes each leaves in the library
+
+// operator+ is quadratic, so it only runs on small sums
+constexpr size_t chained_terms[] = {2000, 4000, 8000};
+constexpr size_t builder_terms[] = {2000, 4000, 8000, 1000000};
+constexpr size_t variables = 100;
+
+std::vector<sym::expression> make_terms(size_t n) {
+	std::vector<sym::symbol> xs;
+	for (size_t i = 0; i < variables; ++i) {
+		xs.emplace_back("x" + std::to_string(i));
+	}
+	std::vector<sym::expression> terms;
+	terms.reserve(n);
+	for (size_t i = 0; i < n; ++i) {
+		terms.push_back(static_cast<double>(i + 1) * xs[i % variables]);
+	}
+	return terms;
+}
+
+template <typename F>
+void run(const std::string& name, size_t n, F&& f) {
+	sym::library lib{};
+	std::vector<sym::expression> terms = make_terms(n);
+	size_t nodes = lib.node_manager().nodes().size();
+	auto start = std::chrono::steady_clock::now();
+	f(terms);
+	std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+	size_t created = lib.node_manager().nodes().size() - nodes;
+	std::cout << std::format("{:<12} {:>10} {:>12.2f} {:>10}\n", name, n, elapsed.count(), created);
+}
+
+int main() {
+	std::cout << std::format("{:<12} {:>10} {:>12} {:>10}\n", "method", "terms", "ms", "new nodes");
+	for (size_t n : chained_terms) {
+		run("operator+", n, [](const std::vector<sym::expression>& terms) {
+			sym::expression sum = terms[0];
+			for (size_t i = 1; i < terms.size(); ++i) {
+				sum = sum + terms[i];
+			}
+		});
+	}
+	for (size_t n : builder_terms) {
+		run("sum_builder", n, [](const std::vector<sym::expression>& terms) {
+			sym::sum_builder sum(terms.size());
+			for (const auto& t : terms) {
+				sum.add(t);
+			}
+			(void)sum.build();
+		});
+	}
+}
@@ -0,0 +1,64 @@
+#include <symaths/symaths.hpp>
+#include <symaths/system.hpp>
+
+#include <chrono>
+#include <format>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Solves the discretized Bratu problem u'' + a exp(u) = 0 on [0, 1] for several values of a, reusing the system
+
+using bench_clock = std::chrono::steady_clock;
+
+int main() {
+	sym::library lib{};
+	sym::symbol a("a");
+
+	std::cout << std::format("{:<8} {:<8} {:<22} {:>12} {:>12} {:>14}\n", "size", "LU", "method", "build ms", "solves", "solves per s");
+	for (size_t n : {10, 100, 1000}) {
+		auto build_start = bench_clock::now();
+		std::vector<sym::symbol> u;
+		for (size_t i = 0; i < n; ++i) {
+			u.emplace_back("u" + std::to_string(i));
+		}
+		double h2 = 1.0 / static_cast<double>((n + 1) * (n + 1));
+		std::vector<sym::equation> equations;
+		for (size_t i = 0; i < n; ++i) {
+			sym::expression lhs = -2.0 * u[i] + h2 * a * sym::exp(u[i]);
+			if (i > 0) lhs = lhs + u[i - 1];
+			if (i + 1 < n) lhs = lhs + u[i + 1];
+			equations.emplace_back(lhs, 0.0);
+		}
+		sym::system bratu(equations, u);
+		std::chrono::duration<double, std::milli> build = bench_clock::now() - build_start;
+
+		for (double density : {0.1, 0.0}) {
+			// Small systems are always dense, and large dense ones too slow
+			if (density == 0 && (n < 32 || n > 100)) {
+				continue;
+			}
+			for (auto method : {sym::nonlinear_method::damped_newton, sym::nonlinear_method::levenberg_marquardt}) {
+				sym::system_options options;
+				options.method = method;
+				options.sparse_density = density;
+
+				size_t solves = 0;
+				auto start = bench_clock::now();
+				std::chrono::duration<double> elapsed{};
+				while (elapsed.count() < 0.5) {
+					std::vector<double> values(n, 0.0);
+					if (!bratu.solve(values, {0.5 + static_cast<double>(solves % 10) * 0.3}, options).converged) {
+						std::cout << "not converged\n";
+					}
+					++solves;
+					elapsed = bench_clock::now() - start;
+				}
+
+				const char* lu = density > 0 && n >= 32 ? "sparse" : "dense";
+				const char* name = method == sym::nonlinear_method::damped_newton ? "damped Newton" : "Levenberg-Marquardt";
+				std::cout << std::format("{:<8} {:<8} {:<22} {:>12.2f} {:>12} {:>14.1f}\n", n, lu, name, build.count(), solves, static_cast<double>(solves) / elapsed.count());
+			}
+		}
+	}
+}
@@ -1,7 +1,20 @@
 #include <gtest/gtest.h>
 
 #include <symaths/symaths.hpp>
+#include <symaths/equation.hpp>
+#include <symaths/integration.hpp>
+#include <symaths/ode.hpp>
 #include <symaths/polynomial.hpp>
+#include <symaths/root_isolation.hpp>
+#include <symaths/system.hpp>
+#include <symaths/detail/polynomial_kernels.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <format>
+#include <fstream>
+#include <numbers>
+#include <random>
 
 int main(int argc, char** argv) {
 	sym::library lib{};
@@ -116,6 +129,27 @@ TEST(basic_exprs_computing, expand_products) {
 	ASSERT_EQ(sym::reduce(sym::expand(expr5)).string(), "-9x^3+9x^2");
 }
 
+TEST(basic_exprs_computing, expand_polynomials) {
+	sym::symbol x("x");
+	sym::symbol y("y");
+
+	ASSERT_EQ(sym::expand(sym::pow(x + 1, 3)).string(), "x^3+3x^2+3x+1");
+	ASSERT_EQ(sym::expand((x + y) * (x - y)).string(), "x^2-y^2");
+	ASSERT_EQ(sym::expand(sym::pow(x + y, 2) - sym::pow(x - y, 2)).string(), "4xy");
+	ASSERT_EQ(sym::expand(sym::sin(x) * (sym::sin(x) + 1)).string(), "sin(x)^2+sin(x)");
+	ASSERT_EQ(sym::expand(sym::pow(x, 2) * x - x * x * x).string(), "0");
+	ASSERT_EQ(sym::expand(sym::pow(x + 1, 2) * (x - 1)).string(), "x^3+x^2-x-1");
+
+	// Over the budget, only the operands are expanded
+	ASSERT_EQ(sym::expand(sym::pow(x + 1, 9), 5).string(), "(x+1)^9");
+	ASSERT_EQ(sym::expand(sym::pow(x + 1, 9) * (y + 1), 5).string(), "(x+1)^9y+(x+1)^9");
+	ASSERT_EQ(sym::expand(sym::pow(x + 1, 2) * (x + 1) + sym::pow(y + 1, 2), 5).string(), "x^3+3x^2+3x+1+y^2+2y+1");
+	// So are the subexpressions whose coefficients overflow 64 bits : C(70, 35) does, C(60, 30) does not
+	ASSERT_EQ(sym::expand(sym::pow(x + 1, 70)).string(), "(x+1)^70");
+	ASSERT_EQ(sym::expand(sym::pow(x + 1, 70) + y).string(), "(x+1)^70+y");
+	ASSERT_NE(sym::expand(sym::pow(x + 1, 60)).string().find("+118264581564861424x^30+"), std::string::npos);
+}
+
 TEST(basic_expr_computing, differentiate_base_operations) {
 	sym::symbol x("x");
 	sym::symbol y("y");
@@ -164,6 +198,29 @@ TEST(basic_expr_computing, differentiate_builtin_functions) {
 TEST(basic_exprs_computing, lexer_tokenize) {
 	sym::lexer lexer;
 	ASSERT_NO_THROW(lexer.tokenize("val0 + val1 * 3val2( 3+ b)"));
+
+	lexer.tokenize("2.5x1 + .5^y $");
+	const auto& tokens = lexer.tokens();
+	ASSERT_EQ(tokens.size(), 8);
+	ASSERT_EQ(tokens[0].type, sym::lexer::number);
+	ASSERT_EQ(tokens[0].value, 2.5);
+	ASSERT_EQ(tokens[0].length, 3);
+	ASSERT_EQ(tokens[1].type, sym::lexer::identifier);
+	ASSERT_EQ(lexer.text(tokens[1]), "x1");
+	ASSERT_EQ(tokens[2].type, sym::lexer::op_addition);
+	ASSERT_EQ(tokens[2].offset, 6);
+	ASSERT_EQ(tokens[3].value, 0.5);
+	ASSERT_EQ(tokens[4].type, sym::lexer::op_power);
+	ASSERT_EQ(lexer.text(tokens[5]), "y");
+	ASSERT_EQ(tokens[6].type, sym::lexer::error);
+	ASSERT_EQ(tokens[7].type, sym::lexer::eof);
+	ASSERT_EQ(sym::parse("x^.5+2.5").string(), "x^0.5+2.5");
+
+	// Out of the range of doubles
+	std::string huge(400, '9');
+	lexer.tokenize(huge);
+	ASSERT_EQ(lexer.tokens().front().type, sym::lexer::error);
+	ASSERT_EQ(sym::parse_many(huge + "+x", 1).errors.size(), 1);
 }
 
 TEST(basic_exprs_computing, parser_parse) {
@@ -190,4 +247,811 @@ TEST(basic_exprs_computing, polynomial_simple) {
 	sym::expression expr1 = sym::parse("3x^2 + 4x - 10");
 
 	sym::polynomial p1(expr1);
-}
\ No newline at end of file
+}
+
+TEST(basic_exprs_computing, dense_polynomial) {
+	sym::symbol x("x");
+	sym::polynomial p(3 * sym::pow(x, 2) + 4 * x - 10);
+
+	sym::numeric_polynomial n(p);
+	ASSERT_EQ(n.coeffs, std::vector<double>({-10, 4, 3}));
+	ASSERT_DOUBLE_EQ(n.eval(2), 10);
+	ASSERT_EQ(n.derivative().coeffs, std::vector<double>({4, 6}));
+	ASSERT_EQ(n.integral(1).coeffs, std::vector<double>({1, -10, 2, 1}));
+	ASSERT_EQ(n.to_expression(x).string(), "3x^2+4x-10");
+	ASSERT_EQ(sym::numeric_polynomial({1, -2, 0, -1}).to_expression(x).string(), "-x^3-2x+1");
+
+	sym::rational_polynomial r(p);
+	ASSERT_EQ(sym::expression(r.integral().to_expression(x)).string(), "x^3+2x^2-10x");
+	ASSERT_EQ(r.derivative().integral().coeffs[1].string(), "4");
+	ASSERT_EQ(sym::rational_polynomial({sym::numbers::natural{1}, sym::numbers::natural{1}}).integral().coeffs[2].string(), "1/2");
+
+	// Estrin's scheme for high degrees, blocks of points in batches
+	std::vector<double> coeffs;
+	for (int k = 0; k <= 100; ++k) {
+		coeffs.push_back(1.0 / (k + 1) * (k % 3 == 0 ? -1 : 1));
+	}
+	sym::numeric_polynomial high(coeffs);
+	std::vector<double> xs, out(1000);
+	for (int i = 0; i < 1000; ++i) {
+		xs.push_back(-1 + 0.002 * i);
+	}
+	high.eval_batch(xs.data(), out.data(), xs.size());
+	for (size_t i = 0; i < xs.size(); ++i) {
+		double expected = 0;
+		for (size_t k = coeffs.size(); k-- > 0;) {
+			expected = expected * xs[i] + coeffs[k];
+		}
+		ASSERT_NEAR(out[i], expected, 1e-12);
+		ASSERT_NEAR(high.eval(xs[i]), expected, 1e-12);
+	}
+}
+
+TEST(basic_exprs_computing, polynomial_multiplication) {
+	sym::symbol x("x");
+	sym::polynomial p = sym::polynomial(x + 1) * sym::polynomial(x - 1);
+	ASSERT_EQ(p.expr.string(), "x^2-1");
+	ASSERT_EQ(p.get_degree(), 2);
+
+	// Karatsuba and FFT give the schoolbook product
+	std::vector<double> a(1000), b(777);
+	for (size_t i = 0; i < a.size(); ++i) a[i] = std::sin(static_cast<double>(i));
+	for (size_t i = 0; i < b.size(); ++i) b[i] = std::cos(static_cast<double>(3 * i));
+	auto expected = sym::detail::multiply_schoolbook(a, b);
+	auto karatsuba = sym::detail::multiply_karatsuba(a, b);
+	auto fft = sym::detail::multiply_fft(a, b);
+	ASSERT_EQ(karatsuba.size(), expected.size());
+	ASSERT_EQ(fft.size(), expected.size());
+	for (size_t i = 0; i < expected.size(); ++i) {
+		ASSERT_NEAR(karatsuba[i], expected[i], 1e-9);
+		ASSERT_NEAR(fft[i], expected[i], 1e-9);
+	}
+
+	// NTT is exact, rationals included
+	std::vector<sym::number> ea, eb;
+	for (long long i = 0; i < 300; ++i) {
+		ea.emplace_back(sym::numbers::integer{(i * 7919) % 2001 - 1000});
+		eb.emplace_back(sym::numbers::rational{(i * 104729) % 1999 - 999, i % 3 + 1});
+	}
+	sym::rational_polynomial exact = sym::rational_polynomial(ea) * sym::rational_polynomial(eb);
+	sym::rational_polynomial reference;
+	reference.coeffs.assign(ea.size() + eb.size() - 1, sym::numbers::natural{0});
+	for (size_t i = 0; i < ea.size(); ++i) {
+		for (size_t j = 0; j < eb.size(); ++j) {
+			reference.coeffs[i + j] += ea[i] * eb[j];
+		}
+	}
+	ASSERT_EQ(exact.coeffs.size(), reference.coeffs.size());
+	for (size_t i = 0; i < exact.coeffs.size(); ++i) {
+		ASSERT_EQ(exact.coeffs[i].string(), reference.coeffs[i].string());
+	}
+}
+
+TEST(basic_exprs_computing, polynomial_roots) {
+	sym::symbol x("x");
+	auto roots = sym::find_roots(sym::polynomial(sym::pow(x, 3.0) - 6.0 * sym::pow(x, 2.0) + 11.0 * x - 6.0));
+	ASSERT_EQ(roots.size(), 3);
+	for (size_t i = 0; i < roots.size(); ++i) {
+		ASSERT_NEAR(roots[i].real(), static_cast<double>(i + 1), 1e-12);
+		ASSERT_NEAR(roots[i].imag(), 0, 1e-12);
+	}
+
+	// x^2 (x^2 + 1) : exact roots at 0, and i and -i
+	roots = sym::find_roots(sym::numeric_polynomial({0, 0, 1, 0, 1}));
+	ASSERT_EQ(roots.size(), 4);
+	ASSERT_EQ(std::ranges::count(roots, std::complex<double>(0, 0)), 2);
+	for (auto root : {std::complex<double>(0, 1), std::complex<double>(0, -1)}) {
+		ASSERT_TRUE(std::ranges::any_of(roots, [&](auto z) { return std::abs(z - root) < 1e-12; }));
+	}
+	ASSERT_THROW(sym::find_roots(sym::numeric_polynomial({0, 0})), std::invalid_argument);
+
+	// Roots of unity of high degree, in a batch
+	std::vector<sym::numeric_polynomial> batch;
+	for (size_t degree : {50, 200, 300}) {
+		std::vector<double> coeffs(degree + 1, 0.0);
+		coeffs[0] = -1;
+		coeffs[degree] = 1;
+		batch.emplace_back(coeffs);
+	}
+	auto all = sym::find_roots(batch, 2);
+	ASSERT_EQ(all.size(), batch.size());
+	for (size_t p = 0; p < batch.size(); ++p) {
+		ASSERT_EQ(all[p].size(), batch[p].degree());
+		ASSERT_EQ(all[p], sym::find_roots(batch[p]));
+		for (size_t i = 0; i < all[p].size(); ++i) {
+			ASSERT_NEAR(std::abs(all[p][i]), 1, 1e-12);
+			if (i > 0) {
+				// Distinct roots
+				ASSERT_GT(std::abs(all[p][i] - all[p][i - 1]), 1e-3);
+			}
+		}
+	}
+}
+
+TEST(basic_exprs_computing, cancel_rational_functions) {
+	sym::symbol x("x"), y("y");
+	ASSERT_EQ(sym::polynomial_gcd(sym::pow(x, 2.0) - 1.0, 2.0 * sym::pow(x, 2.0) + 4.0 * x + 2.0).string(), "x+1");
+	ASSERT_EQ(sym::polynomial_gcd(sym::pow(x, 2.0) + 1.0, x + 1.0).string(), "1");
+	// Multivariate : (x + y)(x - y) and (x + y)^2
+	ASSERT_EQ(sym::polynomial_gcd(sym::pow(x, 2.0) - sym::pow(y, 2.0), sym::pow(x + y, 2.0)).string(), "x+y");
+	ASSERT_EQ(sym::polynomial_gcd(x * y + x, sym::pow(y, 2.0) * x + x * y).string(), "xy+x");
+	// Too many variables of high degree for a Kronecker substitution
+	sym::symbol z("z"), w("w"), v("v");
+	sym::expression g = x * y + z * w + v + 3.0;
+	sym::expression a = sym::expand(g * (sym::pow(x, 6.0) + sym::pow(y, 6.0) + sym::pow(z, 6.0) + sym::pow(w, 6.0) + sym::pow(v, 6.0) + 1.0));
+	sym::expression b = sym::expand(g * (sym::pow(x, 5.0) * y - 2.0 * sym::pow(z, 5.0) * w + sym::pow(v, 5.0) + 3.0 * sym::pow(y, 9.0) * sym::pow(z, 2.0) - 1.0));
+	ASSERT_EQ(sym::polynomial_gcd(a, b).string(), sym::polynomial_gcd(g, g).string());
+
+	ASSERT_EQ(sym::divide_exact(sym::pow(x, 3.0) - sym::pow(y, 3.0), x - y).string(), "x^2+xy+y^2");
+	ASSERT_THROW(sym::divide_exact(sym::pow(x, 2.0) + 1.0, x - 1.0), std::invalid_argument);
+
+	ASSERT_EQ(sym::cancel((sym::pow(x, 2.0) - 1.0) / (x - 1.0)).string(), "x+1");
+	ASSERT_EQ(sym::cancel((2.0 * x + 2.0) / (4.0 * x + 4.0)).string(), "1/2");
+	ASSERT_EQ(sym::cancel(1.0 / x + 1.0 / (sym::pow(x, 2.0) + x)).string(), sym::expression((x + 2.0) / (sym::pow(x, 2.0) + x)).string());
+	ASSERT_EQ(sym::cancel(sym::sin((sym::pow(x, 2.0) - sym::pow(y, 2.0)) / (x - y))).string(), sym::sin(x + y).string());
+	ASSERT_THROW(sym::cancel(1.0 / (x - x)), std::invalid_argument);
+}
+
+TEST(basic_exprs_computing, multivariate_polynomial) {
+	sym::symbol x("x"), y("y"), z("z");
+	sym::multivariate_polynomial p(sym::pow(x + y, 2.0) * z - 2.0 * x * y * z + 3.0, {x, y, z});
+	ASSERT_EQ(p.size(), 3);
+	ASSERT_EQ(p.degree(), 3);
+	ASSERT_EQ(p.degree(2), 1);
+
+	// x^2z and xy^2 have the same degree : grlex compares x first, grevlex prefers the smaller exponent of z
+	sym::multivariate_polynomial q(sym::pow(x, 2.0) * z + x * sym::pow(y, 2.0), {x, y, z}, sym::monomial_order::grlex);
+	ASSERT_EQ(q.exponent(0, 2), 1);
+	sym::multivariate_polynomial r(sym::pow(x, 2.0) * z + x * sym::pow(y, 2.0), {x, y, z}, sym::monomial_order::grevlex);
+	ASSERT_EQ(r.exponent(0, 2), 0);
+
+	sym::multivariate_polynomial s = sym::multivariate_polynomial(x + y) * sym::multivariate_polynomial(x - y);
+	ASSERT_EQ(s.to_expression().string(), sym::multivariate_polynomial(sym::pow(x, 2.0) - sym::pow(y, 2.0)).to_expression().string());
+	ASSERT_EQ((s - s).size(), 0);
+	ASSERT_EQ((s + sym::multivariate_polynomial(z)).variables().size(), 3);
+	ASSERT_EQ(sym::multivariate_polynomial(x + 1.0).pow(10).coefficient(1).get<double>(), 10);
+	// C(60, 30) fits in 64 bits, C(70, 35) only as a real
+	ASSERT_EQ(sym::multivariate_polynomial(x + 1.0).pow(60).coefficient(30), sym::number(sym::numbers::natural{118264581564861424}));
+	sym::number overflowed = sym::multivariate_polynomial(x + 1.0).pow(70).coefficient(35);
+	ASSERT_EQ(sym::number::get_rank(overflowed.p_data), sym::number::rank::Real);
+	ASSERT_NEAR(overflowed.get<double>(), 112186277816662845432.0, 1e6);
+
+	std::vector<double> xs(300), ys(300), zs(300), out(300);
+	for (size_t i = 0; i < xs.size(); ++i) {
+		xs[i] = 0.01 * static_cast<double>(i);
+		ys[i] = 1.0 - 0.02 * static_cast<double>(i);
+		zs[i] = 0.5 + 0.003 * static_cast<double>(i);
+	}
+	const double* columns[] = {xs.data(), ys.data(), zs.data()};
+	p.eval_batch(columns, out.data(), out.size());
+	for (size_t i = 0; i < out.size(); ++i) {
+		double expected = (xs[i] * xs[i] + ys[i] * ys[i]) * zs[i] + 3;
+		double point[] = {xs[i], ys[i], zs[i]};
+		ASSERT_NEAR(p.eval(point), expected, 1e-12);
+		ASSERT_NEAR(out[i], expected, 1e-12);
+	}
+
+	ASSERT_THROW(sym::multivariate_polynomial(sym::sin(x) + y), std::invalid_argument);
+	ASSERT_THROW(sym::multivariate_polynomial(x + y, {x}), std::invalid_argument);
+}
+
+TEST(basic_exprs_computing, equation_solve) {
+	sym::symbol x("x"), y("y");
+	ASSERT_EQ(sym::equation(2.0 * x + 1.0, 7.0).solve().front().string(), "3");
+	auto quadratic = sym::equation(sym::pow(x, 2.0), 3.0 * x - 2.0).solve();
+	ASSERT_EQ(quadratic.size(), 2);
+	ASSERT_EQ(quadratic[0].string(), "1");
+	ASSERT_EQ(quadratic[1].string(), "2");
+	ASSERT_NEAR(sym::equation(sym::pow(x, 2.0), 2.0).solve()[1]().get<double>(), std::sqrt(2.0), 1e-15);
+	ASSERT_TRUE(sym::equation(sym::pow(x, 2.0), -1.0).solve().empty());
+	ASSERT_EQ(sym::equation(sym::pow(x, 3.0) - x, 0.0).solve().size(), 3);
+
+	// sin(x) = 1/2 has 7 solutions in [-10, 10]
+	sym::solve_options options;
+	options.lower = -10;
+	options.upper = 10;
+	options.threads = 3;
+	auto roots = sym::equation(sym::sin(x), 0.5).solve(options);
+	ASSERT_EQ(roots.size(), 7);
+	for (const auto& r : roots) {
+		ASSERT_NEAR(std::sin(r().get<double>()), 0.5, 1e-12);
+	}
+	// Poles of tan are not roots
+	ASSERT_EQ(sym::equation(1.0 / sym::tan(x), 0.0).solve(options).size(), 6);
+
+	ASSERT_TRUE(sym::equation(x, x + y).unknowns().size() == 2);
+	ASSERT_FALSE(sym::equation(x, x + y).is_solvable());
+	ASSERT_THROW(sym::equation(x, x + y).solve(), std::invalid_argument);
+}
+
+TEST(basic_exprs_computing, system_solve) {
+	sym::symbol x("x"), y("y"), a("a");
+
+	// Shared subexpressions are evaluated once
+	sym::compiled_vector_expression v({sym::sin(x * y) + x, sym::sin(x * y) * y}, {x, y});
+	double point[] = {0.5, 2.0}, out[2];
+	v(point, out);
+	ASSERT_NEAR(out[0], std::sin(1.0) + 0.5, 1e-15);
+	ASSERT_NEAR(out[1], std::sin(1.0) * 2, 1e-15);
+	ASSERT_EQ(std::ranges::count(v.program(), sym::detail::load, &sym::detail::instruction::op), 1);
+
+	sym::system circle({{sym::pow(x, 2.0) + sym::pow(y, 2.0), a}, {x * y, 1.0}}, {x, y});
+	ASSERT_EQ(circle.parameters().size(), 1);
+	for (double radius : {4.0, 9.0}) {
+		std::vector<double> values{2.0, 0.5};
+		auto result = circle.solve(values, {radius});
+		ASSERT_TRUE(result.converged);
+		ASSERT_NEAR(values[0] * values[0] + values[1] * values[1], radius, 1e-10);
+		ASSERT_NEAR(values[0] * values[1], 1, 1e-10);
+	}
+
+	// Overdetermined but consistent
+	sym::system lines({{x + y, 3.0}, {x - y, 1.0}, {2.0 * x + y, 5.0}}, {x, y});
+	std::vector<double> values{0.0, 0.0};
+	sym::system_options lm;
+	lm.method = sym::nonlinear_method::levenberg_marquardt;
+	ASSERT_TRUE(lines.solve(values, {}, lm).converged);
+	ASSERT_NEAR(values[0], 2, 1e-10);
+	ASSERT_NEAR(values[1], 1, 1e-10);
+	ASSERT_THROW(lines.solve(values), std::invalid_argument);
+
+	// Tridiagonal : the sparse factorization gives the same solution as the dense one
+	std::vector<sym::symbol> u;
+	for (int i = 0; i < 50; ++i) {
+		u.emplace_back("u" + std::to_string(i));
+	}
+	std::vector<sym::equation> chain;
+	for (size_t i = 0; i < u.size(); ++i) {
+		sym::expression lhs = sym::pow(u[i], 3.0) + 3.0 * u[i];
+		if (i > 0) lhs = lhs - u[i - 1];
+		if (i + 1 < u.size()) lhs = lhs - u[i + 1];
+		chain.emplace_back(lhs, static_cast<double>(i % 3));
+	}
+	sym::system tridiagonal(chain, u);
+	ASSERT_EQ(tridiagonal.jacobian_pattern().size(), 3 * u.size() - 2);
+	sym::system_options dense;
+	dense.sparse_density = 0;
+	for (auto method : {sym::nonlinear_method::damped_newton, sym::nonlinear_method::levenberg_marquardt}) {
+		std::vector<double> sparse_values(u.size(), 0.0), dense_values(u.size(), 0.0);
+		lm.method = dense.method = method;
+		ASSERT_TRUE(tridiagonal.solve(sparse_values, {}, lm).converged);
+		ASSERT_TRUE(tridiagonal.solve(dense_values, {}, dense).converged);
+		for (size_t i = 0; i < u.size(); ++i) {
+			ASSERT_NEAR(sparse_values[i], dense_values[i], 1e-9);
+		}
+	}
+}
+
+TEST(basic_exprs_computing, root_isolation) {
+	sym::symbol x("x"), y("y");
+
+	// Interval evaluation contains every value
+	sym::compiled_vector_expression v({sym::sin(x) * sym::pow(x, 2.0), sym::sqrt(x)}, {x});
+	sym::detail::bounds in[] = {{-0.5, 2.0}}, out[2];
+	std::vector<sym::detail::bounds> workspace;
+	v.eval_bounds(in, out, workspace);
+	ASSERT_TRUE(out[0].contains(std::sin(2.0) * 4) && out[0].contains(std::sin(-0.5) * 0.25));
+	ASSERT_LE(out[0].upper, 4 + 1e-12);
+	ASSERT_EQ(out[1].lower, 0);
+
+	auto disjoint = [](const std::vector<sym::box>& boxes) {
+		for (size_t i = 1; i < boxes.size(); ++i) {
+			if (boxes[i][0].lower <= boxes[i - 1][0].upper) return false;
+		}
+		return true;
+	};
+
+	// sin has 7 roots in [-10;10], all certified
+	auto sine = sym::isolate_roots(sym::sin(x), x, -10, 10);
+	ASSERT_EQ(sine.roots.size(), 7);
+	ASSERT_TRUE(sine.uncertain.empty());
+	ASSERT_TRUE(disjoint(sine.roots));
+	for (size_t k = 0; k < 7; ++k) {
+		ASSERT_TRUE(sine.roots[k][0].contains((static_cast<double>(k) - 3) * std::numbers::pi));
+		ASSERT_LE(sine.roots[k][0].upper - sine.roots[k][0].lower, 1e-11);
+	}
+
+	// Roots 1e-6 apart are separated, a double root is not certified
+	auto close = sym::isolate_roots((x - 1.0) * (x - 1.000001), x, 0, 3);
+	ASSERT_EQ(close.roots.size(), 2);
+	ASSERT_TRUE(disjoint(close.roots));
+	auto twice = sym::isolate_roots(sym::pow(x - 1.0, 2.0), x, 0, 3);
+	ASSERT_TRUE(twice.roots.empty());
+	ASSERT_FALSE(twice.uncertain.empty());
+
+	// Intersections of a circle and a hyperbola
+	sym::isolation_options options;
+	options.threads = 4;
+	auto system = sym::isolate_roots({sym::pow(x, 2.0) + sym::pow(y, 2.0) - 4.0, x * y - 1.0}, {x, y}, {sym::domain::between(-3, 3), sym::domain::between(-3, 3)}, options);
+	ASSERT_EQ(system.roots.size(), 4);
+	for (const auto& b : system.roots) {
+		double px = b[0].lower, py = b[1].lower;
+		ASSERT_NEAR(px * px + py * py, 4, 1e-9);
+		ASSERT_NEAR(px * py, 1, 1e-9);
+	}
+
+	ASSERT_THROW(sym::isolate_roots({x + y}, {x}, {sym::domain::between(0, 1)}), std::invalid_argument);
+}
+
+TEST(basic_exprs_computing, integrate) {
+	sym::symbol x("x"), y("y"), z("z");
+
+	auto sine = sym::integrate(sym::sin(x), x, 0, std::numbers::pi);
+	ASSERT_TRUE(sine.converged);
+	ASSERT_NEAR(sine.value, 2, 1e-12);
+	ASSERT_NEAR(sym::integrate(sym::sin(x), x, std::numbers::pi, 0).value, -2, 1e-12);
+
+	// Peaked and oscillating integrands need many subintervals
+	auto peak = sym::integrate(1.0 / (1e-4 + sym::pow(x - 0.3, 2.0)), x, 0, 1);
+	ASSERT_NEAR(peak.value, 100 * (std::atan(70.0) + std::atan(30.0)), 1e-8 * peak.value);
+	ASSERT_NEAR(sym::integrate(sym::cos(100.0 * x), x, 0, 1).value, std::sin(100.0) / 100, 1e-12);
+
+	// Infinite ranges
+	ASSERT_NEAR(sym::integrate(sym::exp(-sym::pow(x, 2.0)), x, -INFINITY, INFINITY).value, std::sqrt(std::numbers::pi), 1e-10);
+	ASSERT_NEAR(sym::integrate(1.0 / (1.0 + sym::pow(x, 2.0)), x, 0, INFINITY).value, std::numbers::pi / 2, 1e-10);
+
+	// The degree 7 rule is exact on polynomials of degree 7, the error estimate only on those of degree 5
+	sym::box cube{sym::domain::between(0, 1), sym::domain::between(0, 2), sym::domain::between(-1, 1)};
+	sym::integration_options options;
+	options.max_evaluations = 33;
+	auto polynomial = sym::integrate(sym::pow(x, 6.0) * y + z, {x, y, z}, cube, options);
+	ASSERT_NEAR(polynomial.value, 2.0 / 7 * 2, 1e-14);
+	ASSERT_EQ(polynomial.evaluations, 2 * 2 * 2 + 2 * 9 + 2 * 3 + 1);
+	ASSERT_FALSE(polynomial.converged);
+	ASSERT_TRUE(sym::integrate(sym::pow(x, 4.0) * y + z, {x, y, z}, cube, options).converged);
+
+	options = {};
+	options.tolerance = 1e-8;
+	options.threads = 4;
+	auto gaussian = sym::integrate(sym::exp(-(sym::pow(x, 2.0) + sym::pow(y, 2.0))), {x, y}, {sym::domain::real(), sym::domain::between(0, INFINITY)}, options);
+	ASSERT_TRUE(gaussian.converged);
+	ASSERT_NEAR(gaussian.value, std::numbers::pi / 2, 1e-7);
+
+	ASSERT_THROW(sym::integrate(x * y, x, 0, 1), std::invalid_argument);
+}
+
+TEST(basic_exprs_computing, ode_solve) {
+	sym::symbol t("t"), y("y"), v("v"), a("a");
+
+	// Decay rates given per trajectory, over more trajectories than a block holds
+	sym::ode_system decay({-a * y}, {y}, t, {a});
+	std::vector<double> rates, initial(300, 1.0);
+	for (int j = 0; j < 300; ++j) {
+		rates.push_back(0.01 * j);
+	}
+	for (auto method : {sym::ode_method::dormand_prince, sym::ode_method::rosenbrock}) {
+		sym::ode_options options;
+		options.method = method;
+		options.threads = 2;
+		auto result = decay.solve({0, 1, 2}, initial, rates, options);
+		for (size_t j = 0; j < 300; ++j) {
+			ASSERT_EQ(result.status[j], sym::ode_status::success);
+			ASSERT_NEAR(result.state(1, j, 0), std::exp(-rates[j]), method == sym::ode_method::rosenbrock ? 1e-6 : 1e-9);
+			ASSERT_NEAR(result.state(2, j, 0), std::exp(-2 * rates[j]), method == sym::ode_method::rosenbrock ? 1e-6 : 1e-9);
+		}
+	}
+
+	// Oscillator driven in time, integrated backward
+	sym::ode_system driven({v, -y + sym::cos(t)}, {y, v}, t);
+	auto backward = driven.solve({0, -2}, {1, 0});
+	ASSERT_NEAR(backward.state(1, 0, 0), std::cos(2.0) + std::sin(2.0), 1e-7);
+
+	// Stiff : the implicit method takes far fewer steps than the explicit one
+	sym::ode_system stiff({-1000.0 * (y - sym::cos(t))}, {y}, t);
+	sym::ode_options loose;
+	loose.relative_tolerance = loose.absolute_tolerance = 1e-3;
+	auto slow = stiff.solve({0, 10}, {0}, {}, loose);
+	loose.method = sym::ode_method::rosenbrock;
+	auto fast = stiff.solve({0, 10}, {0}, {}, loose);
+	double c = 1e6 / (1e6 + 1);
+	double exact = c * std::cos(10.0) + c / 1000 * std::sin(10.0);
+	ASSERT_NEAR(slow.state(1, 0, 0), exact, 1e-3);
+	ASSERT_NEAR(fast.state(1, 0, 0), exact, 1e-3);
+	ASSERT_LT(fast.steps[0] * 10, slow.steps[0]);
+
+	// Finite time blow-up
+	sym::ode_system blow_up({sym::pow(y, 2.0)}, {y}, t);
+	auto failed = blow_up.solve({0, 0.5, 2}, {1});
+	ASSERT_NEAR(failed.state(1, 0, 0), 2, 1e-8);
+	ASSERT_NE(failed.status[0], sym::ode_status::success);
+	ASSERT_TRUE(std::isnan(failed.state(2, 0, 0)));
+
+	ASSERT_THROW(decay.solve({0, 1}, initial, {1, 2}), std::invalid_argument);
+	ASSERT_THROW(sym::ode_system({y}, {y, v}, t), std::invalid_argument);
+}
+
+TEST(basic_exprs_computing, parse_many) {
+	std::string input;
+	for (int i = 0; i < 1000; ++i) {
+		input += std::format("{}x^2 + sin(y{})\n", i % 10, i % 3);
+	}
+	input += "\n  \nx + (y\nx $ 2\n3 )\ncos(x) + 1";
+
+	sym::parse_many_result result = sym::parse_many(input, 3);
+	ASSERT_EQ(result.expressions.size(), 1001);
+	ASSERT_EQ(result.lines.back(), 1006);
+	// Nodes interned by every thread are merged with the ones of the library
+	ASSERT_EQ(result.expressions[0], sym::parse("0x^2 + sin(y0)"));
+	ASSERT_EQ(result.expressions[742], sym::parse("2x^2 + sin(y1)"));
+	ASSERT_EQ(result.expressions.back(), sym::parse("cos(x) + 1"));
+
+	ASSERT_EQ(result.errors.size(), 3);
+	ASSERT_EQ(result.errors[0].line, 1003);
+	ASSERT_EQ(result.errors[1].line, 1004);
+	ASSERT_EQ(result.errors[2].line, 1005);
+	ASSERT_EQ(result.errors[2].desc, "Unexpected \")\".");
+	ASSERT_THROW(sym::parse_file("missing_expressions.txt"), std::runtime_error);
+	std::filesystem::path path = std::filesystem::temp_directory_path() / std::format("symaths_parse_file_test_{}.txt", std::random_device{}());
+	std::ofstream(path) << "x + 1\nsin(\n";
+	sym::parse_many_result from_file = sym::parse_file(path, 1);
+	std::filesystem::remove(path);
+	ASSERT_EQ(from_file.expressions.size(), 1);
+	ASSERT_EQ(from_file.expressions[0], sym::parse("x + 1"));
+	ASSERT_EQ(from_file.errors.size(), 1);
+
+	// Calls with a wrong amount of arguments
+	sym::parse_many_result calls = sym::parse_many("sin()\nsin(x, y)\nsin(x)", 1);
+	ASSERT_EQ(calls.expressions.size(), 1);
+	ASSERT_EQ(calls.errors.size(), 2);
+	ASSERT_EQ(calls.errors[1].desc, "sin takes 1 argument(s), but got 2.");
+	sym::lexer lexer;
+	lexer.tokenize("cos(x, y) + 1");
+	sym::parser p(lexer);
+	ASSERT_EQ(p.parse(0), nullptr);
+	ASSERT_EQ(p.errors().front().type, sym::parser::unsupported);
+}
+
+TEST(basic_exprs_computing, parse_compiled) {
+	sym::compiled_expression f = sym::parse_compiled("3x^2 + sin(y) / 2 - sqrt(x) + (x - y)^-1", {"x", "y"});
+	sym::symbol x("x");
+	sym::symbol y("y");
+	sym::compiled_expression g(sym::parse("3x^2 + sin(y) / 2 - sqrt(x) + (x - y)^-1"), {x, y});
+	for (double v : {0.5, 2.0, 7.25}) {
+		ASSERT_NEAR(f({v, 1.5}), g({v, 1.5}), 1e-12);
+	}
+	ASSERT_TRUE(std::ranges::any_of(f.program(), [](const auto& ins) { return ins.op == sym::detail::powi; }));
+	ASSERT_TRUE(std::isnan(f({-1.0, 0.0})));
+	// Negative powers keep the domain check of the division
+	ASSERT_TRUE(std::isnan(f({1.5, 1.5})));
+	ASSERT_TRUE(std::isnan(g({1.5, 1.5})));
+	ASSERT_TRUE(std::isnan(sym::parse_compiled("x^-1", {"x"})({0.0})));
+	ASSERT_NEAR(sym::parse_compiled("2 * (x + 1)^-3", {"x"})({1.0}), 0.25, 1e-12);
+
+	ASSERT_THROW(sym::parse_compiled("x + z", {"x", "y"}), std::invalid_argument);
+	ASSERT_THROW(sym::parse_compiled("x + (y", {"x", "y"}), std::invalid_argument);
+	ASSERT_THROW(sym::parse_compiled("x y)", {"x", "y"}), std::invalid_argument);
+}
+
+TEST(basic_exprs_computing, register_function) {
+	uint32_t id = sym::register_function("hypot", 2, [](const double* a) { return std::hypot(a[0], a[1]); });
+	ASSERT_EQ(sym::detail::get_func_id("hypot"), id);
+	ASSERT_EQ(sym::detail::get_func_id("log10"), sym::funcs::log10);
+	ASSERT_EQ(sym::detail::get_func_id("sqr"), sym::funcs::none);
+	ASSERT_THROW(sym::register_function("sin", 1, [](const double* a) { return a[0]; }), std::invalid_argument);
+	ASSERT_THROW(sym::register_function("f2", 9, [](const double* a) { return a[0]; }), std::invalid_argument);
+
+	sym::symbol x("x");
+	sym::expression e = sym::parse("hypot(x, 4) + sin(x)");
+	ASSERT_EQ(e.string(), "hypot(x, 4)+sin(x)");
+	// Arguments are evaluated with the context before calling the function
+	ASSERT_NEAR(e({{"x", sym::numbers::real{3}}}).get<double>(), 5 + std::sin(3.0), 1e-12);
+	ASSERT_THROW(sym::differentiate(e, x), std::logic_error);
+
+	sym::compiled_expression f(e, {x});
+	std::vector<double> xs(300), out(300);
+	for (size_t i = 0; i < xs.size(); ++i) {
+		xs[i] = 0.01 * static_cast<double>(i);
+	}
+	const double* columns[] = {xs.data()};
+	f.eval_batch(columns, out.data(), xs.size());
+	for (size_t i = 0; i < xs.size(); i += 37) {
+		ASSERT_NEAR(out[i], std::hypot(xs[i], 4) + std::sin(xs[i]), 1e-12);
+	}
+	ASSERT_NEAR(sym::parse_compiled("hypot(x, 4)", {"x"})({3.0}), 5, 1e-12);
+	ASSERT_THROW(sym::parse_compiled("hypot(x)", {"x"}), std::invalid_argument);
+}
+
+TEST(basic_exprs_computing, parse_cache) {
+	auto& cache = sym::current_context->parse_cache();
+	cache.set_capacity(2);
+	sym::expression e = sym::parse("x + 1");
+	ASSERT_EQ(sym::parse("  x  +\t1 ").root, e.root);
+	ASSERT_EQ(cache.stats().hits, 1);
+	ASSERT_EQ(cache.stats().misses, 1);
+
+	sym::parse("x + 2");
+	sym::parse("x + 1");
+	sym::parse("x + 3");
+	// "x + 2" was the least recently used
+	ASSERT_EQ(cache.size(), 2);
+	sym::parse("x + 2");
+	ASSERT_EQ(cache.stats().hits, 2);
+	ASSERT_EQ(cache.stats().misses, 4);
+
+	// Failures are not cached, and registering a function drops the entries
+	sym::parse("x + (y");
+	ASSERT_EQ(cache.size(), 2);
+	sym::register_function("ramp", 1, [](const double* a) { return a[0] > 0 ? a[0] : 0; });
+	ASSERT_EQ(sym::parse("ramp(x)").string(), "ramp(x)");
+	ASSERT_EQ(cache.size(), 1);
+
+	cache.set_capacity(0);
+	ASSERT_EQ(cache.size(), 0);
+	cache.clear();
+}
+
+TEST(basic_exprs_computing, printer) {
+	sym::symbol x("x");
+	sym::symbol y("y");
+	sym::expression e = sym::parse("abs(x - 1) * log10(y)^(x+1) - 2");
+	ASSERT_EQ(sym::to_latex(e), "\\left|x-1\\right| \\log_{10}\\left(y\\right)^{x+1}-2");
+	ASSERT_EQ(sym::to_compact(e), "abs(x-1)*log10(y)^(x+1)-2");
+	ASSERT_EQ(sym::parse(sym::to_compact(e)), e);
+
+	sym::expression third = sym::current_context->node_manager().make_constant(sym::numbers::rational(1LL, 3LL));
+	sym::expression r = x * third + sym::pow(x, third);
+	ASSERT_EQ(sym::to_latex(r), "x \\cdot \\frac{1}{3}+x^{\\frac{1}{3}}");
+	ASSERT_EQ(sym::to_compact(r), "x*(1/3)+x^(1/3)");
+
+	// Shared subexpressions are printed once, and copied where they appear again
+	sym::expression s = sym::sin(x + y);
+	sym::expression shared = s * y + sym::pow(s, 2) - s;
+	sym::printer memoized(sym::print_format::plain, true);
+	ASSERT_EQ(memoized.print(shared), shared.string());
+	ASSERT_EQ(memoized.print(shared), shared.string());
+	ASSERT_EQ(memoized.str(), shared.string() + shared.string());
+	memoized.clear();
+	ASSERT_TRUE(memoized.str().empty());
+}
+
+TEST(basic_exprs_computing, structural_hash) {
+	sym::expression e = sym::parse("x * sin(y) + 2.5 / (x - 1)^3");
+	// The same in any process, on any platform
+	ASSERT_EQ(sym::hash(sym::parse("x + 1")).string(), "307ea828ad445f9c8992adda2c407e91");
+
+	// Independent of the addresses and creation order of the nodes
+	sym::library* main_library = sym::current_context;
+	sym::library other;
+	sym::make_context_current(other);
+	sym::parse("(x - 1)^3 + 7");
+	sym::fingerprint again = sym::hash(sym::parse("x * sin(y) + 2.5 / (x - 1)^3"));
+	sym::expression zero = sym::make_constant(-0.0);
+	ASSERT_EQ(sym::hash(zero), sym::hash(sym::make_constant(0.0)));
+	sym::symbol a("a");
+	sym::symbol b("b");
+	ASSERT_NE(sym::hash(sym::pow(a, b)), sym::hash(sym::pow(b, a)));
+	ASSERT_NE(sym::hash(a + b), sym::hash(a * b));
+	sym::make_context_current(*main_library);
+	ASSERT_EQ(sym::hash(e), again);
+}
+
+TEST(basic_exprs_computing, serialization) {
+	sym::symbol x("x");
+	sym::symbol y("y");
+	sym::expression e1 = sym::parse("x * sin(y) + 2.5 / (x - 1)^3");
+	sym::expression e2 = sym::parse("sqrt(x^2 + y^2) - 3/4 * x");
+	std::string bytes = sym::serialize({e1, e2});
+
+	// Interned back into the same nodes
+	std::vector<sym::expression> same = sym::deserialize(bytes);
+	ASSERT_EQ(same.size(), 2);
+	ASSERT_EQ(same[0].root, e1.root);
+	ASSERT_EQ(same[1].root, e2.root);
+
+	sym::library* main_library = sym::current_context;
+	sym::library other;
+	sym::make_context_current(other);
+	std::vector<sym::expression> copied = sym::deserialize(bytes);
+	sym::fingerprint h1 = sym::hash(copied[0]);
+	sym::fingerprint h2 = sym::hash(copied[1]);
+	sym::make_context_current(*main_library);
+	ASSERT_EQ(h1, sym::hash(e1));
+	ASSERT_EQ(h2, sym::hash(e2));
+
+	// Compiled straight from the file
+	// Unique, so that parallel test runs do not share the file
+	std::filesystem::path path = std::filesystem::temp_directory_path() / std::format("symaths_serialization_test_{}.bin", std::random_device{}());
+	sym::save_expressions(path, {e1, e2});
+	{
+		sym::mapped_expressions mapped(path);
+		ASSERT_EQ(mapped.size(), 2);
+		sym::compiled_expression from_file = mapped.compile(0, {"x", "y"});
+		sym::compiled_expression from_nodes(e1, {x, y});
+		for (double v : {-1.5, 0.25, 3.0}) {
+			ASSERT_NEAR(from_file({v, v + 1}), from_nodes({v, v + 1}), 1e-12);
+		}
+		ASSERT_EQ(mapped.load(1).root, e2.root);
+		ASSERT_THROW((void)mapped.compile(0, {"x"}), std::invalid_argument);
+	}
+	std::filesystem::remove(path);
+
+	std::string corrupt = bytes;
+	corrupt[0] = 'X';
+	ASSERT_THROW(sym::deserialize(corrupt), std::invalid_argument);
+	ASSERT_THROW(sym::deserialize(std::string_view(bytes).substr(0, bytes.size() - 8)), std::invalid_argument);
+	// sin(x) is written as the symbol x, then the call. The call's record starts at byte 88, and its child count is its
+	// last word.
+	std::string call = sym::serialize({sym::sin(x)});
+	ASSERT_EQ(call[100], 1);
+	call[100] = 0;
+	ASSERT_THROW(sym::deserialize(call), std::invalid_argument);
+
+	// Every expression of a library
+	sym::library saved;
+	sym::make_context_current(saved);
+	sym::parse("x + 1");
+	sym::parse("(x + 1) * y");
+	std::string lib_bytes = sym::serialize(saved);
+	sym::make_context_current(*main_library);
+	std::vector<sym::expression> roots = sym::deserialize(lib_bytes);
+	ASSERT_EQ(roots.size(), 1);
+	ASSERT_EQ(roots[0].root, sym::parse("(x + 1) * y").root);
+}
+
+TEST(basic_exprs_computing, sum_product_builders) {
+	sym::symbol x("x");
+	sym::symbol y("y");
+	sym::expression chained = 3 * x + sym::sin(y) - x * y + 2;
+
+	size_t nodes = sym::current_context->node_manager().nodes().size();
+	sym::sum_builder sum(4);
+	sum.add(3 * x).add(sym::sin(y));
+	sum -= x * y;
+	sum += 2;
+	ASSERT_EQ(sum.size(), 4);
+	// Only the sum itself is new, without the intermediate sums of the chain
+	ASSERT_EQ(sum.build(), chained);
+	ASSERT_EQ(sym::current_context->node_manager().nodes().size(), nodes);
+
+	// Nested sums are flattened
+	sym::sum_builder nested;
+	nested.add(x + y).add(1);
+	ASSERT_EQ(nested.build(), x + y + 1);
+	ASSERT_EQ(sym::sum_builder().build(), sym::expression(0.0));
+	ASSERT_EQ(sym::sum_builder().add(x).build(), sym::expression(x));
+
+	sym::product_builder product;
+	product.multiply(2).multiply(x * y);
+	product /= x + 1;
+	ASSERT_EQ(product.build(), 2 * x * y / (x + 1));
+	ASSERT_EQ(sym::product_builder().build(), sym::expression(1.0));
+}
+
+TEST(basic_exprs_computing, compiled_expression_eval) {
+	sym::symbol x("x");
+	sym::symbol y("y");
+	sym::expression expr = 3 * sym::pow(x, 2) + sym::sin(y) - x / y;
+	sym::compiled_expression c(expr, {x, y});
+
+	ASSERT_NEAR(c({2.0, 0.5}), 12 + std::sin(0.5) - 4, 1e-12);
+
+	std::vector<double> xs(300), ys(300), out(300);
+	for (size_t i = 0; i < xs.size(); ++i) {
+		xs[i] = 0.01 * static_cast<double>(i);
+		ys[i] = 1.0 + 0.02 * static_cast<double>(i);
+	}
+	const double* columns[] = {xs.data(), ys.data()};
+	c.eval_batch(columns, out.data(), out.size());
+	for (size_t i = 0; i < out.size(); ++i) {
+		ASSERT_NEAR(out[i], c({xs[i], ys[i]}), 1e-12);
+	}
+}
+
+TEST(basic_exprs_computing, domain_inference) {
+	sym::symbol p("p");
+	sym::symbol q("q");
+	sym::assume(p, sym::domain::positive());
+
+	ASSERT_TRUE(sym::infer_domain(p + 1).is_positive());
+	ASSERT_TRUE(sym::infer_domain(sym::sqrt(p) * 2).is_positive());
+	ASSERT_TRUE(sym::infer_domain(sym::pow(q, 2) + 1).is_positive());
+	ASSERT_FALSE(sym::infer_domain(q + 1).excludes_zero());
+	ASSERT_EQ(sym::infer_domain(sym::sin(q)), sym::domain::between(-1, 1));
+
+	// Every domain check is proven useless
+	sym::compiled_expression safe(sym::ln(p) + sym::sqrt(p) + 1 / (p + 1) + sym::ln(sym::exp(q)), {p, q});
+	ASSERT_EQ(safe.guards(), 0);
+
+	sym::compiled_expression unsafe(sym::ln(q) + 1 / q, {p, q});
+	ASSERT_EQ(unsafe.guards(), 2);
+	ASSERT_TRUE(std::isnan(unsafe({1.0, 0.0})));
+	ASSERT_TRUE(std::isnan(unsafe({1.0, -2.0})));
+}
+
+TEST(basic_exprs_computing, optimize_for_eval) {
+	sym::symbol x("x");
+	sym::symbol y("y");
+	sym::expression expr1 = 3 * sym::pow(x, 3) + 2 * sym::pow(x, 2) + x + 5;
+	sym::expression expr2 = sym::exp(x) * sym::exp(y) * sym::pow(x, -1) * sym::pow(y, -2);
+	sym::expression expr3 = x * y + x * sym::sin(y) - x * sym::pow(y, 5);
+
+	for (const auto& expr : {expr1, expr2, expr3}) {
+		sym::expression opt = sym::optimize_for_eval(expr);
+		ASSERT_LT(sym::estimate_cost(opt), sym::estimate_cost(expr));
+
+		sym::compiled_expression before(expr, {x, y});
+		sym::compiled_expression after(opt, {x, y});
+		for (double v : {-1.5, 0.3, 2.0}) {
+			ASSERT_NEAR(after({v, v + 1}), before({v, v + 1}), 1e-9 * std::abs(before({v, v + 1})));
+		}
+	}
+
+	// Unit factors and zero terms are folded away rather than counted
+	sym::expression units = 1 * x * 1 + x * y * 1 + 0.0 * y + sym::pow(x, 1) * sym::pow(y, 2);
+	ASSERT_EQ(sym::optimize_for_eval(units).string(), "x(1+y+y^2)");
+}
+
+TEST(basic_exprs_computing, simplify) {
+	sym::symbol x("x");
+	sym::symbol p("p");
+	sym::assume(p, sym::domain::positive());
+
+	sym::expression trig = sym::simplify(sym::pow(sym::sin(x), 2) + sym::pow(sym::cos(x), 2));
+	ASSERT_TRUE(trig.is_ground());
+	ASSERT_DOUBLE_EQ(trig().get<double>(), 1.0);
+
+	ASSERT_EQ(sym::simplify(x + x + 2 * x).string(), "4x");
+	ASSERT_EQ(sym::simplify(sym::pow(x, 3) / x + 2 * sym::pow(x, 2)).string(), "3x^2");
+	ASSERT_EQ(sym::simplify(sym::ln(sym::exp(x + 1))).string(), sym::expression(x + 1).string());
+	ASSERT_EQ(sym::simplify(sym::exp(sym::ln(p))), sym::expression(p));
+	// x may be negative : exp(ln(x)) is not x
+	ASSERT_NE(sym::simplify(sym::exp(sym::ln(x))), sym::expression(x));
+	// Nor is (x^0.5)^2, but (p^0.5)^2 = p and (x^3)^2 = x^6
+	ASSERT_NE(sym::simplify(sym::pow(sym::pow(x, 0.5), 2)), sym::expression(x));
+	ASSERT_EQ(sym::simplify(sym::pow(sym::pow(p, 0.5), 2)), sym::expression(p));
+	ASSERT_EQ(sym::simplify(sym::pow(sym::pow(x, 3), 2)).string(), "x^6");
+
+	sym::expression expr = x * sym::sin(x) + sym::pow(x, 2) * sym::sin(x) + sym::exp(x) * sym::exp(-x);
+	sym::expression simplified = sym::simplify(expr);
+	ASSERT_LT(sym::estimate_cost(simplified), sym::estimate_cost(expr));
+	sym::compiled_expression before(expr, {x});
+	sym::compiled_expression after(simplified, {x});
+	for (double v : {-2.0, 0.5, 3.0}) {
+		ASSERT_NEAR(after({v}), before({v}), 1e-9 * std::abs(before({v})));
+	}
+
+	sym::simplify_budget none;
+	none.max_iterations = 0;
+	ASSERT_EQ(sym::simplify(x + x, none).string(), "x+x");
+}
+
+TEST(basic_exprs_computing, rewrite_rules) {
+	sym::symbol x("x");
+	sym::symbol y("y");
+	sym::symbol a("a");
+	sym::symbol b("b");
+
+	sym::rule_set rules;
+	rules.add(sym::pow(sym::sin(a), 2) + sym::pow(sym::cos(a), 2), 1.0, {a});
+	rules.add(a + -a, 0.0, {a});
+	rules.add(sym::ln(sym::exp(a)), a, {a});
+	rules.add(sym::exp(a) * sym::exp(b), sym::exp(a + b), {a, b});
+	ASSERT_EQ(rules.size(), 4);
+
+	// Operands of sums match in any order, and a part of a sum can match
+	ASSERT_EQ(rules.rewrite(x + sym::pow(sym::cos(y), 2) + sym::pow(sym::sin(y), 2)).string(), "x+1");
+	// A repeated wildcard must match the same subexpression
+	ASSERT_EQ(rules.rewrite(x + -x).string(), "0");
+	ASSERT_EQ(rules.rewrite(x + -y).string(), "x-y");
+	// Rewriting goes bottom-up until no rule applies
+	ASSERT_EQ(rules.rewrite(sym::ln(sym::exp(sym::ln(sym::exp(x))))), sym::expression(x));
+	ASSERT_EQ(rules.rewrite(sym::exp(x) * sym::exp(y) * sym::exp(2)).string(), "exp(2+x+y)");
+
+	// The index only retrieves rules with the right structure
+	ASSERT_EQ(rules.candidates(sym::ln(sym::exp(y)).root), std::vector<uint32_t>{2});
+	ASSERT_TRUE(rules.candidates(sym::sin(x).root).empty());
+
+	ASSERT_THROW(rules.add(x, a, {a}), std::invalid_argument);
+
+	// Rules which never terminate throw instead of overflowing the stack
+	sym::rule_set commuting;
+	commuting.add(a + b, b + a, {a, b});
+	ASSERT_THROW((void)commuting.rewrite(x + y), std::runtime_error);
+	sym::rule_set growing;
+	growing.add(sym::sin(a), sym::sin(sym::sin(a)), {a});
+	ASSERT_THROW((void)growing.rewrite(sym::sin(x)), std::runtime_error);
+
+	sym::current_context->refactoring_rules().rewrite_rules.add(sym::sqrt(sym::pow(a, 2)), sym::abs(a), {a});
+	ASSERT_EQ(sym::rewrite(sym::sqrt(sym::pow(x + 1, 2))).string(), "abs(x+1)");
+	sym::current_context->refactoring_rules().rewrite_rules.clear();
+}